@@ -0,0 +1,74 @@
+/********************************************************************
+ *                  Automatic Baud Rate Header File                 *
+ *                                                                  *
+ *  [   Author  ]       -       Andrew Borg                         *
+ *  [   Type    ]       -       Serial Port Connector               *
+ *  [   Date    ]       -       19.01.2013                          *
+ *                                                                  *
+ * ******************************************************************
+ *                                                                  *
+ *  Description                                                     *
+ *                                                                  *
+ * Finds the Baud Rate of an unknown Console by Listening to it at  *
+ * each Common Rate for a short Window, and Scoring what was Read.  *
+ *                                                                  *
+ * At the wrong Rate, the UART splits and merges Frames : most      *
+ * Characters are not Printable and many have Framing Errors. At    *
+ * the right one, the Sample is Text, with Line Breaks and the      *
+ * Words Bootloaders and Kernels print ( U-Boot, Starting ... ).    *
+ *                                                                  *
+ * The Score is the Ratio of Printable Characters, less twice the   *
+ * Ratio of Framing Errors, weighted by the Size of the Sample,     *
+ * plus a Bonus per Token Found. The Rates Consoles use the most    *
+ * are Probed first, and the Search stops at the first Sample       *
+ * which is clearly Text, usually within a few Windows.             *
+ *                                                                  *
+ * The Scoring works on any Buffer, so Captures taken at known      *
+ * Rates can be Scored offline ( Serial -Score ).                   *
+ *                                                                  *
+ * ******************************************************************
+ */
+
+#ifndef AUTO_BAUD_H
+#define AUTO_BAUD_H
+
+#include "Sizes.h"
+#include "SerialPort.h"
+
+// A Score at least this high, over enough Characters, Locks the Rate at once
+
+#define BAUD_LOCK_SCORE     0.9
+
+#define BAUD_LOCK_LENGTH    32
+
+typedef struct
+{
+    // The Characters Read, once the Error Marks are Removed
+    
+    QWORD Length;
+    
+    QWORD Printable;
+    
+    // Characters with a Framing or Parity Error, and Breaks
+    
+    QWORD Errors;
+    
+    QWORD LineBreaks;
+    
+    // The Distinct Bootloader and Kernel Tokens Found
+    
+    int Tokens;
+    
+    double Score;
+
+} BaudScore;
+
+// Scores a Sample, Marked Samples hold the Driver's Error Marks ( See MarkLineErrors )
+
+void ScoreSample(const BYTE * Data, QWORD Length, int Marked, BaudScore * Score);
+
+// Probes the Common Rates on an Open Port, Returns the Rate found ( the Port is left at it ) or 0
+
+unsigned int DetectBaudRate(int Port, SerialSettings * Settings, int Verbose);
+
+#endif
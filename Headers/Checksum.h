@@ -0,0 +1,47 @@
+/********************************************************************
+ *                  Checksum Header File                            *
+ *                                                                  *
+ *  [   Author  ]       -       Andrew Borg                         *
+ *  [   Type    ]       -       Firmware Analysis                   *
+ *  [   Date    ]       -       02.01.2014                          *
+ *                                                                  *
+ * ******************************************************************
+ *                                                                  *
+ *  Description                                                     *
+ *                                                                  *
+ * The Checksums used by Firmware Images and Transfer Protocols.    *
+ *                                                                  *
+ * Each Checksum has a portable Slice by 8 implementation, and      *
+ * a faster one using the CPU's Instructions ( PCLMULQDQ for        *
+ * CRC32, SSE 4.2 for CRC32C ) which is selected at Start Up        *
+ * when the CPU supports it.                                        *
+ *                                                                  *
+ * The Checksum of a Stream can be computed Block by Block,         *
+ * passing the Result of each call to the next one, starting        *
+ * from 0.                                                          *
+ *                                                                  *
+ * ******************************************************************
+ */
+
+#ifndef CHECKSUM_H
+#define CHECKSUM_H
+
+#include "Sizes.h"
+
+// CRC32 ( IEEE 802.3, as used by Zip, Zlib and the Belkin Trailer )
+
+DWORD Crc32(DWORD Checksum, const BYTE * Data, QWORD Length);
+
+// CRC32C ( Castagnoli, as used by iSCSI, Ext4 and Btrfs )
+
+DWORD Crc32C(DWORD Checksum, const BYTE * Data, QWORD Length);
+
+// CRC16 ( CCITT, as used by XMODEM, YMODEM and ZMODEM ), always Slice by 8
+
+WORD Crc16(WORD Checksum, const BYTE * Data, QWORD Length);
+
+// The Name of the Implementation selected for each Checksum
+
+const char * ChecksumEngine();
+
+#endif
@@ -19,6 +19,13 @@
 #include <stdlib.h>
 #include <string.h>
 #include "Sizes.h"
+#include "Checksum.h"
+#include "Stats.h"
+#include "Records.h"
+
+// The Size of the Buffer used when Data has to be Copied in User Space
+
+#define COPY_BUFFER_SIZE (1024 * 1024)
 
 extern unsigned long FileSize;
 
@@ -26,3 +33,41 @@ FILE * FileOpener(char * Filename, char * ReadMode);
 char * DumpHex(char * FileName);
 char * DumpHexWithoutNulls(char * FileName);
 
+// Read Only Memory Mapping of a whole File
+
+BYTE * MapFile(char * FileName, QWORD * Size);
+void UnmapFile(BYTE * Map, QWORD Size);
+
+// Keeps the Mapped Files and their Dumps between the Commands of a Batch ( See FWTools.c )
+
+void EnableFileCache(QWORD Budget);
+
+// Drops the Least Recently Used Files no longer in Use, until the Cache fits it's Budget
+
+void TrimFileCache();
+
+// Kernel Side Copy of a Byte Range between two File Descriptors
+// Returns the Method used, from the Cheapest to the most Expensive, or -1 on Error
+
+#define COPY_CLONED 0
+#define COPY_KERNEL 1
+#define COPY_BUFFERED 2
+
+int CopyRange(int Source, QWORD SourceOffset, int Destination, QWORD DestinationOffset, QWORD Length);
+
+// Positioned Write which retries until all the Bytes are Written
+
+int WriteAt(int Descriptor, const void * Data, QWORD Length, QWORD Offset);
+
+// Fills a Range of a File with a Byte Value, using Vectored Writes of a Shared Buffer
+
+int FillRange(int Descriptor, QWORD Offset, QWORD Length, BYTE Value);
+
+// Parses a 64 Bit Size, in Decimal or Hexadecimal ( 0x ), with an optional K, M or G Suffix
+
+QWORD ParseSize(char * Text);
+
+// Fast 64 Bit Content Hash ( Not Cryptographic )
+
+QWORD HashContent(const BYTE * Data, QWORD Length);
+
@@ -0,0 +1,87 @@
+/********************************************************************
+ *                  Firmware Tools Daemon Header File               *
+ *                                                                  *
+ *  [   Author  ]       -       Andrew Borg                         *
+ *  [   Type    ]       -       Firmware Analysis                   *
+ *  [   Date    ]       -       02.01.2014                          *
+ *                                                                  *
+ * ******************************************************************
+ *                                                                  *
+ *  Description                                                     *
+ *                                                                  *
+ * Serves the Firmware Tools on a Local Unix Socket, so repeated    *
+ * Analyses of the same Images skip the Loading :                   *
+ *                                                                  *
+ *      fwtoolsd [Options] <Socket>                                 *
+ *      fwtools -client <Socket> HexDump -Strings Image.bin         *
+ *                                                                  *
+ * The Daemon keeps the Images it was Asked about Mapped, along     *
+ * with their Dumps ( See EnableFileCache ), and the Signatures of  *
+ * the Database, which are Loaded again as soon as the Database     *
+ * File is Replaced or Rewritten ( inotify ).                       *
+ *                                                                  *
+ * Each Request Runs in a Child forked from the Daemon, so it       *
+ * starts with everything the Daemon holds already Loaded, shared   *
+ * Copy on Write, and a Tool which Fails or Crashes only ends it's  *
+ * own Request. The Child's Output is sent back as it is Written.   *
+ * Threads do not survive a fork : each Child starts it's own       *
+ * Thread Pool.                                                     *
+ *                                                                  *
+ * The Files a Request Reads are Loaded by a Warm Thread before     *
+ * it's Child is Forked, so Loading a Large Image never holds up    *
+ * the other Clients.                                               *
+ *                                                                  *
+ * A Client can have several Requests at once. Each Client has a    *
+ * Limit of Requests Running at once, the Others Wait in it's       *
+ * Queue, and the Clients take turns for the Daemon's Jobs.         *
+ *                                                                  *
+ * The Protocol is Text Headers followed by Raw Data. A Request is  *
+ * one Line, Quoted as a Batch Line ( See FWTools.c ) :             *
+ *                                                                  *
+ *      <Id> <Folder> <Tool> [Arguments ...]                        *
+ *                                                                  *
+ * The Folder is where the Tool Runs, the Id is any Word, and is    *
+ * Repeated by every Record Answering the Request :                 *
+ *                                                                  *
+ *      <Id> OUT <Length>\n<Length Bytes of Output>                 *
+ *      <Id> END <Exit Status>\n                                    *
+ *                                                                  *
+ * A Tool Killed by a Signal Ends with 128 + the Signal.            *
+ *                                                                  *
+ * ******************************************************************
+ */
+
+#ifndef DAEMON_H
+#define DAEMON_H
+
+#include "Sizes.h"
+
+typedef struct
+{
+    char * SocketPath;
+
+    char * Database;
+
+    // Requests Running at once, over every Client ( 0 for one per CPU ) and for a single Client
+
+    int Jobs;
+
+    int ClientJobs;
+
+    // The Bytes of Images and Dumps kept Loaded
+
+    QWORD CacheSize;
+
+} DaemonSettings;
+
+#define DAEMON_DEFAULTS { NULL, "Database.DB", 0, 2, 1024ULL * 1024 * 1024 }
+
+// Serves Requests until SIGINT or SIGTERM, Returns 0, or -1 if the Daemon could not Start
+
+int RunDaemon(DaemonSettings * Settings);
+
+// Sends a Single Request, Writes it's Output and Returns it's Exit Status ( -1 if the Daemon cannot be Reached )
+
+int RunClient(char * SocketPath, int argc, char * argv[]);
+
+#endif
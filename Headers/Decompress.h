@@ -0,0 +1,63 @@
+/********************************************************************
+ *                  Decompress Header File                          *
+ *                                                                  *
+ *  [   Author  ]       -       Andrew Borg                         *
+ *  [   Type    ]       -       Firmware Analysis                   *
+ *  [   Date    ]       -       02.01.2014                          *
+ *                                                                  *
+ * ******************************************************************
+ *                                                                  *
+ *  Description                                                     *
+ *                                                                  *
+ * Decoders for the Compressed Streams found inside Firmware, Run   *
+ * straight on the Mapped Image through liblzma and zlib :          *
+ *                                                                  *
+ *      LZMA    : LZMA Alone, the 13 Byte Header ( 5D 00 00 ... )   *
+ *      XZ      : XZ Streams ( FD 37 7A 58 5A 00 )                  *
+ *      GZIP    : The First Member of a Gzip File ( 1F 8B 08 )      *
+ *      ZLIB    : Zlib Streams ( 78 01, 78 5E, 78 9C or 78 DA )     *
+ *                                                                  *
+ * The Decoded Bytes are passed to a Sink in Blocks, which keeps    *
+ * them in Memory, Writes them to a File, or only Counts them. A    *
+ * Stream's Compressed Length is Known once it is Decoded, so a     *
+ * Stream is Carved from it's Decoder's Result.                     *
+ *                                                                  *
+ * Each Call has it's own Decoder, Streams can be Decoded by        *
+ * several Threads at once.                                         *
+ *                                                                  *
+ * ******************************************************************
+ */
+
+#ifndef DECOMPRESS_H
+#define DECOMPRESS_H
+
+#include "Sizes.h"
+
+#define CODEC_NONE  0
+#define CODEC_LZMA  1
+#define CODEC_XZ    2
+#define CODEC_GZIP  3
+#define CODEC_ZLIB  4
+
+// The Results of Decode Stream
+
+#define DECODE_END      0   // The Stream is Complete
+#define DECODE_LIMIT    1   // Stopped at the Limit, or by the Sink
+#define DECODE_ERROR    -1  // The Stream is Invalid, or Truncated
+
+// Receives each Block of Decoded Bytes, Returns non Zero to Stop the Decoder
+
+typedef int (* DecodeSink)(const BYTE * Data, QWORD Length, void * Context);
+
+// Decodes the Stream at Data, until it's End or until Limit Bytes were Decoded ( 0 for no Limit )
+// Consumed is Set to the Compressed Bytes Read, and Produced to the Bytes Decoded
+
+int DecodeStream(int Codec, const BYTE * Data, QWORD Available, QWORD Limit, DecodeSink Sink, void * Context,
+                 QWORD * Consumed, QWORD * Produced);
+
+// Checks a Stream's Header, then Decodes it's First Bytes
+// Returns 1 when the Stream looks Valid
+
+int ProbeStream(int Codec, const BYTE * Data, QWORD Available);
+
+#endif
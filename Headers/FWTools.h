@@ -0,0 +1,56 @@
+/********************************************************************
+ *                  Firmware Tools Header File                      *
+ *                                                                  *
+ *  [   Author  ]       -       Andrew Borg                         *
+ *  [   Type    ]       -       Firmware Analysis                   *
+ *  [   Date    ]       -       02.01.2014                          *
+ *                                                                  *
+ * ******************************************************************
+ *                                                                  *
+ *  Description                                                     *
+ *                                                                  *
+ * The Tools built inside the Multi Call Binary, shared by the      *
+ * Batch ( See FWTools.c ) and the Daemon ( See Daemon.h ).         *
+ *                                                                  *
+ * ******************************************************************
+ */
+
+#ifndef FW_TOOLS_H
+#define FW_TOOLS_H
+
+#include "Sizes.h"
+
+// What a Tool Reads from the Files it is Passed, so they can be Loaded ahead of it
+
+#define WARM_NONE       0
+#define WARM_MAP        1
+#define WARM_DUMP       2
+#define WARM_NO_NULLS   3
+
+typedef int (* ToolMain)(int argc, char * argv[]);
+
+typedef struct
+{
+    char * Name;
+
+    ToolMain Main;
+
+    char * Description;
+
+    int Warm;
+
+} Tool;
+
+// Finds a Tool by it's Name, regardless of the Case, or NULL
+
+const Tool * FindTool(char * Name);
+
+// Cuts a Line into Arguments in place, Quotes and Escapes as a Shell would, Returns the Count or -1
+
+int SplitLine(char * Line, char *** Arguments, int * Capacity);
+
+// Replaces exit inside the Tools
+
+void ExitTool(int Status) __attribute__((noreturn));
+
+#endif
@@ -0,0 +1,64 @@
+/********************************************************************
+ *                  Flash Dump Header File                          *
+ *                                                                  *
+ *  [   Author  ]       -       Andrew Borg                         *
+ *  [   Type    ]       -       Serial Port Connector               *
+ *  [   Date    ]       -       19.01.2013                          *
+ *                                                                  *
+ * ******************************************************************
+ *                                                                  *
+ *  Description                                                     *
+ *                                                                  *
+ * Reads Memory or Flash through a U-Boot Console, when there is    *
+ * no other way to get to it, and saves it as a Binary Image.       *
+ *                                                                  *
+ * The Console is driven like an Expect Script : each Window is     *
+ * read with md.b, and the Hex Dump is Parsed while it arrives,     *
+ * one Character at a time, until the Prompt comes back. If the     *
+ * Target has the crc32 Command, every Window is Checked against    *
+ * it, and a Window which does not match is read again.             *
+ *                                                                  *
+ *  md.b Lines look like ( 16 Bytes per Line ) :                    *
+ *                                                                  *
+ *      80000000: 27 05 19 56 5a 3d 61 4c ...    '..VZ=aL...        *
+ *                                                                  *
+ *  The Address is followed by a Colon, each Byte by a Single       *
+ *  Space, and the ASCII Column by more than one Space.             *
+ *                                                                  *
+ * ******************************************************************
+ */
+
+#ifndef FLASH_DUMP_H
+#define FLASH_DUMP_H
+
+#include "Sizes.h"
+
+typedef struct
+{
+    // The Address of the First Byte and the Number of Bytes to Read
+    
+    QWORD Address;
+    
+    QWORD Length;
+    
+    // The Bytes Read by each md.b Command
+    
+    QWORD Window;
+    
+    // The Console's Prompt, such as "=> "
+    
+    char * Prompt;
+    
+    // Check each Window with the crc32 Command
+    
+    int Verify;
+
+} DumpSettings;
+
+#define DUMP_DEFAULTS { 0, 0, 64 * 1024, "=> ", 1 }
+
+// Reads the Memory described by the Settings into the Output File, Returns 0 or -1
+
+int DumpFlash(int Port, DumpSettings * Settings, char * OutputFile);
+
+#endif
@@ -0,0 +1,91 @@
+/********************************************************************
+ *                  IO Ring Header File                             *
+ *                                                                  *
+ *  [   Author  ]       -       Andrew Borg                         *
+ *  [   Type    ]       -       Firmware Analysis                   *
+ *  [   Date    ]       -       02.01.2014                          *
+ *                                                                  *
+ * ******************************************************************
+ *                                                                  *
+ *  Description                                                     *
+ *                                                                  *
+ * Batches of File Operations submitted through the Kernel's        *
+ * io_uring, for the Tools Writing or Reading one File per Entry.   *
+ * The Opens, Reads, Writes and Closes of many Files are kept in    *
+ * Flight together, and each costs a Fraction of a System Call.     *
+ *                                                                  *
+ * Each File in Flight holds a Slot : a Fixed File, so the Kernel   *
+ * does not look the Descriptor up for every Operation, and a       *
+ * Registered Buffer, which the Kernel does not Map again for every *
+ * Read and Write.                                                  *
+ *                                                                  *
+ * The Ring is Set Up on first use and kept, like the Thread Pool.  *
+ * When the Kernel lacks io_uring, or one of the Operations used,   *
+ * or FWTOOLS_RING=0 is Set, every Method Returns -1 and the Tool   *
+ * takes it's Thread Pool Path instead.                             *
+ *                                                                  *
+ * The Ring is Used by a single Thread at a time.                   *
+ *                                                                  *
+ * ******************************************************************
+ */
+
+#ifndef IORING_H
+#define IORING_H
+
+#include "Sizes.h"
+
+// The Registered Buffer of each Slot, Files Copied by RingCopyFiles have to be Smaller
+
+#define RING_BUFFER_SIZE (256 * 1024)
+
+typedef struct
+{
+    // The File Created, or Read
+    
+    const char * Path;
+    
+    // RingWriteFiles : The Data Written to the File
+    
+    const BYTE * Data;
+    
+    QWORD Length;
+    
+    // RingCopyFiles : Where the File is Written inside the Output
+    
+    QWORD Offset;
+    
+    // The Bytes Written, or Read for RingCopyFiles, or -errno
+    
+    long long Result;
+
+} RingFile;
+
+// Called with the Content of each File Read by RingCopyFiles, before it is Written
+
+typedef void (* RingInspect)(int Index, const BYTE * Data, QWORD Length, void * Context);
+
+// 1 when the Ring can be Used
+
+int RingAvailable();
+
+// Creates each File and Writes it's Data
+// Returns 0 once every File was Attempted ( See each Result ), or -1 when the Ring cannot be Used
+
+int RingWriteFiles(RingFile * Files, int Count);
+
+// Reads each File whole, and Writes it at it's Offset inside the Output. A File whose Size is not it's
+// Length is not Written, it's Result tells the Size Read
+// Returns 0 once every File was Attempted, or -1 when the Ring cannot be Used
+
+int RingCopyFiles(RingFile * Files, int Count, int Output, RingInspect Inspect, void * Context);
+
+// Opens each Path, Descriptors holds each Descriptor or -errno
+// Returns 0 once every File was Attempted, or -1 when the Ring cannot be Used
+
+int RingOpenFiles(char ** Paths, int Count, int Flags, int Mode, int * Descriptors);
+
+// Closes each Descriptor which is not Negative
+
+int RingCloseFiles(int * Descriptors, int Count);
+
+#endif
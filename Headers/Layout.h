@@ -0,0 +1,88 @@
+/********************************************************************
+ *                  Flash Layout Header File                        *
+ *                                                                  *
+ *  [   Author  ]       -       Andrew Borg                         *
+ *  [   Type    ]       -       Firmware Analysis                   *
+ *  [   Date    ]       -       02.01.2014                          *
+ *                                                                  *
+ * ******************************************************************
+ *                                                                  *
+ *  Description                                                     *
+ *                                                                  *
+ * A Layout describes where each Partition lives inside a Flash     *
+ * Image. It is used by the Merger to Assemble an Image and by      *
+ * the Splitter to cut an Image back into it's Partitions.          *
+ *                                                                  *
+ * Each Line of a Layout File holds a Partition :                   *
+ *                                                                  *
+ *      <File>  <Offset>  [Maximum Size]  [Fill Byte]               *
+ *                                                                  *
+ * Sizes and Offsets accept the K, M and G Suffixes. A Maximum      *
+ * Size of - means the Partition ends where the next one starts     *
+ * ( or at the End of the Image ). The Fill Byte ( 0xFF by          *
+ * Default ) pads the Partition up to it's Maximum Size.            *
+ *                                                                  *
+ * An optional Line sets the Size of the whole Image and the Byte   *
+ * used for the Gaps between Partitions :                           *
+ *                                                                  *
+ *      Size  <Image Size>  [Fill Byte]                             *
+ *                                                                  *
+ * Everything following a # is a Comment.                          *
+ *                                                                  *
+ * ******************************************************************
+ */
+
+#ifndef LAYOUT_H
+#define LAYOUT_H
+
+#include "Sizes.h"
+
+// The Maximum Size of a Partition which ends where the Next one Starts
+
+#define SIZE_TO_NEXT ((QWORD) -1)
+
+typedef struct
+{
+    char * FileName;
+    
+    QWORD Offset;
+    
+    QWORD MaximumSize;
+    
+    BYTE Fill;
+    
+} LayoutEntry;
+
+typedef struct
+{
+    LayoutEntry * Entries;
+    
+    int Count;
+    
+    // The Size of the Image, 0 if not Set
+    
+    QWORD ImageSize;
+    
+    BYTE Fill;
+    
+} Layout;
+
+Layout LoadLayout(char * FileName);
+
+void AddLayoutEntry(Layout * Map, char * FileName, QWORD Offset, QWORD MaximumSize, BYTE Fill);
+
+void SortLayout(Layout * Map);
+
+// Cuts the Partitions of Known Size at the Partitions of Size - starting inside them
+
+void CutLayout(Layout * Map);
+
+void ResolveLayout(Layout * Map, QWORD ImageSize);
+
+int CheckLayout(Layout * Map);
+
+void WriteLayout(Layout * Map, FILE * File);
+
+void FreeLayout(Layout * Map);
+
+#endif
@@ -0,0 +1,138 @@
+/********************************************************************
+ *                  PFS File System Header File                     *
+ *                                                                  *
+ *  [   Author  ]       -       Andrew Borg                         *
+ *  [   Type    ]       -       PFS Extractor                       *
+ *  [   Date    ]       -       07.12.2013                          *
+ *                                                                  *
+ * ******************************************************************
+ *                                                                  *
+ *  Description                                                     *
+ *                                                                  *
+ * The Structures and Methods used to Pack a PFS File System.       *
+ * They are shared by the PFS Packer and by the Padder's Pipeline   *
+ * Mode, which streams a Packed Folder inside a Firmware Image.     *
+ *                                                                  *
+ * ******************************************************************
+ */
+
+#ifndef PFS_H
+#define PFS_H
+
+#define NAME_BLOCK 64
+#define MAX_FILES 1000
+#define PATH_MAX 4096
+
+// The Size of the PFS Header and of a single Entry inside the Entry Table
+
+#define HEADER_SIZE 16
+#define ENTRY_SIZE (NAME_BLOCK + 4 + 4 + 4)
+
+// A Structure used to store the Header of the PFS Image
+// A more Detailed Description can be found in the Unpacker 
+
+typedef struct 
+{
+    char Signature [8];
+
+    char NullPadding [4];
+
+    WORD UnknownField;
+
+    WORD EntryCount;
+
+} PFSHeader;
+
+// A Structure used to store each file's attributes
+// A more Detailed Description can be found in the Unpacker 
+
+typedef struct
+{
+    char FileName[NAME_BLOCK];
+    
+    DWORD Timestamp;
+    
+    DWORD Offset;
+    
+    DWORD Size;
+    
+    // The Fields below are not written inside the Image
+    
+    // The Path of the File on Disk
+    
+    char * SourcePath;
+    
+    // The Last Modification Time of the File in Nanoseconds
+    
+    QWORD Modified;
+    
+    // The Content Hash of the File, stored inside the Manifest
+    
+    QWORD Hash;
+    
+    // Set to 1 once the Hash Field is Valid
+    
+    char Hashed;
+    
+    // The Index of the Entry holding the same Content, or -1 if the Data is Written for this Entry
+    
+    int Alias;
+    
+    // Set to 1 if the Data is copied from the Previous Image instead of the File
+    
+    char Reused;
+    
+    // The Absolute Offset of the Data inside the Previous Image
+    
+    QWORD PreviousOffset;
+    
+} PFSEntry;
+
+// A Structure used to store each line of the Manifest written next to the Image
+// The Manifest allows an Update to skip Files which were not modified since the last Pack
+
+typedef struct
+{
+    char FileName[NAME_BLOCK];
+    
+    QWORD Size;
+    
+    QWORD Modified;
+    
+    QWORD Hash;
+    
+} ManifestEntry;
+
+// The Function called with each Block of an Archive being Streamed
+
+typedef void (* ArchiveWriter)(const BYTE * Data, QWORD Length, void * Context);
+
+// The Number of Files Gathered and the Length of the Packed Folder's Path
+
+extern int TotalFiles;
+
+extern int RootLength;
+
+void SetPackRoot(char * Directory);
+
+void GatherFiles(char * ParentFolder, char RecursiveScan);
+
+void ClearFiles();
+
+PFSHeader PopulateArchiveHeader(WORD Entries);
+
+PFSEntry * PackFiles();
+
+void DeduplicateFiles(PFSEntry * Packer, ManifestEntry * Manifest, int ManifestCount);
+
+void HashEntry(int Index, void * Context);
+
+char SameContent(PFSEntry * First, PFSEntry * Second);
+
+ManifestEntry * FindManifestEntry(ManifestEntry * Manifest, int ManifestCount, char * FileName);
+
+BYTE * BuildEntryTable(PFSEntry * Packer, QWORD * Length);
+
+QWORD StreamArchive(PFSEntry * Packer, ArchiveWriter Write, void * Context);
+
+#endif
@@ -0,0 +1,77 @@
+/********************************************************************
+ *                  Records Header File                             *
+ *                                                                  *
+ *  [   Author  ]       -       Andrew Borg                         *
+ *  [   Type    ]       -       Firmware Analysis                   *
+ *  [   Date    ]       -       02.01.2014                          *
+ *                                                                  *
+ * ******************************************************************
+ *                                                                  *
+ *  Description                                                     *
+ *                                                                  *
+ * The Results of the Tools, as Records a Program can Read without  *
+ * Parsing the Text. The Format is Chosen with --format on the      *
+ * Command Line of any Tool, or with FWTOOLS_FORMAT :               *
+ *                                                                  *
+ *      text    : The Tools' usual Output ( the Default )           *
+ *      json    : One JSON Object per Line, with a "type" Field     *
+ *      csv     : A Header Line the first time each Type is Seen,   *
+ *                then one Line per Record, Texts Quoted            *
+ *      binary  : Length Prefixed Records, Little Endian :          *
+ *                                                                  *
+ *          [ 4 Bytes - Length of the Rest ] [ 1 Byte - Type ]      *
+ *          Then each Field in Order, a Number as 8 Bytes, a Text   *
+ *          as [ 2 Bytes - Length ] [ Bytes ]                       *
+ *                                                                  *
+ * The Types, and their Fields ( N for a Number, T for a Text ) :   *
+ *                                                                  *
+ *      1 signature  : file T, name T, description T, offset N      *
+ *      2 string     : offset N, text T                             *
+ *      3 partition  : index N, start N, end N, size N              *
+ *      4 entry      : index N, name T, timestamp N, offset N,      *
+ *                     size N, shared T                             *
+ *      5 extraction : path T, offset N, size N, status T           *
+ *                                                                  *
+ * In the Structured Formats, only the Records are Written. The     *
+ * Text Format is one more Renderer of the same Records, and the    *
+ * Tools' Headers and Summaries go through OutputText.              *
+ *                                                                  *
+ * Records are Written through the Standard Output's own Buffer,    *
+ * so they stay in Order with whatever else the Tools Print. It is  *
+ * Enlarged when the Output is not a Terminal. Records have to be   *
+ * Emitted from a single Thread.                                    *
+ *                                                                  *
+ * ******************************************************************
+ */
+
+#ifndef RECORDS_H
+#define RECORDS_H
+
+#include "Sizes.h"
+
+#define FORMAT_TEXT     0
+#define FORMAT_JSON     1
+#define FORMAT_CSV      2
+#define FORMAT_BINARY   3
+
+extern int OutputFormat;
+
+// Chooses the Format from --format ( it is then Removed from argv ) or FWTOOLS_FORMAT
+
+void InitOutput(int * argc, char * argv[]);
+
+// Text Written only in the Text Format, such as Headers and Summaries
+
+void OutputText(const char * Format, ...) __attribute__((format(printf, 1, 2)));
+
+void EmitSignature(const char * File, const char * Name, const char * Description, QWORD Offset);
+void EmitString(QWORD Offset, const char * Text, QWORD Length);
+void EmitPartition(int Index, QWORD Start, QWORD End);
+void EmitEntry(int Index, const char * Name, DWORD Timestamp, QWORD Offset, QWORD Size, const char * Shared);
+void EmitExtraction(const char * Path, QWORD Offset, QWORD Size, const char * Status);
+
+// Writes what is Buffered to the Standard Output
+
+void FlushOutput();
+
+#endif
@@ -0,0 +1,123 @@
+/********************************************************************
+ *                  Serial Hub Header File                          *
+ *                                                                  *
+ *  [   Author  ]       -       Andrew Borg                         *
+ *  [   Type    ]       -       Serial Port Connector               *
+ *  [   Date    ]       -       19.01.2013                          *
+ *                                                                  *
+ * ******************************************************************
+ *                                                                  *
+ *  Description                                                     *
+ *                                                                  *
+ * Watches many Serial Ports from a single Process, such as every   *
+ * Board of a Test Farm. Each Port is Logged to it's own Rotated    *
+ * Log, and is shared on a Local Unix Socket : any number of        *
+ * Clients can Attach to it ( Serial -Attach <Socket> ), Type on    *
+ * the Console and Detach again, while the Capture goes on.         *
+ *                                                                  *
+ * Every Port, Socket and Client is Served by one epoll Loop, so    *
+ * a Port costs a few Descriptors, a small Log Ring and a mostly    *
+ * Sleeping Logger Thread. A Client which cannot keep up is         *
+ * Detached, it never slows down the Capture. What the Clients and  *
+ * the Triggers Type is Queued for each Port, so a Port which stops *
+ * Draining ( Flow Control held off ) never stalls the others, once *
+ * it's Queue is Full the Input is Dropped. A Port which goes away  *
+ * ( an unplugged USB Adapter ) is Opened again every few Seconds.  *
+ *                                                                  *
+ * Each Line of a Hub File holds a Port :                           *
+ *                                                                  *
+ *      <Port> <Baud Rate> <Log File> <Socket> [Format] [Flow]      *
+ *                                                                  *
+ * Such as : /dev/ttyUSB0 115200 Board1.log Board1.sock 8N1 none    *
+ *                                                                  *
+ * Optional Lines set the Logging of every Port :                   *
+ *                                                                  *
+ *      Rotate <Size> [Seconds]                                     *
+ *      Stamp none|lines|chunks                                     *
+ *      Ring <Size>                 ( 256K by Default )             *
+ *      Triggers <Trigger File>     ( See Trigger.h )               *
+ *      Events <File>               ( Standard Error by Default )   *
+ *                                                                  *
+ * Everything following a # is a Comment.                           *
+ *                                                                  *
+ * ******************************************************************
+ */
+
+#ifndef SERIAL_HUB_H
+#define SERIAL_HUB_H
+
+#include "SerialPort.h"
+#include "SerialLog.h"
+#include "Trigger.h"
+
+// The Default Log Ring of each Port, about 20 Seconds of Data at 115200 Baud
+
+#define HUB_RING_SIZE (256 * 1024)
+
+typedef struct
+{
+    char * PortName;
+    
+    SerialSettings Settings;
+    
+    char * LogFile;
+    
+    char * SocketPath;
+    
+    // The Port, -1 while it is Closed
+    
+    int Descriptor;
+    
+    int Listener;
+    
+    SerialLog * Log;
+    
+    // The Bytes Typed on the Port which it did not Take yet, Allocated when first Needed
+    
+    BYTE * Queue;
+    
+    int Queued;
+    
+    // The Attached Clients
+    
+    int * Clients;
+    
+    int ClientCount;
+    
+    int ClientSpace;
+    
+    // When the Port is Opened again, in Monotonic Seconds
+    
+    QWORD RetryAt;
+    
+    QWORD Bytes;
+    
+    TriggerState Matching;
+
+} HubPort;
+
+typedef struct
+{
+    HubPort * Ports;
+    
+    int Count;
+    
+    LogSettings Logging;
+    
+    // The Triggers Matched on every Port, or NULL
+    
+    TriggerSet * Triggers;
+
+} Hub;
+
+// Reads a Hub File, any Syntax Error ends the Application
+
+Hub LoadHub(char * FileName);
+
+// Serves every Port of the Hub until SIGINT, SIGTERM or SIGHUP, Returns 0 or -1
+
+int RunHub(Hub * Ports);
+
+void FreeHub(Hub * Ports);
+
+#endif
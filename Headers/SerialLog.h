@@ -0,0 +1,133 @@
+/********************************************************************
+ *                  Serial Logger Header File                       *
+ *                                                                  *
+ *  [   Author  ]       -       Andrew Borg                         *
+ *  [   Type    ]       -       Serial Port Connector               *
+ *  [   Date    ]       -       19.01.2013                          *
+ *                                                                  *
+ * ******************************************************************
+ *                                                                  *
+ *  Description                                                     *
+ *                                                                  *
+ * The Serial Logger writes the Data read from a Port to a Log      *
+ * File from it's own Thread, so that a slow Disk never stalls      *
+ * the Port Reader.                                                 *
+ *                                                                  *
+ * The Reader copies each Chunk, with the Monotonic Time it was     *
+ * Read at, inside a Single Producer / Single Consumer Ring. The    *
+ * Ring is Lock Free : the Reader only moves the Head and the       *
+ * Logger only moves the Tail. The Logger wakes up at most once     *
+ * per Batch Window and writes everything Pending in one Go.        *
+ *                                                                  *
+ * The Log is either Raw ( the exact Bytes ), or Text with a        *
+ * Timestamp in front of every Line or of every Chunk. It can be    *
+ * Rotated once it reaches a Size, or an Age. Rotated Logs are      *
+ * Renamed to <Log>.1, <Log>.2 ...                                  *
+ *                                                                  *
+ * ******************************************************************
+ */
+
+#ifndef SERIAL_LOG_H
+#define SERIAL_LOG_H
+
+#include <pthread.h>
+#include <stdatomic.h>
+
+#include "Sizes.h"
+
+// Timestamp Modes
+
+#define STAMP_NONE      0
+#define STAMP_LINES     1
+#define STAMP_CHUNKS    2
+
+// The Default Ring Size, 16 MB hold about 50 Seconds of Data at 3 Mbaud
+
+#define LOG_RING_SIZE (16 * 1024 * 1024)
+
+typedef struct
+{
+    // One of the Timestamp Modes, Raw Logs use STAMP_NONE
+    
+    int Timestamps;
+    
+    // Rotate once the Log holds this many Bytes, 0 to never Rotate by Size
+    
+    QWORD MaximumSize;
+    
+    // Rotate once the Log is this many Seconds old, 0 to never Rotate by Age
+    
+    QWORD MaximumAge;
+    
+    // The Ring Size, a Power of Two, 0 for LOG_RING_SIZE ( Smaller Rings suit many Slow Ports )
+    
+    QWORD RingSize;
+
+} LogSettings;
+
+typedef struct
+{
+    char * FileName;
+    
+    LogSettings Settings;
+    
+    int Descriptor;
+    
+    // The Ring, it's Size is a Power of Two
+    
+    BYTE * Ring;
+    
+    QWORD RingSize;
+    
+    // The Size of the Logger's Format Buffer
+    
+    QWORD BufferSize;
+    
+    // Written by the Reader only, and by the Logger only
+    
+    _Atomic QWORD Head;
+    _Atomic QWORD Tail;
+    
+    // Set by the Logger before it Sleeps, the Reader then Wakes it through the Event
+    
+    _Atomic int Sleeping;
+    
+    _Atomic int Closing;
+    
+    int Event;
+    
+    pthread_t Thread;
+    
+    // The Logger's State
+    
+    QWORD Start;
+    
+    QWORD Opened;
+    
+    QWORD Written;
+    
+    int AtLineStart;
+    
+    int Rotations;
+    
+    // The Number of times the Reader had to Wait because the Ring was Full
+    
+    _Atomic QWORD Stalls;
+    
+    QWORD Bytes;
+
+} SerialLog;
+
+// Opens the Log ( Truncated ) and Starts it's Logger Thread, Returns NULL on Error
+
+SerialLog * OpenSerialLog(char * FileName, LogSettings * Settings);
+
+// Queues a Chunk read from the Port, Called by the Reader only
+
+void LogData(SerialLog * Log, const BYTE * Data, QWORD Length);
+
+// Writes everything Queued, Stops the Logger Thread and Closes the Log
+
+void CloseSerialLog(SerialLog * Log);
+
+#endif
@@ -0,0 +1,88 @@
+/********************************************************************
+ *                  Serial Port Header File                         *
+ *                                                                  *
+ *  [   Author  ]       -       Andrew Borg                         *
+ *  [   Type    ]       -       Serial Port Connector               *
+ *  [   Date    ]       -       19.01.2013                          *
+ *                                                                  *
+ * ******************************************************************
+ *                                                                  *
+ *  Description                                                     *
+ *                                                                  *
+ * Opens and Configures a Serial Port through the Linux termios2    *
+ * Interface, which takes the Baud Rate as a Number ( BOTHER )      *
+ * instead of one of the Standard B0 - B230400 Constants.           *
+ *                                                                  *
+ * Any Rate the UART can generate is accepted, such as 460800,      *
+ * 921600, 1500000, 3000000 or Vendor specific Rates.               *
+ *                                                                  *
+ * ******************************************************************
+ */
+
+#ifndef SERIAL_PORT_H
+#define SERIAL_PORT_H
+
+// Flow Control Settings
+
+#define FLOW_NONE       'N'
+#define FLOW_HARDWARE   'H'
+#define FLOW_SOFTWARE   'S'
+
+typedef struct
+{
+    unsigned int BaudRate;
+    
+    // Data Bits, from 5 to 8
+    
+    int DataBits;
+    
+    // N(one), E(ven) or O(dd)
+    
+    char Parity;
+    
+    // 1 or 2
+    
+    int StopBits;
+    
+    char FlowControl;
+
+} SerialSettings;
+
+// 115200 8N1, without Flow Control
+
+#define SERIAL_DEFAULTS { 115200, 8, 'N', 1, FLOW_NONE }
+
+// Opens the Port in Raw Non Blocking Mode and applies the Settings, Returns the Descriptor or -1
+
+int OpenSerialPort(char * PortName, SerialSettings * Settings);
+
+// Applies the Settings to an Open Port, Returns 0 or -1
+
+int ConfigureSerialPort(int Port, SerialSettings * Settings);
+
+// The Baud Rate the Driver actually Set, which can differ from the one Asked for, or 0
+
+unsigned int ActualBaudRate(int Port);
+
+// Reports Framing and Parity Errors inside the Data, as 0xFF 0x00 <Character>, until the Port is Configured again
+// Returns 0 or -1
+
+int MarkLineErrors(int Port);
+
+// Drops whatever was Received and not Read yet, Returns 0 or -1
+
+int FlushInput(int Port);
+
+// Parses a Frame Format such as 8N1 or 7E2, Returns 0 or -1
+
+int ParseSerialFormat(char * Text, SerialSettings * Settings);
+
+// Parses a Flow Control Name : none, rtscts or xonxoff, Returns 0 or -1
+
+int ParseFlowControl(char * Text, SerialSettings * Settings);
+
+// Writes a whole Buffer, waiting when the Descriptor is Full, Returns 0 or -1
+
+int WriteAll(int Descriptor, const unsigned char * Buffer, size_t Length);
+
+#endif
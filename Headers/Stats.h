@@ -0,0 +1,76 @@
+/********************************************************************
+ *                  Statistics Header File                          *
+ *                                                                  *
+ *  [   Author  ]       -       Andrew Borg                         *
+ *  [   Type    ]       -       Firmware Analysis                   *
+ *  [   Date    ]       -       02.01.2014                          *
+ *                                                                  *
+ * ******************************************************************
+ *                                                                  *
+ *  Description                                                     *
+ *                                                                  *
+ * Where the Time of a Tool goes. Enabled with --stats on the       *
+ * Command Line of any Tool, or with FWTOOLS_STATS in it's          *
+ * Environment :                                                    *
+ *                                                                  *
+ *      HexDump --stats -Strings Image.bin                          *
+ *      HexDump --stats=Stats.json -Strings Image.bin               *
+ *      FWTOOLS_STATS=1 BinarySearcher Image.bin                    *
+ *      FWTOOLS_STATS=Stats.json BinarySearcher Image.bin           *
+ *                                                                  *
+ * A Summary is Printed on the Standard Error when the Tool Exits,  *
+ * or JSON is Written to the File given.                            *
+ *                                                                  *
+ * Recorded : the Wall and CPU Time, Page Faults, Bytes Read and    *
+ * Written of each Phase, the Hits and Files of the Tool, the Peak  *
+ * RSS, and the CPU Time of each Thread of the Thread Pool.         *
+ *                                                                  *
+ * The Counters are kept by each Thread, without Locks. When the    *
+ * Statistics are Disabled, every Macro below is a single Test of   *
+ * StatsEnabled.                                                    *
+ *                                                                  *
+ * ******************************************************************
+ */
+
+#ifndef STATS_H
+#define STATS_H
+
+#include "Sizes.h"
+
+// The Counters kept by every Thread
+
+#define STAT_READ       0   // Bytes Read or Mapped
+#define STAT_WRITTEN    1   // Bytes Written
+#define STAT_HITS       2   // Signatures, Strings, Partitions or Entries Found
+#define STAT_FILES      3   // Files Written
+
+#define STAT_COUNTERS   4
+
+extern int StatsEnabled;
+
+// Enables the Statistics when --stats is Passed ( it is then Removed from argv ) or FWTOOLS_STATS is Set
+
+void InitStats(int * argc, char * argv[]);
+
+// A Phase is Timed from Begin to End, the Handle Returned by Begin is Passed to End
+
+int BeginPhase(const char * Name);
+void EndPhase(int Handle);
+
+void AddCounter(int Counter, QWORD Amount);
+
+// Names the Calling Thread inside the Report
+
+void RegisterThread(const char * Name);
+
+// Prints or Writes what was Recorded, then Starts Recording again
+
+void ReportStats();
+
+#define STATS_BEGIN(Name) (StatsEnabled ? BeginPhase(Name) : -1)
+
+#define STATS_END(Handle) do { if ((Handle) >= 0) EndPhase(Handle); } while (0)
+
+#define STATS_ADD(Counter, Amount) do { if (StatsEnabled) AddCounter(Counter, Amount); } while (0)
+
+#endif
@@ -0,0 +1,62 @@
+/********************************************************************
+ *                  Task Graph Header File                          *
+ *                                                                  *
+ *  [   Author  ]       -       Andrew Borg                         *
+ *  [   Type    ]       -       Firmware Analysis                   *
+ *  [   Date    ]       -       02.01.2014                          *
+ *                                                                  *
+ * ******************************************************************
+ *                                                                  *
+ *  Description                                                     *
+ *                                                                  *
+ * Tasks Run by the Workers of the Thread Pool, each once the Tasks *
+ * it Depends on are Done. The Graph grows while it Runs : a Task   *
+ * may Create Tasks, and make a Task which did not Start yet wait   *
+ * for them, as the Recursive Extractor does when a Container turns *
+ * out to hold more Files.                                          *
+ *                                                                  *
+ *      Task * Scan = CreateTask(Graph, ScanNode, Node);            *
+ *      Task * Done = CreateTask(Graph, FinishNode, Node);          *
+ *                                                                  *
+ *      AddDependency(Done, Scan);                                  *
+ *                                                                  *
+ *      SubmitTask(Scan);                                           *
+ *      SubmitTask(Done);                                           *
+ *                                                                  *
+ *      RunGraph(Graph);                                            *
+ *                                                                  *
+ * The Ready Tasks are Run Newest First, so a Deep Tree is Walked   *
+ * Depth First and it's Finished Branches Release their Memory      *
+ * early. A Task must not Call RunParallel.                         *
+ *                                                                  *
+ * ******************************************************************
+ */
+
+#ifndef TASK_GRAPH_H
+#define TASK_GRAPH_H
+
+typedef struct Task Task;
+
+typedef struct TaskGraph TaskGraph;
+
+typedef void (* TaskWork)(void * Context);
+
+TaskGraph * CreateGraph();
+
+// A Task is not Run before it is Submitted, every Task Created has to be Submitted
+
+Task * CreateTask(TaskGraph * Graph, TaskWork Work, void * Context);
+
+// Later will Run once Earlier is Done, Later must not have Started
+
+void AddDependency(Task * Later, Task * Earlier);
+
+void SubmitTask(Task * Item);
+
+// Runs the Graph on the Thread Pool, until no Task is left
+
+void RunGraph(TaskGraph * Graph);
+
+void FreeGraph(TaskGraph * Graph);
+
+#endif
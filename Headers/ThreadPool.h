@@ -0,0 +1,38 @@
+/********************************************************************
+ *                  Thread Pool Header File                         *
+ *                                                                  *
+ *  [   Author  ]       -       Andrew Borg                         *
+ *  [   Type    ]       -       Firmware Analysis                   *
+ *  [   Date    ]       -       02.01.2014                          *
+ *                                                                  *
+ * ******************************************************************
+ *                                                                  *
+ *  Description                                                     *
+ *                                                                  *
+ * A Pool of Worker Threads, one per CPU, shared by the Tools.      *
+ * The Workers are started on first use and are kept alive, so      *
+ * that repeated Parallel Loops do not pay the Thread Creation.     *
+ *                                                                  *
+ * ******************************************************************
+ */
+
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+// The Work Function is called once for every Index between 0 and Count - 1
+
+typedef void (* ParallelWork)(int Index, void * Context);
+
+// Runs the Work Function for every Index using the Pool, and Waits for all of them
+
+void RunParallel(int Count, ParallelWork Work, void * Context);
+
+// The Number of Workers inside the Pool
+
+int PoolSize();
+
+// 1 when Called from inside a Work Function, on any Thread
+
+int InParallelWork();
+
+#endif
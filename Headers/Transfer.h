@@ -0,0 +1,44 @@
+/********************************************************************
+ *                  File Transfer Header File                       *
+ *                                                                  *
+ *  [   Author  ]       -       Andrew Borg                         *
+ *  [   Type    ]       -       Serial Port Connector               *
+ *  [   Date    ]       -       19.01.2013                          *
+ *                                                                  *
+ * ******************************************************************
+ *                                                                  *
+ *  Description                                                     *
+ *                                                                  *
+ * Sends a File over a Serial Port to a Bootloader ( such as the    *
+ * U-Boot loadx and loady Commands ) or to rz.                      *
+ *                                                                  *
+ *  - XMODEM-1K : 1024 Byte Blocks with CRC16, each one Acked.      *
+ *                Falls back to 128 Byte Blocks with an Additive    *
+ *                Checksum when the Receiver asks for it.           *
+ *  - YMODEM    : XMODEM-1K preceded by a Block holding the File    *
+ *                Name and Size, ended by an Empty Batch Block.     *
+ *  - ZMODEM    : Streaming, the Data is never waited on. The       *
+ *                Receiver Acks every Window in the Background      *
+ *                ( ZCRCQ ), and asks to Resume from an Offset      *
+ *                when a Packet is Damaged. CRC32 is used when the  *
+ *                Receiver supports it, CRC16 otherwise.            *
+ *                                                                  *
+ * ******************************************************************
+ */
+
+#ifndef TRANSFER_H
+#define TRANSFER_H
+
+#define PROTOCOL_XMODEM     0
+#define PROTOCOL_YMODEM     1
+#define PROTOCOL_ZMODEM     2
+
+// Parses a Protocol Name : xmodem, ymodem or zmodem, Returns the Protocol or -1
+
+int ParseProtocol(char * Text);
+
+// Sends a File over an Open Port with a Protocol, printing the Progress, Returns 0 or -1
+
+int SendFile(int Port, char * FileName, int Protocol);
+
+#endif
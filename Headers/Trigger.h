@@ -0,0 +1,170 @@
+/********************************************************************
+ *                  Serial Trigger Header File                      *
+ *                                                                  *
+ *  [   Author  ]       -       Andrew Borg                         *
+ *  [   Type    ]       -       Serial Port Connector               *
+ *  [   Date    ]       -       19.01.2013                          *
+ *                                                                  *
+ * ******************************************************************
+ *                                                                  *
+ *  Description                                                     *
+ *                                                                  *
+ * Matches a Set of Patterns against the Bytes read from a Port,    *
+ * as they arrive, and Fires an Action for every Match : Boot       *
+ * Markers, Kernel Panics, Bootloader Prompts ...                   *
+ *                                                                  *
+ * Every Pattern is compiled into a single Aho-Corasick Automaton,  *
+ * stored as a full Transition Table, so each Byte costs one        *
+ * Lookup whatever the Number of Patterns. The Automaton's State    *
+ * is kept between Chunks, a Pattern Split across two Reads is      *
+ * still Found.                                                     *
+ *                                                                  *
+ * Each Line of a Trigger File holds a Pattern :                    *
+ *                                                                  *
+ *      Event    "Kernel panic"                                     *
+ *      Reply    "Hit any key to stop autoboot"  "\r"               *
+ *      Command  "login:"  "notify-send Booted"                     *
+ *                                                                  *
+ *  - Event   : Writes a Timestamped Line to the Events Output.     *
+ *  - Reply   : Types the Argument on the Port ( and an Event ).    *
+ *  - Command : Runs the Argument with /bin/sh ( and an Event ),    *
+ *              SERIAL_PORT, SERIAL_TRIGGER and SERIAL_OFFSET       *
+ *              are set in it's Environment.                        *
+ *                                                                  *
+ * Patterns and Arguments are Quoted, and accept the \r \n \t \\    *
+ * \" and \xHH Escapes. A Line can also add every Signature of a    *
+ * Signature Database as an Event :                                 *
+ *                                                                  *
+ *      Signatures  Signatures/Database.DB                          *
+ *                                                                  *
+ * Everything following a # outside of Quotes is a Comment.         *
+ *                                                                  *
+ * ******************************************************************
+ */
+
+#ifndef TRIGGER_H
+#define TRIGGER_H
+
+#include <stdio.h>
+
+#include "Sizes.h"
+
+// Trigger Actions
+
+#define TRIGGER_EVENT       0
+#define TRIGGER_REPLY       1
+#define TRIGGER_COMMAND     2
+
+typedef struct
+{
+    // The Pattern with it's Unprintable Bytes shown as Dots, or the Signature's Name
+    
+    char * Name;
+    
+    BYTE * Pattern;
+    
+    int Length;
+    
+    int Action;
+    
+    // The Reply or the Command
+    
+    BYTE * Argument;
+    
+    int ArgumentLength;
+    
+    // The Next Trigger with the same Pattern, or -1
+    
+    int Same;
+    
+    QWORD Matches;
+
+} Trigger;
+
+typedef struct
+{
+    Trigger * Triggers;
+    
+    int Count;
+    
+    // The Automaton : a Transition Table of 256 Entries per Node
+    
+    int (* Next)[256];
+    
+    int NodeCount;
+    
+    // The Trigger whose Pattern Ends at a Node, and the next Node down the Failure Chain which Ends one, or -1
+    
+    int * Output;
+    
+    int * OutputLink;
+    
+    // Set for the Nodes where any Pattern Ends, the only thing Checked per Byte
+    
+    BYTE * Final;
+    
+    // Where the Events are Written, Line Buffered
+    
+    FILE * Events;
+
+} TriggerSet;
+
+typedef struct
+{
+    // The Name the Events give to the Stream, such as the Port
+    
+    char * Name;
+    
+    // The Automaton's Node, and the Bytes Matched so far
+    
+    int Node;
+    
+    QWORD Offset;
+    
+    QWORD Start;
+    
+    // Time spent Matching, to report the Cost per Chunk
+    
+    QWORD Chunks;
+    
+    QWORD Nanoseconds;
+    
+    // The Matches past CHUNK_MATCHES inside a single Chunk, which were never Fired
+    
+    QWORD Dropped;
+
+} TriggerState;
+
+// Types a Reply on the Port, Returns 0 or -1
+
+typedef int (* TriggerReply)(const BYTE * Data, QWORD Length, void * Context);
+
+// Reads a Trigger File and Builds it's Automaton, any Syntax Error ends the Application
+
+void LoadTriggers(TriggerSet * Set, char * FileName, FILE * Events);
+
+// Appends a Trigger, the Automaton has to be Built again afterwards
+
+void AddTrigger(TriggerSet * Set, char * Name, BYTE * Pattern, int Length, int Action, BYTE * Argument, int ArgumentLength);
+
+// Adds every Signature of a Signature Database as an Event, Returns the Count or -1
+
+int AddSignatureTriggers(TriggerSet * Set, char * DatabaseName);
+
+void BuildTriggers(TriggerSet * Set);
+
+// Starts Matching a new Stream
+
+void ResetTriggers(TriggerState * State, char * Name);
+
+// Matches a Chunk read from the Port, then Fires the Actions, Replies are passed to Reply ( or Dropped if NULL )
+
+void MatchTriggers(TriggerSet * Set, TriggerState * State, TriggerReply Reply, void * Context, const BYTE * Data, QWORD Length);
+
+// Prints the Matches and the Cost per Chunk of a Stream
+
+void PrintTriggerStats(TriggerSet * Set, TriggerState * State);
+
+void FreeTriggers(TriggerSet * Set);
+
+#endif
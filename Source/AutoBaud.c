@@ -0,0 +1,259 @@
+/* Automatic Baud Rate Detection */
+
+#define _GNU_SOURCE
+
+#include <poll.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "../Headers/AutoBaud.h"
+
+// The Rates Probed, the ones Consoles use the most come first
+
+static const unsigned int ProbeRates[] =
+{
+    115200, 57600, 38400, 9600, 19200, 230400, 460800, 921600, 1500000, 3000000,
+    2000000, 1000000, 4000000, 4800, 2400, 1200
+};
+
+// Words printed by Bootloaders, Kernels and Shells
+
+static const char * Tokens[] =
+{
+    "U-Boot", "=> ", "login", "Linux", "Starting", "Hit any key", "autoboot", "CFE", "RedBoot",
+    "Booting", "Kernel", "DRAM", "Uncompressing", "Loading", "[    0.", "BusyBox", "Password"
+};
+
+// A Sample stops once it holds this many Bytes, the Window may not be over yet
+
+#define SAMPLE_SIZE 1024
+
+// The Rounds over every Rate before giving Up, when the Console says Nothing
+
+#define PROBE_ROUNDS 8
+
+static QWORD Milliseconds()
+{
+    struct timespec Now;
+    
+    clock_gettime(CLOCK_MONOTONIC, &Now);
+    
+    return (QWORD) Now.tv_sec * 1000 + Now.tv_nsec / 1000000;
+}
+
+/*
+ *  The Score Sample Method will Score how much a Sample looks like a Console's
+ *  Text. The Error Marks of a Marked Sample are Counted, and not Scored as
+ *  Characters.
+ * 
+ *  Parameters:
+ *          The Sample and it's Length
+ *          1 if the Sample holds Error Marks, 0 for a Plain Capture
+ *          The Score to Fill
+ * 
+ *  Returns:
+ *          VOID
+ */
+
+void ScoreSample(const BYTE * Data, QWORD Length, int Marked, BaudScore * Score)
+{
+    memset(Score, 0, sizeof(BaudScore));
+    
+    QWORD Position = 0;
+    
+    while (Position < Length)
+    {
+        BYTE Character = Data[Position ++];
+        
+        // 0xFF 0xFF is a Real 0xFF, 0xFF 0x00 X is an Error on X ( or a Break when X is 0 )
+        
+        if (Marked && Character == 0xFF && Position < Length)
+        {
+            if (Data[Position] == 0xFF)
+            {
+                Position ++;
+            }
+            else if (Data[Position] == 0x00 && Position + 1 < Length)
+            {
+                Position += 2;
+                
+                Score -> Errors ++;
+                
+                continue;
+            }
+        }
+        
+        Score -> Length ++;
+        
+        if ((Character >= 0x20 && Character <= 0x7E) || Character == '\r' || Character == '\n' || Character == '\t')
+        {
+            Score -> Printable ++;
+        }
+        
+        Score -> LineBreaks += Character == '\n';
+    }
+    
+    int Counter;
+    
+    for (Counter = 0; Counter < (int) (sizeof(Tokens) / sizeof(Tokens[0])); Counter ++)
+    {
+        Score -> Tokens += memmem(Data, Length, Tokens[Counter], strlen(Tokens[Counter])) != NULL;
+    }
+    
+    if (Score -> Length == 0)
+    {
+        return;
+    }
+    
+    double Printable = (double) Score -> Printable / Score -> Length;
+    
+    double Errors = (double) Score -> Errors / (Score -> Length + Score -> Errors);
+    
+    // A Few Characters can be Printable by Chance, Short Samples count for less
+    
+    double Confidence = (double) Score -> Length / (Score -> Length + 16);
+    
+    Score -> Score = Confidence * (Printable - 2 * Errors) + 0.05 * (Score -> Tokens < 4 ? Score -> Tokens : 4);
+    
+    // Consoles break their Lines
+    
+    if (Score -> Length >= 160 && Score -> LineBreaks == 0)
+    {
+        Score -> Score -= 0.2;
+    }
+}
+
+/*
+ *  The Sample Rate Method will Switch the Port to a Rate, Drop what was Read
+ *  at the Previous one, and Read for a Window long enough for about 64
+ *  Characters ( between 20 and 80 ms ).
+ */
+
+static QWORD SampleRate(int Port, SerialSettings * Settings, unsigned int Rate, BYTE * Sample)
+{
+    Settings -> BaudRate = Rate;
+    
+    if (ConfigureSerialPort(Port, Settings) != 0)
+    {
+        return 0;
+    }
+    
+    MarkLineErrors(Port);
+    
+    FlushInput(Port);
+    
+    QWORD Window = 64 * 10 * 1000ULL / Rate;
+    
+    Window = Window < 20 ? 20 : Window > 80 ? 80 : Window;
+    
+    QWORD Deadline = Milliseconds() + Window, Now;
+    
+    QWORD Length = 0;
+    
+    struct pollfd Descriptor = { Port, POLLIN, 0 };
+    
+    while (Length < SAMPLE_SIZE && (Now = Milliseconds()) < Deadline)
+    {
+        if (poll(&Descriptor, 1, Deadline - Now) <= 0)
+        {
+            continue;
+        }
+        
+        ssize_t Read = read(Port, Sample + Length, SAMPLE_SIZE - Length);
+        
+        if (Read > 0)
+        {
+            Length += Read;
+        }
+    }
+    
+    return Length;
+}
+
+/*
+ *  The Detect Baud Rate Method will Probe every Rate, in the Order of
+ *  ProbeRates, until one Locks. When none does, the Best Rate of the Round
+ *  is taken if it is Text at all. A Console which says Nothing is Probed for
+ *  a few Rounds, so the Board can be Reset meanwhile.
+ * 
+ *  Parameters:
+ *          An Open Port, and it's Settings ( the Baud Rate is Replaced )
+ *          1 to Print the Score of every Sample
+ * 
+ *  Returns:
+ *          The Rate Found, the Port is left Configured at it, or 0
+ */
+
+unsigned int DetectBaudRate(int Port, SerialSettings * Settings, int Verbose)
+{
+    static BYTE Sample[SAMPLE_SIZE];
+    
+    unsigned int Original = Settings -> BaudRate;
+    
+    QWORD Start = Milliseconds();
+    
+    int Round;
+    
+    for (Round = 0; Round < PROBE_ROUNDS; Round ++)
+    {
+        unsigned int Best = 0;
+        
+        double BestScore = 0;
+        
+        int Counter;
+        
+        for (Counter = 0; Counter < (int) (sizeof(ProbeRates) / sizeof(ProbeRates[0])); Counter ++)
+        {
+            QWORD Length = SampleRate(Port, Settings, ProbeRates[Counter], Sample);
+            
+            BaudScore Score;
+            
+            ScoreSample(Sample, Length, 1, &Score);
+            
+            if (Verbose)
+            {
+                printf("%10u : %5llu Characters, %3.0f%% Printable, %4llu Errors, %d Tokens, Score %5.2f \r\n", ProbeRates[Counter],
+                       (unsigned long long) Score.Length, Score.Length ? Score.Printable * 100.0 / Score.Length : 0,
+                       (unsigned long long) Score.Errors, Score.Tokens, Score.Score);
+            }
+            
+            if (Score.Score >= BAUD_LOCK_SCORE && Score.Length >= BAUD_LOCK_LENGTH)
+            {
+                Best = ProbeRates[Counter];
+                
+                break;
+            }
+            
+            if (Score.Length >= 16 && Score.Score > BestScore)
+            {
+                Best = ProbeRates[Counter];
+                
+                BestScore = Score.Score;
+            }
+        }
+        
+        if (Best && (BestScore >= 0.5 || Counter < (int) (sizeof(ProbeRates) / sizeof(ProbeRates[0]))))
+        {
+            Settings -> BaudRate = Best;
+            
+            // Configuring the Port again also Stops the Error Marks
+            
+            ConfigureSerialPort(Port, Settings);
+            
+            if (Verbose)
+            {
+                printf("Locked on %u Baud in %llu ms \r\n", Best, (unsigned long long) (Milliseconds() - Start));
+            }
+            
+            return Best;
+        }
+    }
+    
+    Settings -> BaudRate = Original;
+    
+    ConfigureSerialPort(Port, Settings);
+    
+    return 0;
+}
@@ -22,6 +22,9 @@
  *  - Parameters:                                                   *
  *              char * FileName                                     *
  *                  - The FileName of the Binary to Analyse         *   
+ *              Layout * Map                                        *
+ *                  - A Layout to Fill with the Signature Hits,     *
+ *                    used by -Map to feed the Splitter ( or NULL ) *
  *  - Returns:                                                      *
  *              VOID                                                *
  *                                                                  *
@@ -79,8 +82,10 @@
 
 #include <sqlite3.h>
 #include <string.h>
+#include <sys/stat.h>
 
 #include "../Headers/Common.h"
+#include "../Headers/Layout.h"
 
 #define DATABASE "Database.DB"
 
@@ -101,36 +106,75 @@ SignatureRow * GetSignatures(char * DatabaseName);
 
 // Function Prototype for the Signature Search Method
 
-void SignatureSearch(char * FileName);
+void SignatureSearch(char * FileName, Layout * Map);
 
 int SignatureCount;
 
+// The Database Searched, the Daemon Replaces it with an Absolute Path
+
+char * SignatureDatabase = DATABASE;
+
+// The Signatures Retrieved Last, Reused by the next Search of a Batch while the Database is Unchanged
+
+static SignatureRow * LoadedSignatures = NULL;
+
+static struct stat LoadedDatabase;
+
 // The Main Method for the Application
 
 // The Main Method will check for the Passed Arguments and redirect the Execution Flow Accordingly
 
 int main(int argc, char * argv[])
 {
+    InitStats(&argc, argv);
+    InitOutput(&argc, argv);
+    
+    // With -Map, the Signature Hits are also Written to a Layout File, for the Splitter
+    
+    if (argc == 4 && strcmp(argv[1], "-Map") == 0)
+    {
+        Layout Map = { NULL, 0, 0, 0xFF };
+        
+        OutputText("Binary Searcher \r\n\r\n\n");
+        SignatureSearch(argv[3], &Map);
+        
+        FILE * File = FileOpener(argv[2], "w");
+        
+        fprintf(File, "# Signatures Found inside %s\n", argv[3]);
+        
+        SortLayout(&Map);
+        WriteLayout(&Map, File);
+        
+        fclose(File);
+        
+        OutputText("%d Signature Hits Written to %s \r\n", Map.Count, argv[2]);
+        
+        FreeLayout(&Map);
+    }
+    
     // If The Total Number of Arguments is not Equal to Two, show the Syntax
     
-    if (argc != 2)
+    else if (argc != 2)
     {
         puts("Syntax: \r\n");
         printf("\t\t %s FILE \r\n", argv[0]);
+        printf("\t\t %s -Map LAYOUTFILE FILE \r\n", argv[0]);
     }
     // Else Redurect to the Signature Search Method
     
     else 
     {
-        puts("Binary Searcher \r\n\r\n");
-        SignatureSearch(argv[1]);
+        OutputText("Binary Searcher \r\n\r\n\n");
+        SignatureSearch(argv[1], NULL);
     }
+    
+    return 0;
 }
 
 // This Method will Search the Binary File for Signatures which may reveal contents inside the File
 // The Signatures are Stored inside the SQLITE Database and are Retrieved via the Get Signatures Method
 
-void SignatureSearch(char * FileName)
+void SignatureSearch(char * FileName, Layout * Map)
 {
     
     // Get the Hex Equivalent of the Binary File
@@ -145,7 +189,13 @@ void SignatureSearch(char * FileName)
         
     // Retrieve the Signatures from the Database File
     
-    SignatureRow  * Signatures = GetSignatures(DATABASE);
+    int Phase = STATS_BEGIN("Signatures");
+    
+    SignatureRow  * Signatures = GetSignatures(SignatureDatabase);
+    
+    STATS_END(Phase);
+    
+    Phase = STATS_BEGIN("Scan");
     
     int SignatureByteCounter = 0;
     
@@ -169,7 +219,27 @@ void SignatureSearch(char * FileName)
             
             // Print The Offset, along with a brief description of the found File
             
-            printf("%s was Found at Offset 0x%X \r\n", Signatures[Counter].Description, Offset);
+            EmitSignature(FileName, Signatures[Counter].Name, Signatures[Counter].Description, Offset);
+            
+            // Each Hit starts a Partition, which ends where the Next one Starts
+            
+            if (Map)
+            {
+                char Name[64];
+                
+                snprintf(Name, sizeof(Name), "%s_0x%X.bin", Signatures[Counter].Name, Offset);
+                
+                // Layout Fields are Separated by Spaces
+                
+                char * Space;
+                
+                while ((Space = strpbrk(Name, " \t#/")) != NULL)
+                {
+                    *Space = '_';
+                }
+                
+                AddLayoutEntry(Map, Name, Offset, SIZE_TO_NEXT, 0xFF);
+            }
             
             // Increment the File Found Variable
             
@@ -183,7 +253,9 @@ void SignatureSearch(char * FileName)
         // If any file was Found, print Summary
         
         if (FilesFound > 0)
-            printf("\t%d %s Partitions Found ! \r\n\r\n", FilesFound, Signatures[Counter].Name);
+            OutputText("\t%d %s Partitions Found ! \r\n\r\n", FilesFound, Signatures[Counter].Name);
+        
+        STATS_ADD(STAT_HITS, FilesFound);
         
         // Free the Pointer to Prevent Memory Leaks
         
@@ -194,6 +266,8 @@ void SignatureSearch(char * FileName)
         Counter ++;
         
     }
+    
+    STATS_END(Phase);
 }
 
 // This Method will retrieve all the information inside the SQLITE Database.
@@ -209,6 +283,28 @@ SignatureRow * GetSignatures(char * DatabaseName)
     
     const char * End;
     
+    struct stat Status;
+    
+    // A Batch Searching many Files only Reads the Database once
+    
+    if (LoadedSignatures && stat(DatabaseName, &Status) == 0 && Status.st_ino == LoadedDatabase.st_ino &&
+        Status.st_size == LoadedDatabase.st_size && Status.st_mtim.tv_sec == LoadedDatabase.st_mtim.tv_sec &&
+        Status.st_mtim.tv_nsec == LoadedDatabase.st_mtim.tv_nsec)
+    {
+        int Counter;
+        
+        for (Counter = 0; Counter < SignatureCount; Counter ++)
+        {
+            OutputText("Getting Signature for: %s \r\n", LoadedSignatures[Counter].Name);
+        }
+        
+        OutputText("----------------------------------------");
+        
+        OutputText("\r\n\r\n");
+        
+        return LoadedSignatures;
+    }
+    
     // Open the Database
     
     int Error = sqlite3_open(DatabaseName, &Connection);
@@ -240,6 +336,8 @@ SignatureRow * GetSignatures(char * DatabaseName)
         SignatureCount = sqlite3_column_int(Result, 0);
     }
     
+    sqlite3_finalize(Result);
+    
     // Retrieve the Signatures inside the Database
     
     Error = sqlite3_prepare_v2(Connection, "SELECT Name, Description, Signature, Length(Signature) FROM Signatures", 100, &Result, &End);
@@ -281,7 +379,7 @@ SignatureRow * GetSignatures(char * DatabaseName)
         
         unsigned char TempSignature[20];
         
-        printf("Getting Signature for: %s \r\n", Temp.Name);
+        OutputText("Getting Signature for: %s \r\n", Temp.Name);
         
         int ByteCounter = 0;
         
@@ -316,10 +414,21 @@ SignatureRow * GetSignatures(char * DatabaseName)
         
     }
     
-    printf("----------------------------------------");
+    OutputText("----------------------------------------");
+    
+    OutputText("\r\n\r\n");
+    
+    sqlite3_finalize(Result);
+    
+    sqlite3_close(Connection);
+    
+    // Keep the Signatures for the next Search
+    
+    free(LoadedSignatures);
     
-    printf("\r\n\r\n");
+    LoadedSignatures = Signatures;
     
+    stat(DatabaseName, &LoadedDatabase);
     
     // Return all the Signatures Retrieved from the database
     return Signatures;
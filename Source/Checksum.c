@@ -0,0 +1,397 @@
+/* Checksums */
+
+#include <stdio.h>
+#include <string.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define X86_CHECKSUMS
+#endif
+
+#include "../Headers/Checksum.h"
+
+// The Reflected Polynomials of each Checksum
+
+#define CRC32_POLYNOMIAL 0xEDB88320
+#define CRC32C_POLYNOMIAL 0x82F63B78
+
+// CRC16 is not Reflected, it's Polynomial is used as is
+
+#define CRC16_POLYNOMIAL 0x1021
+
+// The Slice by 8 Lookup Tables, Generated at Start Up
+
+static DWORD Crc32Table[8][256];
+static DWORD Crc32CTable[8][256];
+static WORD Crc16Table[8][256];
+
+// The Implementation used by each Checksum, Selected at Start Up
+
+typedef DWORD (* ChecksumMethod)(DWORD Checksum, const BYTE * Data, QWORD Length);
+
+static ChecksumMethod Crc32Method;
+static ChecksumMethod Crc32CMethod;
+
+static const char * Crc32Engine = "Slice by 8";
+static const char * Crc32CEngine = "Slice by 8";
+
+static char EngineName[64];
+
+/*
+ *  The Generate Table Method will fill the Eight Lookup Tables of a Polynomial.
+ *  Table 0 is the classic Byte at a Time Table, each following Table
+ *  advances the Checksum over one more Zero Byte.
+ */
+
+static void GenerateTable(DWORD Table[8][256], DWORD Polynomial)
+{
+    DWORD Byte;
+    
+    for (Byte = 0; Byte < 256; Byte ++)
+    {
+        DWORD Value = Byte;
+        
+        int Bit;
+        
+        for (Bit = 0; Bit < 8; Bit ++)
+        {
+            Value = (Value >> 1) ^ (Value & 1 ? Polynomial : 0);
+        }
+        
+        Table[0][Byte] = Value;
+    }
+    
+    for (Byte = 0; Byte < 256; Byte ++)
+    {
+        int Slice;
+        
+        for (Slice = 1; Slice < 8; Slice ++)
+        {
+            Table[Slice][Byte] = (Table[Slice - 1][Byte] >> 8) ^ Table[0][Table[Slice - 1][Byte] & 0xFF];
+        }
+    }
+}
+
+/*
+ *  The Slice by 8 Method will update a Checksum Eight Bytes at a time,
+ *  using one Table Lookup per Byte but no Dependency between the Lookups.
+ *  The Checksum is passed and returned in it's Inverted ( Internal ) Form.
+ */
+
+static DWORD SliceBy8(DWORD Table[8][256], DWORD Checksum, const BYTE * Data, QWORD Length)
+{
+    while (Length >= 8)
+    {
+        DWORD Low, High;
+        
+        memcpy(&Low, Data, 4);
+        memcpy(&High, Data + 4, 4);
+        
+        Low ^= Checksum;
+        
+        Checksum = Table[7][Low & 0xFF] ^ Table[6][(Low >> 8) & 0xFF] ^ Table[5][(Low >> 16) & 0xFF] ^ Table[4][Low >> 24]
+                 ^ Table[3][High & 0xFF] ^ Table[2][(High >> 8) & 0xFF] ^ Table[1][(High >> 16) & 0xFF] ^ Table[0][High >> 24];
+        
+        Data += 8;
+        Length -= 8;
+    }
+    
+    while (Length --)
+    {
+        Checksum = Table[0][(Checksum ^ *Data ++) & 0xFF] ^ (Checksum >> 8);
+    }
+    
+    return Checksum;
+}
+
+static DWORD Crc32Slice(DWORD Checksum, const BYTE * Data, QWORD Length)
+{
+    return ~SliceBy8(Crc32Table, ~Checksum, Data, Length);
+}
+
+static DWORD Crc32CSlice(DWORD Checksum, const BYTE * Data, QWORD Length)
+{
+    return ~SliceBy8(Crc32CTable, ~Checksum, Data, Length);
+}
+
+#ifdef X86_CHECKSUMS
+
+/*
+ *  The Fold Method will compute the CRC32 of Length Bytes ( At Least 64, and a
+ *  Multiple of 16 ) using Carry-Less Multiplication, as described in Intel's
+ *  "Fast CRC Computation for Generic Polynomials Using PCLMULQDQ Instruction".
+ * 
+ *  Four 128 Bit Lanes are Folded 64 Bytes at a time, then Folded into one Lane,
+ *  which is reduced to 64 Bits and finally to 32 Bits with a Barrett Reduction.
+ *  The Checksum is passed and returned in it's Inverted ( Internal ) Form.
+ */
+
+__attribute__((target("pclmul,sse4.1")))
+static DWORD Fold(DWORD Checksum, const BYTE * Data, QWORD Length)
+{
+    // The Folding Constants of the Reflected Polynomial ( x^(4*128+32) mod P, x^(4*128-32) mod P, ... )
+    
+    const __m128i K1K2 = _mm_set_epi64x(0x01C6E41596, 0x0154442BD4);
+    const __m128i K3K4 = _mm_set_epi64x(0x00CCAA009E, 0x01751997D0);
+    const __m128i K5K0 = _mm_set_epi64x(0x0000000000, 0x0163CD6124);
+    
+    // The Polynomial and it's Barrett Constant ( Mu )
+    
+    const __m128i Polynomial = _mm_set_epi64x(0x01F7011641, 0x01DB710641);
+    
+    const __m128i Mask = _mm_setr_epi32(~0, 0, ~0, 0);
+    
+    __m128i X0, X1, X2, X3, X4, X5, X6, X7, X8;
+    
+    X1 = _mm_loadu_si128((const __m128i *) (Data + 0x00));
+    X2 = _mm_loadu_si128((const __m128i *) (Data + 0x10));
+    X3 = _mm_loadu_si128((const __m128i *) (Data + 0x20));
+    X4 = _mm_loadu_si128((const __m128i *) (Data + 0x30));
+    
+    X1 = _mm_xor_si128(X1, _mm_cvtsi32_si128(Checksum));
+    
+    Data += 64;
+    Length -= 64;
+    
+    // Fold the Four Lanes over each following Block of 64 Bytes
+    
+    while (Length >= 64)
+    {
+        X5 = _mm_clmulepi64_si128(X1, K1K2, 0x00);
+        X6 = _mm_clmulepi64_si128(X2, K1K2, 0x00);
+        X7 = _mm_clmulepi64_si128(X3, K1K2, 0x00);
+        X8 = _mm_clmulepi64_si128(X4, K1K2, 0x00);
+        
+        X1 = _mm_clmulepi64_si128(X1, K1K2, 0x11);
+        X2 = _mm_clmulepi64_si128(X2, K1K2, 0x11);
+        X3 = _mm_clmulepi64_si128(X3, K1K2, 0x11);
+        X4 = _mm_clmulepi64_si128(X4, K1K2, 0x11);
+        
+        X1 = _mm_xor_si128(_mm_xor_si128(X1, X5), _mm_loadu_si128((const __m128i *) (Data + 0x00)));
+        X2 = _mm_xor_si128(_mm_xor_si128(X2, X6), _mm_loadu_si128((const __m128i *) (Data + 0x10)));
+        X3 = _mm_xor_si128(_mm_xor_si128(X3, X7), _mm_loadu_si128((const __m128i *) (Data + 0x20)));
+        X4 = _mm_xor_si128(_mm_xor_si128(X4, X8), _mm_loadu_si128((const __m128i *) (Data + 0x30)));
+        
+        Data += 64;
+        Length -= 64;
+    }
+    
+    // Fold the Four Lanes into One
+    
+    X5 = _mm_clmulepi64_si128(X1, K3K4, 0x00);
+    X1 = _mm_clmulepi64_si128(X1, K3K4, 0x11);
+    X1 = _mm_xor_si128(_mm_xor_si128(X1, X2), X5);
+    
+    X5 = _mm_clmulepi64_si128(X1, K3K4, 0x00);
+    X1 = _mm_clmulepi64_si128(X1, K3K4, 0x11);
+    X1 = _mm_xor_si128(_mm_xor_si128(X1, X3), X5);
+    
+    X5 = _mm_clmulepi64_si128(X1, K3K4, 0x00);
+    X1 = _mm_clmulepi64_si128(X1, K3K4, 0x11);
+    X1 = _mm_xor_si128(_mm_xor_si128(X1, X4), X5);
+    
+    // Fold the Remaining Blocks of 16 Bytes
+    
+    while (Length >= 16)
+    {
+        X5 = _mm_clmulepi64_si128(X1, K3K4, 0x00);
+        X1 = _mm_clmulepi64_si128(X1, K3K4, 0x11);
+        X1 = _mm_xor_si128(_mm_xor_si128(X1, _mm_loadu_si128((const __m128i *) Data)), X5);
+        
+        Data += 16;
+        Length -= 16;
+    }
+    
+    // Reduce 128 Bits to 64 Bits
+    
+    X2 = _mm_clmulepi64_si128(X1, K3K4, 0x10);
+    X1 = _mm_srli_si128(X1, 8);
+    X1 = _mm_xor_si128(X1, X2);
+    
+    X2 = _mm_srli_si128(X1, 4);
+    X1 = _mm_and_si128(X1, Mask);
+    X1 = _mm_clmulepi64_si128(X1, K5K0, 0x00);
+    X1 = _mm_xor_si128(X1, X2);
+    
+    // Barrett Reduction to 32 Bits
+    
+    X0 = _mm_and_si128(X1, Mask);
+    X0 = _mm_clmulepi64_si128(X0, Polynomial, 0x10);
+    X0 = _mm_and_si128(X0, Mask);
+    X0 = _mm_clmulepi64_si128(X0, Polynomial, 0x00);
+    X1 = _mm_xor_si128(X1, X0);
+    
+    return _mm_extract_epi32(X1, 1);
+}
+
+static DWORD Crc32Fold(DWORD Checksum, const BYTE * Data, QWORD Length)
+{
+    Checksum = ~Checksum;
+    
+    // Short Buffers are not worth the Set Up of the Folding Lanes
+    
+    if (Length >= 64)
+    {
+        QWORD Folded = Length & ~(QWORD) 15;
+        
+        Checksum = Fold(Checksum, Data, Folded);
+        
+        Data += Folded;
+        Length -= Folded;
+    }
+    
+    return ~SliceBy8(Crc32Table, Checksum, Data, Length);
+}
+
+/*
+ *  The CRC32C Hardware Method will use the SSE 4.2 CRC32 Instruction,
+ *  which implements the Castagnoli Polynomial, Eight Bytes at a time.
+ */
+
+__attribute__((target("sse4.2")))
+static DWORD Crc32CHardware(DWORD Checksum, const BYTE * Data, QWORD Length)
+{
+#ifdef __x86_64__
+    QWORD Value = ~Checksum;
+    
+    while (Length >= 8)
+    {
+        QWORD Word;
+        
+        memcpy(&Word, Data, 8);
+        
+        Value = _mm_crc32_u64(Value, Word);
+        
+        Data += 8;
+        Length -= 8;
+    }
+    
+    DWORD Result = Value;
+#else
+    DWORD Result = ~Checksum;
+#endif
+    
+    while (Length --)
+    {
+        Result = _mm_crc32_u8(Result, *Data ++);
+    }
+    
+    return ~Result;
+}
+
+#endif
+
+/*
+ *  The Generate Crc16 Table Method fills the Slice by 8 Tables of CRC16. Table K
+ *  holds the Checksum of each Byte followed by K Zero Bytes.
+ */
+
+static void GenerateCrc16Table()
+{
+    DWORD Byte;
+    
+    for (Byte = 0; Byte < 256; Byte ++)
+    {
+        WORD Value = Byte << 8;
+        
+        int Bit;
+        
+        for (Bit = 0; Bit < 8; Bit ++)
+        {
+            Value = (Value << 1) ^ (Value & 0x8000 ? CRC16_POLYNOMIAL : 0);
+        }
+        
+        Crc16Table[0][Byte] = Value;
+    }
+    
+    for (Byte = 0; Byte < 256; Byte ++)
+    {
+        int Slice;
+        
+        for (Slice = 1; Slice < 8; Slice ++)
+        {
+            WORD Previous = Crc16Table[Slice - 1][Byte];
+            
+            Crc16Table[Slice][Byte] = (Previous << 8) ^ Crc16Table[0][Previous >> 8];
+        }
+    }
+}
+
+/*
+ *  The Select Engine Method Generates the Lookup Tables and picks the fastest
+ *  Implementation of each Checksum the CPU supports. It runs before main, so
+ *  the Checksums can be used from any Thread without Locking.
+ */
+
+__attribute__((constructor))
+static void SelectEngine()
+{
+    GenerateTable(Crc32Table, CRC32_POLYNOMIAL);
+    GenerateTable(Crc32CTable, CRC32C_POLYNOMIAL);
+    GenerateCrc16Table();
+    
+    Crc32Method = Crc32Slice;
+    Crc32CMethod = Crc32CSlice;
+    
+#ifdef X86_CHECKSUMS
+    __builtin_cpu_init();
+    
+    if (__builtin_cpu_supports("pclmul") && __builtin_cpu_supports("sse4.1"))
+    {
+        Crc32Method = Crc32Fold;
+        
+        Crc32Engine = "PCLMULQDQ Folding";
+    }
+    
+    if (__builtin_cpu_supports("sse4.2"))
+    {
+        Crc32CMethod = Crc32CHardware;
+        
+        Crc32CEngine = "SSE 4.2";
+    }
+#endif
+    
+    snprintf(EngineName, sizeof(EngineName), "CRC32 %s, CRC32C %s", Crc32Engine, Crc32CEngine);
+}
+
+DWORD Crc32(DWORD Checksum, const BYTE * Data, QWORD Length)
+{
+    return Crc32Method(Checksum, Data, Length);
+}
+
+DWORD Crc32C(DWORD Checksum, const BYTE * Data, QWORD Length)
+{
+    return Crc32CMethod(Checksum, Data, Length);
+}
+
+const char * ChecksumEngine()
+{
+    return EngineName;
+}
+
+/*
+ *  CRC16 is consumed Eight Bytes at a time : the Checksum is folded inside the
+ *  First Two Bytes, and each Byte is looked up in the Table matching the Number
+ *  of Bytes which follow it.
+ */
+
+WORD Crc16(WORD Checksum, const BYTE * Data, QWORD Length)
+{
+    while (Length >= 8)
+    {
+        WORD First = Checksum ^ ((Data[0] << 8) | Data[1]);
+        
+        Checksum = Crc16Table[7][First >> 8] ^ Crc16Table[6][First & 0xFF] ^ Crc16Table[5][Data[2]] ^ Crc16Table[4][Data[3]] ^
+                   Crc16Table[3][Data[4]] ^ Crc16Table[2][Data[5]] ^ Crc16Table[1][Data[6]] ^ Crc16Table[0][Data[7]];
+        
+        Data += 8;
+        Length -= 8;
+    }
+    
+    while (Length --)
+    {
+        Checksum = (Checksum << 8) ^ Crc16Table[0][(Checksum >> 8) ^ *Data ++];
+    }
+    
+    return Checksum;
+}
@@ -1,5 +1,17 @@
 /* Common Functions */
 
+#define _GNU_SOURCE
+
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <linux/fs.h>
+
 #include "../Headers/Common.h"
 
 unsigned long FileSize = 0;
@@ -23,60 +35,770 @@ FILE * FileOpener(char * Filename, char * ReadMode)
     return File;
 }
 
-char * DumpHex(char * FileName)
+// The Files kept Mapped by the Cache, with the Dumps made from them
+
+typedef struct
 {
+    // A File is only Found again while it's Device, Inode, Size and Modification Time are Unchanged
+    
+    dev_t Device;
+    
+    ino_t Inode;
+    
+    QWORD Size;
+    
+    QWORD Modified;
+    
+    BYTE * Map;
+    
+    // The Copies returned by DumpHex and DumpHexWithoutNulls, NULL until one is Requested
     
-    FILE *  File = FileOpener(FileName, "rb");
+    char * Dumps[2];
     
-    fseek(File, 0L, SEEK_END);
+    // The Mappings not yet Released by UnmapFile, a File in Use is never Dropped
+    
+    int Users;
+    
+    QWORD LastUse;
+
+} CachedFile;
+
+// The Most Files Cached at once, the Files Mapped past it are not Cached
+
+#define FILE_CACHE_ENTRIES 256
+
+static CachedFile * FileCache = NULL;
+
+static int CachedFiles = 0;
+
+static QWORD CacheBudget;
+
+static QWORD CacheClock;
+
+// The Packers Map Files from the Thread Pool's Workers
 
-    FileSize = ftell(File);
+static pthread_mutex_t CacheLock = PTHREAD_MUTEX_INITIALIZER;
+
+// A Process Forked while another Thread Updates the Cache gets it Unlocked and Whole
+
+static void LockCache()
+{
+    pthread_mutex_lock(&CacheLock);
+}
+
+static void UnlockCache()
+{
+    pthread_mutex_unlock(&CacheLock);
+}
+
+/*
+ *  The Enable File Cache Method will keep every File Mapped by MapFile, and
+ *  every Dump, once Released, so that the next Command of a Batch asking for
+ *  the same File finds it Ready. TrimFileCache Drops the Files no longer in
+ *  Use once the Cache holds more than it's Budget.
+ * 
+ *  Parameters:
+ *          The Bytes the Mappings and Dumps can hold between Commands
+ * 
+ *  Returns:
+ *          VOID
+ */
+
+void EnableFileCache(QWORD Budget)
+{
+    if (FileCache == NULL)
+    {
+        FileCache = calloc(FILE_CACHE_ENTRIES, sizeof(CachedFile));
+        
+        pthread_atfork(LockCache, UnlockCache, UnlockCache);
+    }
+    
+    CacheBudget = Budget;
+}
+
+// Finds a Cached File by it's Mapping, the Cache Lock has to be Held
+
+static CachedFile * FindMapping(BYTE * Map)
+{
+    int Counter;
+    
+    for (Counter = 0; Counter < CachedFiles; Counter ++)
+    {
+        if (FileCache[Counter].Map == Map)
+        {
+            return &FileCache[Counter];
+        }
+    }
+    
+    return NULL;
+}
+
+// Finds a Cached File by it's Status, the Cache Lock has to be Held
+
+static CachedFile * FindFile(struct stat * Status)
+{
+    int Counter;
+    
+    for (Counter = 0; Counter < CachedFiles; Counter ++)
+    {
+        CachedFile * Entry = &FileCache[Counter];
+        
+        if (Entry -> Device == Status -> st_dev && Entry -> Inode == Status -> st_ino && Entry -> Size == (QWORD) Status -> st_size &&
+            Entry -> Modified == (QWORD) Status -> st_mtim.tv_sec * 1000000000ULL + Status -> st_mtim.tv_nsec)
+        {
+            return Entry;
+        }
+    }
+    
+    return NULL;
+}
+
+void TrimFileCache()
+{
+    pthread_mutex_lock(&CacheLock);
+    
+    while (1)
+    {
+        QWORD Total = 0;
+        
+        int Oldest = -1;
+        
+        int Counter;
+        
+        for (Counter = 0; Counter < CachedFiles; Counter ++)
+        {
+            CachedFile * Entry = &FileCache[Counter];
+            
+            Total += Entry -> Size * (1 + (Entry -> Dumps[0] != NULL) + (Entry -> Dumps[1] != NULL));
+            
+            if (Entry -> Users == 0 && (Oldest < 0 || Entry -> LastUse < FileCache[Oldest].LastUse))
+            {
+                Oldest = Counter;
+            }
+        }
+        
+        if (Total <= CacheBudget || Oldest < 0)
+        {
+            break;
+        }
+        
+        munmap(FileCache[Oldest].Map, FileCache[Oldest].Size);
+        
+        free(FileCache[Oldest].Dumps[0]);
+        free(FileCache[Oldest].Dumps[1]);
+        
+        FileCache[Oldest] = FileCache[-- CachedFiles];
+    }
+    
+    pthread_mutex_unlock(&CacheLock);
+}
+
+/*
+ *  The Load Dump Method will copy a whole File inside a Buffer, followed by a
+ *  NULL Byte. The NULL Bytes of the File are replaced by 0xFF when asked, so
+ *  that String Functions can search the Buffer.
+ * 
+ *  The Global FileSize holds the Size of the File. With the File Cache, the
+ *  Buffer is owned by the Cache and Returned again for the same File.
+ */
+
+static char * LoadDump(char * FileName, int WithoutNulls)
+{
+    QWORD Size;
     
-    fseek(File, 0L, SEEK_SET);
+    int Phase = STATS_BEGIN("Load");
     
-    char * HexArray = malloc(FileSize);
+    BYTE * Map = MapFile(FileName, &Size);
+    
+    FileSize = Size;
+    
+    if (FileCache)
+    {
+        pthread_mutex_lock(&CacheLock);
+        
+        CachedFile * Entry = FindMapping(Map);
+        
+        char * Dump = Entry ? Entry -> Dumps[WithoutNulls] : NULL;
         
-    int Counter = 0;
+        pthread_mutex_unlock(&CacheLock);
+        
+        if (Dump)
+        {
+            UnmapFile(Map, Size);
+            
+            STATS_END(Phase);
+            
+            return Dump;
+        }
+    }
+    
+    char * HexArray = malloc(Size + 1);
     
-    while (Counter < FileSize)
-    {       
-        HexArray[Counter++] = fgetc(File);
+    memcpy(HexArray, Map, Size);
+    
+    HexArray[Size] = '\0';
+    
+    if (WithoutNulls)
+    {
+        char * Null = HexArray;
+        
+        while ((Null = memchr(Null, '\0', HexArray + Size - Null)) != NULL)
+        {
+            *Null++ = (char) 0xFF;
+        }
     }
     
+    // Trimming moves the Cached Files while Unlocked, and another Thread may have Loaded the same Dump meanwhile
+    
+    if (FileCache)
+    {
+        pthread_mutex_lock(&CacheLock);
+        
+        CachedFile * Entry = FindMapping(Map);
+        
+        if (Entry && Entry -> Dumps[WithoutNulls])
+        {
+            free(HexArray);
+            
+            HexArray = Entry -> Dumps[WithoutNulls];
+        }
+        else if (Entry)
+        {
+            Entry -> Dumps[WithoutNulls] = HexArray;
+        }
+        
+        pthread_mutex_unlock(&CacheLock);
+    }
+    
+    UnmapFile(Map, Size);
+    
+    STATS_END(Phase);
     
     return HexArray;
 }
 
+char * DumpHex(char * FileName)
+{
+    return LoadDump(FileName, 0);
+}
+
 char * DumpHexWithoutNulls(char * FileName)
 {
+    return LoadDump(FileName, 1);
+}
+
+/*
+ *  The Map File Method will map a whole File inside the Process' Memory
+ *  as Read Only. Unlike DumpHex no copy of the File is made, the Pages
+ *  are loaded by the Kernel only when accessed.
+ * 
+ *  With the File Cache, a File Mapped again while Unchanged returns the
+ *  same Mapping.
+ * 
+ *  Parameters:
+ *          A Char Array with the Name of the File being Mapped
+ *          A Pointer to a QWORD which will hold the Size of the File
+ * 
+ *  Returns:
+ *          A Pointer to the Mapped Bytes ( Never NULL, even for Empty Files )
+ */
+
+BYTE * MapFile(char * FileName, QWORD * Size)
+{
+    static BYTE EmptyFile[1];
+    
+    int Descriptor = open(FileName, O_RDONLY);
     
-    FILE *  File = FileOpener(FileName, "rb");
+    struct stat Status;
     
-    fseek(File, 0L, SEEK_END);
+    if (Descriptor < 0 || fstat(Descriptor, &Status) != 0)
+    {
+        puts("File Not Found");
+        exit(-1);
+    }
+    
+    *Size = Status.st_size;
+    
+    STATS_ADD(STAT_READ, *Size);
+    
+    // Zero Length Mappings are not allowed by mmap
+    
+    if (*Size == 0)
+    {
+        close(Descriptor);
+        
+        return EmptyFile;
+    }
+    
+    if (FileCache)
+    {
+        pthread_mutex_lock(&CacheLock);
+        
+        CachedFile * Entry = FindFile(&Status);
+        
+        if (Entry)
+        {
+            Entry -> Users ++;
+            
+            Entry -> LastUse = ++ CacheClock;
+        }
+        
+        pthread_mutex_unlock(&CacheLock);
+        
+        if (Entry)
+        {
+            close(Descriptor);
+            
+            return Entry -> Map;
+        }
+    }
+    
+    BYTE * Map = mmap(NULL, *Size, PROT_READ, MAP_PRIVATE, Descriptor, 0);
+    
+    // The Mapping stays valid after the Descriptor is Closed
+    
+    close(Descriptor);
+    
+    if (Map == MAP_FAILED)
+    {
+        puts("Error Reading File");
+        exit(-1);
+    }
+    
+    // The Files are mostly scanned from Start to End
+    
+    madvise(Map, *Size, MADV_SEQUENTIAL);
+    
+    if (FileCache)
+    {
+        pthread_mutex_lock(&CacheLock);
+        
+        // Another Thread may have Mapped the same File meanwhile
+        
+        CachedFile * Entry = FindFile(&Status);
+        
+        if (Entry)
+        {
+            munmap(Map, *Size);
+            
+            Map = Entry -> Map;
+            
+            Entry -> Users ++;
+            
+            Entry -> LastUse = ++ CacheClock;
+        }
+        else if (CachedFiles < FILE_CACHE_ENTRIES)
+        {
+            Entry = &FileCache[CachedFiles ++];
+            
+            memset(Entry, 0, sizeof(CachedFile));
+            
+            Entry -> Device = Status.st_dev;
+            Entry -> Inode = Status.st_ino;
+            Entry -> Size = *Size;
+            Entry -> Modified = (QWORD) Status.st_mtim.tv_sec * 1000000000ULL + Status.st_mtim.tv_nsec;
+            
+            Entry -> Map = Map;
+            Entry -> Users = 1;
+            Entry -> LastUse = ++ CacheClock;
+        }
+        
+        pthread_mutex_unlock(&CacheLock);
+    }
+    
+    return Map;
+}
 
-    FileSize = ftell(File);
+void UnmapFile(BYTE * Map, QWORD Size)
+{
+    if (Size == 0)
+    {
+        return;
+    }
     
-    fseek(File, 0L, SEEK_SET);
+    // Cached Mappings are kept for the next Command
     
-    char * HexArray = malloc(FileSize);
+    if (FileCache)
+    {
+        pthread_mutex_lock(&CacheLock);
+        
+        CachedFile * Entry = FindMapping(Map);
+        
+        if (Entry)
+        {
+            Entry -> Users --;
+        }
+        
+        pthread_mutex_unlock(&CacheLock);
+        
+        if (Entry)
+        {
+            return;
+        }
+    }
     
-    unsigned char Character;
+    munmap(Map, Size);
+}
+
+/*
+ *  The Copy Range Method will copy Length Bytes from one File to another
+ *  without passing the Data through User Space.
+ * 
+ *  The Cheapest Method the File System supports is used:
+ * 
+ *      - A Reflink ( FICLONERANGE ), sharing the Blocks of the Source.
+ *        Only possible on Copy on Write File Systems, with Block Aligned Offsets
+ *      - copy_file_range, copying the Data inside the Kernel
+ *      - A buffered pread / pwrite Loop
+ * 
+ *  The File Positions of both Descriptors are not modified.
+ * 
+ *  Parameters:
+ *          Source Descriptor and the Offset to Start Reading From
+ *          Destination Descriptor and the Offset to Start Writing To
+ *          The Number of Bytes to Copy
+ * 
+ *  Returns:
+ *          The Method used ( COPY_CLONED, COPY_KERNEL or COPY_BUFFERED ), or -1 on Error
+ */
+
+int CopyRange(int Source, QWORD SourceOffset, int Destination, QWORD DestinationOffset, QWORD Length)
+{
+    loff_t InOffset = SourceOffset;
+    loff_t OutOffset = DestinationOffset;
+    
+    int Method = COPY_KERNEL;
+    
+    STATS_ADD(STAT_READ, Length);
+    STATS_ADD(STAT_WRITTEN, Length);
+    
+    struct file_clone_range Clone = { Source, SourceOffset, Length, DestinationOffset };
     
-    int Counter = 0;
+    if (Length > 0 && ioctl(Destination, FICLONERANGE, &Clone) == 0)
+    {
+        return COPY_CLONED;
+    }
     
-    while (Counter < FileSize)
+    while (Length > 0)
     {
-        Character = fgetc(File);
+        ssize_t Copied = copy_file_range(Source, &InOffset, Destination, &OutOffset, Length, 0);
         
-        if (Character == '\0')
+        if (Copied > 0)
         {
-            Character = 0xFF;
+            Length -= Copied;
+            
+            continue;
         }
-        sprintf(HexArray  + Counter, "%c", Character);
         
-        Counter++;
+        // Zero means the Source ended early
+        
+        if (Copied == 0)
+        {
+            return -1;
+        }
+        
+        // Any other Error means the Copy has to be done in User Space
+        
+        if (errno == EINTR)
+        {
+            continue;
+        }
+        
+        break;
     }
     
+    if (Length == 0)
+    {
+        return Method;
+    }
     
-    return HexArray;
+    Method = COPY_BUFFERED;
+    
+    BYTE * Buffer = malloc(COPY_BUFFER_SIZE);
+    
+    if (Buffer == NULL)
+    {
+        return -1;
+    }
+    
+    while (Length > 0)
+    {
+        size_t Chunk = Length < COPY_BUFFER_SIZE ? Length : COPY_BUFFER_SIZE;
+        
+        ssize_t Read = pread(Source, Buffer, Chunk, InOffset);
+        
+        if (Read <= 0)
+        {
+            free(Buffer);
+            
+            return -1;
+        }
+        
+        if (WriteAt(Destination, Buffer, Read, OutOffset) != 0)
+        {
+            free(Buffer);
+            
+            return -1;
+        }
+        
+        InOffset += Read;
+        OutOffset += Read;
+        Length -= Read;
+    }
+    
+    free(Buffer);
+    
+    return Method;
+}
+
+/*
+ *  The Write At Method will write a Buffer at a given Offset of a File,
+ *  retrying on short writes until every Byte is Written.
+ * 
+ *  Parameters:
+ *          The Destination Descriptor
+ *          A Pointer to the Data and it's Length
+ *          The Offset inside the File to Start Writing To
+ * 
+ *  Returns:
+ *          0 on Success, -1 on Error
+ */
+
+int WriteAt(int Descriptor, const void * Data, QWORD Length, QWORD Offset)
+{
+    const BYTE * Pointer = Data;
+    
+    STATS_ADD(STAT_WRITTEN, Length);
+    
+    while (Length > 0)
+    {
+        ssize_t Written = pwrite(Descriptor, Pointer, Length, Offset);
+        
+        if (Written < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        
+        if (Written <= 0)
+        {
+            return -1;
+        }
+        
+        Pointer += Written;
+        Offset += Written;
+        Length -= Written;
+    }
+    
+    return 0;
+}
+
+/*
+ *  The Fill Range Method will Write Length Bytes of the same Value inside a
+ *  File, starting at Offset.
+ * 
+ *  A single Buffer is Filled once with the Value, and every Vector of each
+ *  Vectored Write points to it, so each System Call covers up to 64 MB.
+ *  The Buffer is shared, so the Method must not be called by two Threads at once.
+ * 
+ *  Parameters:
+ *          The Destination Descriptor
+ *          The Offset to Start Writing To and the Number of Bytes
+ *          The Byte Value to Write
+ * 
+ *  Returns:
+ *          0 on Success, -1 on Error
+ */
+
+#define FILL_VECTORS 64
+
+int FillRange(int Descriptor, QWORD Offset, QWORD Length, BYTE Value)
+{
+    static BYTE Fill[COPY_BUFFER_SIZE];
+    
+    static int FillValue = -1;
+    
+    if (FillValue != Value)
+    {
+        memset(Fill, Value, sizeof(Fill));
+        
+        FillValue = Value;
+    }
+    
+    struct iovec Vectors[FILL_VECTORS];
+    
+    STATS_ADD(STAT_WRITTEN, Length);
+    
+    while (Length > 0)
+    {
+        int Count = 0;
+        
+        QWORD Chunk = 0;
+        
+        while (Count < FILL_VECTORS && Chunk < Length)
+        {
+            Vectors[Count].iov_base = Fill;
+            Vectors[Count].iov_len = Length - Chunk < sizeof(Fill) ? Length - Chunk : sizeof(Fill);
+            
+            Chunk += Vectors[Count ++].iov_len;
+        }
+        
+        ssize_t Written = pwritev(Descriptor, Vectors, Count, Offset);
+        
+        if (Written < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        
+        if (Written <= 0)
+        {
+            return -1;
+        }
+        
+        Offset += Written;
+        
+        Length -= Written;
+    }
+    
+    return 0;
+}
+
+/*
+ *  The Parse Size Method will convert a Size given on the Command Line to a
+ *  64 Bit Value. The Size can be Decimal or Hexadecimal ( 0x Prefix ), and
+ *  can be followed by a K, M or G Suffix ( Multiples of 1024 ).
+ * 
+ *  Parameters:
+ *          A Char Array with the Size, for example 8M, 0x10000 or 2G
+ * 
+ *  Returns:
+ *          QWORD with the Size in Bytes
+ */
+
+QWORD ParseSize(char * Text)
+{
+    char * End;
+    
+    errno = 0;
+    
+    QWORD Size = strtoull(Text, &End, 0);
+    
+    QWORD Multiplier = 1;
+    
+    switch (*End)
+    {
+        case 'k':
+        case 'K':
+            Multiplier = 1ULL << 10;
+            End ++;
+            break;
+        
+        case 'm':
+        case 'M':
+            Multiplier = 1ULL << 20;
+            End ++;
+            break;
+        
+        case 'g':
+        case 'G':
+            Multiplier = 1ULL << 30;
+            End ++;
+            break;
+    }
+    
+    // Reject Negative Sizes, Trailing Characters and Overflows
+    
+    if (End == Text || *End != '\0' || errno != 0 || strchr(Text, '-') || Size > UINT64_MAX / Multiplier)
+    {
+        printf("Invalid Size %s \r\n", Text);
+        exit(-1);
+    }
+    
+    return Size * Multiplier;
+}
+
+/*
+ *  The Hash Content Method will generate a 64 Bit Hash of a Byte Array.
+ * 
+ *  The Data is consumed Eight Bytes at a time over Four independent Lanes,
+ *  which are merged and mixed at the End. The Hash is meant to detect
+ *  changed Content quickly, it is NOT a Cryptographic Hash.
+ * 
+ *  Parameters:
+ *          A Pointer to the Data and it's Length
+ * 
+ *  Returns:
+ *          QWORD with the Hash Value
+ */
+
+#define HASH_PRIME_1 0x9E3779B185EBCA87ULL
+#define HASH_PRIME_2 0xC2B2AE3D27D4EB4FULL
+#define HASH_PRIME_3 0x165667B19E3779F9ULL
+
+#define ROTATE_LEFT(Value, Bits) (((Value) << (Bits)) | ((Value) >> (64 - (Bits))))
+
+static QWORD HashRound(QWORD Lane, QWORD Input)
+{
+    Lane += Input * HASH_PRIME_2;
+    Lane = ROTATE_LEFT(Lane, 31);
+    
+    return Lane * HASH_PRIME_1;
+}
+
+QWORD HashContent(const BYTE * Data, QWORD Length)
+{
+    QWORD Lanes[4] = { HASH_PRIME_1 + HASH_PRIME_2, HASH_PRIME_2, 0, -HASH_PRIME_1 };
+    
+    QWORD Counter = 0;
+    
+    QWORD Word;
+    
+    // Consume 32 Bytes per Iteration
+    
+    while (Counter + 32 <= Length)
+    {
+        int Lane;
+        
+        for (Lane = 0; Lane < 4; Lane ++)
+        {
+            memcpy(&Word, Data + Counter + Lane * 8, 8);
+            
+            Lanes[Lane] = HashRound(Lanes[Lane], Word);
+        }
+        
+        Counter += 32;
+    }
+    
+    QWORD Hash = ROTATE_LEFT(Lanes[0], 1) + ROTATE_LEFT(Lanes[1], 7) + ROTATE_LEFT(Lanes[2], 12) + ROTATE_LEFT(Lanes[3], 18);
+    
+    Hash += Length * HASH_PRIME_3;
+    
+    // Consume the Remaining Words and Bytes
+    
+    while (Counter + 8 <= Length)
+    {
+        memcpy(&Word, Data + Counter, 8);
+        
+        Hash ^= HashRound(0, Word);
+        Hash = ROTATE_LEFT(Hash, 27) * HASH_PRIME_1 + HASH_PRIME_3;
+        
+        Counter += 8;
+    }
+    
+    while (Counter < Length)
+    {
+        Hash ^= Data[Counter] * HASH_PRIME_3;
+        Hash = ROTATE_LEFT(Hash, 11) * HASH_PRIME_1;
+        
+        Counter ++;
+    }
+    
+    // Final Avalanche
+    
+    Hash ^= Hash >> 33;
+    Hash *= HASH_PRIME_2;
+    Hash ^= Hash >> 29;
+    Hash *= HASH_PRIME_3;
+    Hash ^= Hash >> 32;
+    
+    return Hash;
 }
@@ -0,0 +1,1554 @@
+/* Firmware Tools Daemon */
+
+#define _GNU_SOURCE
+
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <pthread.h>
+#include <signal.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/inotify.h>
+#include <sys/signalfd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+
+#include "../Headers/Common.h"
+#include "../Headers/FWTools.h"
+#include "../Headers/Daemon.h"
+
+// The Binary Searcher's Database and Signature Loader, the Loaded Rows are kept by the Binary Searcher
+
+extern char * SignatureDatabase;
+
+extern int SignatureCount;
+
+void * GetSignatures(char * DatabaseName);
+
+// The Largest Chunk Read from a Client or a Request's Output at once
+
+#define DAEMON_CHUNK (64 * 1024)
+
+// The Longest Request Line, a Client sending a longer one is Dropped
+
+#define REQUEST_LENGTH (64 * 1024)
+
+// The Records Queued for a Client past which it's Requests' Output is no longer Read
+
+#define CLIENT_BACKLOG (1024 * 1024)
+
+// The Requests Waiting for a Client past which it's Socket is no longer Read
+
+#define CLIENT_QUEUE 64
+
+// What each epoll Event belongs to, Stored with an Index and the Descriptor
+
+#define EVENT_LISTENER  0
+#define EVENT_CLIENT    1
+#define EVENT_OUTPUT    2
+#define EVENT_SIGNAL    3
+#define EVENT_WATCH     4
+#define EVENT_WARMED    5
+
+#define EVENT_DATA(Kind, Index, Descriptor) (((QWORD) (Descriptor) << 32) | ((QWORD) (Index) << 3) | (Kind))
+
+// Where a Request is with the Loading of it's Files, before it's Child is Forked
+
+#define JOB_COLD        0
+#define JOB_WARMING     1
+#define JOB_WARM        2
+
+typedef struct
+{
+    // The Client's Index, or -1 once the Client is Gone
+    
+    int Client;
+    
+    // The Request Line, holding the Arguments : the Id, the Folder, then the Tool's argv
+    
+    char * Line;
+    
+    char ** Arguments;
+    
+    int Count;
+    
+    const Tool * Chosen;
+    
+    // 0 while Waiting
+    
+    pid_t Process;
+    
+    // JOB_COLD, JOB_WARMING while a Warm Thread Loads it's Files, then JOB_WARM
+    
+    int Warm;
+    
+    // The Read End of the Child's Output, -1 once Closed
+    
+    int Output;
+    
+    // The Exit Status, -1 until the Child is Reaped
+    
+    int Status;
+    
+    // The Order of Arrival, a Client's Oldest Request Runs first
+    
+    QWORD Sequence;
+    
+    QWORD Started;
+    
+    int Used;
+
+} Request;
+
+typedef struct
+{
+    // -1 for a Free Slot
+    
+    int Socket;
+    
+    // A Partial Request Line
+    
+    char * Input;
+    
+    int InputLength;
+    
+    // The Records not yet Sent
+    
+    BYTE * Pending;
+    
+    QWORD PendingLength;
+    
+    QWORD PendingSpace;
+    
+    int Running;
+    
+    int Waiting;
+    
+    // Set while the Output of the Client's Requests is not Read, until it's Records are Sent
+    
+    int Paused;
+
+} DaemonClient;
+
+typedef struct
+{
+    DaemonSettings * Settings;
+    
+    int Loop;
+    
+    DaemonClient * Clients;
+    
+    int ClientSpace;
+    
+    Request * Requests;
+    
+    int RequestSpace;
+    
+    int Running;
+    
+    // The Client which takes the next Free Job, when it has a Request Waiting
+    
+    int NextClient;
+    
+    QWORD Sequence;
+    
+    // The Signal Mask of the Children
+    
+    sigset_t Saved;
+    
+    // The Pipes Carrying Warm Orders to the Warm Threads, and back once Done
+    
+    int Orders[2];
+    
+    int Warmed[2];
+
+} Daemon;
+
+// The Files of a Request, Loaded by a Warm Thread
+
+typedef struct
+{
+    // The Request's Slot, and it's Sequence in case the Slot was Reused meanwhile
+    
+    int Slot;
+    
+    QWORD Sequence;
+    
+    int Mode;
+    
+    char ** Paths;
+    
+    int Count;
+
+} WarmOrder;
+
+static QWORD Nanoseconds()
+{
+    struct timespec Now;
+    
+    clock_gettime(CLOCK_MONOTONIC, &Now);
+    
+    return (QWORD) Now.tv_sec * 1000000000ULL + Now.tv_nsec;
+}
+
+/*
+ *  The Load Signatures Method will Load the Database's Signatures inside
+ *  the Daemon, so that every Child finds them Loaded. The Binary Searcher
+ *  ends the Process on a Broken Database, so the Database is first Loaded
+ *  by a Child : a Database being Replaced never brings the Daemon down.
+ */
+
+static void LoadSignatures()
+{
+    struct stat Status;
+    
+    if (stat(SignatureDatabase, &Status) != 0)
+    {
+        return;
+    }
+    
+    pid_t Probe = fork();
+    
+    if (Probe == 0)
+    {
+        GetSignatures(SignatureDatabase);
+        
+        _exit(0);
+    }
+    
+    int Result;
+    
+    if (Probe < 0 || waitpid(Probe, &Result, 0) != Probe || !WIFEXITED(Result) || WEXITSTATUS(Result) != 0)
+    {
+        fprintf(stderr, "Cannot Load the Signatures of %s \r\n", SignatureDatabase);
+        
+        return;
+    }
+    
+    GetSignatures(SignatureDatabase);
+    
+    FlushOutput();
+    
+    fprintf(stderr, "%d Signatures Loaded from %s \r\n", SignatureCount, SignatureDatabase);
+}
+
+/*
+ *  The Warm Method will Load the Files a Request's Tool Reads, inside the
+ *  Daemon's File Cache, before the Child is Forked. Only the Paths which
+ *  are Readable Files are Loaded. It is Run by a Warm Thread, so Loading
+ *  a Large Image never holds up the Loop.
+ */
+
+static void Warm(WarmOrder * Order)
+{
+    int Counter;
+    
+    for (Counter = 0; Counter < Order -> Count; Counter ++)
+    {
+        char * Path = Order -> Paths[Counter];
+        
+        // The Map File Method Exits on Files it cannot Open
+        
+        int Descriptor = open(Path, O_RDONLY | O_CLOEXEC);
+        
+        struct stat Status;
+        
+        if (Descriptor < 0)
+        {
+            continue;
+        }
+        
+        int Regular = fstat(Descriptor, &Status) == 0 && S_ISREG(Status.st_mode) && Status.st_size > 0;
+        
+        close(Descriptor);
+        
+        if (!Regular)
+        {
+            continue;
+        }
+        
+        if (Order -> Mode == WARM_DUMP)
+        {
+            DumpHex(Path);
+        }
+        else if (Order -> Mode == WARM_NO_NULLS)
+        {
+            DumpHexWithoutNulls(Path);
+        }
+        else
+        {
+            QWORD Size;
+            
+            UnmapFile(MapFile(Path, &Size), Size);
+        }
+    }
+    
+    TrimFileCache();
+}
+
+// A Warm Thread, Orders are passed as Pointers through the Pipes it is given
+
+static void * WarmThread(void * Context)
+{
+    int * Pipes = Context;
+    
+    WarmOrder * Order;
+    
+    while (read(Pipes[0], &Order, sizeof(Order)) == sizeof(Order))
+    {
+        Warm(Order);
+        
+        if (write(Pipes[1], &Order, sizeof(Order)) != sizeof(Order))
+        {
+            break;
+        }
+    }
+    
+    free(Pipes);
+    
+    return NULL;
+}
+
+static void SetEvents(Daemon * Server, int Descriptor, QWORD Data, unsigned int Events)
+{
+    struct epoll_event Event = { Events, { .u64 = Data } };
+    
+    epoll_ctl(Server -> Loop, EPOLL_CTL_MOD, Descriptor, &Event);
+}
+
+/*
+ *  The Pause Output Method will Stop or Resume Reading the Output of a
+ *  Client's Running Requests. Their Children then Block on a Full Pipe,
+ *  rather than the Daemon Queueing what a Slow Client cannot Take.
+ */
+
+static void PauseOutput(Daemon * Server, int Index, int Paused)
+{
+    Server -> Clients[Index].Paused = Paused;
+    
+    int Counter;
+    
+    for (Counter = 0; Counter < Server -> RequestSpace; Counter ++)
+    {
+        Request * Job = &Server -> Requests[Counter];
+        
+        if (Job -> Used && Job -> Client == Index && Job -> Output >= 0)
+        {
+            SetEvents(Server, Job -> Output, EVENT_DATA(EVENT_OUTPUT, Counter, Job -> Output), Paused ? 0 : EPOLLIN);
+        }
+    }
+}
+
+static void DropClient(Daemon * Server, int Index);
+
+/*
+ *  The Flush Client Method will Send what the Socket Takes of a Client's
+ *  Records, and Wait for it to Drain when it is Full.
+ */
+
+static void FlushClient(Daemon * Server, int Index)
+{
+    DaemonClient * Client = &Server -> Clients[Index];
+    
+    QWORD Sent = 0;
+    
+    while (Sent < Client -> PendingLength)
+    {
+        ssize_t Length = send(Client -> Socket, Client -> Pending + Sent, Client -> PendingLength - Sent, MSG_DONTWAIT | MSG_NOSIGNAL);
+        
+        if (Length < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            
+            if (errno != EAGAIN)
+            {
+                DropClient(Server, Index);
+                
+                return;
+            }
+            
+            break;
+        }
+        
+        Sent += Length;
+    }
+    
+    memmove(Client -> Pending, Client -> Pending + Sent, Client -> PendingLength - Sent);
+    
+    Client -> PendingLength -= Sent;
+    
+    unsigned int Events = (Client -> Waiting < CLIENT_QUEUE ? EPOLLIN : 0) | (Client -> PendingLength ? EPOLLOUT : 0);
+    
+    SetEvents(Server, Client -> Socket, EVENT_DATA(EVENT_CLIENT, Index, Client -> Socket), Events);
+    
+    if (Client -> Paused != (Client -> PendingLength > CLIENT_BACKLOG))
+    {
+        PauseOutput(Server, Index, !Client -> Paused);
+    }
+}
+
+// Queues a Record Header and it's Data for a Client, then Sends what it can
+
+static void SendRecord(Daemon * Server, int Index, char * Header, const BYTE * Data, QWORD Length)
+{
+    DaemonClient * Client = &Server -> Clients[Index];
+    
+    QWORD HeaderLength = strlen(Header);
+    
+    if (Client -> PendingLength + HeaderLength + Length > Client -> PendingSpace)
+    {
+        Client -> PendingSpace = (Client -> PendingLength + HeaderLength + Length) * 2;
+        
+        Client -> Pending = realloc(Client -> Pending, Client -> PendingSpace);
+    }
+    
+    memcpy(Client -> Pending + Client -> PendingLength, Header, HeaderLength);
+    
+    memcpy(Client -> Pending + Client -> PendingLength + HeaderLength, Data, Length);
+    
+    Client -> PendingLength += HeaderLength + Length;
+    
+    FlushClient(Server, Index);
+}
+
+static void FreeRequest(Request * Job)
+{
+    free(Job -> Line);
+    
+    free(Job -> Arguments);
+    
+    Job -> Used = 0;
+}
+
+/*
+ *  The Drop Client Method will Close a Client's Socket. It's Waiting
+ *  Requests are Dropped and it's Running ones Killed, they are Freed once
+ *  their Children are Reaped.
+ */
+
+static void DropClient(Daemon * Server, int Index)
+{
+    DaemonClient * Client = &Server -> Clients[Index];
+    
+    int Counter;
+    
+    for (Counter = 0; Counter < Server -> RequestSpace; Counter ++)
+    {
+        Request * Job = &Server -> Requests[Counter];
+        
+        if (!Job -> Used || Job -> Client != Index)
+        {
+            continue;
+        }
+        
+        if (Job -> Process)
+        {
+            kill(Job -> Process, SIGKILL);
+            
+            Job -> Client = -1;
+        }
+        else if (Job -> Warm == JOB_WARMING)
+        {
+            // Freed once it's Warm Thread is Done with it
+            
+            Job -> Client = -1;
+        }
+        else
+        {
+            FreeRequest(Job);
+        }
+    }
+    
+    epoll_ctl(Server -> Loop, EPOLL_CTL_DEL, Client -> Socket, NULL);
+    
+    close(Client -> Socket);
+    
+    free(Client -> Input);
+    free(Client -> Pending);
+    
+    memset(Client, 0, sizeof(DaemonClient));
+    
+    Client -> Socket = -1;
+}
+
+static void AcceptClient(Daemon * Server, int Listener)
+{
+    int Socket = accept4(Listener, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC);
+    
+    if (Socket < 0)
+    {
+        return;
+    }
+    
+    int Index;
+    
+    for (Index = 0; Index < Server -> ClientSpace && Server -> Clients[Index].Socket >= 0; Index ++);
+    
+    if (Index == Server -> ClientSpace)
+    {
+        Server -> ClientSpace = Server -> ClientSpace ? Server -> ClientSpace * 2 : 16;
+        
+        Server -> Clients = realloc(Server -> Clients, Server -> ClientSpace * sizeof(DaemonClient));
+        
+        int Counter;
+        
+        for (Counter = Index; Counter < Server -> ClientSpace; Counter ++)
+        {
+            memset(&Server -> Clients[Counter], 0, sizeof(DaemonClient));
+            
+            Server -> Clients[Counter].Socket = -1;
+        }
+    }
+    
+    Server -> Clients[Index].Socket = Socket;
+    
+    Server -> Clients[Index].Input = malloc(REQUEST_LENGTH);
+    
+    struct epoll_event Event = { EPOLLIN, { .u64 = EVENT_DATA(EVENT_CLIENT, Index, Socket) } };
+    
+    epoll_ctl(Server -> Loop, EPOLL_CTL_ADD, Socket, &Event);
+}
+
+/*
+ *  The Add Request Method will Queue a Request Line. A Line which is not a
+ *  Request is Answered at once with Exit Status 255.
+ */
+
+static void AddRequest(Daemon * Server, int Index, char * Text)
+{
+    char * Line = strdup(Text);
+    
+    char ** Arguments = NULL;
+    
+    int Capacity = 0;
+    
+    int Count = SplitLine(Line, &Arguments, &Capacity);
+    
+    if (Count == 0)
+    {
+        free(Line);
+        
+        return;
+    }
+    
+    const Tool * Chosen = Count >= 3 ? FindTool(Arguments[2]) : NULL;
+    
+    if (Chosen == NULL || Arguments[1][0] != '/')
+    {
+        char Header[256];
+        
+        char * Message = Count < 0 ? "Unclosed Quote \r\n" : Count < 3 ? "Syntax : <Id> <Folder> <Tool> [Arguments ...] \r\n" :
+                         Chosen == NULL ? "Unknown Tool \r\n" : "The Folder has to be an Absolute Path \r\n";
+        
+        char * Id = Count > 0 ? Arguments[0] : "?";
+        
+        snprintf(Header, sizeof(Header), "%.64s OUT %zu\n", Id, strlen(Message));
+        
+        SendRecord(Server, Index, Header, (BYTE *) Message, strlen(Message));
+        
+        // The Client may have been Dropped while Sending
+        
+        if (Server -> Clients[Index].Socket >= 0)
+        {
+            snprintf(Header, sizeof(Header), "%.64s END 255\n", Id);
+            
+            SendRecord(Server, Index, Header, NULL, 0);
+        }
+        
+        free(Arguments);
+        free(Line);
+        
+        return;
+    }
+    
+    int Slot;
+    
+    for (Slot = 0; Slot < Server -> RequestSpace && Server -> Requests[Slot].Used; Slot ++);
+    
+    if (Slot == Server -> RequestSpace)
+    {
+        Server -> RequestSpace = Server -> RequestSpace ? Server -> RequestSpace * 2 : 64;
+        
+        Server -> Requests = realloc(Server -> Requests, Server -> RequestSpace * sizeof(Request));
+        
+        memset(Server -> Requests + Slot, 0, (Server -> RequestSpace - Slot) * sizeof(Request));
+    }
+    
+    Request * Job = &Server -> Requests[Slot];
+    
+    memset(Job, 0, sizeof(Request));
+    
+    Job -> Client = Index;
+    Job -> Line = Line;
+    Job -> Arguments = Arguments;
+    Job -> Count = Count;
+    Job -> Chosen = Chosen;
+    Job -> Output = -1;
+    Job -> Status = -1;
+    Job -> Sequence = Server -> Sequence ++;
+    Job -> Used = 1;
+    
+    Server -> Clients[Index].Waiting ++;
+}
+
+static void ReadClient(Daemon * Server, int Index)
+{
+    DaemonClient * Client = &Server -> Clients[Index];
+    
+    ssize_t Length = read(Client -> Socket, Client -> Input + Client -> InputLength, REQUEST_LENGTH - Client -> InputLength);
+    
+    if (Length <= 0)
+    {
+        if (Length == 0 || (errno != EAGAIN && errno != EINTR))
+        {
+            DropClient(Server, Index);
+        }
+        
+        return;
+    }
+    
+    Client -> InputLength += Length;
+    
+    char * Start = Client -> Input;
+    
+    char * End;
+    
+    while ((End = memchr(Start, '\n', Client -> Input + Client -> InputLength - Start)) != NULL)
+    {
+        *End = '\0';
+        
+        AddRequest(Server, Index, Start);
+        
+        if (Client -> Socket < 0)
+        {
+            return;
+        }
+        
+        Start = End + 1;
+    }
+    
+    Client -> InputLength -= Start - Client -> Input;
+    
+    memmove(Client -> Input, Start, Client -> InputLength);
+    
+    if (Client -> InputLength == REQUEST_LENGTH)
+    {
+        fprintf(stderr, "Client %d Sent a Request Longer than %d Bytes, Dropped \r\n", Index, REQUEST_LENGTH);
+        
+        DropClient(Server, Index);
+        
+        return;
+    }
+    
+    // Stop Reading a Client with too many Requests Waiting
+    
+    FlushClient(Server, Index);
+}
+
+/*
+ *  The Abort Request Method will Answer a Scheduled Request which could not
+ *  be Started with Exit Status 255, and Free it's Job.
+ */
+
+static void AbortRequest(Daemon * Server, int Slot)
+{
+    Request * Job = &Server -> Requests[Slot];
+    
+    int Index = Job -> Client;
+    
+    char Header[128];
+    
+    snprintf(Header, sizeof(Header), "%.64s END 255\n", Job -> Arguments[0]);
+    
+    fprintf(stderr, "Client %d : %s could not be Started, %s \r\n", Index, Job -> Chosen -> Name, strerror(errno));
+    
+    Server -> Running --;
+    
+    FreeRequest(Job);
+    
+    if (Index >= 0)
+    {
+        Server -> Clients[Index].Running --;
+        
+        SendRecord(Server, Index, Header, NULL, 0);
+    }
+}
+
+/*
+ *  The Start Request Method will Fork the Child Running a Request. The
+ *  Child's Standard Output and Error are a Pipe Read by the Daemon. The
+ *  Request's Job was Counted by the Scheduler.
+ */
+
+static void StartRequest(Daemon * Server, int Slot)
+{
+    Request * Job = &Server -> Requests[Slot];
+    
+    DaemonClient * Client = &Server -> Clients[Job -> Client];
+    
+    int Pipe[2];
+    
+    if (pipe2(Pipe, O_CLOEXEC) != 0)
+    {
+        AbortRequest(Server, Slot);
+        
+        return;
+    }
+    
+    // Anything still Buffered would be Written again by the Child
+    
+    FlushOutput();
+    fflush(stderr);
+    
+    Job -> Process = fork();
+    
+    if (Job -> Process == 0)
+    {
+        sigprocmask(SIG_SETMASK, &Server -> Saved, NULL);
+        
+        dup2(Pipe[1], STDOUT_FILENO);
+        dup2(Pipe[1], STDERR_FILENO);
+        
+        if (chdir(Job -> Arguments[1]) != 0)
+        {
+            printf("Cannot Enter %s \r\n", Job -> Arguments[1]);
+            
+            exit(-1);
+        }
+        
+        exit(Job -> Chosen -> Main(Job -> Count - 2, Job -> Arguments + 2));
+    }
+    
+    close(Pipe[1]);
+    
+    if (Job -> Process < 0)
+    {
+        close(Pipe[0]);
+        
+        AbortRequest(Server, Slot);
+        
+        return;
+    }
+    
+    fcntl(Pipe[0], F_SETFL, O_NONBLOCK);
+    
+    Job -> Output = Pipe[0];
+    
+    Job -> Started = Nanoseconds();
+    
+    struct epoll_event Event = { Client -> Paused ? 0 : EPOLLIN, { .u64 = EVENT_DATA(EVENT_OUTPUT, Slot, Pipe[0]) } };
+    
+    epoll_ctl(Server -> Loop, EPOLL_CTL_ADD, Pipe[0], &Event);
+}
+
+/*
+ *  The Warm Request Method will hand the Files a Request's Tool Reads to
+ *  the Warm Threads. The Request is Started once they are Loaded.
+ */
+
+static void WarmRequest(Daemon * Server, int Slot)
+{
+    Request * Job = &Server -> Requests[Slot];
+    
+    WarmOrder * Order = calloc(1, sizeof(WarmOrder));
+    
+    Order -> Slot = Slot;
+    Order -> Sequence = Job -> Sequence;
+    Order -> Mode = Job -> Chosen -> Warm;
+    Order -> Paths = calloc(Job -> Count, sizeof(char *));
+    
+    int Counter;
+    
+    for (Counter = 3; Counter < Job -> Count; Counter ++)
+    {
+        char Path[PATH_MAX];
+        
+        char * Argument = Job -> Arguments[Counter];
+        
+        if (Argument[0] == '/')
+        {
+            snprintf(Path, sizeof(Path), "%s", Argument);
+        }
+        else
+        {
+            snprintf(Path, sizeof(Path), "%s/%s", Job -> Arguments[1], Argument);
+        }
+        
+        Order -> Paths[Order -> Count ++] = strdup(Path);
+    }
+    
+    Job -> Warm = JOB_WARMING;
+    
+    if (write(Server -> Orders[1], &Order, sizeof(Order)) != sizeof(Order))
+    {
+        // Without the Warm Threads, the Request Runs Cold
+        
+        Job -> Warm = JOB_WARM;
+        
+        StartRequest(Server, Slot);
+    }
+}
+
+static void FreeOrder(WarmOrder * Order)
+{
+    int Counter;
+    
+    for (Counter = 0; Counter < Order -> Count; Counter ++)
+    {
+        free(Order -> Paths[Counter]);
+    }
+    
+    free(Order -> Paths);
+    free(Order);
+}
+
+// Starts the Requests whose Files the Warm Threads Loaded
+
+static void ReadWarmed(Daemon * Server)
+{
+    WarmOrder * Order;
+    
+    while (read(Server -> Warmed[0], &Order, sizeof(Order)) == sizeof(Order))
+    {
+        Request * Job = &Server -> Requests[Order -> Slot];
+        
+        if (Job -> Used && Job -> Sequence == Order -> Sequence && Job -> Warm == JOB_WARMING)
+        {
+            Job -> Warm = JOB_WARM;
+            
+            // The Client went away meanwhile
+            
+            if (Job -> Client < 0)
+            {
+                Server -> Running --;
+                
+                FreeRequest(Job);
+            }
+            else
+            {
+                StartRequest(Server, Order -> Slot);
+            }
+        }
+        
+        FreeOrder(Order);
+    }
+}
+
+/*
+ *  The Schedule Method will Start Waiting Requests while Jobs are Free. The
+ *  Clients take turns, and a Client already Running as many Requests as it
+ *  is Allowed is Skipped. A Request holds it's Job while it's Files are
+ *  Loaded.
+ */
+
+static void Schedule(Daemon * Server)
+{
+    while (Server -> Running < Server -> Settings -> Jobs && Server -> ClientSpace > 0)
+    {
+        int Chosen = -1;
+        
+        int Turn;
+        
+        for (Turn = 0; Turn < Server -> ClientSpace && Chosen < 0; Turn ++)
+        {
+            int Index = (Server -> NextClient + Turn) % Server -> ClientSpace;
+            
+            DaemonClient * Client = &Server -> Clients[Index];
+            
+            if (Client -> Socket < 0 || Client -> Waiting == 0 || Client -> Running >= Server -> Settings -> ClientJobs)
+            {
+                continue;
+            }
+            
+            int Counter;
+            
+            for (Counter = 0; Counter < Server -> RequestSpace; Counter ++)
+            {
+                Request * Job = &Server -> Requests[Counter];
+                
+                if (Job -> Used && Job -> Client == Index && Job -> Process == 0 && Job -> Warm == JOB_COLD &&
+                    (Chosen < 0 || Job -> Sequence < Server -> Requests[Chosen].Sequence))
+                {
+                    Chosen = Counter;
+                }
+            }
+        }
+        
+        if (Chosen < 0)
+        {
+            break;
+        }
+        
+        Request * Job = &Server -> Requests[Chosen];
+        
+        DaemonClient * Client = &Server -> Clients[Job -> Client];
+        
+        Server -> NextClient = (Job -> Client + 1) % Server -> ClientSpace;
+        
+        Client -> Waiting --;
+        Client -> Running ++;
+        
+        Server -> Running ++;
+        
+        if (Job -> Chosen -> Warm == WARM_NONE)
+        {
+            StartRequest(Server, Chosen);
+        }
+        else
+        {
+            WarmRequest(Server, Chosen);
+        }
+    }
+}
+
+// Sends the End of a Request once it's Child is Reaped and it's Output Read
+
+static void FinishRequest(Daemon * Server, int Slot)
+{
+    Request * Job = &Server -> Requests[Slot];
+    
+    if (Job -> Client >= 0)
+    {
+        char Header[128];
+        
+        snprintf(Header, sizeof(Header), "%.64s END %d\n", Job -> Arguments[0], Job -> Status);
+        
+        fprintf(stderr, "Client %d : %s %s %s, Status %d in %.3f ms \r\n", Job -> Client, Job -> Chosen -> Name,
+                Job -> Count > 3 ? Job -> Arguments[3] : "", Job -> Count > 4 ? Job -> Arguments[4] : "", Job -> Status,
+                (Nanoseconds() - Job -> Started) / 1e6);
+        
+        Server -> Clients[Job -> Client].Running --;
+        
+        SendRecord(Server, Job -> Client, Header, NULL, 0);
+    }
+    
+    Server -> Running --;
+    
+    FreeRequest(Job);
+}
+
+static void ReadOutput(Daemon * Server, int Slot)
+{
+    static BYTE Buffer[DAEMON_CHUNK];
+    
+    Request * Job = &Server -> Requests[Slot];
+    
+    ssize_t Length = read(Job -> Output, Buffer, DAEMON_CHUNK);
+    
+    if (Length > 0)
+    {
+        if (Job -> Client >= 0)
+        {
+            char Header[128];
+            
+            snprintf(Header, sizeof(Header), "%.64s OUT %zd\n", Job -> Arguments[0], Length);
+            
+            SendRecord(Server, Job -> Client, Header, Buffer, Length);
+        }
+        
+        return;
+    }
+    
+    if (Length < 0 && (errno == EAGAIN || errno == EINTR))
+    {
+        return;
+    }
+    
+    epoll_ctl(Server -> Loop, EPOLL_CTL_DEL, Job -> Output, NULL);
+    
+    close(Job -> Output);
+    
+    Job -> Output = -1;
+    
+    if (Job -> Status >= 0)
+    {
+        FinishRequest(Server, Slot);
+    }
+}
+
+// Reaps every Child which Ended, a Request Finishes once it's Output is also Read
+
+static void Reap(Daemon * Server)
+{
+    pid_t Process;
+    
+    int Result;
+    
+    while ((Process = waitpid(-1, &Result, WNOHANG)) > 0)
+    {
+        int Counter;
+        
+        for (Counter = 0; Counter < Server -> RequestSpace; Counter ++)
+        {
+            Request * Job = &Server -> Requests[Counter];
+            
+            if (!Job -> Used || Job -> Process != Process)
+            {
+                continue;
+            }
+            
+            Job -> Status = WIFEXITED(Result) ? WEXITSTATUS(Result) : 128 + WTERMSIG(Result);
+            
+            if (Job -> Output < 0)
+            {
+                FinishRequest(Server, Counter);
+            }
+            
+            break;
+        }
+    }
+}
+
+/*
+ *  The Open Listener Method will create the Daemon's Unix Socket, replacing
+ *  one left behind by an earlier Run. Only the Daemon's User can Connect.
+ */
+
+static int OpenListener(Daemon * Server)
+{
+    struct sockaddr_un Address;
+    
+    memset(&Address, 0, sizeof(Address));
+    
+    Address.sun_family = AF_UNIX;
+    
+    if (strlen(Server -> Settings -> SocketPath) >= sizeof(Address.sun_path))
+    {
+        return -1;
+    }
+    
+    strcpy(Address.sun_path, Server -> Settings -> SocketPath);
+    
+    unlink(Server -> Settings -> SocketPath);
+    
+    int Listener = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    
+    if (Listener < 0 || bind(Listener, (struct sockaddr *) &Address, sizeof(Address)) != 0 ||
+        chmod(Server -> Settings -> SocketPath, 0600) != 0 || listen(Listener, 64) != 0)
+    {
+        return -1;
+    }
+    
+    struct epoll_event Event = { EPOLLIN, { .u64 = EVENT_DATA(EVENT_LISTENER, 0, Listener) } };
+    
+    epoll_ctl(Server -> Loop, EPOLL_CTL_ADD, Listener, &Event);
+    
+    return Listener;
+}
+
+/*
+ *  The Watch Database Method will Watch the Folder holding the Database,
+ *  which catches the Database being Rewritten as well as Replaced.
+ */
+
+static int WatchDatabase(Daemon * Server)
+{
+    int Watch = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    
+    char Folder[PATH_MAX];
+    
+    snprintf(Folder, sizeof(Folder), "%s", SignatureDatabase);
+    
+    * strrchr(Folder, '/') = '\0';
+    
+    if (Watch < 0 || inotify_add_watch(Watch, Folder[0] ? Folder : "/", IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE) < 0)
+    {
+        fprintf(stderr, "Cannot Watch %s, the Signatures will not be Reloaded \r\n", SignatureDatabase);
+        
+        return -1;
+    }
+    
+    struct epoll_event Event = { EPOLLIN, { .u64 = EVENT_DATA(EVENT_WATCH, 0, Watch) } };
+    
+    epoll_ctl(Server -> Loop, EPOLL_CTL_ADD, Watch, &Event);
+    
+    return Watch;
+}
+
+static void ReadWatch(int Watch)
+{
+    char Buffer[4096] __attribute__((aligned(__alignof__(struct inotify_event))));
+    
+    char * Name = strrchr(SignatureDatabase, '/') + 1;
+    
+    int Changed = 0;
+    
+    ssize_t Length;
+    
+    while ((Length = read(Watch, Buffer, sizeof(Buffer))) > 0)
+    {
+        char * Position = Buffer;
+        
+        while (Position < Buffer + Length)
+        {
+            struct inotify_event * Event = (struct inotify_event *) Position;
+            
+            Changed |= Event -> len && strcmp(Event -> name, Name) == 0;
+            
+            Position += sizeof(struct inotify_event) + Event -> len;
+        }
+    }
+    
+    if (Changed)
+    {
+        LoadSignatures();
+    }
+}
+
+/*
+ *  The Run Daemon Method will Serve Requests from a single epoll Loop until
+ *  SIGINT, SIGTERM or SIGHUP is Received. The Signals, and the Children's
+ *  SIGCHLD, arrive through a signalfd.
+ * 
+ *  The Daemon's own Standard Output is Discarded, the Tools' Loaders print
+ *  on it. The Daemon Reports on the Standard Error.
+ * 
+ *  Parameters:
+ *          The Daemon's Settings
+ * 
+ *  Returns:
+ *          0 when Stopped by a Signal, -1 if the Daemon could not Start
+ */
+
+int RunDaemon(DaemonSettings * Settings)
+{
+    Daemon Server;
+    
+    memset(&Server, 0, sizeof(Server));
+    
+    Server.Settings = Settings;
+    
+    if (Settings -> Jobs <= 0)
+    {
+        Settings -> Jobs = sysconf(_SC_NPROCESSORS_ONLN) > 0 ? sysconf(_SC_NPROCESSORS_ONLN) : 1;
+    }
+    
+    if (Settings -> ClientJobs <= 0)
+    {
+        Settings -> ClientJobs = 1;
+    }
+    
+    // The Children Run inside the Requests' Folders, the Database has to be Found from any of them
+    
+    char Database[PATH_MAX];
+    
+    if (realpath(Settings -> Database, Database) == NULL)
+    {
+        char Folder[PATH_MAX];
+        
+        if (Settings -> Database[0] == '/' || getcwd(Folder, sizeof(Folder)) == NULL)
+        {
+            snprintf(Database, sizeof(Database), "%s", Settings -> Database);
+        }
+        else
+        {
+            snprintf(Database, sizeof(Database), "%s/%s", Folder, Settings -> Database);
+        }
+    }
+    
+    SignatureDatabase = Database;
+    
+    EnableFileCache(Settings -> CacheSize);
+    
+    int Null = open("/dev/null", O_WRONLY);
+    
+    dup2(Null, STDOUT_FILENO);
+    
+    close(Null);
+    
+    Server.Loop = epoll_create1(EPOLL_CLOEXEC);
+    
+    sigset_t Signals;
+    
+    sigemptyset(&Signals);
+    sigaddset(&Signals, SIGINT);
+    sigaddset(&Signals, SIGTERM);
+    sigaddset(&Signals, SIGHUP);
+    sigaddset(&Signals, SIGCHLD);
+    
+    sigprocmask(SIG_BLOCK, &Signals, &Server.Saved);
+    
+    int Received = signalfd(-1, &Signals, SFD_NONBLOCK | SFD_CLOEXEC);
+    
+    struct epoll_event Event = { EPOLLIN, { .u64 = EVENT_DATA(EVENT_SIGNAL, 0, Received) } };
+    
+    int Listener = -1;
+    
+    if (Server.Loop < 0 || Received < 0 || epoll_ctl(Server.Loop, EPOLL_CTL_ADD, Received, &Event) != 0 ||
+        (Listener = OpenListener(&Server)) < 0)
+    {
+        fprintf(stderr, "Cannot Listen on %s \r\n", Settings -> SocketPath);
+        
+        return -1;
+    }
+    
+    // The Warm Threads are Created once the Signals are Blocked, so they all reach the signalfd
+    // One per Job, so a Request never Waits for the Files of another
+    
+    struct epoll_event Warmed = { EPOLLIN, { .u64 = 0 } };
+    
+    if (pipe2(Server.Orders, O_CLOEXEC) != 0 || pipe2(Server.Warmed, O_CLOEXEC) != 0)
+    {
+        fprintf(stderr, "Cannot Start the Warm Threads \r\n");
+        
+        return -1;
+    }
+    
+    fcntl(Server.Warmed[0], F_SETFL, O_NONBLOCK);
+    
+    int Counter;
+    
+    for (Counter = 0; Counter < Settings -> Jobs; Counter ++)
+    {
+        pthread_t Warmer;
+        
+        int * Pipes = malloc(2 * sizeof(int));
+        
+        Pipes[0] = Server.Orders[0];
+        Pipes[1] = Server.Warmed[1];
+        
+        if (pthread_create(&Warmer, NULL, WarmThread, Pipes) != 0)
+        {
+            fprintf(stderr, "Cannot Start the Warm Threads \r\n");
+            
+            return -1;
+        }
+        
+        pthread_detach(Warmer);
+    }
+    
+    Warmed.data.u64 = EVENT_DATA(EVENT_WARMED, 0, Server.Warmed[0]);
+    
+    epoll_ctl(Server.Loop, EPOLL_CTL_ADD, Server.Warmed[0], &Warmed);
+    
+    LoadSignatures();
+    
+    int Watch = WatchDatabase(&Server);
+    
+    fprintf(stderr, "Serving on %s, %d Jobs ( %d per Client ), Send SIGTERM to Stop \r\n", Settings -> SocketPath,
+            Settings -> Jobs, Settings -> ClientJobs);
+    
+    struct epoll_event Events[64];
+    
+    int Running = 1;
+    
+    while (Running)
+    {
+        int Count = epoll_wait(Server.Loop, Events, 64, -1);
+        
+        if (Count < 0 && errno != EINTR)
+        {
+            break;
+        }
+        
+        int Current;
+        
+        for (Current = 0; Current < Count; Current ++)
+        {
+            QWORD Data = Events[Current].data.u64;
+            
+            int Kind = Data & 7;
+            
+            int Index = (Data & 0xFFFFFFFF) >> 3;
+            
+            int Descriptor = Data >> 32;
+            
+            switch (Kind)
+            {
+                case EVENT_LISTENER:
+                    
+                    AcceptClient(&Server, Listener);
+                    
+                    break;
+                
+                case EVENT_CLIENT:
+                    
+                    // The Client may have been Dropped by an earlier Event
+                    
+                    if (Index < Server.ClientSpace && Server.Clients[Index].Socket == Descriptor)
+                    {
+                        if (Events[Current].events & EPOLLOUT)
+                        {
+                            FlushClient(&Server, Index);
+                        }
+                        
+                        if (Server.Clients[Index].Socket == Descriptor && (Events[Current].events & (EPOLLIN | EPOLLHUP | EPOLLERR)))
+                        {
+                            ReadClient(&Server, Index);
+                        }
+                    }
+                    
+                    break;
+                
+                case EVENT_OUTPUT:
+                    
+                    if (Index < Server.RequestSpace && Server.Requests[Index].Used && Server.Requests[Index].Output == Descriptor)
+                    {
+                        ReadOutput(&Server, Index);
+                    }
+                    
+                    break;
+                
+                case EVENT_WATCH:
+                    
+                    ReadWatch(Watch);
+                    
+                    break;
+                
+                case EVENT_WARMED:
+                    
+                    ReadWarmed(&Server);
+                    
+                    break;
+                
+                default:
+                    
+                    {
+                        struct signalfd_siginfo Signal;
+                        
+                        while (read(Received, &Signal, sizeof(Signal)) == sizeof(Signal))
+                        {
+                            if (Signal.ssi_signo != SIGCHLD)
+                            {
+                                fprintf(stderr, "Signal %u Received \r\n", Signal.ssi_signo);
+                                
+                                Running = 0;
+                            }
+                        }
+                        
+                        Reap(&Server);
+                    }
+                    
+                    break;
+            }
+        }
+        
+        Schedule(&Server);
+    }
+    
+    // Stop every Request still Running, then Drop the Clients
+    
+    for (Counter = 0; Counter < Server.RequestSpace; Counter ++)
+    {
+        if (Server.Requests[Counter].Used && Server.Requests[Counter].Process > 0)
+        {
+            kill(Server.Requests[Counter].Process, SIGKILL);
+            
+            waitpid(Server.Requests[Counter].Process, NULL, 0);
+        }
+    }
+    
+    for (Counter = 0; Counter < Server.ClientSpace; Counter ++)
+    {
+        if (Server.Clients[Counter].Socket >= 0)
+        {
+            DropClient(&Server, Counter);
+        }
+    }
+    
+    for (Counter = 0; Counter < Server.RequestSpace; Counter ++)
+    {
+        if (Server.Requests[Counter].Used)
+        {
+            if (Server.Requests[Counter].Output >= 0)
+            {
+                close(Server.Requests[Counter].Output);
+            }
+            
+            FreeRequest(&Server.Requests[Counter]);
+        }
+    }
+    
+    free(Server.Requests);
+    free(Server.Clients);
+    
+    close(Listener);
+    
+    unlink(Settings -> SocketPath);
+    
+    if (Watch >= 0)
+    {
+        close(Watch);
+    }
+    
+    // The Warm Threads End on the Closed Pipe, or with the Process
+    
+    close(Server.Orders[1]);
+    
+    close(Received);
+    close(Server.Loop);
+    
+    sigprocmask(SIG_SETMASK, &Server.Saved, NULL);
+    
+    fprintf(stderr, "Stopped \r\n");
+    
+    return 0;
+}
+
+// Appends an Argument to a Request Line, inside Single Quotes
+
+static void AppendQuoted(char * Line, size_t Size, char * Argument)
+{
+    size_t Length = strlen(Line);
+    
+    if (Length + 2 < Size)
+    {
+        Line[Length ++] = ' ';
+        Line[Length ++] = '\'';
+    }
+    
+    for (; *Argument && Length + 5 < Size; Argument ++)
+    {
+        // A Quote Closes the Quoted Text, is Escaped, and Opens it again
+        
+        if (*Argument == '\'')
+        {
+            memcpy(Line + Length, "'\\''", 4);
+            
+            Length += 4;
+        }
+        else
+        {
+            Line[Length ++] = *Argument;
+        }
+    }
+    
+    Line[Length ++] = '\'';
+    
+    Line[Length] = '\0';
+}
+
+/*
+ *  The Run Client Method will Send one Request to a Daemon, from the
+ *  Current Folder, and Write the Output Records as they Arrive.
+ * 
+ *  Parameters:
+ *          A Char Array with the Daemon's Socket
+ *          The Tool's argv, starting with the Tool's Name
+ * 
+ *  Returns:
+ *          The Request's Exit Status, or -1 if the Daemon cannot be Reached
+ */
+
+int RunClient(char * SocketPath, int argc, char * argv[])
+{
+    struct sockaddr_un Address;
+    
+    memset(&Address, 0, sizeof(Address));
+    
+    Address.sun_family = AF_UNIX;
+    
+    snprintf(Address.sun_path, sizeof(Address.sun_path), "%s", SocketPath);
+    
+    int Socket = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    
+    if (Socket < 0 || connect(Socket, (struct sockaddr *) &Address, sizeof(Address)) != 0)
+    {
+        printf("Cannot Connect to %s \r\n", SocketPath);
+        
+        return -1;
+    }
+    
+    char * Line = malloc(REQUEST_LENGTH);
+    
+    char Folder[PATH_MAX];
+    
+    if (getcwd(Folder, sizeof(Folder)) == NULL)
+    {
+        puts("Cannot Find the Current Folder");
+        
+        return -1;
+    }
+    
+    strcpy(Line, "1");
+    
+    AppendQuoted(Line, REQUEST_LENGTH - 1, Folder);
+    
+    int Counter;
+    
+    for (Counter = 0; Counter < argc; Counter ++)
+    {
+        AppendQuoted(Line, REQUEST_LENGTH - 1, argv[Counter]);
+    }
+    
+    strcat(Line, "\n");
+    
+    size_t Sent = 0;
+    
+    while (Sent < strlen(Line))
+    {
+        ssize_t Length = send(Socket, Line + Sent, strlen(Line) - Sent, MSG_NOSIGNAL);
+        
+        if (Length <= 0)
+        {
+            puts("Cannot Send the Request");
+            
+            return -1;
+        }
+        
+        Sent += Length;
+    }
+    
+    free(Line);
+    
+    // The Records, a Header Line then it's Data
+    
+    FILE * Records = fdopen(Socket, "r");
+    
+    char Header[256];
+    
+    int Status = -1;
+    
+    while (fgets(Header, sizeof(Header), Records))
+    {
+        char Kind[8];
+        
+        long long Value;
+        
+        if (sscanf(Header, "%*s %7s %lld", Kind, &Value) != 2)
+        {
+            break;
+        }
+        
+        if (strcmp(Kind, "END") == 0)
+        {
+            Status = Value;
+            
+            break;
+        }
+        
+        static BYTE Buffer[DAEMON_CHUNK];
+        
+        while (Value > 0)
+        {
+            size_t Length = fread(Buffer, 1, Value < DAEMON_CHUNK ? Value : DAEMON_CHUNK, Records);
+            
+            if (Length == 0)
+            {
+                break;
+            }
+            
+            fwrite(Buffer, 1, Length, stdout);
+            
+            Value -= Length;
+        }
+        
+        fflush(stdout);
+    }
+    
+    fclose(Records);
+    
+    if (Status < 0)
+    {
+        puts("The Daemon Closed the Connection");
+    }
+    
+    return Status;
+}
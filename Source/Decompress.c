@@ -0,0 +1,300 @@
+/* Decompress */
+
+#include <stdlib.h>
+#include <string.h>
+#include <lzma.h>
+#include <zlib.h>
+
+#include "../Headers/Decompress.h"
+
+// The Decoded Bytes are passed to the Sink in Blocks of this Size
+
+#define DECODE_BLOCK (256 * 1024)
+
+// The Memory an LZMA or XZ Decoder may use, mostly for it's Dictionary
+
+#define DECODER_MEMORY (512ULL * 1024 * 1024)
+
+// The Bytes Decoded by a Probe
+
+#define PROBE_LENGTH (16 * 1024)
+
+// zlib Counts the Input in 32 Bits, it is Fed in Slices
+
+#define INFLATE_SLICE (1U << 30)
+
+// The Room left in the Block, so the Decoder Stops at the Limit
+
+static QWORD BlockRoom(QWORD Limit, QWORD Produced)
+{
+    return Limit && Limit - Produced < DECODE_BLOCK ? Limit - Produced : DECODE_BLOCK;
+}
+
+/*
+ *  The Decode LZMA Method will Decode an LZMA Alone or an XZ Stream through
+ *  liblzma. Data past the End of the Stream is not Read.
+ * 
+ *  Parameters:
+ *          The Codec, the Stream and the Bytes Available, the Limit, the Sink,
+ *          a Block for the Decoded Bytes and the Counters to Set
+ * 
+ *  Returns:
+ *          DECODE_END, DECODE_LIMIT or DECODE_ERROR
+ */
+
+static int DecodeLZMA(int Codec, const BYTE * Data, QWORD Available, QWORD Limit, DecodeSink Sink, void * Context,
+                      BYTE * Block, QWORD * Consumed, QWORD * Produced)
+{
+    lzma_stream Stream = LZMA_STREAM_INIT;
+    
+    lzma_ret Status = Codec == CODEC_XZ ? lzma_stream_decoder(&Stream, DECODER_MEMORY, 0) : lzma_alone_decoder(&Stream, DECODER_MEMORY);
+    
+    if (Status != LZMA_OK)
+    {
+        return DECODE_ERROR;
+    }
+    
+    Stream.next_in = Data;
+    Stream.avail_in = Available;
+    
+    int Result = DECODE_ERROR;
+    
+    while (1)
+    {
+        QWORD Room = BlockRoom(Limit, Stream.total_out);
+        
+        Stream.next_out = Block;
+        Stream.avail_out = Room;
+        
+        Status = lzma_code(&Stream, LZMA_FINISH);
+        
+        QWORD Length = Room - Stream.avail_out;
+        
+        if (Length && Sink && Sink(Block, Length, Context))
+        {
+            Result = DECODE_LIMIT;
+            
+            break;
+        }
+        
+        if (Status == LZMA_STREAM_END)
+        {
+            Result = DECODE_END;
+            
+            break;
+        }
+        
+        // A Truncated Stream ends with LZMA_BUF_ERROR
+        
+        if (Status != LZMA_OK)
+        {
+            break;
+        }
+        
+        if (Limit && Stream.total_out >= Limit)
+        {
+            Result = DECODE_LIMIT;
+            
+            break;
+        }
+    }
+    
+    *Consumed = Stream.total_in;
+    *Produced = Stream.total_out;
+    
+    lzma_end(&Stream);
+    
+    return Result;
+}
+
+/*
+ *  The Inflate Stream Method will Decode a Gzip Member or a Zlib Stream
+ *  through zlib, which also Checks it's CRC or Adler Checksum.
+ * 
+ *  Parameters:
+ *          The Codec, the Stream and the Bytes Available, the Limit, the Sink,
+ *          a Block for the Decoded Bytes and the Counters to Set
+ * 
+ *  Returns:
+ *          DECODE_END, DECODE_LIMIT or DECODE_ERROR
+ */
+
+static int InflateStream(int Codec, const BYTE * Data, QWORD Available, QWORD Limit, DecodeSink Sink, void * Context,
+                         BYTE * Block, QWORD * Consumed, QWORD * Produced)
+{
+    z_stream Stream;
+    
+    memset(&Stream, 0, sizeof(Stream));
+    
+    // Gzip Headers are Parsed by zlib when 16 is Added to the Window Bits
+    
+    if (inflateInit2(&Stream, Codec == CODEC_GZIP ? 15 + 16 : 15) != Z_OK)
+    {
+        return DECODE_ERROR;
+    }
+    
+    QWORD Remaining = Available;
+    
+    Stream.next_in = (Bytef *) Data;
+    
+    int Result = DECODE_ERROR;
+    
+    while (1)
+    {
+        if (Stream.avail_in == 0 && Remaining > 0)
+        {
+            Stream.avail_in = Remaining < INFLATE_SLICE ? Remaining : INFLATE_SLICE;
+            
+            Remaining -= Stream.avail_in;
+        }
+        
+        QWORD Room = BlockRoom(Limit, *Produced);
+        
+        Stream.next_out = Block;
+        Stream.avail_out = Room;
+        
+        int Status = inflate(&Stream, Z_NO_FLUSH);
+        
+        QWORD Length = Room - Stream.avail_out;
+        
+        *Produced += Length;
+        
+        if (Length && Sink && Sink(Block, Length, Context))
+        {
+            Result = DECODE_LIMIT;
+            
+            break;
+        }
+        
+        if (Status == Z_STREAM_END)
+        {
+            Result = DECODE_END;
+            
+            break;
+        }
+        
+        // A Truncated Stream ends with Z_BUF_ERROR, once the Input is Exhausted
+        
+        if (Status != Z_OK)
+        {
+            break;
+        }
+        
+        if (Limit && *Produced >= Limit)
+        {
+            Result = DECODE_LIMIT;
+            
+            break;
+        }
+    }
+    
+    *Consumed = Available - Remaining - Stream.avail_in;
+    
+    inflateEnd(&Stream);
+    
+    return Result;
+}
+
+int DecodeStream(int Codec, const BYTE * Data, QWORD Available, QWORD Limit, DecodeSink Sink, void * Context,
+                 QWORD * Consumed, QWORD * Produced)
+{
+    *Consumed = 0;
+    *Produced = 0;
+    
+    BYTE * Block = malloc(DECODE_BLOCK);
+    
+    int Result = DECODE_ERROR;
+    
+    if (Codec == CODEC_LZMA || Codec == CODEC_XZ)
+    {
+        Result = DecodeLZMA(Codec, Data, Available, Limit, Sink, Context, Block, Consumed, Produced);
+    }
+    else if (Codec == CODEC_GZIP || Codec == CODEC_ZLIB)
+    {
+        Result = InflateStream(Codec, Data, Available, Limit, Sink, Context, Block, Consumed, Produced);
+    }
+    
+    free(Block);
+    
+    return Result;
+}
+
+/*
+ *  The Probe Stream Method will Check the Header of a Stream, which for
+ *  LZMA Alone is all there is : Sane Properties, a Dictionary Size of 2^n
+ *  or 3 * 2^n, and an Uncompressed Size which is Unknown or below 4G. The
+ *  First Bytes are then Decoded, as most False Hits fail within them.
+ * 
+ *  Parameters:
+ *          The Codec, the Stream and the Bytes Available
+ * 
+ *  Returns:
+ *          1 when the Stream looks Valid, else 0
+ */
+
+int ProbeStream(int Codec, const BYTE * Data, QWORD Available)
+{
+    QWORD Consumed, Produced;
+    
+    if (Codec == CODEC_LZMA)
+    {
+        if (Available < 13 || Data[0] >= 9 * 5 * 5)
+        {
+            return 0;
+        }
+        
+        QWORD Dictionary = Data[1] | Data[2] << 8 | Data[3] << 16 | (QWORD) Data[4] << 24;
+        
+        QWORD Power = Dictionary % 3 == 0 ? Dictionary / 3 : Dictionary;
+        
+        QWORD Uncompressed = 0;
+        
+        int Counter;
+        
+        for (Counter = 0; Counter < 8; Counter ++)
+        {
+            Uncompressed |= (QWORD) Data[5 + Counter] << (8 * Counter);
+        }
+        
+        if (Dictionary < 4096 || (Power & (Power - 1)) != 0 || (Uncompressed != (QWORD) -1 && Uncompressed > (1ULL << 32)))
+        {
+            return 0;
+        }
+    }
+    
+    // The Stream Flags hold a Zero Byte, and a Check Type below 16
+    
+    else if (Codec == CODEC_XZ)
+    {
+        if (Available < 32 || Data[6] != 0 || Data[7] > 0x0F)
+        {
+            return 0;
+        }
+    }
+    
+    // The Reserved Flags are Clear
+    
+    else if (Codec == CODEC_GZIP)
+    {
+        if (Available < 18 || (Data[3] & 0xE0) != 0)
+        {
+            return 0;
+        }
+    }
+    
+    // Deflate with a Window up to 32K, no Preset Dictionary, and the Header Check
+    
+    else if (Codec == CODEC_ZLIB)
+    {
+        if (Available < 8 || (Data[0] & 0x0F) != 8 || (Data[0] >> 4) > 7 || (Data[1] & 0x20) != 0 || ((Data[0] << 8) | Data[1]) % 31 != 0)
+        {
+            return 0;
+        }
+    }
+    else
+    {
+        return 0;
+    }
+    
+    return DecodeStream(Codec, Data, Available, PROBE_LENGTH, NULL, NULL, &Consumed, &Produced) != DECODE_ERROR;
+}
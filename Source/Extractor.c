@@ -0,0 +1,1759 @@
+/********************************************************************
+ *                  Recursive Extractor                             *
+ *                                                                  *
+ *  [   Author  ]       -       Andrew Borg                         *
+ *  [   Type    ]       -       Firmware Analysis                   *
+ *  [   Date    ]       -       02.01.2014                          *
+ *                                                                  *
+ * ******************************************************************
+ *                                                                  *
+ *  Description                                                     *
+ *                                                                  *
+ *  Firmware is Nested : an Image holds Compressed Blobs, which     *
+ *  hold a PFS File System, which holds more Archives. This         *
+ *  Application does what the Binary Searcher, the Hex Dump's       *
+ *  Extraction and the PFS Unpacker do by Hand, in one Pass.        *
+ *                                                                  *
+ *  Each File is a Node of a Tree. A Node is Scanned for the        *
+ *  Signatures of the Formats below, each Hit is Validated, and     *
+ *  the Valid Hits are Carved to their own Files. A Node which is   *
+ *  a Container is Unpacked instead. Every Carved or Unpacked File  *
+ *  becomes a Node in turn, Written inside the Folder of it's       *
+ *  Parent :                                                        *
+ *                                                                  *
+ *      Output/0x1000.pfs                                           *
+ *      Output/0x1000.pfs.extracted/bin/busybox                     *
+ *      Output/0x1000.pfs.extracted/bin/busybox.extracted/...       *
+ *                                                                  *
+ *  The Nodes are Tasks of a Task Graph Run by the Thread Pool : a  *
+ *  Large Node is Scanned in Chunks by several Workers, and the     *
+ *  Children of every Node are Examined in Parallel. A Node is      *
+ *  Finished once all it's Children are, it's Totals are then Known.*
+ *                                                                  *
+ *  Compressed Streams ( LZMA, XZ, Gzip and Zlib ) are Decoded as   *
+ *  they are Carved, in Parallel, as their Length is only Known     *
+ *  once Decoded. The Decoded Data is a Child of the Stream :       *
+ *                                                                  *
+ *      Output/0x302000.lzma                                        *
+ *      Output/0x302000.lzma.extracted/0x302000                     *
+ *                                                                  *
+ *  Every other Node is a View of the Mapped Image or of a Decoded  *
+ *  Stream, nothing is Copied but the Files Written. The Decoded    *
+ *  Streams are kept in Memory while their Children are Examined,   *
+ *  within the -Memory Budget. Past it, a Stream is Decoded again   *
+ *  straight to it's File, which is Mapped back. With -List no File *
+ *  is Written, the Tree is Explored in Memory.                     *
+ *                                                                  *
+ *  Containers Nested deeper than -Depth are Written but not        *
+ *  Opened, and Files above -MaxSize, or past the -MaxTotal Bytes   *
+ *  Written, are not Written at all.                                *
+ *                                                                  *
+ *  The Tree is Reported as Extraction Records, and Written as a    *
+ *  single JSON Document to manifest.json inside the Output Folder. *
+ *                                                                  *
+ * ******************************************************************/
+
+#define _GNU_SOURCE
+
+#include <string.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "../Headers/Common.h"
+#include "../Headers/PFS.h"
+#include "../Headers/Decompress.h"
+#include "../Headers/TaskGraph.h"
+
+// Large Nodes are Scanned by one Task per Chunk
+
+#define SCAN_CHUNK (8 * 1024 * 1024)
+
+#define DEFAULT_DEPTH 8
+
+#define DEFAULT_MEMORY (1024ULL * 1024 * 1024)
+
+// Why the Output of a Stream was not Kept
+
+#define LIMIT_NONE      0
+#define LIMIT_MEMORY    1
+#define LIMIT_SIZE      2
+
+typedef struct Node Node;
+
+typedef struct Format Format;
+
+// A Format the Extractor Recognizes
+
+struct Format
+{
+    char * Name;
+    
+    const char * Magic;
+    
+    int MagicLength;
+    
+    // Returns the Length of the Valid Stream at Data, or 0
+    
+    QWORD (* Validate)(const Format * Kind, const BYTE * Data, QWORD Available);
+    
+    // Adds the Children of a Container, or NULL when the Format is not Opened
+    
+    void (* Unpack)(Node * Item);
+    
+    // The Codec of a Compressed Stream, it's Length is then Known once it is Decoded
+    
+    int Codec;
+
+};
+
+// A Compressed Stream, Decoded while it's Node is Carved
+
+typedef struct
+{
+    const BYTE * Data;
+    
+    QWORD Available;
+    
+    int Codec;
+    
+    // Set when the Output is Kept, rather than only Counted
+    
+    char Keep;
+    
+    int Result;
+    
+    QWORD Consumed;
+    
+    // The Output, and the Bytes of the Memory Budget it Reserved
+    
+    BYTE * Output;
+    
+    QWORD Capacity;
+    
+    QWORD Produced;
+    
+    QWORD Reserved;
+    
+    char Limit;
+
+} Stream;
+
+// A File of the Tree, the Input is the Root
+
+struct Node
+{
+    Node * Parent;
+    
+    Node ** Children;
+    
+    int ChildCount;
+    
+    int ChildCapacity;
+    
+    char * Name;
+    
+    char * Path;
+    
+    // The Folder holding the Children, Created with the First one Written
+    
+    char * Folder;
+    
+    char FolderMade;
+    
+    const Format * Kind;
+    
+    // The Data, inside the Parent's Data, at Offset
+    
+    const BYTE * Data;
+    
+    QWORD Offset;
+    
+    QWORD Size;
+    
+    int Depth;
+    
+    // Set once the Node is Written, or Found with -List
+    
+    char Extracted;
+    
+    char Status[96];
+    
+    // A Compressed Node's Decoded Stream, until it's Child takes the Output
+    
+    Stream * Decoded;
+    
+    // The Decoded Data Owned by the Node, and the Bytes of the Memory Budget it Reserved
+    
+    BYTE * Owned;
+    
+    QWORD Reserved;
+    
+    // Set when the Data did not fit the Budget, it is Decoded to the File and Mapped
+    
+    char Spilled;
+    
+    char Mapped;
+    
+    // The Files and Bytes Written for the Node and it's Children, Set once Finished
+    
+    QWORD Files;
+    
+    QWORD Bytes;
+    
+    Task * Finish;
+
+};
+
+// A Valid Hit found by a Scan
+
+typedef struct
+{
+    QWORD Offset;
+    
+    QWORD Length;
+    
+    const Format * Kind;
+    
+    Stream * Decoded;
+
+} Hit;
+
+// A Chunk of a Node being Scanned, and the Hits found inside it
+
+typedef struct
+{
+    Node * Item;
+    
+    QWORD Start;
+    
+    QWORD End;
+    
+    Hit * Hits;
+    
+    int Count;
+    
+    int Capacity;
+
+} ScanJob;
+
+typedef struct
+{
+    Node * Item;
+    
+    ScanJob * Jobs;
+    
+    int JobCount;
+
+} Scan;
+
+// The Hits of a Node, once it's Compressed Streams are Decoded
+
+typedef struct
+{
+    Node * Item;
+    
+    Hit * Hits;
+    
+    int Count;
+
+} Carving;
+
+// The File a Spilled Stream is Decoded to
+
+typedef struct
+{
+    int Descriptor;
+    
+    QWORD Offset;
+
+} DecodedFile;
+
+////////////////////////////////////////////////////////////////////////////////
+
+// Internal Function Prototypes
+
+void ExtractImage(char * ImageFile, char * Folder);
+
+Node * CreateChild(Node * Parent, char * Name, const Format * Kind, const BYTE * Data, QWORD Offset, QWORD Size, const char * Status);
+
+void SubmitChild(Node * Child);
+
+void ExamineNode(void * Context);
+
+void ScanChunk(void * Context);
+
+void CarveNode(void * Context);
+
+void DecodeHit(void * Context);
+
+void PlaceHits(void * Context);
+
+void FinishNode(void * Context);
+
+int WriteNode(Node * Item);
+
+int KeepDecoded(const BYTE * Data, QWORD Length, void * Context);
+
+int WriteDecoded(const BYTE * Data, QWORD Length, void * Context);
+
+void ReleaseStream(Stream * Decoded);
+
+int CompareHits(const void * First, const void * Second);
+
+QWORD ValidatePFS(const Format * Kind, const BYTE * Data, QWORD Available);
+
+QWORD ValidateELF(const Format * Kind, const BYTE * Data, QWORD Available);
+
+QWORD ValidateStream(const Format * Kind, const BYTE * Data, QWORD Available);
+
+void UnpackPFS(Node * Item);
+
+void UnpackStream(Node * Item);
+
+void ReportNode(Node * Item);
+
+void WriteManifestNode(FILE * Manifest, Node * Item, int Indent);
+
+void FreeNode(Node * Item);
+
+// The Recognized Formats, Zlib has one Magic per Compression Level
+
+static const Format Formats[] =
+{
+    { "pfs", "PFS/0.9\0", 8, ValidatePFS, UnpackPFS, CODEC_NONE },
+    { "elf", "\x7F" "ELF", 4, ValidateELF, NULL, CODEC_NONE },
+    { "lzma", "\x5D\x00\x00", 3, ValidateStream, UnpackStream, CODEC_LZMA },
+    { "xz", "\xFD" "7zXZ\0", 6, ValidateStream, UnpackStream, CODEC_XZ },
+    { "gz", "\x1F\x8B\x08", 3, ValidateStream, UnpackStream, CODEC_GZIP },
+    { "zlib", "\x78\x01", 2, ValidateStream, UnpackStream, CODEC_ZLIB },
+    { "zlib", "\x78\x5E", 2, ValidateStream, UnpackStream, CODEC_ZLIB },
+    { "zlib", "\x78\x9C", 2, ValidateStream, UnpackStream, CODEC_ZLIB },
+    { "zlib", "\x78\xDA", 2, ValidateStream, UnpackStream, CODEC_ZLIB }
+};
+
+#define FORMAT_COUNT (int) (sizeof(Formats) / sizeof(Format))
+
+// The Limits, and the State shared by the Tasks
+
+static int MaxDepth;
+
+static QWORD MaxSize;
+
+static QWORD MaxTotal;
+
+static QWORD TotalWritten;
+
+static char ListOnly;
+
+static QWORD MemoryBudget;
+
+static QWORD MemoryUsed;
+
+static int Failed;
+
+static TaskGraph * Graph;
+
+////////////////////////////////////////////////////////////////////////////////
+
+int main(int argc, char * argv[])
+{
+    InitStats(&argc, argv);
+    InitOutput(&argc, argv);
+    
+    MaxDepth = DEFAULT_DEPTH;
+    MaxSize = 0;
+    MaxTotal = 0;
+    ListOnly = 0;
+    MemoryBudget = DEFAULT_MEMORY;
+    
+    int First = 1;
+    
+    // Each Option but -List is Followed by it's Value
+    
+    while (First + 1 < argc && argv[First][0] == '-')
+    {
+        if (strcmp(argv[First], "-List") == 0)
+        {
+            ListOnly = 1;
+            
+            First ++;
+            
+            continue;
+        }
+        
+        if (strcmp(argv[First], "-Depth") == 0)
+        {
+            MaxDepth = atoi(argv[First + 1]);
+        }
+        else if (strcmp(argv[First], "-MaxSize") == 0)
+        {
+            MaxSize = ParseSize(argv[First + 1]);
+        }
+        else if (strcmp(argv[First], "-MaxTotal") == 0)
+        {
+            MaxTotal = ParseSize(argv[First + 1]);
+        }
+        else if (strcmp(argv[First], "-Memory") == 0)
+        {
+            MemoryBudget = ParseSize(argv[First + 1]);
+        }
+        else
+        {
+            break;
+        }
+        
+        First += 2;
+    }
+    
+    if (MaxDepth > 0 && (argc - First == 1 || argc - First == 2) && argv[First][0] != '-')
+    {
+        char Folder[PATH_MAX];
+        
+        // The Default Output Folder is Named after the Image
+        
+        if (argc - First == 2)
+        {
+            snprintf(Folder, sizeof(Folder), "%s", argv[First + 1]);
+        }
+        else
+        {
+            snprintf(Folder, sizeof(Folder), "%s.extracted", argv[First]);
+        }
+        
+        int Phase = STATS_BEGIN("Extract");
+        
+        ExtractImage(argv[First], Folder);
+        
+        STATS_END(Phase);
+    }
+    else
+    {
+        puts("Syntax : \r\n");
+        
+        printf("\t %s [-List] [-Depth COUNT] [-MaxSize SIZE] [-MaxTotal SIZE] [-Memory SIZE] <Image> [Output Folder] \r\n\r\n", argv[0]);
+        
+        puts("Available Options:");
+        
+        printf("\t -List          : Explore the Tree in Memory, only the Manifest is Written \r\n");
+        printf("\t -Depth COUNT   : Containers Nested deeper are Written but not Opened ( Default %d ) \r\n", DEFAULT_DEPTH);
+        printf("\t -MaxSize SIZE  : Files Larger are not Written \r\n");
+        printf("\t -MaxTotal SIZE : Stop Writing Files once SIZE Bytes were Written \r\n");
+        printf("\t -Memory SIZE   : The Decoded Streams kept in Memory ( Default 1G ) \r\n\r\n");
+        
+        puts("Recognized Formats:");
+        
+        int Counter;
+        
+        for (Counter = 0; Counter < FORMAT_COUNT; Counter ++)
+        {
+            if (Counter == 0 || strcmp(Formats[Counter].Name, Formats[Counter - 1].Name) != 0)
+            {
+                printf("\t %-6s %s \r\n", Formats[Counter].Name, Formats[Counter].Codec ? "( Decoded )" : Formats[Counter].Unpack ? "( Unpacked )" : "( Carved )");
+            }
+        }
+        
+        printf("\r\n\t The Output Folder Defaults to <Image>.extracted \r\n");
+    }
+    
+    return 0;
+}
+
+/*  The Extract Image Method Builds the Tree of an Image, Writing every File
+ *  found inside it, then Reports the Tree and Writes it's Manifest.
+ * 
+ *  Parameters:
+ *          Image File  : Char Array with the Name of the Image
+ *          Folder      : Char Array with the Folder the Files are Written to
+ * 
+ *  Returns :
+ *          VOID
+ */
+
+void ExtractImage(char * ImageFile, char * Folder)
+{
+    QWORD ImageSize;
+    
+    BYTE * Image = MapFile(ImageFile, &ImageSize);
+    
+    if (mkdir(Folder, 0755) != 0 && errno != EEXIST)
+    {
+        puts("Error Creating the Output Folder");
+        exit(-1);
+    }
+    
+    TotalWritten = 0;
+    MemoryUsed = 0;
+    Failed = 0;
+    
+    Node * Root = calloc(1, sizeof(Node));
+    
+    char * Name = strrchr(ImageFile, '/');
+    
+    Root -> Name = strdup(Name ? Name + 1 : ImageFile);
+    Root -> Path = strdup(ImageFile);
+    Root -> Folder = strdup(Folder);
+    Root -> FolderMade = 1;
+    Root -> Data = Image;
+    Root -> Size = ImageSize;
+    
+    snprintf(Root -> Status, sizeof(Root -> Status), "Input");
+    
+    // The Root is not Written, only Examined
+    
+    Graph = CreateGraph();
+    
+    Task * Examine = CreateTask(Graph, ExamineNode, Root);
+    
+    Root -> Finish = CreateTask(Graph, FinishNode, Root);
+    
+    AddDependency(Root -> Finish, Examine);
+    
+    SubmitTask(Examine);
+    SubmitTask(Root -> Finish);
+    
+    RunGraph(Graph);
+    
+    FreeGraph(Graph);
+    
+    // Every Node is Reported in Tree Order
+    
+    OutputText("--------------------------------------------------------------------- \r\n\r\n");
+    
+    int Counter;
+    
+    for (Counter = 0; Counter < Root -> ChildCount; Counter ++)
+    {
+        ReportNode(Root -> Children[Counter]);
+    }
+    
+    char ManifestPath[PATH_MAX];
+    
+    snprintf(ManifestPath, sizeof(ManifestPath), "%s/manifest.json", Folder);
+    
+    FILE * Manifest = fopen(ManifestPath, "w");
+    
+    if (Manifest == NULL)
+    {
+        puts("Error Writing the Manifest");
+        exit(-1);
+    }
+    
+    WriteManifestNode(Manifest, Root, 0);
+    
+    fprintf(Manifest, "\n");
+    
+    fclose(Manifest);
+    
+    OutputText("\r\n%llu Files, %llu Bytes %s %s \r\n", (unsigned long long) Root -> Files,
+               (unsigned long long) Root -> Bytes, ListOnly ? "Found in" : "Extracted to", ListOnly ? ImageFile : Folder);
+    OutputText("Manifest Written to %s \r\n", ManifestPath);
+    
+    FreeNode(Root);
+    
+    UnmapFile(Image, ImageSize);
+    
+    if (Failed > 0)
+    {
+        puts("Error Writing File");
+        exit(-1);
+    }
+}
+
+/*
+ *  The Create Child Method will add a File found inside a Node to the Tree.
+ *  It is only Called by the Task Examining or Carving the Parent, which
+ *  then Submits the Child.
+ * 
+ *  Parameters:
+ *          The Parent, the Child's Name inside the Parent's Folder, it's Format or NULL,
+ *          it's Data, Offset and Size, and a Status when the Child is Skipped ( or NULL )
+ * 
+ *  Returns:
+ *          The Child
+ */
+
+Node * CreateChild(Node * Parent, char * Name, const Format * Kind, const BYTE * Data, QWORD Offset, QWORD Size, const char * Status)
+{
+    Node * Child = calloc(1, sizeof(Node));
+    
+    Child -> Parent = Parent;
+    Child -> Kind = Kind;
+    Child -> Data = Data;
+    Child -> Offset = Offset;
+    Child -> Size = Size;
+    Child -> Depth = Parent -> Depth + 1;
+    Child -> Name = strdup(Name);
+    
+    if (Parent -> ChildCount == Parent -> ChildCapacity)
+    {
+        Parent -> ChildCapacity = Parent -> ChildCapacity ? Parent -> ChildCapacity * 2 : 8;
+        
+        Parent -> Children = realloc(Parent -> Children, Parent -> ChildCapacity * sizeof(Node *));
+    }
+    
+    Parent -> Children[Parent -> ChildCount ++] = Child;
+    
+    if (Parent -> Folder == NULL)
+    {
+        Parent -> Folder = malloc(strlen(Parent -> Path) + 11);
+        
+        sprintf(Parent -> Folder, "%s.extracted", Parent -> Path);
+    }
+    
+    Child -> Path = malloc(strlen(Parent -> Folder) + strlen(Name) + 2);
+    
+    sprintf(Child -> Path, "%s/%s", Parent -> Folder, Name);
+    
+    if (Status)
+    {
+        snprintf(Child -> Status, sizeof(Child -> Status), "%s", Status);
+        
+        return Child;
+    }
+    
+    if (ListOnly)
+    {
+        return Child;
+    }
+    
+    if (!Parent -> FolderMade)
+    {
+        mkdir(Parent -> Folder, 0755);
+        
+        Parent -> FolderMade = 1;
+    }
+    
+    // Names holding Folders, as inside a PFS, have them Created
+    
+    char * Separator = Child -> Path + strlen(Parent -> Folder) + 1;
+    
+    while ((Separator = strchr(Separator, '/')) != NULL)
+    {
+        *Separator = '\0';
+        
+        mkdir(Child -> Path, 0755);
+        
+        *Separator = '/';
+        
+        Separator ++;
+    }
+    
+    return Child;
+}
+
+/*
+ *  The Submit Child Method will Submit the Tasks Examining and Finishing a
+ *  Child, unless it is Skipped. The Parent is not Finished before the Child is.
+ * 
+ *  Parameters:
+ *          The Child
+ * 
+ *  Returns:
+ *          VOID
+ */
+
+void SubmitChild(Node * Child)
+{
+    Node * Parent = Child -> Parent;
+    
+    if (Child -> Status[0])
+    {
+        return;
+    }
+    
+    Task * Examine = CreateTask(Graph, ExamineNode, Child);
+    
+    Child -> Finish = CreateTask(Graph, FinishNode, Child);
+    
+    AddDependency(Child -> Finish, Examine);
+    AddDependency(Parent -> Finish, Child -> Finish);
+    
+    SubmitTask(Examine);
+    SubmitTask(Child -> Finish);
+    
+    STATS_ADD(STAT_HITS, 1);
+}
+
+/*
+ *  The Examine Node Method is the First Task of a Node. It Writes the Node,
+ *  then Unpacks it if it is a Container, or Scans it for the Formats when
+ *  it's Format is not Known.
+ * 
+ *  Parameters:
+ *          The Node
+ * 
+ *  Returns:
+ *          VOID
+ */
+
+void ExamineNode(void * Context)
+{
+    Node * Item = Context;
+    
+    if (Item -> Parent && !WriteNode(Item))
+    {
+        return;
+    }
+    
+    // Known Formats which are not Containers are not Opened
+    
+    if (Item -> Kind && !Item -> Kind -> Unpack)
+    {
+        return;
+    }
+    
+    if (Item -> Depth >= MaxDepth)
+    {
+        if (Item -> Kind)
+        {
+            snprintf(Item -> Status, sizeof(Item -> Status), "%s, Not Opened ( Depth Limit )", ListOnly ? "Found" : "Written");
+        }
+        
+        return;
+    }
+    
+    if (Item -> Kind)
+    {
+        Item -> Kind -> Unpack(Item);
+        
+        return;
+    }
+    
+    // The Chunks are Scanned in Parallel, and Carved once all of them are Done
+    
+    Scan * Search = calloc(1, sizeof(Scan));
+    
+    Search -> Item = Item;
+    Search -> JobCount = Item -> Size / SCAN_CHUNK + 1;
+    Search -> Jobs = calloc(Search -> JobCount, sizeof(ScanJob));
+    
+    Task * Carve = CreateTask(Graph, CarveNode, Search);
+    
+    AddDependency(Item -> Finish, Carve);
+    
+    int Counter;
+    
+    for (Counter = 0; Counter < Search -> JobCount; Counter ++)
+    {
+        ScanJob * Job = &Search -> Jobs[Counter];
+        
+        Job -> Item = Item;
+        Job -> Start = (QWORD) Counter * SCAN_CHUNK;
+        Job -> End = Job -> Start + SCAN_CHUNK < Item -> Size ? Job -> Start + SCAN_CHUNK : Item -> Size;
+        
+        Task * Chunk = CreateTask(Graph, ScanChunk, Job);
+        
+        AddDependency(Carve, Chunk);
+        
+        SubmitTask(Chunk);
+    }
+    
+    SubmitTask(Carve);
+}
+
+/*
+ *  The Write Node Method will Write a Node to it's Path, unless it is
+ *  above the Size Limits. A Spilled Node is Decoded from it's Parent
+ *  straight to the File, which is then Mapped as the Node's Data.
+ * 
+ *  Parameters:
+ *          The Node
+ * 
+ *  Returns:
+ *          1 when the Node can be Examined, the Node's Extracted and Status Fields are Set
+ */
+
+int WriteNode(Node * Item)
+{
+    if (ListOnly)
+    {
+        Item -> Extracted = 1;
+        
+        snprintf(Item -> Status, sizeof(Item -> Status), "Found");
+        
+        return 1;
+    }
+    
+    if (MaxSize && Item -> Size > MaxSize)
+    {
+        snprintf(Item -> Status, sizeof(Item -> Status), "Not Written ( Size Limit )");
+        
+        return 0;
+    }
+    
+    // The Total is Reserved before Writing, so the Workers together never go past it
+    
+    if (MaxTotal && __atomic_add_fetch(&TotalWritten, Item -> Size, __ATOMIC_RELAXED) > MaxTotal)
+    {
+        __atomic_sub_fetch(&TotalWritten, Item -> Size, __ATOMIC_RELAXED);
+        
+        snprintf(Item -> Status, sizeof(Item -> Status), "Not Written ( Total Size Limit )");
+        
+        return 0;
+    }
+    
+    int Output = open(Item -> Path, (Item -> Spilled ? O_RDWR : O_WRONLY) | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    
+    int Error = Output < 0;
+    
+    if (!Error && Item -> Spilled)
+    {
+        DecodedFile File = { Output, 0 };
+        
+        QWORD Consumed, Produced;
+        
+        Error = DecodeStream(Item -> Parent -> Kind -> Codec, Item -> Parent -> Data, Item -> Parent -> Size, 0, WriteDecoded, &File,
+                             &Consumed, &Produced) != DECODE_END;
+    }
+    else if (!Error)
+    {
+        Error = WriteAt(Output, Item -> Data, Item -> Size, 0) != 0;
+    }
+    
+    if (Error)
+    {
+        snprintf(Item -> Status, sizeof(Item -> Status), "Error Writing ( %s )", strerror(errno));
+        
+        __atomic_add_fetch(&Failed, 1, __ATOMIC_RELAXED);
+        
+        if (Output >= 0)
+        {
+            close(Output);
+        }
+        
+        return 0;
+    }
+    
+    Item -> Extracted = 1;
+    
+    snprintf(Item -> Status, sizeof(Item -> Status), "Written");
+    
+    STATS_ADD(STAT_FILES, 1);
+    
+    // The Spilled Data is Read back through the Page Cache
+    
+    if (Item -> Spilled)
+    {
+        void * Map = Item -> Size ? mmap(NULL, Item -> Size, PROT_READ, MAP_SHARED, Output, 0) : MAP_FAILED;
+        
+        if (Map == MAP_FAILED)
+        {
+            snprintf(Item -> Status, sizeof(Item -> Status), "Written, Not Opened ( Memory Limit )");
+            
+            close(Output);
+            
+            return 0;
+        }
+        
+        Item -> Data = Map;
+        Item -> Mapped = 1;
+    }
+    
+    close(Output);
+    
+    return 1;
+}
+
+// The Sink of a Spilled Stream, each Block is Appended to the File
+
+int WriteDecoded(const BYTE * Data, QWORD Length, void * Context)
+{
+    DecodedFile * File = Context;
+    
+    if (WriteAt(File -> Descriptor, Data, Length, File -> Offset) != 0)
+    {
+        return 1;
+    }
+    
+    File -> Offset += Length;
+    
+    return 0;
+}
+
+/*
+ *  The Scan Chunk Method will Search a Chunk of a Node for the Magic of
+ *  every Format, and Validate each Hit. A Hit Starting inside the Chunk is
+ *  Validated against the Rest of the Node.
+ * 
+ *  Parameters:
+ *          The Scan Job
+ * 
+ *  Returns:
+ *          VOID, the Valid Hits are Added to the Job
+ */
+
+void ScanChunk(void * Context)
+{
+    ScanJob * Job = Context;
+    
+    const BYTE * Data = Job -> Item -> Data;
+    
+    QWORD Size = Job -> Item -> Size;
+    
+    int Counter;
+    
+    for (Counter = 0; Counter < FORMAT_COUNT; Counter ++)
+    {
+        const Format * Kind = &Formats[Counter];
+        
+        QWORD Position = Job -> Start;
+        
+        while (Position < Job -> End)
+        {
+            // The Magic may Cross the End of the Chunk
+            
+            QWORD Limit = Job -> End + Kind -> MagicLength - 1 < Size ? Job -> End + Kind -> MagicLength - 1 : Size;
+            
+            const BYTE * Found = memmem(Data + Position, Limit - Position, Kind -> Magic, Kind -> MagicLength);
+            
+            if (Found == NULL)
+            {
+                break;
+            }
+            
+            Position = Found - Data;
+            
+            QWORD Length = Kind -> Validate(Kind, Found, Size - Position);
+            
+            if (Length > 0)
+            {
+                if (Job -> Count == Job -> Capacity)
+                {
+                    Job -> Capacity = Job -> Capacity ? Job -> Capacity * 2 : 16;
+                    
+                    Job -> Hits = realloc(Job -> Hits, Job -> Capacity * sizeof(Hit));
+                }
+                
+                Hit Valid = { Position, Length, Kind, NULL };
+                
+                Job -> Hits[Job -> Count ++] = Valid;
+            }
+            
+            Position ++;
+        }
+    }
+}
+
+// Orders the Hits by Offset, the Longest First
+
+int CompareHits(const void * First, const void * Second)
+{
+    const Hit * Left = First, * Right = Second;
+    
+    if (Left -> Offset != Right -> Offset)
+    {
+        return Left -> Offset < Right -> Offset ? -1 : 1;
+    }
+    
+    return Left -> Length > Right -> Length ? -1 : Left -> Length < Right -> Length;
+}
+
+/*
+ *  The Carve Node Method is Run once every Chunk of a Node was Scanned. Hits
+ *  inside an Earlier Hit of a Known Length are Dropped. The Compressed
+ *  Streams left are Decoded in Parallel, each by it's own Task, and the
+ *  Hits are Placed once all of them are Done.
+ * 
+ *  Parameters:
+ *          The Scan
+ * 
+ *  Returns:
+ *          VOID
+ */
+
+void CarveNode(void * Context)
+{
+    Scan * Search = Context;
+    
+    Node * Item = Search -> Item;
+    
+    int Total = 0, Counter;
+    
+    for (Counter = 0; Counter < Search -> JobCount; Counter ++)
+    {
+        Total += Search -> Jobs[Counter].Count;
+    }
+    
+    Hit * Hits = malloc((Total + 1) * sizeof(Hit));
+    
+    Total = 0;
+    
+    for (Counter = 0; Counter < Search -> JobCount; Counter ++)
+    {
+        memcpy(Hits + Total, Search -> Jobs[Counter].Hits, Search -> Jobs[Counter].Count * sizeof(Hit));
+        
+        Total += Search -> Jobs[Counter].Count;
+        
+        free(Search -> Jobs[Counter].Hits);
+    }
+    
+    qsort(Hits, Total, sizeof(Hit), CompareHits);
+    
+    free(Search -> Jobs);
+    free(Search);
+    
+    // The Length of a Stream is not Known yet, only Known Lengths Drop the Hits they Cover
+    
+    Carving * Carve = malloc(sizeof(Carving));
+    
+    Carve -> Item = Item;
+    Carve -> Hits = Hits;
+    Carve -> Count = 0;
+    
+    int Streams = 0;
+    
+    QWORD End = 0;
+    
+    for (Counter = 0; Counter < Total; Counter ++)
+    {
+        if (Hits[Counter].Offset < End)
+        {
+            continue;
+        }
+        
+        Hits[Carve -> Count ++] = Hits[Counter];
+        
+        if (Hits[Counter].Kind -> Codec)
+        {
+            Streams ++;
+        }
+        else
+        {
+            End = Hits[Counter].Offset + Hits[Counter].Length;
+        }
+    }
+    
+    if (Streams == 0)
+    {
+        PlaceHits(Carve);
+        
+        return;
+    }
+    
+    Task * Place = CreateTask(Graph, PlaceHits, Carve);
+    
+    AddDependency(Item -> Finish, Place);
+    
+    for (Counter = 0; Counter < Carve -> Count; Counter ++)
+    {
+        if (!Hits[Counter].Kind -> Codec)
+        {
+            continue;
+        }
+        
+        Stream * Decoded = calloc(1, sizeof(Stream));
+        
+        Decoded -> Data = Item -> Data + Hits[Counter].Offset;
+        Decoded -> Available = Item -> Size - Hits[Counter].Offset;
+        Decoded -> Codec = Hits[Counter].Kind -> Codec;
+        
+        // Streams past the Depth are only Measured, unless the Node may be the Stream itself
+        
+        Decoded -> Keep = Item -> Depth + 1 < MaxDepth || Hits[Counter].Offset == 0;
+        
+        Hits[Counter].Decoded = Decoded;
+        
+        Task * Decode = CreateTask(Graph, DecodeHit, Decoded);
+        
+        AddDependency(Place, Decode);
+        
+        SubmitTask(Decode);
+    }
+    
+    SubmitTask(Place);
+}
+
+/*
+ *  The Decode Hit Method will Decode a Compressed Stream to Memory, which
+ *  gives it's Length. The Output is Kept within the Memory Budget.
+ * 
+ *  Parameters:
+ *          The Stream
+ * 
+ *  Returns:
+ *          VOID, the Stream's Result, Consumed and Output are Set
+ */
+
+void DecodeHit(void * Context)
+{
+    Stream * Decoded = Context;
+    
+    QWORD Produced;
+    
+    Decoded -> Result = DecodeStream(Decoded -> Codec, Decoded -> Data, Decoded -> Available, 0, KeepDecoded, Decoded,
+                                     &Decoded -> Consumed, &Produced);
+    
+    if (Decoded -> Result != DECODE_END)
+    {
+        ReleaseStream(Decoded);
+        
+        return;
+    }
+    
+    // The Room left past the Output is given back to the Budget
+    
+    if (Decoded -> Output && Decoded -> Capacity > Decoded -> Produced)
+    {
+        Decoded -> Output = realloc(Decoded -> Output, Decoded -> Produced ? Decoded -> Produced : 1);
+        
+        __atomic_sub_fetch(&MemoryUsed, Decoded -> Capacity - Decoded -> Produced, __ATOMIC_RELAXED);
+        
+        Decoded -> Reserved -= Decoded -> Capacity - Decoded -> Produced;
+        Decoded -> Capacity = Decoded -> Produced;
+    }
+}
+
+/*
+ *  The Keep Decoded Method is the Sink of a Stream being Carved. The Output
+ *  is Appended to the Stream's Buffer, which Grows while the Memory Budget
+ *  allows it. Past the Budget, or past -MaxSize, the Output is Dropped and
+ *  only Counted.
+ * 
+ *  Parameters:
+ *          A Block of Decoded Bytes, and the Stream
+ * 
+ *  Returns:
+ *          0, the Stream is always Decoded to it's End
+ */
+
+int KeepDecoded(const BYTE * Data, QWORD Length, void * Context)
+{
+    Stream * Decoded = Context;
+    
+    if (Decoded -> Limit == LIMIT_NONE && !ListOnly && MaxSize && Decoded -> Produced + Length > MaxSize)
+    {
+        ReleaseStream(Decoded);
+        
+        Decoded -> Limit = LIMIT_SIZE;
+    }
+    
+    if (Decoded -> Limit == LIMIT_NONE && Decoded -> Keep && Decoded -> Produced + Length > Decoded -> Capacity)
+    {
+        QWORD Capacity = Decoded -> Capacity ? Decoded -> Capacity : 64 * 1024;
+        
+        while (Capacity < Decoded -> Produced + Length)
+        {
+            Capacity *= 2;
+        }
+        
+        QWORD Growth = Capacity - Decoded -> Capacity;
+        
+        if (__atomic_add_fetch(&MemoryUsed, Growth, __ATOMIC_RELAXED) > MemoryBudget)
+        {
+            __atomic_sub_fetch(&MemoryUsed, Growth, __ATOMIC_RELAXED);
+            
+            ReleaseStream(Decoded);
+            
+            Decoded -> Limit = LIMIT_MEMORY;
+        }
+        else
+        {
+            Decoded -> Output = realloc(Decoded -> Output, Capacity);
+            Decoded -> Capacity = Capacity;
+            Decoded -> Reserved += Growth;
+        }
+    }
+    
+    if (Decoded -> Limit == LIMIT_NONE && Decoded -> Keep)
+    {
+        memcpy(Decoded -> Output + Decoded -> Produced, Data, Length);
+    }
+    
+    Decoded -> Produced += Length;
+    
+    return 0;
+}
+
+// Releases a Stream's Output, and the Budget it Reserved
+
+void ReleaseStream(Stream * Decoded)
+{
+    free(Decoded -> Output);
+    
+    __atomic_sub_fetch(&MemoryUsed, Decoded -> Reserved, __ATOMIC_RELAXED);
+    
+    Decoded -> Output = NULL;
+    Decoded -> Capacity = 0;
+    Decoded -> Reserved = 0;
+}
+
+/*
+ *  The Place Hits Method is Run once the Compressed Streams of a Node are
+ *  Decoded, and their Lengths Known. Invalid Streams, and Hits inside an
+ *  Earlier Hit, are Dropped, the Rest are Added as Children. A Node which
+ *  is a single Hit is that Container or Stream, and is Unpacked instead.
+ * 
+ *  Parameters:
+ *          The Carving
+ * 
+ *  Returns:
+ *          VOID
+ */
+
+void PlaceHits(void * Context)
+{
+    Carving * Carve = Context;
+    
+    Node * Item = Carve -> Item;
+    
+    Hit * Hits = Carve -> Hits;
+    
+    int Kept = 0, Counter;
+    
+    QWORD End = 0;
+    
+    for (Counter = 0; Counter < Carve -> Count; Counter ++)
+    {
+        Stream * Decoded = Hits[Counter].Decoded;
+        
+        if (Decoded)
+        {
+            Hits[Counter].Length = Decoded -> Result == DECODE_END ? Decoded -> Consumed : 0;
+        }
+        
+        if (Hits[Counter].Length == 0 || (Kept > 0 && Hits[Counter].Offset < End))
+        {
+            if (Decoded)
+            {
+                ReleaseStream(Decoded);
+                
+                free(Decoded);
+            }
+            
+            continue;
+        }
+        
+        Hits[Kept ++] = Hits[Counter];
+        
+        End = Hits[Counter].Offset + Hits[Counter].Length;
+    }
+    
+    if (Kept == 1 && Hits[0].Offset == 0 && Hits[0].Length == Item -> Size)
+    {
+        Item -> Kind = Hits[0].Kind;
+        Item -> Decoded = Hits[0].Decoded;
+        
+        if (Item -> Kind -> Unpack)
+        {
+            Item -> Kind -> Unpack(Item);
+        }
+    }
+    else
+    {
+        for (Counter = 0; Counter < Kept; Counter ++)
+        {
+            char Name[64];
+            
+            snprintf(Name, sizeof(Name), "0x%llX.%s", (unsigned long long) Hits[Counter].Offset, Hits[Counter].Kind -> Name);
+            
+            Node * Child = CreateChild(Item, Name, Hits[Counter].Kind, Item -> Data + Hits[Counter].Offset, Hits[Counter].Offset,
+                                       Hits[Counter].Length, NULL);
+            
+            Child -> Decoded = Hits[Counter].Decoded;
+            
+            SubmitChild(Child);
+        }
+    }
+    
+    free(Hits);
+    free(Carve);
+}
+
+/*
+ *  The Finish Node Method is Run once a Node and all it's Children are Done,
+ *  and Sums the Files and Bytes Written for the Node. No Child uses the
+ *  Node's Data any more, Decoded Data is Released.
+ * 
+ *  Parameters:
+ *          The Node
+ * 
+ *  Returns:
+ *          VOID
+ */
+
+void FinishNode(void * Context)
+{
+    Node * Item = Context;
+    
+    Item -> Files = Item -> Extracted;
+    Item -> Bytes = Item -> Extracted ? Item -> Size : 0;
+    
+    int Counter;
+    
+    for (Counter = 0; Counter < Item -> ChildCount; Counter ++)
+    {
+        Item -> Files += Item -> Children[Counter] -> Files;
+        Item -> Bytes += Item -> Children[Counter] -> Bytes;
+    }
+    
+    // A Stream not Opened still holds it's Output
+    
+    if (Item -> Decoded)
+    {
+        ReleaseStream(Item -> Decoded);
+        
+        free(Item -> Decoded);
+        
+        Item -> Decoded = NULL;
+    }
+    
+    if (Item -> Owned)
+    {
+        free(Item -> Owned);
+        
+        __atomic_sub_fetch(&MemoryUsed, Item -> Reserved, __ATOMIC_RELAXED);
+    }
+    
+    if (Item -> Mapped)
+    {
+        munmap((void *) Item -> Data, Item -> Size);
+    }
+    
+    Item -> Owned = NULL;
+    Item -> Data = NULL;
+}
+
+// Reads a Little or Big Endian Value of 1 to 8 Bytes
+
+static QWORD ReadValue(const BYTE * Data, int Length, int BigEndian)
+{
+    QWORD Value = 0;
+    
+    int Counter;
+    
+    for (Counter = 0; Counter < Length; Counter ++)
+    {
+        Value |= (QWORD) Data[BigEndian ? Length - 1 - Counter : Counter] << (8 * Counter);
+    }
+    
+    return Value;
+}
+
+/*
+ *  The Validate PFS Method will Check a PFS Header and it's Entry Table, as
+ *  Written by the PFS Packer.
+ * 
+ *  Parameters:
+ *          The Data at the Hit, and the Bytes Available from there
+ * 
+ *  Returns:
+ *          The Length of the Archive, up to the End of it's Last File, or 0
+ */
+
+QWORD ValidatePFS(const Format * Kind, const BYTE * Data, QWORD Available)
+{
+    (void) Kind;
+    
+    if (Available < HEADER_SIZE)
+    {
+        return 0;
+    }
+    
+    QWORD Entries = ReadValue(Data + 14, 2, 0);
+    
+    QWORD Segment = HEADER_SIZE + Entries * ENTRY_SIZE;
+    
+    if (Entries == 0 || Segment > Available)
+    {
+        return 0;
+    }
+    
+    QWORD Length = Segment;
+    
+    QWORD Counter;
+    
+    for (Counter = 0; Counter < Entries; Counter ++)
+    {
+        const BYTE * Entry = Data + HEADER_SIZE + Counter * ENTRY_SIZE;
+        
+        // Each Name is Terminated inside it's Block
+        
+        if (Entry[0] == '\0' || memchr(Entry, '\0', NAME_BLOCK) == NULL)
+        {
+            return 0;
+        }
+        
+        QWORD End = Segment + ReadValue(Entry + NAME_BLOCK + 4, 4, 0) + ReadValue(Entry + NAME_BLOCK + 8, 4, 0);
+        
+        if (End > Available)
+        {
+            return 0;
+        }
+        
+        Length = End > Length ? End : Length;
+    }
+    
+    return Length;
+}
+
+/*
+ *  The Validate Stream Method will Check the Header of a Compressed Stream,
+ *  and Decode it's First Bytes ( See ProbeStream ). The Length is Known once
+ *  the Stream is Decoded, when it is Carved.
+ * 
+ *  Parameters:
+ *          The Format, the Data at the Hit, and the Bytes Available from there
+ * 
+ *  Returns:
+ *          The Bytes Available, or 0
+ */
+
+QWORD ValidateStream(const Format * Kind, const BYTE * Data, QWORD Available)
+{
+    return ProbeStream(Kind -> Codec, Data, Available) ? Available : 0;
+}
+
+/*
+ *  The Validate ELF Method will Check an ELF Header, 32 or 64 Bit in either
+ *  Byte Order, and the Program and Section Tables it points to.
+ * 
+ *  Parameters:
+ *          The Data at the Hit, and the Bytes Available from there
+ * 
+ *  Returns:
+ *          The Length of the File, up to the End of it's Last Table or Section, or 0
+ */
+
+QWORD ValidateELF(const Format * Kind, const BYTE * Data, QWORD Available)
+{
+    (void) Kind;
+    
+    if (Available < 52 || (Data[4] != 1 && Data[4] != 2) || (Data[5] != 1 && Data[5] != 2) || Data[6] != 1)
+    {
+        return 0;
+    }
+    
+    int Wide = Data[4] == 2, Big = Data[5] == 2;
+    
+    QWORD Length = Wide ? 64 : 52;
+    
+    if (Available < Length)
+    {
+        return 0;
+    }
+    
+    int Word = Wide ? 8 : 4;
+    
+    QWORD ProgramTable = ReadValue(Data + (Wide ? 32 : 28), Word, Big);
+    QWORD SectionTable = ReadValue(Data + (Wide ? 40 : 32), Word, Big);
+    QWORD ProgramSize = ReadValue(Data + (Wide ? 54 : 42), 2, Big);
+    QWORD ProgramCount = ReadValue(Data + (Wide ? 56 : 44), 2, Big);
+    QWORD SectionSize = ReadValue(Data + (Wide ? 58 : 46), 2, Big);
+    QWORD SectionCount = ReadValue(Data + (Wide ? 60 : 48), 2, Big);
+    
+    // Each Table has to fit, and so does every Segment and Section it Describes
+    
+    if ((ProgramCount && (ProgramSize < (QWORD) (Wide ? 56 : 32) || ProgramTable > Available || ProgramCount * ProgramSize > Available - ProgramTable)) ||
+        (SectionCount && (SectionSize < (QWORD) (Wide ? 64 : 40) || SectionTable > Available || SectionCount * SectionSize > Available - SectionTable)))
+    {
+        return 0;
+    }
+    
+    if (ProgramCount && ProgramTable + ProgramCount * ProgramSize > Length)
+    {
+        Length = ProgramTable + ProgramCount * ProgramSize;
+    }
+    
+    if (SectionCount && SectionTable + SectionCount * SectionSize > Length)
+    {
+        Length = SectionTable + SectionCount * SectionSize;
+    }
+    
+    QWORD Counter;
+    
+    for (Counter = 0; Counter < ProgramCount; Counter ++)
+    {
+        const BYTE * Program = Data + ProgramTable + Counter * ProgramSize;
+        
+        QWORD Offset = ReadValue(Program + (Wide ? 8 : 4), Word, Big);
+        QWORD Size = ReadValue(Program + (Wide ? 32 : 16), Word, Big);
+        
+        if (Offset > Available || Size > Available - Offset)
+        {
+            return 0;
+        }
+        
+        Length = Offset + Size > Length ? Offset + Size : Length;
+    }
+    
+    for (Counter = 0; Counter < SectionCount; Counter ++)
+    {
+        const BYTE * Section = Data + SectionTable + Counter * SectionSize;
+        
+        // Sections of Type NOBITS take no Room inside the File
+        
+        if (ReadValue(Section + 4, 4, Big) == 8)
+        {
+            continue;
+        }
+        
+        QWORD Offset = ReadValue(Section + (Wide ? 24 : 16), Word, Big);
+        QWORD Size = ReadValue(Section + (Wide ? 32 : 20), Word, Big);
+        
+        if (Offset > Available || Size > Available - Offset)
+        {
+            return 0;
+        }
+        
+        Length = Offset + Size > Length ? Offset + Size : Length;
+    }
+    
+    return Length;
+}
+
+/*
+ *  The Unpack PFS Method will Add every File of a Validated PFS Archive as a
+ *  Child. Names escaping the Archive's Folder are Skipped, and of the Entries
+ *  sharing a Name only the Last is Written, as the PFS Unpacker does.
+ * 
+ *  Parameters:
+ *          The Node holding the Archive
+ * 
+ *  Returns:
+ *          VOID
+ */
+
+void UnpackPFS(Node * Item)
+{
+    QWORD Entries = ReadValue(Item -> Data + 14, 2, 0);
+    
+    QWORD Segment = HEADER_SIZE + Entries * ENTRY_SIZE;
+    
+    QWORD Counter, Index;
+    
+    for (Counter = 0; Counter < Entries; Counter ++)
+    {
+        const BYTE * Entry = Item -> Data + HEADER_SIZE + Counter * ENTRY_SIZE;
+        
+        char * Name = (char *) Entry;
+        
+        const char * Status = NULL;
+        
+        // Absolute Names are Written inside the Archive's Folder
+        
+        while (*Name == '/')
+        {
+            Name ++;
+        }
+        
+        if (*Name == '\0' || strcmp(Name, "..") == 0 || strncmp(Name, "../", 3) == 0 || strstr(Name, "/../") ||
+            (strlen(Name) >= 3 && strcmp(Name + strlen(Name) - 3, "/..") == 0))
+        {
+            Status = "Skipped, Invalid File Name";
+            Name = (char *) Entry;
+        }
+        
+        for (Index = Counter + 1; Index < Entries && !Status; Index ++)
+        {
+            if (strcmp((char *) Entry, (char *) Item -> Data + HEADER_SIZE + Index * ENTRY_SIZE) == 0)
+            {
+                Status = "Replaced by a Later Entry";
+            }
+        }
+        
+        QWORD Offset = Segment + ReadValue(Entry + NAME_BLOCK + 4, 4, 0);
+        
+        SubmitChild(CreateChild(Item, Name, NULL, Item -> Data + Offset, Offset, ReadValue(Entry + NAME_BLOCK + 8, 4, 0), Status));
+    }
+}
+
+/*
+ *  The Unpack Stream Method will Add the Decoded Data of a Compressed Node
+ *  as it's only Child, Named after the Node without it's Extension. The
+ *  Child takes the Output, or is Decoded again to it's File when the
+ *  Output did not fit the Memory Budget.
+ * 
+ *  Parameters:
+ *          The Node holding the Stream
+ * 
+ *  Returns:
+ *          VOID
+ */
+
+void UnpackStream(Node * Item)
+{
+    Stream * Decoded = Item -> Decoded;
+    
+    if (Decoded == NULL)
+    {
+        return;
+    }
+    
+    Item -> Decoded = NULL;
+    
+    char Name[NAME_BLOCK + 8];
+    
+    char * Base = strrchr(Item -> Name, '/');
+    
+    snprintf(Name, sizeof(Name), "%s", Base ? Base + 1 : Item -> Name);
+    
+    char * Extension = strrchr(Name, '.');
+    
+    if (Extension && Extension != Name)
+    {
+        *Extension = '\0';
+    }
+    
+    const char * Status = NULL;
+    
+    if (Decoded -> Limit == LIMIT_SIZE)
+    {
+        Status = "Not Written ( Size Limit )";
+    }
+    else if (Decoded -> Limit == LIMIT_MEMORY && ListOnly)
+    {
+        Status = "Not Opened ( Memory Limit )";
+    }
+    
+    Node * Child = CreateChild(Item, Name, NULL, Decoded -> Output, 0, Decoded -> Produced, Status);
+    
+    if (Status == NULL)
+    {
+        Child -> Owned = Decoded -> Output;
+        Child -> Reserved = Decoded -> Reserved;
+        Child -> Spilled = Decoded -> Limit == LIMIT_MEMORY;
+        
+        Decoded -> Output = NULL;
+        Decoded -> Reserved = 0;
+    }
+    
+    ReleaseStream(Decoded);
+    
+    free(Decoded);
+    
+    SubmitChild(Child);
+}
+
+/*
+ *  The Report Node Method will Emit the Extraction Record of a Node, then of
+ *  each of it's Children.
+ * 
+ *  Parameters:
+ *          The Node
+ * 
+ *  Returns:
+ *          VOID
+ */
+
+void ReportNode(Node * Item)
+{
+    EmitExtraction(Item -> Path, Item -> Offset, Item -> Size, Item -> Status);
+    
+    int Counter;
+    
+    for (Counter = 0; Counter < Item -> ChildCount; Counter ++)
+    {
+        ReportNode(Item -> Children[Counter]);
+    }
+}
+
+// Writes a JSON String, Escaping the Quotes, Backslashes and Control or non ASCII Bytes
+
+static void WriteJSONText(FILE * Manifest, const char * Text)
+{
+    fputc('"', Manifest);
+    
+    for (; *Text; Text ++)
+    {
+        BYTE Character = *Text;
+        
+        if (Character == '"' || Character == '\\')
+        {
+            fprintf(Manifest, "\\%c", Character);
+        }
+        else if (Character < 0x20 || Character >= 0x7F)
+        {
+            fprintf(Manifest, "\\u%04X", Character);
+        }
+        else
+        {
+            fputc(Character, Manifest);
+        }
+    }
+    
+    fputc('"', Manifest);
+}
+
+/*
+ *  The Write Manifest Node Method will Write a Node as a JSON Object, it's
+ *  Children Nested inside it.
+ * 
+ *  Parameters:
+ *          The Manifest File, the Node and it's Indentation
+ * 
+ *  Returns:
+ *          VOID
+ */
+
+void WriteManifestNode(FILE * Manifest, Node * Item, int Indent)
+{
+    fprintf(Manifest, "%*s{ \"name\": ", Indent, "");
+    
+    WriteJSONText(Manifest, Item -> Name);
+    
+    fprintf(Manifest, ", \"path\": ");
+    
+    if (Item -> Path && ((Item -> Extracted && !ListOnly) || !Item -> Parent))
+    {
+        WriteJSONText(Manifest, Item -> Path);
+    }
+    else
+    {
+        fprintf(Manifest, "null");
+    }
+    
+    fprintf(Manifest, ", \"format\": ");
+    
+    if (Item -> Kind)
+    {
+        WriteJSONText(Manifest, Item -> Kind -> Name);
+    }
+    else
+    {
+        fprintf(Manifest, "null");
+    }
+    
+    fprintf(Manifest, ", \"offset\": %llu, \"size\": %llu, \"depth\": %d, \"status\": ", (unsigned long long) Item -> Offset,
+            (unsigned long long) Item -> Size, Item -> Depth);
+    
+    WriteJSONText(Manifest, Item -> Status);
+    
+    fprintf(Manifest, ", \"files\": %llu, \"bytes\": %llu, \"children\": [", (unsigned long long) Item -> Files,
+            (unsigned long long) Item -> Bytes);
+    
+    int Counter;
+    
+    for (Counter = 0; Counter < Item -> ChildCount; Counter ++)
+    {
+        fprintf(Manifest, Counter ? ",\n" : "\n");
+        
+        WriteManifestNode(Manifest, Item -> Children[Counter], Indent + 2);
+    }
+    
+    if (Item -> ChildCount)
+    {
+        fprintf(Manifest, "\n%*s", Indent, "");
+    }
+    
+    fprintf(Manifest, "] }");
+}
+
+void FreeNode(Node * Item)
+{
+    int Counter;
+    
+    for (Counter = 0; Counter < Item -> ChildCount; Counter ++)
+    {
+        FreeNode(Item -> Children[Counter]);
+    }
+    
+    free(Item -> Children);
+    free(Item -> Name);
+    free(Item -> Path);
+    free(Item -> Folder);
+    free(Item);
+}
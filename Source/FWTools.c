@@ -0,0 +1,532 @@
+/********************************************************************
+ *                  Firmware Tools                                  *
+ *                                                                  *
+ *  [   Author  ]       -       Andrew Borg                         *
+ *  [   Type    ]       -       Firmware Analysis                   *
+ *  [   Date    ]       -       02.01.2014                          *
+ *                                                                  *
+ * ******************************************************************
+ *                                                                  *
+ *  Description                                                     *
+ *                                                                  *
+ *  Every Firmware Tool inside a single Executable. The Tool is     *
+ *  Chosen by the Name the Executable is Run with, so a Link        *
+ *  named HexDump runs the Hex Dump, or by the First Argument :     *
+ *                                                                  *
+ *      fwtools HexDump -Strings Image.bin                          *
+ *                                                                  *
+ *  A Batch runs a Script of Commands, one per Line, inside one     *
+ *  Process ( - Reads the Script from the Standard Input ) :        *
+ *                                                                  *
+ *      fwtools -batch [-cache SIZE] Script.txt                     *
+ *                                                                  *
+ *      # Anything following a # is a Comment                       *
+ *      BinarySearcher Image.bin                                    *
+ *      HexDump -Map Image.layout Image.bin                         *
+ *      Splitter "Image.layout" Image.bin "Out Folder"              *
+ *                                                                  *
+ *  The Process, the Dynamic Linking and the Thread Pool are only   *
+ *  Started once. The Files Mapped or Dumped by a Command are kept  *
+ *  for the next ones ( up to the Cache Size, 1G by Default ), and  *
+ *  the Signatures are only Read again when the Database Changes.   *
+ *                                                                  *
+ *  The Tools are Compiled with their main Renamed ( HexDumpMain )  *
+ *  and their exit Replaced by ExitTool, so a Failing Command only  *
+ *  ends it's own Line. What the Failed Command had Allocated or    *
+ *  Opened is not Released.                                         *
+ *                                                                  *
+ * ******************************************************************/
+
+#define _GNU_SOURCE
+
+#include <ctype.h>
+#include <pthread.h>
+#include <setjmp.h>
+#include <string.h>
+#include <strings.h>
+#include <time.h>
+
+#include "../Headers/Common.h"
+#include "../Headers/ThreadPool.h"
+#include "../Headers/FWTools.h"
+#include "../Headers/Daemon.h"
+
+// The Cache Budget of a Batch, when -cache is not Passed
+
+#define DEFAULT_CACHE_SIZE (1024ULL * 1024 * 1024)
+
+int MergerMain(int argc, char * argv[]);
+int SplitterMain(int argc, char * argv[]);
+int PFSPackerMain(int argc, char * argv[]);
+int PFSUnpackerMain(int argc, char * argv[]);
+int BinarySearcherMain(int argc, char * argv[]);
+int HexDumpMain(int argc, char * argv[]);
+int PadderMain(int argc, char * argv[]);
+int ExtractorMain(int argc, char * argv[]);
+int SerialMain(int argc, char * argv[]);
+
+static const Tool Tools[] =
+{
+    { "Merger", MergerMain, "Concatenates Files, or Assembles an Image from a Layout", WARM_NONE },
+    { "Splitter", SplitterMain, "Cuts an Image into the Partitions of a Layout", WARM_MAP },
+    { "PFSPacker", PFSPackerMain, "Packs a Folder inside a PFS/0.9 Image", WARM_NONE },
+    { "PFSUnpacker", PFSUnpackerMain, "Lists or Extracts a PFS/0.9 Image", WARM_MAP },
+    { "BinarySearcher", BinarySearcherMain, "Searches an Image for the Signatures of the Database", WARM_NO_NULLS },
+    { "HexDump", HexDumpMain, "Hex, Strings, Partitions and Extraction", WARM_DUMP },
+    { "Padder", PadderMain, "Pads a Partition and Writes the Belkin Trailer", WARM_NONE },
+    { "Extractor", ExtractorMain, "Recursively Carves and Unpacks the Files inside an Image", WARM_MAP },
+    { "Serial", SerialMain, "Connects to a Serial Port, Logs it, Uploads and Dumps through it", WARM_NONE }
+};
+
+#define TOOL_COUNT ((int) (sizeof(Tools) / sizeof(Tools[0])))
+
+// Set while a Batch Command Runs, ExitTool Jumps back to the Batch instead of Ending the Process
+
+static jmp_buf * CommandJump = NULL;
+
+static pthread_t BatchThread;
+
+int RunBatch(char * ScriptName, QWORD CacheSize);
+
+int StartDaemon(int argc, char * argv[]);
+
+void PrintHelp(char * ProgramName);
+
+////////////////////////////////////////////////////////////////////////////////
+
+int main(int argc, char * argv[])
+{
+    // --stats in front of a Batch Reports each Command
+    
+    InitStats(&argc, argv);
+    InitOutput(&argc, argv);
+    
+    // A Link named after a Tool Runs it
+    
+    char * Name = strrchr(argv[0], '/') ? strrchr(argv[0], '/') + 1 : argv[0];
+    
+    const Tool * Chosen = FindTool(Name);
+    
+    if (Chosen)
+    {
+        return Chosen -> Main(argc, argv);
+    }
+    
+    // The Daemon, under it's own Name or as an Option
+    
+    if (strcmp(Name, "fwtoolsd") == 0)
+    {
+        return StartDaemon(argc, argv);
+    }
+    
+    if (argc >= 2 && strcmp(argv[1], "-daemon") == 0)
+    {
+        return StartDaemon(argc - 1, argv + 1);
+    }
+    
+    if (argc >= 4 && strcmp(argv[1], "-client") == 0)
+    {
+        // The Format was Removed from the Arguments, the Daemon's Tool is Told again
+        
+        static char * Formats[] = { "--format=text", "--format=json", "--format=csv", "--format=binary" };
+        
+        char * Arguments[argc];
+        
+        Arguments[0] = argv[3];
+        Arguments[1] = Formats[OutputFormat];
+        
+        memcpy(Arguments + 2, argv + 4, (argc - 4) * sizeof(char *));
+        
+        int Status = RunClient(argv[2], argc - 2, Arguments);
+        
+        return Status < 0 ? 1 : Status;
+    }
+    
+    if (argc >= 3 && strcmp(argv[1], "-batch") == 0)
+    {
+        QWORD CacheSize = DEFAULT_CACHE_SIZE;
+        
+        if (argc == 5 && strcmp(argv[2], "-cache") == 0)
+        {
+            CacheSize = ParseSize(argv[3]);
+        }
+        else if (argc != 3)
+        {
+            PrintHelp(argv[0]);
+            
+            return 1;
+        }
+        
+        return RunBatch(argv[argc - 1], CacheSize) == 0 ? 0 : 1;
+    }
+    
+    if (argc >= 2 && (Chosen = FindTool(argv[1])) != NULL)
+    {
+        return Chosen -> Main(argc - 1, argv + 1);
+    }
+    
+    PrintHelp(argv[0]);
+    
+    return argc == 1 ? 0 : 1;
+}
+
+// Prints the Syntax Help and the Tools
+
+void PrintHelp(char * ProgramName)
+{
+    puts("Syntax : \r\n");
+    
+    printf("\t %s <Tool> [Arguments ...] \r\n", ProgramName);
+    printf("\t %s -batch [-cache SIZE] <Script or -> \r\n", ProgramName);
+    printf("\t %s -daemon [-jobs N] [-clientjobs N] [-cache SIZE] [-database FILE] <Socket> \r\n", ProgramName);
+    printf("\t %s -client <Socket> <Tool> [Arguments ...] \r\n\r\n", ProgramName);
+    
+    puts("Available Options:");
+    
+    printf("\t -batch FILE : Run every Line of FILE as a Command, inside this Process \r\n");
+    printf("\t -cache SIZE : The Mapped Files kept between Commands ( K, M and G Suffixes, Default 1G ) \r\n");
+    printf("\t --stats[=FILE] : Report the Time and Resources of each Phase, or Write them as JSON ( See Stats.h ) \r\n");
+    printf("\t --format=FORMAT : Write the Results as text, json, csv or binary Records ( See Records.h ) \r\n");
+    printf("\t -daemon    : Serve the Tools on a Unix Socket ( also Run as fwtoolsd ) \r\n");
+    printf("\t -jobs N    : Requests the Daemon Runs at once ( Default one per CPU ) \r\n");
+    printf("\t -clientjobs N : Requests a single Client Runs at once ( Default 2 ) \r\n");
+    printf("\t -database FILE : The Signature Database, Reloaded when it Changes ( Default Database.DB ) \r\n");
+    printf("\t -client    : Run a Tool through the Daemon, from the Current Folder \r\n\r\n");
+    
+    puts("Tools:");
+    
+    int Counter;
+    
+    for (Counter = 0; Counter < TOOL_COUNT; Counter ++)
+    {
+        printf("\t %-16s %s \r\n", Tools[Counter].Name, Tools[Counter].Description);
+    }
+}
+
+/*
+ *  The Start Daemon Method will Parse the Daemon's Options, and Serve until
+ *  the Daemon is Stopped.
+ * 
+ *  Parameters:
+ *          The Options, argv[0] being the Daemon's Name
+ * 
+ *  Returns:
+ *          The Exit Status
+ */
+
+int StartDaemon(int argc, char * argv[])
+{
+    DaemonSettings Settings = DAEMON_DEFAULTS;
+    
+    int Counter;
+    
+    for (Counter = 1; Counter + 1 < argc; Counter += 2)
+    {
+        if (strcmp(argv[Counter], "-jobs") == 0)
+        {
+            Settings.Jobs = atoi(argv[Counter + 1]);
+        }
+        else if (strcmp(argv[Counter], "-clientjobs") == 0)
+        {
+            Settings.ClientJobs = atoi(argv[Counter + 1]);
+        }
+        else if (strcmp(argv[Counter], "-cache") == 0)
+        {
+            Settings.CacheSize = ParseSize(argv[Counter + 1]);
+        }
+        else if (strcmp(argv[Counter], "-database") == 0)
+        {
+            Settings.Database = argv[Counter + 1];
+        }
+        else
+        {
+            break;
+        }
+    }
+    
+    // An Unknown Option, such as -h, is not taken for the Socket
+    
+    if (Counter != argc - 1 || argv[Counter][0] == '-')
+    {
+        PrintHelp("fwtools");
+        
+        return 1;
+    }
+    
+    Settings.SocketPath = argv[Counter];
+    
+    return RunDaemon(&Settings) == 0 ? 0 : 1;
+}
+
+const Tool * FindTool(char * Name)
+{
+    int Counter;
+    
+    for (Counter = 0; Counter < TOOL_COUNT; Counter ++)
+    {
+        if (strcasecmp(Tools[Counter].Name, Name) == 0)
+        {
+            return &Tools[Counter];
+        }
+    }
+    
+    return NULL;
+}
+
+/*
+ *  The Exit Tool Method replaces exit inside the Tools. Outside of a Batch,
+ *  or when called from a Parallel Loop ( which holds the Thread Pool's
+ *  Locks ), the Process Exits. Otherwise only the Running Command Ends.
+ * 
+ *  Parameters:
+ *          The Exit Status
+ * 
+ *  Returns:
+ *          Never
+ */
+
+void ExitTool(int Status)
+{
+    if (CommandJump && pthread_equal(pthread_self(), BatchThread) && !InParallelWork())
+    {
+        // setjmp Returns 0 only when Called, so the Status is Offset
+        
+        longjmp(*CommandJump, (Status & 0xFF) + 1);
+    }
+    
+    exit(Status);
+}
+
+/*
+ *  The Split Line Method will cut a Script Line into Arguments, in place.
+ *  Arguments are Separated by Spaces, unless Quoted with " or ', and a \
+ *  outside of Single Quotes Escapes the next Character. A # starting an
+ *  Argument Comments the rest of the Line.
+ * 
+ *  Parameters:
+ *          The Line, modified to hold the Arguments
+ *          The Argument Array, grown as needed, and it's Capacity
+ * 
+ *  Returns:
+ *          The Number of Arguments, or -1 when a Quote is not Closed
+ */
+
+int SplitLine(char * Line, char *** Arguments, int * Capacity)
+{
+    int Count = 0;
+    
+    char * Read = Line;
+    
+    while (1)
+    {
+        while (isspace((unsigned char) *Read))
+        {
+            Read ++;
+        }
+        
+        if (*Read == '\0' || *Read == '#')
+        {
+            break;
+        }
+        
+        // The Argument is Written over the Line, never ahead of what was Read
+        
+        char * Write = Read;
+        
+        char * Argument = Write;
+        
+        char Quote = 0;
+        
+        while (*Read && (Quote || !isspace((unsigned char) *Read)))
+        {
+            if (Quote && *Read == Quote)
+            {
+                Quote = 0;
+                
+                Read ++;
+            }
+            else if (!Quote && (*Read == '"' || *Read == '\''))
+            {
+                Quote = *Read ++;
+            }
+            else if (*Read == '\\' && Quote != '\'' && Read[1])
+            {
+                *Write++ = Read[1];
+                
+                Read += 2;
+            }
+            else
+            {
+                *Write++ = *Read++;
+            }
+        }
+        
+        if (Quote)
+        {
+            return -1;
+        }
+        
+        char End = *Read;
+        
+        *Write = '\0';
+        
+        if (End)
+        {
+            Read ++;
+        }
+        
+        // One Slot is kept for the NULL ending argv
+        
+        if (Count + 2 > *Capacity)
+        {
+            *Capacity = *Capacity ? *Capacity * 2 : 16;
+            
+            *Arguments = realloc(*Arguments, *Capacity * sizeof(char *));
+        }
+        
+        (*Arguments)[Count ++] = Argument;
+        
+        if (!End)
+        {
+            break;
+        }
+    }
+    
+    if (Count)
+    {
+        (*Arguments)[Count] = NULL;
+    }
+    
+    return Count;
+}
+
+/*
+ *  The Run Command Method will Run a Tool as a Batch Command : when the Tool
+ *  Exits, the Command Ends and the Exit Status is Returned.
+ * 
+ *  Parameters:
+ *          The Tool, and the Arguments of the Command
+ * 
+ *  Returns:
+ *          The Tool's Exit Status
+ */
+
+static int RunCommand(const Tool * Chosen, int argc, char * argv[])
+{
+    jmp_buf Jump;
+    
+    int Status = setjmp(Jump);
+    
+    if (Status == 0)
+    {
+        CommandJump = &Jump;
+        
+        Status = Chosen -> Main(argc, argv);
+    }
+    else
+    {
+        Status --;
+    }
+    
+    CommandJump = NULL;
+    
+    return Status;
+}
+
+/*
+ *  The Run Batch Method will Run every Command of a Script in turn. A
+ *  Command which Fails is Reported on the Standard Error, and the Batch
+ *  goes on with the next Line.
+ * 
+ *  Parameters:
+ *          A Char Array with the Script's Name, or - for the Standard Input
+ *          The Bytes of Mapped Files kept between Commands
+ * 
+ *  Returns:
+ *          0 when every Command Succeeded, -1 otherwise
+ */
+
+int RunBatch(char * ScriptName, QWORD CacheSize)
+{
+    FILE * Script = strcmp(ScriptName, "-") == 0 ? stdin : FileOpener(ScriptName, "r");
+    
+    EnableFileCache(CacheSize);
+    
+    BatchThread = pthread_self();
+    
+    char * Line = NULL;
+    
+    size_t LineSize = 0;
+    
+    char ** Arguments = NULL;
+    
+    int Capacity = 0;
+    
+    int LineNumber = 0;
+    
+    int Commands = 0;
+    
+    int Failed = 0;
+    
+    struct timespec Start, End;
+    
+    clock_gettime(CLOCK_MONOTONIC, &Start);
+    
+    while (getline(&Line, &LineSize, Script) != -1)
+    {
+        LineNumber ++;
+        
+        int Count = SplitLine(Line, &Arguments, &Capacity);
+        
+        if (Count == 0)
+        {
+            continue;
+        }
+        
+        Commands ++;
+        
+        const Tool * Chosen = Count > 0 ? FindTool(Arguments[0]) : NULL;
+        
+        if (Chosen == NULL)
+        {
+            fprintf(stderr, "Line %d : %s \r\n", LineNumber, Count > 0 ? "Unknown Tool" : "Unclosed Quote");
+            
+            Failed ++;
+            
+            continue;
+        }
+        
+        int Status = RunCommand(Chosen, Count, Arguments);
+        
+        // Keep the Output of each Command in Order with the Errors Reported
+        
+        FlushOutput();
+        
+        if (Status != 0)
+        {
+            fprintf(stderr, "Line %d : %s Failed ( Status %d ) \r\n", LineNumber, Chosen -> Name, Status);
+            
+            Failed ++;
+        }
+        
+        ReportStats();
+        
+        TrimFileCache();
+    }
+    
+    clock_gettime(CLOCK_MONOTONIC, &End);
+    
+    fprintf(stderr, "%d Commands, %d Failed, in %.3f Seconds \r\n", Commands, Failed,
+            (End.tv_sec - Start.tv_sec) + (End.tv_nsec - Start.tv_nsec) / 1e9);
+    
+    free(Arguments);
+    
+    free(Line);
+    
+    if (Script != stdin)
+    {
+        fclose(Script);
+    }
+    
+    return Failed == 0 ? 0 : -1;
+}
@@ -0,0 +1,1018 @@
+/********************************************************************
+ *                  Firmware Benchmark                              *
+ *                                                                  *
+ *  [   Author  ]       -       Andrew Borg                         *
+ *  [   Type    ]       -       Firmware Analysis                   *
+ *  [   Date    ]       -       02.01.2014                          *
+ *                                                                  *
+ * ******************************************************************
+ *                                                                  *
+ *  Description                                                     *
+ *                                                                  *
+ * Times every Mode of the Firmware Tools on Synthetic Images, so   *
+ * a Change can be Measured, and Compared with earlier Commits.     *
+ *                                                                  *
+ * The Image is Generated from a Seed : the same Seed and Size      *
+ * always give the same Image. It is made of Regions Aligned on     *
+ * 4K, as Flash Partitions are :                                    *
+ *                                                                  *
+ *      - LZMA Streams ( a Valid Header, then Compressed Noise )    *
+ *      - ELF Executables, with their Strings                       *
+ *      - PFS/0.9 Archives                                          *
+ *      - HTML and XML Pages                                        *
+ *      - Erased Flash ( 0xFF ) and Zeroed Blocks                   *
+ *                                                                  *
+ * A Folder of Seeded Files is Generated as well, for the PFS       *
+ * Packer, and it's Archive is then Listed, Extracted, Merged and   *
+ * Padded. The Merged Image is Extracted Recursively.               *
+ *                                                                  *
+ * Each Tool Runs in a Child, with it's Output Discarded. Reported  *
+ * for each Mode : the Wall Time and Throughput ( of the Best Run ),*
+ * the CPU Time, the Peak RSS, and the System Calls ( Counted in a  *
+ * Separate Run, Traced with ptrace, so the Timing is not Slowed ). *
+ *                                                                  *
+ * The Results are Appended as JSON Lines, one per Mode, tagged     *
+ * with a Label ( such as the Commit ) for the Comparisons.         *
+ *                                                                  *
+ * The Files are all in the Page Cache when the Tools Run : the     *
+ * Timings are of the Tools, not of the Disk.                       *
+ *                                                                  *
+ * ******************************************************************/
+
+#define _GNU_SOURCE
+
+#include <errno.h>
+#include <fcntl.h>
+#include <ftw.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/ptrace.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+
+#include "../Headers/Common.h"
+
+// The Alignment of the Regions, and the Largest Region
+
+#define REGION_ALIGN 0x1000
+
+#define REGION_MAX (1024 * 1024)
+
+// The PFS Layout, See PFS.h
+
+#define PFS_HEADER_SIZE 16
+#define PFS_ENTRY_SIZE 76
+#define PFS_NAME_BLOCK 64
+
+// The Files Packed by the PFS Packer, whose Archives hold at most 1000
+
+#define PACK_FILES_MIN 8
+#define PACK_FILES_MAX 900
+
+#define MODE_COUNT 12
+
+////////////////////////////////////////////////////////////////////////////////
+
+typedef struct
+{
+    char * Name;
+    
+    // The Tool, and it's Arguments after the Name ( at most 5 )
+    
+    char * Tool;
+    
+    char * Arguments[6];
+    
+    // The Input Measured for the Throughput
+    
+    QWORD Bytes;
+
+} Mode;
+
+typedef struct
+{
+    // The Best Wall Time, and the CPU Time of that Run, in Seconds
+    
+    double Seconds;
+    
+    double User;
+    
+    double System;
+    
+    // The Highest Peak RSS over every Run, in KB
+    
+    long PeakRSS;
+    
+    // -1 when not Counted
+    
+    long long Syscalls;
+    
+    int Status;
+
+} Measure;
+
+// Internal Function Prototypes
+
+void PrintHelp(char * ProgramName);
+
+QWORD GenerateImage(char * FileName, QWORD Size, DWORD Seed);
+
+QWORD GenerateFolder(char * Folder, QWORD Size, DWORD Seed);
+
+Measure RunMode(char * ToolFolder, char * WorkFolder, Mode * Chosen, int Repeat, int CountSyscalls);
+
+////////////////////////////////////////////////////////////////////////////////
+
+static QWORD Monotonic()
+{
+    struct timespec Now;
+    
+    clock_gettime(CLOCK_MONOTONIC, &Now);
+    
+    return (QWORD) Now.tv_sec * 1000000000ULL + Now.tv_nsec;
+}
+
+// Xorshift, the same Seed gives the same Image
+
+static QWORD NextRandom(QWORD * State)
+{
+    *State ^= *State << 13;
+    *State ^= *State >> 7;
+    *State ^= *State << 17;
+    
+    return *State;
+}
+
+static QWORD FileLength(char * FileName)
+{
+    struct stat Status;
+    
+    return stat(FileName, &Status) == 0 ? (QWORD) Status.st_size : 0;
+}
+
+static int RemoveEntry(const char * Path, const struct stat * Status, int Type, struct FTW * Walk)
+{
+    (void) Status;
+    (void) Type;
+    (void) Walk;
+    
+    return remove(Path);
+}
+
+int main(int argc, char ** argv)
+{
+    char ToolFolder[4096];
+    
+    char WorkFolder[4096] = "";
+    
+    QWORD Size = 16 * 1024 * 1024;
+    
+    DWORD Seed = 1;
+    
+    int Repeat = 3, CountSyscalls = 1, Keep = 0;
+    
+    char * Database = "Signatures/Database.DB";
+    
+    char * Results = "FirmwareBench.jsonl";
+    
+    char * Label = "";
+    
+    char * Only = NULL;
+    
+    // The Tools are looked for next to the Benchmark
+    
+    snprintf(ToolFolder, sizeof(ToolFolder), "%s", argv[0]);
+    
+    char * Slash = strrchr(ToolFolder, '/');
+    
+    snprintf(Slash ? Slash : ToolFolder, sizeof(ToolFolder) - (Slash ? Slash - ToolFolder : 0), "%s", Slash ? "" : ".");
+    
+    int First;
+    
+    for (First = 1; First < argc; First += 2)
+    {
+        if (strcmp(argv[First], "-Keep") == 0)
+        {
+            Keep = 1;
+            
+            First --;
+            
+            continue;
+        }
+        
+        if (strcmp(argv[First], "-NoSyscalls") == 0)
+        {
+            CountSyscalls = 0;
+            
+            First --;
+            
+            continue;
+        }
+        
+        if (First + 1 >= argc)
+        {
+            PrintHelp(argv[0]);
+        }
+        
+        if (strcmp(argv[First], "-Size") == 0)
+        {
+            Size = ParseSize(argv[First + 1]);
+        }
+        else if (strcmp(argv[First], "-Seed") == 0)
+        {
+            Seed = ParseSize(argv[First + 1]);
+        }
+        else if (strcmp(argv[First], "-Repeat") == 0)
+        {
+            Repeat = atoi(argv[First + 1]);
+        }
+        else if (strcmp(argv[First], "-Tools") == 0)
+        {
+            snprintf(ToolFolder, sizeof(ToolFolder), "%s", argv[First + 1]);
+        }
+        else if (strcmp(argv[First], "-Work") == 0)
+        {
+            snprintf(WorkFolder, sizeof(WorkFolder), "%s", argv[First + 1]);
+        }
+        else if (strcmp(argv[First], "-Database") == 0)
+        {
+            Database = argv[First + 1];
+        }
+        else if (strcmp(argv[First], "-Results") == 0)
+        {
+            Results = argv[First + 1];
+        }
+        else if (strcmp(argv[First], "-Label") == 0)
+        {
+            Label = argv[First + 1];
+        }
+        else if (strcmp(argv[First], "-Only") == 0)
+        {
+            Only = argv[First + 1];
+        }
+        else
+        {
+            PrintHelp(argv[0]);
+        }
+    }
+    
+    if (Size < 1024 * 1024 || Repeat < 1)
+    {
+        PrintHelp(argv[0]);
+    }
+    
+    // The Tools Run inside the Work Folder, the Paths given to them have to be Absolute
+    
+    char Absolute[4096];
+    
+    if (realpath(ToolFolder, Absolute) == NULL)
+    {
+        printf("Cannot Find the Tools Folder %s \r\n", ToolFolder);
+        exit(-1);
+    }
+    
+    snprintf(ToolFolder, sizeof(ToolFolder), "%s", Absolute);
+    
+    if (WorkFolder[0] == '\0')
+    {
+        snprintf(WorkFolder, sizeof(WorkFolder), "/tmp/FirmwareBench.XXXXXX");
+        
+        if (mkdtemp(WorkFolder) == NULL)
+        {
+            puts("Cannot Create the Work Folder");
+            exit(-1);
+        }
+    }
+    else if (mkdir(WorkFolder, 0755) != 0 && errno != EEXIST)
+    {
+        printf("Cannot Create the Work Folder %s \r\n", WorkFolder);
+        exit(-1);
+    }
+    
+    if (realpath(WorkFolder, Absolute) == NULL)
+    {
+        printf("Cannot Find the Work Folder %s \r\n", WorkFolder);
+        exit(-1);
+    }
+    
+    snprintf(WorkFolder, sizeof(WorkFolder), "%s", Absolute);
+    
+    // The Binary Searcher Reads Database.DB from the Folder it Runs in
+    
+    char Path[4200];
+    
+    snprintf(Path, sizeof(Path), "%s/Database.DB", WorkFolder);
+    
+    int Source = open(Database, O_RDONLY);
+    
+    int Destination = open(Path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    
+    if (Source < 0 || Destination < 0 || CopyRange(Source, 0, Destination, 0, FileLength(Database)) < 0)
+    {
+        printf("Cannot Copy the Database %s \r\n", Database);
+        exit(-1);
+    }
+    
+    close(Source);
+    close(Destination);
+    
+    char Image[4200], Folder[4200], Archive[4200], Layout[4200], PartitionSize[32];
+    
+    snprintf(Image, sizeof(Image), "%s/Image.bin", WorkFolder);
+    snprintf(Folder, sizeof(Folder), "%s/Pack", WorkFolder);
+    snprintf(Archive, sizeof(Archive), "%s/Archive.pfs", WorkFolder);
+    snprintf(Layout, sizeof(Layout), "%s/Image.layout", WorkFolder);
+    
+    QWORD Started = Monotonic();
+    
+    QWORD ImageSize = GenerateImage(Image, Size, Seed);
+    
+    // PFS Offsets are 32 Bit, the Folder stays below 2G
+    
+    QWORD FolderSize = GenerateFolder(Folder, Size < 0x80000000ULL ? Size : 0x80000000ULL, Seed);
+    
+    printf("Generated : %llu Bytes of Image, %llu Bytes of Files, Seed %u, in %.2f Seconds \r\n", (unsigned long long) ImageSize,
+           (unsigned long long) FolderSize, Seed, (Monotonic() - Started) / 1e9);
+    
+    printf("Work      : %s \r\n\r\n", WorkFolder);
+    
+    // The Map's Layout is Split, and the Pack's Archive Listed, Extracted, Merged, Recursively Extracted and Padded
+    
+    Mode Modes[MODE_COUNT] =
+    {
+        { "Hex", "HexDump", { "-Hex", Image }, ImageSize },
+        { "Strings", "HexDump", { "-Strings", Image }, ImageSize },
+        { "Partitions", "HexDump", { "-Partitions", Image }, ImageSize },
+        { "Map", "HexDump", { "-Map", Layout, Image }, ImageSize },
+        { "Signatures", "BinarySearcher", { Image }, ImageSize },
+        { "Split", "Splitter", { Layout, Image, "Split" }, ImageSize },
+        { "Pack", "PFSPacker", { "-R", Folder, Archive }, FolderSize },
+        { "List", "PFSUnpacker", { "-List", Archive }, 0 },
+        { "Extract", "PFSUnpacker", { "-Extract", Archive }, 0 },
+        { "Merge", "Merger", { "-y", Image, Archive, "Merged.bin" }, 0 },
+        { "Recursive", "Extractor", { "Merged.bin", "Recursive" }, 0 },
+        { "Pad", "Padder", { Archive, PartitionSize, "Padded.bin" }, 0 }
+    };
+    
+    FILE * Output = FileOpener(Results, "a");
+    
+    printf("%-12s %-16s %10s %10s %10s %10s %12s %12s %6s \r\n", "Mode", "Tool", "Seconds", "MB/s", "User", "System", "Peak RSS KB",
+           "Syscalls", "Status");
+    
+    int Failed = 0;
+    
+    int Counter;
+    
+    for (Counter = 0; Counter < MODE_COUNT; Counter ++)
+    {
+        Mode * Chosen = &Modes[Counter];
+        
+        // The Archive only Exists once Packed
+        
+        if (Chosen -> Bytes == 0)
+        {
+            QWORD ArchiveSize = FileLength(Archive);
+            
+            Chosen -> Bytes = ArchiveSize + (strcmp(Chosen -> Name, "Merge") == 0 ? ImageSize : 0);
+            
+            snprintf(PartitionSize, sizeof(PartitionSize), "0x%llX", (unsigned long long) ((ArchiveSize | 0xFFFFF) + 1 + 0x100000));
+        }
+        
+        if (Only && strstr(Only, Chosen -> Name) == NULL)
+        {
+            continue;
+        }
+        
+        Measure Result = RunMode(ToolFolder, WorkFolder, Chosen, Repeat, CountSyscalls);
+        
+        double Throughput = Result.Seconds > 0 ? Chosen -> Bytes / 1048576.0 / Result.Seconds : 0;
+        
+        printf("%-12s %-16s %10.4f %10.1f %10.4f %10.4f %12ld %12lld %6d \r\n", Chosen -> Name, Chosen -> Tool, Result.Seconds,
+               Throughput, Result.User, Result.System, Result.PeakRSS, Result.Syscalls, Result.Status);
+        
+        fprintf(Output, "{\"label\": \"%s\", \"seed\": %u, \"size\": %llu, \"mode\": \"%s\", \"tool\": \"%s\", \"bytes\": %llu, "
+                "\"runs\": %d, \"seconds\": %.6f, \"mbps\": %.3f, \"user\": %.6f, \"system\": %.6f, \"peak_rss_kb\": %ld, "
+                "\"syscalls\": %lld, \"status\": %d}\n", Label, Seed, (unsigned long long) Size, Chosen -> Name, Chosen -> Tool,
+                (unsigned long long) Chosen -> Bytes, Repeat, Result.Seconds, Throughput, Result.User, Result.System,
+                Result.PeakRSS, Result.Syscalls, Result.Status);
+        
+        Failed += Result.Status != 0;
+        
+        fflush(stdout);
+    }
+    
+    fclose(Output);
+    
+    printf("\r\nResults Appended to %s \r\n", Results);
+    
+    if (!Keep)
+    {
+        nftw(WorkFolder, RemoveEntry, 16, FTW_DEPTH | FTW_PHYS);
+    }
+    
+    return Failed == 0 ? 0 : 1;
+}
+
+void PrintHelp(char * ProgramName)
+{
+    puts("Firmware Benchmark \r\n");
+        
+        puts("Syntax : ");
+            
+            printf("\t %s [Options] \r\n\r\n", ProgramName);
+    
+    puts("Available Options:");
+        
+        printf("\t -Size SIZE : Bytes of Synthetic Image, from 1M to 4G ( Default 16M ) \r\n\r\n");
+        printf("\t -Seed NUMBER : Seed of the Image and of the Packed Files ( Default 1 ) \r\n\r\n");
+        printf("\t -Repeat COUNT : Runs of each Mode, the Fastest is Reported ( Default 3 ) \r\n\r\n");
+        printf("\t -Only MODES : Only Run the Named Modes, such as Strings,Pack \r\n\r\n");
+        printf("\t -Tools FOLDER : Where the Tools are ( Default next to the Benchmark ) \r\n\r\n");
+        printf("\t -Work FOLDER : Where the Files are Generated ( Default a New Folder inside /tmp ) \r\n\r\n");
+        printf("\t -Database FILE : The Signature Database ( Default Signatures/Database.DB ) \r\n\r\n");
+        printf("\t -Results FILE : The JSON Lines the Results are Appended to ( Default FirmwareBench.jsonl ) \r\n\r\n");
+        printf("\t -Label TEXT : Stored with the Results, such as the Commit \r\n\r\n");
+        printf("\t -NoSyscalls : Do not Count the System Calls \r\n\r\n");
+        printf("\t -Keep : Keep the Work Folder \r\n\r\n");
+    
+    puts("Modes:");
+        
+        printf("\t Hex, Strings, Partitions, Map, Signatures, Split, Pack, List, Extract, Merge, Pad \r\n");
+    
+    exit(-1);
+}
+
+// Fills a Block with Noise, as Compressed or Encrypted Data looks
+
+static void FillNoise(BYTE * Data, QWORD Length, QWORD * State)
+{
+    QWORD Counter;
+    
+    for (Counter = 0; Counter + 8 <= Length; Counter += 8)
+    {
+        QWORD Value = NextRandom(State);
+        
+        memcpy(Data + Counter, &Value, 8);
+    }
+    
+    for (; Counter < Length; Counter ++)
+    {
+        Data[Counter] = NextRandom(State);
+    }
+}
+
+// Fills a Block with Words, from a List, separated by Spaces, and returns the Length Written
+
+static QWORD FillWords(char * Text, QWORD Length, const char ** Words, int WordCount, QWORD * State)
+{
+    QWORD Written = 0;
+    
+    while (1)
+    {
+        const char * Word = Words[NextRandom(State) % WordCount];
+        
+        QWORD WordLength = strlen(Word);
+        
+        if (Written + WordLength + 1 > Length)
+        {
+            break;
+        }
+        
+        memcpy(Text + Written, Word, WordLength);
+        
+        Written += WordLength;
+        
+        Text[Written ++] = NextRandom(State) % 8 == 0 ? '\n' : ' ';
+    }
+    
+    return Written;
+}
+
+/*
+ *  The LZMA Region is an LZMA Alone Header ( Properties 0x5D, a 8M
+ *  Dictionary and the Uncompressed Size ), followed by Noise.
+ */
+
+static QWORD LZMARegion(BYTE * Data, QWORD Length, QWORD * State)
+{
+    static const BYTE Header[5] = { 0x5D, 0x00, 0x00, 0x80, 0x00 };
+    
+    memcpy(Data, Header, 5);
+    
+    QWORD Uncompressed = Length * (2 + NextRandom(State) % 3);
+    
+    memcpy(Data + 5, &Uncompressed, 8);
+    
+    FillNoise(Data + 13, Length - 13, State);
+    
+    return Length;
+}
+
+/*
+ *  The ELF Region is an ELF32 Header, then Code ( Noise ) and a String
+ *  Table, the Strings of a Firmware's Binaries.
+ */
+
+static QWORD ELFRegion(BYTE * Data, QWORD Length, QWORD * State)
+{
+    static const char * Strings[] =
+    {
+        "/bin/sh", "/etc/init.d/rcS", "%s: cannot open %s", "usage: %s [-v] <file>", "libc.so.0", "libpthread.so.0",
+        "malloc", "printf", "strncpy", "socket", "bind", "/dev/mtdblock3", "nvram_get", "httpd", "admin", "password",
+        "GET /cgi-bin/upgrade.cgi HTTP/1.1", "Content-Type: text/html", "firmware_version", "telnetd", "0123456789abcdef"
+    };
+    
+    static const BYTE Header[20] = { 0x7F, 'E', 'L', 'F', 1, 1, 1, 0, 0, 0, 0, 0, 0, 0, 0, 0, 2, 0, 8, 0 };
+    
+    memset(Data, 0, 52);
+    
+    memcpy(Data, Header, sizeof(Header));
+    
+    // Three Quarters of Code, then the String Table
+    
+    QWORD Code = 52 + (Length - 52) * 3 / 4;
+    
+    FillNoise(Data + 52, Code - 52, State);
+    
+    QWORD Position = Code;
+    
+    while (Position < Length)
+    {
+        const char * String = Strings[NextRandom(State) % (sizeof(Strings) / sizeof(Strings[0]))];
+        
+        QWORD StringLength = strlen(String) + 1;
+        
+        if (Position + StringLength > Length)
+        {
+            memset(Data + Position, 0, Length - Position);
+            
+            break;
+        }
+        
+        memcpy(Data + Position, String, StringLength);
+        
+        Position += StringLength;
+    }
+    
+    return Length;
+}
+
+/*
+ *  The PFS Region is a PFS/0.9 Archive of a few Files, half Text and half
+ *  Noise, which the Unpacker can List and Extract.
+ */
+
+static QWORD PFSRegion(BYTE * Data, QWORD Length, QWORD * State)
+{
+    static const char * Words[] = { "config", "option", "lan", "wan", "dhcp", "enable", "1", "0", "192.168.1.1", "255.255.255.0" };
+    
+    int Count = 2 + NextRandom(State) % 11;
+    
+    QWORD DataSegment = PFS_HEADER_SIZE + Count * PFS_ENTRY_SIZE;
+    
+    QWORD FileSize = (Length - DataSegment) / Count;
+    
+    memset(Data, 0, DataSegment);
+    
+    memcpy(Data, "PFS/0.9", 8);
+    
+    WORD Entries = Count;
+    
+    memcpy(Data + 14, &Entries, 2);
+    
+    int Counter;
+    
+    for (Counter = 0; Counter < Count; Counter ++)
+    {
+        BYTE * Entry = Data + PFS_HEADER_SIZE + Counter * PFS_ENTRY_SIZE;
+        
+        DWORD Fields[3] = { 1388534400 + NextRandom(State) % 31536000, Counter * FileSize, FileSize };
+        
+        snprintf((char *) Entry, PFS_NAME_BLOCK, "%s/file_%d.%s", Counter % 3 ? "webroot" : "etc", Counter, Counter % 2 ? "bin" : "txt");
+        
+        memcpy(Entry + PFS_NAME_BLOCK, Fields, sizeof(Fields));
+        
+        BYTE * File = Data + DataSegment + Counter * FileSize;
+        
+        if (Counter % 2)
+        {
+            FillNoise(File, FileSize, State);
+        }
+        else
+        {
+            QWORD Written = FillWords((char *) File, FileSize, Words, sizeof(Words) / sizeof(Words[0]), State);
+            
+            memset(File + Written, '\n', FileSize - Written);
+        }
+    }
+    
+    return DataSegment + Count * FileSize;
+}
+
+// The Markup Region is an HTML Page or an XML Document
+
+static QWORD MarkupRegion(BYTE * Data, QWORD Length, QWORD * State)
+{
+    static const char * HTML[] =
+    {
+        "<div>", "</div>", "<td>", "</td>", "<tr>", "</tr>", "<input type=\"text\" name=\"ssid\">", "<b>Wireless</b>",
+        "<a href=\"status.htm\">Status</a>", "Router", "Settings", "Apply", "Cancel", "<script>", "</script>", "<br>"
+    };
+    
+    static const char * XML[] =
+    {
+        "<item>", "</item>", "<name>", "</name>", "<value>", "</value>", "<enabled>true</enabled>", "<port>80</port>",
+        "<service type=\"upnp\"/>", "<device>", "</device>", "InternetGatewayDevice", "WANIPConnection"
+    };
+    
+    int IsXML = NextRandom(State) % 2;
+    
+    const char * Open = IsXML ? "<?xml version=\"1.0\"?>\n<root>\n" : "<html>\n<head><title>Setup</title></head>\n<body>\n";
+    
+    const char * Close = IsXML ? "\n</root>\n" : "\n</body>\n</html>\n";
+    
+    QWORD OpenLength = strlen(Open), CloseLength = strlen(Close);
+    
+    memcpy(Data, Open, OpenLength);
+    
+    QWORD Written = OpenLength;
+    
+    if (IsXML)
+    {
+        Written += FillWords((char *) Data + Written, Length - Written - CloseLength, XML, sizeof(XML) / sizeof(XML[0]), State);
+    }
+    else
+    {
+        Written += FillWords((char *) Data + Written, Length - Written - CloseLength, HTML, sizeof(HTML) / sizeof(HTML[0]), State);
+    }
+    
+    memcpy(Data + Written, Close, CloseLength);
+    
+    return Written + CloseLength;
+}
+
+/*
+ *  The Generate Image Method will Write a Synthetic Image of Regions. Each
+ *  Region starts on a 4K Boundary, the Gap before it is Erased Flash.
+ * 
+ *  Parameters:
+ *          The Image's File Name, it's Size and the Seed
+ * 
+ *  Returns:
+ *          The Image's Size
+ */
+
+QWORD GenerateImage(char * FileName, QWORD Size, DWORD Seed)
+{
+    FILE * Image = FileOpener(FileName, "wb");
+    
+    BYTE * Region = malloc(REGION_MAX + REGION_ALIGN);
+    
+    if (Region == NULL)
+    {
+        puts("Error Allocating Memory");
+        exit(-1);
+    }
+    
+    QWORD State = Seed * 0x9E3779B97F4A7C15ULL + 1;
+    
+    QWORD Position = 0;
+    
+    while (Position < Size)
+    {
+        // Erased Flash and Noise are the most Common, then LZMA and ELF
+        
+        QWORD Kind = NextRandom(&State) % 12;
+        
+        QWORD Length = 4096 + NextRandom(&State) % (REGION_MAX - 4096);
+        
+        if (Length > Size - Position)
+        {
+            Length = Size - Position;
+        }
+        
+        QWORD Used = Length;
+        
+        if (Kind < 3 || Length < 4096)
+        {
+            memset(Region, 0xFF, Length);
+        }
+        else if (Kind < 5)
+        {
+            Used = LZMARegion(Region, Length, &State);
+        }
+        else if (Kind < 7)
+        {
+            Used = ELFRegion(Region, Length, &State);
+        }
+        else if (Kind < 8)
+        {
+            Used = PFSRegion(Region, Length, &State);
+        }
+        else if (Kind < 10)
+        {
+            Used = MarkupRegion(Region, Length / 8, &State);
+        }
+        else if (Kind < 11)
+        {
+            FillNoise(Region, Length, &State);
+        }
+        else
+        {
+            memset(Region, 0, Length);
+        }
+        
+        // Erase up to the next Boundary
+        
+        QWORD Aligned = (Used + REGION_ALIGN - 1) & ~((QWORD) REGION_ALIGN - 1);
+        
+        if (Aligned > Size - Position)
+        {
+            Aligned = Size - Position;
+        }
+        
+        if (Aligned > Used)
+        {
+            memset(Region + Used, 0xFF, Aligned - Used);
+        }
+        
+        if (fwrite(Region, 1, Aligned, Image) != Aligned)
+        {
+            printf("Cannot Write %s \r\n", FileName);
+            exit(-1);
+        }
+        
+        Position += Aligned;
+    }
+    
+    free(Region);
+    
+    fclose(Image);
+    
+    return Position;
+}
+
+/*
+ *  The Generate Folder Method will Write the Files Packed by the PFS Packer,
+ *  in a few Subfolders. The Files are Regions of the Image Generator.
+ * 
+ *  Parameters:
+ *          The Folder, the Total Size of the Files and the Seed
+ * 
+ *  Returns:
+ *          The Total Size Written
+ */
+
+QWORD GenerateFolder(char * Folder, QWORD Size, DWORD Seed)
+{
+    QWORD Count = Size / (256 * 1024);
+    
+    Count = Count < PACK_FILES_MIN ? PACK_FILES_MIN : Count > PACK_FILES_MAX ? PACK_FILES_MAX : Count;
+    
+    QWORD FileSize = Size / Count;
+    
+    BYTE * Data = malloc(FileSize);
+    
+    if (Data == NULL)
+    {
+        puts("Error Allocating Memory");
+        exit(-1);
+    }
+    
+    QWORD State = (Seed + 1) * 0x9E3779B97F4A7C15ULL + 1;
+    
+    mkdir(Folder, 0755);
+    
+    QWORD Total = 0;
+    
+    QWORD Counter;
+    
+    for (Counter = 0; Counter < Count; Counter ++)
+    {
+        char Path[4200];
+        
+        snprintf(Path, sizeof(Path), "%s/Folder%llu", Folder, (unsigned long long) Counter % 4);
+        
+        mkdir(Path, 0755);
+        
+        snprintf(Path, sizeof(Path), "%s/Folder%llu/File%llu.bin", Folder, (unsigned long long) Counter % 4, (unsigned long long) Counter);
+        
+        // Whole Regions up to 1M, Noise past them
+        
+        QWORD Kind = NextRandom(&State) % 3;
+        
+        QWORD Length = FileSize < REGION_MAX ? FileSize : REGION_MAX;
+        
+        if (Kind == 0 && Length > 4096)
+        {
+            LZMARegion(Data, Length, &State);
+        }
+        else if (Kind == 1 && Length > 4096)
+        {
+            ELFRegion(Data, Length, &State);
+        }
+        else
+        {
+            Length = FillWords((char *) Data, Length, (const char *[]) { "option", "value", "enable", "disable", "lan" }, 5, &State);
+        }
+        
+        FillNoise(Data + Length, FileSize - Length, &State);
+        
+        FILE * File = FileOpener(Path, "wb");
+        
+        if (fwrite(Data, 1, FileSize, File) != FileSize)
+        {
+            printf("Cannot Write %s \r\n", Path);
+            exit(-1);
+        }
+        
+        fclose(File);
+        
+        Total += FileSize;
+    }
+    
+    free(Data);
+    
+    return Total;
+}
+
+/*
+ *  The Start Tool Method will Fork the Child Running a Mode, inside the Work
+ *  Folder, with it's Output Discarded. A Traced Child Stops before the Tool
+ *  is Executed, so the Tracer can Attach.
+ */
+
+static pid_t StartTool(char * ToolFolder, char * WorkFolder, Mode * Chosen, int Traced)
+{
+    char Path[4200];
+    
+    snprintf(Path, sizeof(Path), "%s/%s", ToolFolder, Chosen -> Tool);
+    
+    fflush(stdout);
+    
+    pid_t Child = fork();
+    
+    if (Child != 0)
+    {
+        return Child;
+    }
+    
+    int Null = open("/dev/null", O_RDWR);
+    
+    dup2(Null, STDIN_FILENO);
+    dup2(Null, STDOUT_FILENO);
+    dup2(Null, STDERR_FILENO);
+    
+    if (chdir(WorkFolder) != 0)
+    {
+        _exit(127);
+    }
+    
+    char * Arguments[8] = { Path };
+    
+    memcpy(Arguments + 1, Chosen -> Arguments, sizeof(Chosen -> Arguments));
+    
+    if (Traced)
+    {
+        ptrace(PTRACE_TRACEME, 0, NULL, NULL);
+        
+        raise(SIGSTOP);
+    }
+    
+    execv(Path, Arguments);
+    
+    _exit(127);
+}
+
+/*
+ *  The Count Syscalls Method will Run a Mode under ptrace, and Count the
+ *  System Calls of every Thread. Each Call Stops the Thread twice, on the
+ *  Way in and on the Way out.
+ * 
+ *  Returns:
+ *          The Number of System Calls, or -1 when the Child cannot be Traced
+ */
+
+static long long CountSyscalls(char * ToolFolder, char * WorkFolder, Mode * Chosen)
+{
+    pid_t Child = StartTool(ToolFolder, WorkFolder, Chosen, 1);
+    
+    int Status;
+    
+    if (Child < 0 || waitpid(Child, &Status, 0) != Child || !WIFSTOPPED(Status))
+    {
+        return -1;
+    }
+    
+    if (ptrace(PTRACE_SETOPTIONS, Child, NULL, PTRACE_O_TRACESYSGOOD | PTRACE_O_TRACECLONE | PTRACE_O_EXITKILL) != 0)
+    {
+        kill(Child, SIGKILL);
+        
+        waitpid(Child, NULL, 0);
+        
+        return -1;
+    }
+    
+    long long Stops = 0;
+    
+    ptrace(PTRACE_SYSCALL, Child, NULL, NULL);
+    
+    pid_t Thread;
+    
+    while ((Thread = waitpid(-1, &Status, __WALL)) > 0)
+    {
+        if (!WIFSTOPPED(Status))
+        {
+            continue;
+        }
+        
+        int Signal = WSTOPSIG(Status);
+        
+        if (Signal == (SIGTRAP | 0x80))
+        {
+            Stops ++;
+            
+            Signal = 0;
+        }
+        else if (Signal == SIGTRAP || Signal == SIGSTOP)
+        {
+            // Clone Events, and the Stop of each New Thread
+            
+            Signal = 0;
+        }
+        
+        ptrace(PTRACE_SYSCALL, Thread, NULL, (void *) (long) Signal);
+    }
+    
+    return (Stops + 1) / 2;
+}
+
+/*
+ *  The Run Mode Method will Run a Mode a few Times and Measure it.
+ * 
+ *  Parameters:
+ *          The Tools' Folder and the Work Folder
+ *          The Mode, and the Number of Timed Runs
+ *          1 to Count the System Calls of an Extra Run
+ * 
+ *  Returns:
+ *          The Measure of the Fastest Run, and the Highest Peak RSS
+ */
+
+Measure RunMode(char * ToolFolder, char * WorkFolder, Mode * Chosen, int Repeat, int CountCalls)
+{
+    Measure Result = { 0, 0, 0, 0, -1, 0 };
+    
+    int Run;
+    
+    for (Run = 0; Run < Repeat; Run ++)
+    {
+        QWORD Start = Monotonic();
+        
+        pid_t Child = StartTool(ToolFolder, WorkFolder, Chosen, 0);
+        
+        int Status;
+        
+        struct rusage Usage;
+        
+        if (Child < 0 || wait4(Child, &Status, 0, &Usage) != Child)
+        {
+            Result.Status = -1;
+            
+            return Result;
+        }
+        
+        double Seconds = (Monotonic() - Start) / 1e9;
+        
+        if (Run == 0 || Seconds < Result.Seconds)
+        {
+            Result.Seconds = Seconds;
+            
+            Result.User = Usage.ru_utime.tv_sec + Usage.ru_utime.tv_usec / 1e6;
+            
+            Result.System = Usage.ru_stime.tv_sec + Usage.ru_stime.tv_usec / 1e6;
+        }
+        
+        if (Usage.ru_maxrss > Result.PeakRSS)
+        {
+            Result.PeakRSS = Usage.ru_maxrss;
+        }
+        
+        if (Status != 0)
+        {
+            Result.Status = WIFEXITED(Status) ? WEXITSTATUS(Status) : 128 + WTERMSIG(Status);
+        }
+    }
+    
+    if (CountCalls)
+    {
+        Result.Syscalls = CountSyscalls(ToolFolder, WorkFolder, Chosen);
+    }
+    
+    return Result;
+}
@@ -0,0 +1,499 @@
+/* Flash Dump through a Bootloader Console */
+
+#include <fcntl.h>
+#include <poll.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "../Headers/Common.h"
+#include "../Headers/SerialPort.h"
+#include "../Headers/FlashDump.h"
+
+// The Number of times a Window is Read before giving Up
+
+#define WINDOW_RETRIES 3
+
+// Milliseconds without any Character before a Command is considered Stuck
+
+#define CONSOLE_TIMEOUT 5000
+
+// Milliseconds of Silence after which the Console is taken to be Idle
+
+#define DRAIN_QUIET 200
+
+// The Largest Chunk Read from the Port at once
+
+#define DUMP_CHUNK (64 * 1024)
+
+// The States of the Hex Dump Parser
+
+#define LINE_START  0
+#define ADDRESS     1
+#define BYTE_GAP    2
+#define BYTE_LOW    3
+#define SKIP_LINE   4
+
+typedef struct
+{
+    int State;
+    
+    QWORD LineAddress;
+    
+    int AddressDigits;
+    
+    // The Column of the Next Byte inside the Line, and the Spaces seen before it
+    
+    int Column;
+    
+    int Spaces;
+    
+    int High;
+    
+    // The Window being Filled, and which of it's Bytes were Received
+    
+    QWORD Start;
+    
+    QWORD Length;
+    
+    BYTE * Data;
+    
+    BYTE * Seen;
+    
+    QWORD Received;
+
+} HexParser;
+
+// The Value of each Hex Digit, -1 for any other Character
+
+static signed char HexValue[256];
+
+// Every Character Received from the Console, to report how much of the Line was Data
+
+static QWORD Characters;
+
+static void BuildHexTable()
+{
+    int Counter;
+    
+    memset(HexValue, -1, sizeof(HexValue));
+    
+    for (Counter = 0; Counter < 10; Counter ++)
+    {
+        HexValue['0' + Counter] = Counter;
+    }
+    
+    for (Counter = 0; Counter < 6; Counter ++)
+    {
+        HexValue['a' + Counter] = 10 + Counter;
+        HexValue['A' + Counter] = 10 + Counter;
+    }
+}
+
+/*
+ *  The Parse Character Method moves the Hex Dump Parser by one Character.
+ *  Lines which do not start with an Address and a Colon ( the Command's Echo,
+ *  Messages, the Prompt ) are Skipped, as is the ASCII Column.
+ */
+
+static void ParseCharacter(HexParser * Parser, BYTE Character)
+{
+    int Value = HexValue[Character];
+    
+    if (Character == '\n' || Character == '\r')
+    {
+        Parser -> State = LINE_START;
+        
+        return;
+    }
+    
+    switch (Parser -> State)
+    {
+        case LINE_START:
+            
+            Parser -> LineAddress = 0;
+            Parser -> AddressDigits = 0;
+            
+            Parser -> State = ADDRESS;
+            
+            // Fall Through, the Character is the First Digit
+        
+        case ADDRESS:
+            
+            if (Value >= 0 && Parser -> AddressDigits < 16)
+            {
+                Parser -> LineAddress = (Parser -> LineAddress << 4) | Value;
+                Parser -> AddressDigits ++;
+            }
+            else if (Character == ':' && Parser -> AddressDigits > 0)
+            {
+                Parser -> Column = 0;
+                Parser -> Spaces = 0;
+                
+                Parser -> State = BYTE_GAP;
+            }
+            else
+            {
+                Parser -> State = SKIP_LINE;
+            }
+            
+            break;
+        
+        case BYTE_GAP:
+            
+            // A Byte follows a Single Space, more Spaces start the ASCII Column
+            
+            if (Character == ' ' && Parser -> Spaces == 0)
+            {
+                Parser -> Spaces = 1;
+            }
+            else if (Value >= 0 && Parser -> Spaces == 1)
+            {
+                Parser -> High = Value;
+                
+                Parser -> State = BYTE_LOW;
+            }
+            else
+            {
+                Parser -> State = SKIP_LINE;
+            }
+            
+            break;
+        
+        case BYTE_LOW:
+            
+            if (Value < 0)
+            {
+                Parser -> State = SKIP_LINE;
+                
+                break;
+            }
+            
+            {
+                QWORD Address = Parser -> LineAddress + Parser -> Column ++;
+                
+                if (Address >= Parser -> Start && Address - Parser -> Start < Parser -> Length)
+                {
+                    QWORD Offset = Address - Parser -> Start;
+                    
+                    Parser -> Data[Offset] = (Parser -> High << 4) | Value;
+                    
+                    if (!Parser -> Seen[Offset])
+                    {
+                        Parser -> Seen[Offset] = 1;
+                        
+                        Parser -> Received ++;
+                    }
+                }
+            }
+            
+            Parser -> Spaces = 0;
+            
+            Parser -> State = BYTE_GAP;
+            
+            break;
+        
+        default:
+            
+            break;
+    }
+}
+
+/*
+ *  The Run Command Method will Type a Command, then Read the Console until
+ *  the Prompt comes back. Every Character is given to the Parser, if any,
+ *  and the Last Characters are kept inside the Answer, if any.
+ * 
+ *  Returns:
+ *          0 once the Prompt is seen, -1 on Timeout or Error
+ */
+
+static int RunCommand(int Port, char * Command, char * Prompt, HexParser * Parser, char * Answer, int AnswerSize)
+{
+    static BYTE Chunk[DUMP_CHUNK];
+    
+    int PromptLength = strlen(Prompt);
+    
+    int Matched = 0;
+    
+    // The Prompt only counts at the Start of a Line, U-Boot's crc32 prints "==> " itself
+    
+    BYTE Previous = '\n';
+    
+    int AnswerLength = 0;
+    
+    if (WriteAll(Port, (BYTE *) Command, strlen(Command)) != 0 || WriteAll(Port, (BYTE *) "\r", 1) != 0)
+    {
+        return -1;
+    }
+    
+    struct pollfd Console = { Port, POLLIN, 0 };
+    
+    while (poll(&Console, 1, CONSOLE_TIMEOUT) > 0)
+    {
+        ssize_t Length = read(Port, Chunk, DUMP_CHUNK);
+        
+        if (Length <= 0)
+        {
+            return -1;
+        }
+        
+        Characters += Length;
+        
+        ssize_t Counter;
+        
+        for (Counter = 0; Counter < Length; Counter ++)
+        {
+            BYTE Character = Chunk[Counter];
+            
+            if (Parser)
+            {
+                ParseCharacter(Parser, Character);
+            }
+            
+            if (Answer && AnswerLength < AnswerSize - 1)
+            {
+                Answer[AnswerLength ++] = Character;
+            }
+            
+            // The Prompt is Matched as it Streams in
+            
+            if (Character == (BYTE) Prompt[Matched] && (Matched > 0 || Previous == '\n' || Previous == '\r'))
+            {
+                Matched ++;
+            }
+            else
+            {
+                Matched = 0;
+            }
+            
+            Previous = Character;
+            
+            if (Matched == PromptLength)
+            {
+                if (Answer)
+                {
+                    Answer[AnswerLength] = '\0';
+                }
+                
+                return 0;
+            }
+        }
+    }
+    
+    return -1;
+}
+
+/*
+ *  The Target Crc Method will ask the Target for the CRC32 of a Window.
+ * 
+ *  Returns:
+ *          1 with the Checksum, 0 if the Target has no crc32 Command, -1 on Error
+ */
+
+static int TargetCrc(int Port, char * Prompt, QWORD Address, QWORD Length, DWORD * Checksum)
+{
+    char Command[64];
+    
+    char Answer[512];
+    
+    snprintf(Command, sizeof(Command), "crc32 %llx %llx", (unsigned long long) Address, (unsigned long long) Length);
+    
+    if (RunCommand(Port, Command, Prompt, NULL, Answer, sizeof(Answer)) != 0)
+    {
+        return -1;
+    }
+    
+    // U-Boot Answers : CRC32 for 80000000 ... 8000ffff ==> 1a2b3c4d
+    
+    char * Result = strstr(Answer, "==>");
+    
+    if (Result == NULL)
+    {
+        return 0;
+    }
+    
+    *Checksum = strtoul(Result + 3, NULL, 16);
+    
+    return 1;
+}
+
+/*
+ *  The Drain Method will Discard the Console's Output until it has been Quiet
+ *  for a while, so that an older Prompt is not taken for the next one.
+ */
+
+static void Drain(int Port)
+{
+    static BYTE Chunk[DUMP_CHUNK];
+    
+    struct pollfd Console = { Port, POLLIN, 0 };
+    
+    while (poll(&Console, 1, DRAIN_QUIET) > 0 && read(Port, Chunk, DUMP_CHUNK) > 0)
+    {
+        // Discarded
+    }
+}
+
+static double Elapsed(struct timespec * Since)
+{
+    struct timespec Now;
+    
+    clock_gettime(CLOCK_MONOTONIC, &Now);
+    
+    return (Now.tv_sec - Since -> tv_sec) + (Now.tv_nsec - Since -> tv_nsec) / 1e9;
+}
+
+/*
+ *  The Dump Flash Method will Read the Memory Window by Window, and Write each
+ *  Window to the Output once it is Complete ( and Checked ).
+ * 
+ *  Parameters:
+ *          The Port, Connected to the Bootloader's Console
+ *          The Dump Settings
+ *          A Char Array with the Name of the Output File
+ * 
+ *  Returns:
+ *          0 on Success, -1 on Failure
+ */
+
+int DumpFlash(int Port, DumpSettings * Settings, char * OutputFile)
+{
+    BuildHexTable();
+    
+    int Output = open(OutputFile, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    
+    if (Output < 0)
+    {
+        puts("Cannot Create Output File");
+        
+        return -1;
+    }
+    
+    HexParser Parser;
+    
+    Parser.Data = malloc(Settings -> Window);
+    Parser.Seen = malloc(Settings -> Window);
+    
+    // Wait for the Prompt, the Console may be in the middle of a Line
+    
+    int Retry;
+    
+    int Result = -1;
+    
+    for (Retry = 0; Retry < 3 && Result != 0; Retry ++)
+    {
+        Result = RunCommand(Port, "", Settings -> Prompt, NULL, NULL, 0);
+    }
+    
+    Drain(Port);
+    
+    if (Result != 0)
+    {
+        printf("The Prompt \"%s\" was not Found \r\n", Settings -> Prompt);
+        
+        free(Parser.Data);
+        free(Parser.Seen);
+        
+        close(Output);
+        
+        return -1;
+    }
+    
+    struct timespec Start;
+    
+    clock_gettime(CLOCK_MONOTONIC, &Start);
+    
+    Characters = 0;
+    
+    QWORD Done = 0;
+    
+    while (Done < Settings -> Length)
+    {
+        QWORD Length = Settings -> Length - Done < Settings -> Window ? Settings -> Length - Done : Settings -> Window;
+        
+        QWORD Address = Settings -> Address + Done;
+        
+        for (Retry = 0; Retry < WINDOW_RETRIES; Retry ++)
+        {
+            char Command[64];
+            
+            snprintf(Command, sizeof(Command), "md.b %llx %llx", (unsigned long long) Address, (unsigned long long) Length);
+            
+            Parser.State = LINE_START;
+            Parser.Start = Address;
+            Parser.Length = Length;
+            Parser.Received = 0;
+            
+            memset(Parser.Seen, 0, Length);
+            
+            if (RunCommand(Port, Command, Settings -> Prompt, &Parser, NULL, 0) != 0 || Parser.Received != Length)
+            {
+                printf("\r\nWindow 0x%llX : %llu of %llu Bytes Received, Reading it again \r\n", (unsigned long long) Address,
+                       (unsigned long long) Parser.Received, (unsigned long long) Length);
+                
+                continue;
+            }
+            
+            if (!Settings -> Verify)
+            {
+                break;
+            }
+            
+            DWORD Expected;
+            
+            int Check = TargetCrc(Port, Settings -> Prompt, Address, Length, &Expected);
+            
+            if (Check == 0)
+            {
+                puts("\r\nThe Target has no crc32 Command, the Windows are not Checked");
+                
+                Settings -> Verify = 0;
+                
+                break;
+            }
+            
+            if (Check == 1 && Expected == Crc32(0, Parser.Data, Length))
+            {
+                break;
+            }
+            
+            printf("\r\nWindow 0x%llX : CRC32 Mismatch, Reading it again \r\n", (unsigned long long) Address);
+        }
+        
+        if (Retry == WINDOW_RETRIES)
+        {
+            printf("Window 0x%llX could not be Read \r\n", (unsigned long long) Address);
+            
+            free(Parser.Data);
+            free(Parser.Seen);
+            
+            close(Output);
+            
+            return -1;
+        }
+        
+        WriteAt(Output, Parser.Data, Length, Done);
+        
+        Done += Length;
+        
+        double Seconds = Elapsed(&Start);
+        
+        printf("\rRead %llu of %llu Bytes ( %3.0f%% ) %8.1f KB/s ", (unsigned long long) Done, (unsigned long long) Settings -> Length,
+               Done * 100.0 / Settings -> Length, Seconds > 0 ? Done / Seconds / 1024 : 0);
+        
+        fflush(stdout);
+    }
+    
+    printf("\r\nDumped %llu Bytes to %s in %.2f Seconds, %llu Characters Received ( %.2f per Byte ) \r\n", (unsigned long long) Done, OutputFile,
+           Elapsed(&Start), (unsigned long long) Characters, Done ? (double) Characters / Done : 0);
+    
+    free(Parser.Data);
+    free(Parser.Seen);
+    
+    close(Output);
+    
+    return 0;
+}
@@ -65,6 +65,9 @@
  *                          100 NULL (FF) Characters are repeated   *
  *                          in succession                           *
  *                                                                  *
+ *          With -Map, the Partitions are Written as a Layout       *
+ *          File, which the Splitter can use to cut the Image.      *
+ *                                                                  *
  * ******************************************************************/
  
 
@@ -73,6 +76,7 @@
 #include <ctype.h>
 
 #include "../Headers/Common.h"
+#include "../Headers/Layout.h"
 
 // The Maximum Hex Digits Displayed Per Line - Used in the Format Hex Method
 
@@ -94,13 +98,16 @@ char * DumpHex(char * FileName);
 
 void FormatHex(char * HexDump);
 void StringExtractor(char * HexDump);
-void PartitionDetector(char * HexDump);
+void PartitionDetector(char * HexDump, Layout * Map);
+void PartitionMap(char * MapFile, char * FileName);
 void ExtractFromHex(int Start, int Count, char * FileName, char * HexDump);
 
 // The Main Method will check the Passed Arguments and redirect the Flow Accordingly
 
 int main(int argc, char **argv)
 {
+    InitStats(&argc, argv);
+    InitOutput(&argc, argv);
     
     // Check User Input and Redirect Accordingly
     
@@ -110,6 +117,8 @@ int main(int argc, char **argv)
     {
         char * Hex = DumpHex(argv[2]);
 
+        int Phase = STATS_BEGIN(argv[1] + 1);
+        
         // If the First Argument is -Hex Redirect To the Format Hex Method
         
         if (strcmp(argv[1], "-Hex") == 0)
@@ -123,10 +132,19 @@ int main(int argc, char **argv)
         // If the First Argument is -Partitions Redirect to the Partition Detector Method
         
         else if (strcmp(argv[1], "-Partitions") == 0)
-            PartitionDetector(Hex);
+            PartitionDetector(Hex, NULL);
+        
+        STATS_END(Phase);
         
         
-        printf("\r\n\r\n");
+        OutputText("\r\n\r\n");
+    }
+    
+    // If the First Argument is -Map, Write the Detected Partitions to a Layout File
+    
+    else if (argc == 4 && strcmp(argv[1], "-Map") == 0)
+    {
+        PartitionMap(argv[2], argv[3]);
     }
     
     // If the Number of Arguments is Equal to 6, Check for Valid Arguments
@@ -148,7 +166,8 @@ int main(int argc, char **argv)
         puts("Syntax : \r\n");
         printf("\t %s -Hex FILE \r\n", argv[0]);
         printf("\t %s -Strings FILE \r\n", argv[0]);
-        printf("\t %s -Partitions FILE \r\n\r\n", argv[0]);
+        printf("\t %s -Partitions FILE \r\n", argv[0]);
+        printf("\t %s -Map LAYOUTFILE FILE \r\n\r\n", argv[0]);
         printf("\t %s -Extract Start BytesToExtract OutputName FILE \r\n\r\n", argv[0]);
     }
     
@@ -222,78 +241,37 @@ void StringExtractor(char * HexDump)
 {
         int Counter = 0;
         
-        int EmptyLine = 1;
+        // The Offset where the Printable Run Started, or -1 Outside a Run
         
-        char CharArray[50];
+        int RunStart = -1;
         
-        int CharCounter = 0;
+        // One more Pass past the End, to Close a Run Reaching the End of the File
         
-        // While Counter is Less Then File Size Bytes
-        
-        while (Counter < FileSize)
+        while (Counter <= FileSize)
         {
-            // Store the Equivalent Hex Dump inside a Four Byte Char Variable
+            // If the Character is Printable, the Run goes on
             
-            char Character = HexDump[Counter];
-            
-            // If the Character is Printable
-            
-            if (isprint(Character))
+            if (Counter < FileSize && isprint((unsigned char) HexDump[Counter]))
             {
-                // Check if the Character have space inside the Char Array
-                // The + 1 denotes the NULL Byte
-                
-                if (CharCounter + 1 != 50)
-                {
-                    // Store the Character inside the Char Array
-                    
-                    CharArray[CharCounter++] = Character;
-                    
-                    // Set the Empty Line Variable to Zero
-                    
-                    EmptyLine = 0;
-                }
-                else
+                if (RunStart < 0)
                 {
-                    // Put A Null Byte inside the Char Array, to Prevent a Memory Leak
-                    // The NULL Byte is Inputted inside the Character Array, as a Null Terminator for the String
-                    
-                    CharArray[CharCounter] = '\0';
-                    
-                    // Print hte Character Array
-                    
-                    printf("%s", CharArray);
-                    
-                    // Set the Char Counter to Zero
-                    CharCounter = 0;
+                    RunStart = Counter;
                 }
             }
             
-            // Else : The Character is Not Printable
+            // Else : The Run Ends, and is a String when Longer than the MINIMUM_STRING_LENGTH
             
-            else if (EmptyLine == 0) 
-            {               
-                // Insert a NULL Byte inside the Char Array
-                CharArray[CharCounter] = '\0';
-                
-                // If The Total Char Array Count is Bigger then the MINIMUM_STRING_LENGTH
-                
-                if (strlen(CharArray) > MINIMUM_STRING_LENGTH)
+            else if (RunStart >= 0)
+            {
+                if (Counter - RunStart > MINIMUM_STRING_LENGTH)
                 {
-                    // Print the Char Array
-                    
-                    printf("%s", CharArray);
-                    
-                    // Print a New Line
+                    EmitString(RunStart, HexDump + RunStart, Counter - RunStart);
                     
-                    printf("\r\n");
+                    STATS_ADD(STAT_HITS, 1);
                 }
                 
-                EmptyLine = 1;
-                
-                CharCounter = 0;
-                
-            }   
+                RunStart = -1;
+            }
             
             Counter ++;
         }
@@ -306,12 +284,13 @@ void StringExtractor(char * HexDump)
  * 
  *  Parameters :
  *              A Char Array with the Binary's equivalent Hex Code
+ *              A Layout to Fill with the Partitions, or NULL to Print them
  * 
  *  Returns :
  *              VOID
  * 
  */
-void PartitionDetector(char * HexDump)
+void PartitionDetector(char * HexDump, Layout * Map)
 {
     
     // Set Environment
@@ -354,21 +333,23 @@ void PartitionDetector(char * HexDump)
             {
                 // If There was more then 100 NULL Bytes
                 
-                if (NullBytes > MINIMUM_NULL)
+                if (NullBytes > MINIMUM_NULL && Map)
                 {
-                    // Print Partition Details
-                    
-                    printf("\t\t\t Partition %d \r\n\r\n", ++PartitionCount);
+                    char Name[32];
                     
-                    // Print the Data Partition Starting and Ending Offset
+                    snprintf(Name, sizeof(Name), "Partition_%d.bin", ++PartitionCount);
                     
-                    printf("Data Found From Offset 0x%-6X Till 0x%-6X (%d Bytes) \r\n", DataOffset, Counter - 1, (Counter - 1) - DataOffset);
+                    // The Partition holds it's Data and the Padding following it
                     
-                    // Print the Null Partition Starting and Enging Offset
+                    AddLayoutEntry(Map, Name, DataOffset, Counter - DataOffset, 0xFF);
                     
-                    //printf("Null Padding Found From Offset 0x%-6X Till 0x%-6X (%d Bytes) \r\n", NullStart, Counter, Counter - NullStart);
+                    DataOffset = Counter;
+                }
+                else if (NullBytes > MINIMUM_NULL)
+                {
+                    // Emit the Partition Details, the Data Partition's Starting and Ending Offset
                     
-                    puts("-----------------------------------------------------------------------------------------");
+                    EmitPartition(++PartitionCount, DataOffset, Counter - 1);
                     
                     
                     // Set the Data Offset Variable to the Value of Counter
@@ -384,6 +365,23 @@ void PartitionDetector(char * HexDump)
         }
         
         
+        // The Data following the Last Padding is the Last Partition
+        
+        if (Map)
+        {
+            char Name[32];
+            
+            snprintf(Name, sizeof(Name), "Partition_%d.bin", ++PartitionCount);
+            
+            AddLayoutEntry(Map, Name, DataOffset, SIZE_TO_NEXT, 0xFF);
+            
+            STATS_ADD(STAT_HITS, PartitionCount);
+            
+            return;
+        }
+        
+        STATS_ADD(STAT_HITS, PartitionCount);
+        
         // Print the Partition Summary
         
         // Check if Partitions were found and display a Message accordingly
@@ -392,15 +390,53 @@ void PartitionDetector(char * HexDump)
         {
             // If Partitions were Found, Print how many
             
-            printf("%d Possible Partitions Found ", PartitionCount);
+            OutputText("%d Possible Partitions Found ", PartitionCount);
         }
         else
         {
             // If not Partitions were found, Print Message
-            puts("No Partitions were Found ");
+            OutputText("No Partitions were Found \n");
         }
 }
 
+/*
+ *  The Partition Map Method will Write the Partitions found by the
+ *  Partition Detector to a Layout File, to be used by the Splitter.
+ * 
+ *  Parameters :
+ *              A Char Array with the Name of the Layout File
+ *              A Char Array with the Name of the Binary File
+ * 
+ *  Returns :
+ *              VOID
+ * 
+ */
+void PartitionMap(char * MapFile, char * FileName)
+{
+    Layout Map = { NULL, 0, 0, 0xFF };
+    
+    char * Hex = DumpHex(FileName);
+    
+    int Phase = STATS_BEGIN("Map");
+    
+    PartitionDetector(Hex, &Map);
+    
+    STATS_END(Phase);
+    
+    Map.ImageSize = FileSize;
+    
+    FILE * File = FileOpener(MapFile, "w");
+    
+    fprintf(File, "# Partitions Detected inside %s\n", FileName);
+    
+    WriteLayout(&Map, File);
+    
+    fclose(File);
+    
+    OutputText("%d Possible Partitions Written to %s \r\n", Map.Count, MapFile);
+    
+    FreeLayout(&Map);
+}
 
 void ExtractFromHex(int Start, int Count, char * FileName, char * HexDump)
 {
@@ -411,10 +447,12 @@ void ExtractFromHex(int Start, int Count, char * FileName, char * HexDump)
         Count = FileSize - Start;
     }
     
-    printf("Extracting %d Bytes ... \r\n", Count);
+    OutputText("Extracting %d Bytes ... \r\n", Count);
     
     int Counter = 0;
     
+    int Phase = STATS_BEGIN("Extract");
+    
     FILE * File = fopen(FileName, "w");
     
     while (Counter < Count)
@@ -424,8 +462,13 @@ void ExtractFromHex(int Start, int Count, char * FileName, char * HexDump)
         Counter ++;
     }
     
+    STATS_ADD(STAT_WRITTEN, Count);
+    STATS_ADD(STAT_FILES, 1);
+    
+    STATS_END(Phase);
+    
     
-    printf("Done. Extracted Partition. Saved to %s \r\n", FileName);
+    EmitExtraction(FileName, Start, Count, "Written");
     
     fclose(File);
 }
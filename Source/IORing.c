@@ -0,0 +1,832 @@
+/* io_uring File Operations */
+
+#define _GNU_SOURCE
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+
+#include "../Headers/Common.h"
+#include "../Headers/IORing.h"
+
+// The Files kept in Flight, each holding a Slot
+
+#define RING_SLOTS 32
+
+// The Submission Queue, Larger than every Slot's Operations together
+
+#define RING_ENTRIES 128
+
+// The Fixed File of RingCopyFiles' Output, past the Slots
+
+#define OUTPUT_SLOT RING_SLOTS
+
+// The Longest single Write, the Kernel Caps each below 2G
+
+#define WRITE_LIMIT (1ULL << 30)
+
+// Each Completion carries the Slot and the Operation
+
+#define TAG_OPEN    0
+#define TAG_READ    1
+#define TAG_WRITE   2
+#define TAG_CLOSE   3
+
+#define USER_DATA(Slot, Tag) (((QWORD) (Slot) << 2) | (Tag))
+
+#define MODE_WRITE  0
+#define MODE_COPY   1
+
+typedef struct
+{
+    int Descriptor;
+    
+    // The Submission Queue, Entries are Queued past the Kernel's Tail until Submitted
+    
+    unsigned * SubmitTail;
+    unsigned * SubmitArray;
+    unsigned SubmitMask;
+    unsigned Queued;
+    unsigned ToSubmit;
+    
+    struct io_uring_sqe * Entries;
+    
+    // The Completion Queue
+    
+    unsigned * CompleteHead;
+    unsigned * CompleteTail;
+    unsigned CompleteMask;
+    
+    struct io_uring_cqe * Completions;
+    
+    // The Registered Buffers, RING_BUFFER_SIZE Bytes for each Slot
+    
+    BYTE * Buffers;
+
+} Ring;
+
+typedef struct
+{
+    // The Index of the File using the Slot, or -1 when the Slot is Free
+    
+    int File;
+    
+    // The Operations Submitted and not yet Completed
+    
+    int InFlight;
+    
+    // 1 once Nothing but Completions are left to the File
+    
+    int Closing;
+    
+    QWORD Done;
+
+} RingSlot;
+
+// The State of a single Batch of RingWriteFiles or RingCopyFiles
+
+typedef struct
+{
+    int Mode;
+    
+    RingFile * Files;
+    
+    RingSlot Slots[RING_SLOTS];
+    
+    RingInspect Inspect;
+    
+    void * Context;
+
+} RingBatch;
+
+typedef void (* PrepareEntry)(struct io_uring_sqe * Entry, int Index, void * Context);
+
+static Ring Shared;
+
+// 0 before the Ring was Tried, 1 when it is Ready, -1 when it cannot be Used
+
+static int RingState = 0;
+
+static int Enter(unsigned Submit, unsigned Wait)
+{
+    int Result;
+    
+    do
+    {
+        Result = syscall(__NR_io_uring_enter, Shared.Descriptor, Submit, Wait, Wait ? IORING_ENTER_GETEVENTS : 0, NULL, 0);
+    }
+    while (Result < 0 && errno == EINTR);
+    
+    return Result;
+}
+
+static int Register(unsigned Opcode, void * Argument, unsigned Count)
+{
+    return syscall(__NR_io_uring_register, Shared.Descriptor, Opcode, Argument, Count);
+}
+
+static struct io_uring_sqe * QueueEntry(BYTE Opcode, QWORD UserData)
+{
+    unsigned Index = Shared.Queued & Shared.SubmitMask;
+    
+    struct io_uring_sqe * Entry = &Shared.Entries[Index];
+    
+    memset(Entry, 0, sizeof(*Entry));
+    
+    Entry -> opcode = Opcode;
+    Entry -> user_data = UserData;
+    
+    Shared.SubmitArray[Index] = Index;
+    
+    Shared.Queued ++;
+    Shared.ToSubmit ++;
+    
+    return Entry;
+}
+
+// Submits the Queued Entries, and Waits for at least one Completion
+
+static void Submit()
+{
+    __atomic_store_n(Shared.SubmitTail, Shared.Queued, __ATOMIC_RELEASE);
+    
+    int Result = Enter(Shared.ToSubmit, 1);
+    
+    if (Result < 0)
+    {
+        puts("Error Submitting to the IO Ring");
+        exit(EXIT_FAILURE);
+    }
+    
+    Shared.ToSubmit -= Result;
+}
+
+static int NextCompletion(QWORD * UserData, int * Result)
+{
+    unsigned Head = *Shared.CompleteHead;
+    
+    if (Head == __atomic_load_n(Shared.CompleteTail, __ATOMIC_ACQUIRE))
+    {
+        return 0;
+    }
+    
+    struct io_uring_cqe * Completion = &Shared.Completions[Head & Shared.CompleteMask];
+    
+    *UserData = Completion -> user_data;
+    *Result = Completion -> res;
+    
+    __atomic_store_n(Shared.CompleteHead, Head + 1, __ATOMIC_RELEASE);
+    
+    return 1;
+}
+
+/*
+ *  The Probe Operations Method will Check the Kernel offers every
+ *  Operation the Ring Submits.
+ * 
+ *  Returns:
+ *          1 when every Operation is Supported, 0 Otherwise
+ */
+
+static int ProbeOperations()
+{
+    static const BYTE Needed[] = { IORING_OP_OPENAT, IORING_OP_CLOSE, IORING_OP_READ_FIXED, IORING_OP_WRITE_FIXED, IORING_OP_WRITE };
+    
+    struct io_uring_probe * Probe = calloc(1, sizeof(struct io_uring_probe) + 256 * sizeof(struct io_uring_probe_op));
+    
+    int Supported = Register(IORING_REGISTER_PROBE, Probe, 256) == 0;
+    
+    unsigned Counter;
+    
+    for (Counter = 0; Supported && Counter < sizeof(Needed); Counter ++)
+    {
+        Supported = Needed[Counter] <= Probe -> last_op && (Probe -> ops[Needed[Counter]].flags & IO_URING_OP_SUPPORTED);
+    }
+    
+    free(Probe);
+    
+    return Supported;
+}
+
+/*
+ *  The Register Slots Method will Register an Empty Table of Fixed Files,
+ *  then Open and Close a Fixed File, which Kernels before Linux 5.15 Refuse.
+ * 
+ *  Returns:
+ *          1 when the Slots can be Used, 0 Otherwise
+ */
+
+static int RegisterSlots()
+{
+    int Files[RING_SLOTS + 1];
+    
+    int Counter;
+    
+    for (Counter = 0; Counter <= RING_SLOTS; Counter ++)
+    {
+        Files[Counter] = -1;
+    }
+    
+    if (Register(IORING_REGISTER_FILES, Files, RING_SLOTS + 1) != 0)
+    {
+        return 0;
+    }
+    
+    struct io_uring_sqe * Entry = QueueEntry(IORING_OP_OPENAT, USER_DATA(0, TAG_OPEN));
+    
+    Entry -> fd = AT_FDCWD;
+    Entry -> addr = (QWORD) (uintptr_t) "/";
+    Entry -> open_flags = O_RDONLY | O_DIRECTORY | O_CLOEXEC;
+    Entry -> file_index = 1;
+    Entry -> flags = IOSQE_IO_LINK;
+    
+    Entry = QueueEntry(IORING_OP_CLOSE, USER_DATA(0, TAG_CLOSE));
+    
+    Entry -> file_index = 1;
+    
+    __atomic_store_n(Shared.SubmitTail, Shared.Queued, __ATOMIC_RELEASE);
+    
+    if (Enter(2, 2) != 2)
+    {
+        return 0;
+    }
+    
+    Shared.ToSubmit = 0;
+    
+    QWORD UserData;
+    
+    int Result, Failed = 0, Completed = 0;
+    
+    while (Completed < 2)
+    {
+        if (NextCompletion(&UserData, &Result))
+        {
+            Failed |= Result != 0;
+            
+            Completed ++;
+        }
+        else if (Enter(0, 1) < 0)
+        {
+            return 0;
+        }
+    }
+    
+    return !Failed;
+}
+
+/*
+ *  The Register Buffers Method will Register the Buffers of the Slots, on
+ *  the first Copy, as the Kernel Pins them in Memory.
+ * 
+ *  Returns:
+ *          1 when the Buffers are Registered, 0 Otherwise
+ */
+
+static int RegisterBuffers()
+{
+    static int Registered = 0;
+    
+    if (Registered)
+    {
+        return Registered > 0;
+    }
+    
+    Registered = -1;
+    
+    struct iovec Vectors[RING_SLOTS];
+    
+    int Counter;
+    
+    Shared.Buffers = mmap(NULL, (size_t) RING_SLOTS * RING_BUFFER_SIZE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    
+    if (Shared.Buffers == MAP_FAILED)
+    {
+        return 0;
+    }
+    
+    for (Counter = 0; Counter < RING_SLOTS; Counter ++)
+    {
+        Vectors[Counter].iov_base = Shared.Buffers + (size_t) Counter * RING_BUFFER_SIZE;
+        Vectors[Counter].iov_len = RING_BUFFER_SIZE;
+    }
+    
+    if (Register(IORING_REGISTER_BUFFERS, Vectors, RING_SLOTS) != 0)
+    {
+        munmap(Shared.Buffers, (size_t) RING_SLOTS * RING_BUFFER_SIZE);
+        
+        return 0;
+    }
+    
+    Registered = 1;
+    
+    return 1;
+}
+
+/*
+ *  The Setup Ring Method will Create the Ring on first use, Map it's
+ *  Queues and Register the Slots.
+ * 
+ *  Returns:
+ *          1 when the Ring can be Used, 0 Otherwise
+ */
+
+static int SetupRing()
+{
+    if (RingState != 0)
+    {
+        return RingState > 0;
+    }
+    
+    RingState = -1;
+    
+    char * Setting = getenv("FWTOOLS_RING");
+    
+    if (Setting && strcmp(Setting, "0") == 0)
+    {
+        return 0;
+    }
+    
+    struct io_uring_params Params;
+    
+    memset(&Params, 0, sizeof(Params));
+    
+    Shared.Descriptor = syscall(__NR_io_uring_setup, RING_ENTRIES, &Params);
+    
+    // A single Mapping holds both Queues since Linux 5.4
+    
+    if (Shared.Descriptor < 0 || !(Params.features & IORING_FEAT_SINGLE_MMAP))
+    {
+        if (Shared.Descriptor >= 0)
+        {
+            close(Shared.Descriptor);
+        }
+        
+        return 0;
+    }
+    
+    size_t QueueSize = Params.sq_off.array + Params.sq_entries * sizeof(unsigned);
+    
+    size_t CompleteSize = Params.cq_off.cqes + Params.cq_entries * sizeof(struct io_uring_cqe);
+    
+    if (CompleteSize > QueueSize)
+    {
+        QueueSize = CompleteSize;
+    }
+    
+    size_t EntriesSize = Params.sq_entries * sizeof(struct io_uring_sqe);
+    
+    BYTE * Queues = mmap(NULL, QueueSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, Shared.Descriptor, IORING_OFF_SQ_RING);
+    
+    void * Entries = mmap(NULL, EntriesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, Shared.Descriptor, IORING_OFF_SQES);
+    
+    if (Queues != MAP_FAILED && Entries != MAP_FAILED)
+    {
+        Shared.SubmitTail = (unsigned *) (Queues + Params.sq_off.tail);
+        Shared.SubmitArray = (unsigned *) (Queues + Params.sq_off.array);
+        Shared.SubmitMask = *(unsigned *) (Queues + Params.sq_off.ring_mask);
+        Shared.Queued = *Shared.SubmitTail;
+        Shared.ToSubmit = 0;
+        
+        Shared.Entries = Entries;
+        
+        Shared.CompleteHead = (unsigned *) (Queues + Params.cq_off.head);
+        Shared.CompleteTail = (unsigned *) (Queues + Params.cq_off.tail);
+        Shared.CompleteMask = *(unsigned *) (Queues + Params.cq_off.ring_mask);
+        
+        Shared.Completions = (struct io_uring_cqe *) (Queues + Params.cq_off.cqes);
+        
+        if (ProbeOperations() && RegisterSlots())
+        {
+            RingState = 1;
+            
+            return 1;
+        }
+    }
+    
+    // Closing the Ring Releases what was Registered
+    
+    close(Shared.Descriptor);
+    
+    if (Queues != MAP_FAILED)
+    {
+        munmap(Queues, QueueSize);
+    }
+    
+    if (Entries != MAP_FAILED)
+    {
+        munmap(Entries, EntriesSize);
+    }
+    
+    return 0;
+}
+
+int RingAvailable()
+{
+    return SetupRing();
+}
+
+static void SubmitClose(RingBatch * Batch, int Index)
+{
+    struct io_uring_sqe * Entry = QueueEntry(IORING_OP_CLOSE, USER_DATA(Index, TAG_CLOSE));
+    
+    Entry -> file_index = Index + 1;
+    
+    Batch -> Slots[Index].InFlight ++;
+    Batch -> Slots[Index].Closing = 1;
+}
+
+static void SubmitWrite(RingBatch * Batch, int Index)
+{
+    RingSlot * Slot = &Batch -> Slots[Index];
+    
+    RingFile * File = &Batch -> Files[Slot -> File];
+    
+    QWORD Length = File -> Length - Slot -> Done;
+    
+    struct io_uring_sqe * Entry;
+    
+    // Copied Files are Written from the Slot's Buffer, into the Output
+    
+    if (Batch -> Mode == MODE_COPY)
+    {
+        Entry = QueueEntry(IORING_OP_WRITE_FIXED, USER_DATA(Index, TAG_WRITE));
+        
+        Entry -> fd = OUTPUT_SLOT;
+        Entry -> addr = (QWORD) (uintptr_t) (Shared.Buffers + (size_t) Index * RING_BUFFER_SIZE + Slot -> Done);
+        Entry -> off = File -> Offset + Slot -> Done;
+        Entry -> buf_index = Index;
+    }
+    else
+    {
+        Entry = QueueEntry(IORING_OP_WRITE, USER_DATA(Index, TAG_WRITE));
+        
+        Entry -> fd = Index;
+        Entry -> addr = (QWORD) (uintptr_t) (File -> Data + Slot -> Done);
+        Entry -> off = Slot -> Done;
+    }
+    
+    Entry -> len = Length < WRITE_LIMIT ? Length : WRITE_LIMIT;
+    Entry -> flags = IOSQE_FIXED_FILE;
+    
+    Slot -> InFlight ++;
+}
+
+static void StartFile(RingBatch * Batch, int Index, int File)
+{
+    RingSlot * Slot = &Batch -> Slots[Index];
+    
+    Slot -> File = File;
+    Slot -> InFlight = 1;
+    Slot -> Closing = 0;
+    Slot -> Done = 0;
+    
+    Batch -> Files[File].Result = 0;
+    
+    struct io_uring_sqe * Entry = QueueEntry(IORING_OP_OPENAT, USER_DATA(Index, TAG_OPEN));
+    
+    Entry -> fd = AT_FDCWD;
+    Entry -> addr = (QWORD) (uintptr_t) Batch -> Files[File].Path;
+    Entry -> len = 0644;
+    Entry -> open_flags = (Batch -> Mode == MODE_WRITE ? O_WRONLY | O_CREAT | O_TRUNC : O_RDONLY) | O_CLOEXEC;
+    Entry -> file_index = Index + 1;
+}
+
+/*
+ *  The Complete Method will move a File to it's Next Operation once the
+ *  Last one Completed :
+ * 
+ *      Writing : Open -> Write ( until every Byte is Written ) -> Close
+ *      Copying : Open -> Read ( the whole File ) -> Write and Close
+ * 
+ *  Parameters:
+ *          The Batch, the Slot's Index, the Operation which Completed and it's Result
+ * 
+ *  Returns:
+ *          VOID
+ */
+
+static void Complete(RingBatch * Batch, int Index, int Tag, int Result)
+{
+    RingSlot * Slot = &Batch -> Slots[Index];
+    
+    RingFile * File = &Batch -> Files[Slot -> File];
+    
+    Slot -> InFlight --;
+    
+    switch (Tag)
+    {
+        case TAG_OPEN:
+            
+            if (Result < 0)
+            {
+                File -> Result = Result;
+                
+                Slot -> Closing = 1;
+            }
+            else if (Batch -> Mode == MODE_COPY)
+            {
+                // One more Byte than Expected is Read, to Notice a File which Grew
+                
+                struct io_uring_sqe * Entry = QueueEntry(IORING_OP_READ_FIXED, USER_DATA(Index, TAG_READ));
+                
+                Entry -> fd = Index;
+                Entry -> addr = (QWORD) (uintptr_t) (Shared.Buffers + (size_t) Index * RING_BUFFER_SIZE);
+                Entry -> len = File -> Length + 1;
+                Entry -> buf_index = Index;
+                Entry -> flags = IOSQE_FIXED_FILE;
+                
+                Slot -> InFlight ++;
+            }
+            else if (File -> Length > 0)
+            {
+                SubmitWrite(Batch, Index);
+            }
+            else
+            {
+                SubmitClose(Batch, Index);
+            }
+            
+            break;
+        
+        case TAG_READ:
+            
+            File -> Result = Result;
+            
+            if (Result >= 0)
+            {
+                STATS_ADD(STAT_READ, Result);
+            }
+            
+            // The Source is no longer Needed, the Output is Written from the Buffer
+            
+            if (Result == (long long) File -> Length)
+            {
+                if (Batch -> Inspect)
+                {
+                    Batch -> Inspect(Slot -> File, Shared.Buffers + (size_t) Index * RING_BUFFER_SIZE, File -> Length, Batch -> Context);
+                }
+                
+                if (File -> Length > 0)
+                {
+                    SubmitWrite(Batch, Index);
+                }
+            }
+            
+            SubmitClose(Batch, Index);
+            
+            break;
+        
+        case TAG_WRITE:
+            
+            if (Result <= 0)
+            {
+                File -> Result = Result < 0 ? Result : -EIO;
+            }
+            else
+            {
+                STATS_ADD(STAT_WRITTEN, Result);
+                
+                Slot -> Done += Result;
+                
+                if (Slot -> Done < File -> Length)
+                {
+                    SubmitWrite(Batch, Index);
+                }
+                else if (Batch -> Mode == MODE_WRITE)
+                {
+                    File -> Result = Slot -> Done;
+                }
+            }
+            
+            if (Batch -> Mode == MODE_WRITE && Slot -> InFlight == 0)
+            {
+                SubmitClose(Batch, Index);
+            }
+            
+            break;
+        
+        case TAG_CLOSE:
+            
+            if (Result < 0 && File -> Result >= 0)
+            {
+                File -> Result = Result;
+            }
+            
+            break;
+    }
+}
+
+static void RunFiles(RingBatch * Batch, int Count)
+{
+    int Next = 0, Busy = 0, Counter;
+    
+    for (Counter = 0; Counter < RING_SLOTS; Counter ++)
+    {
+        Batch -> Slots[Counter].File = -1;
+    }
+    
+    while (Next < Count || Busy > 0)
+    {
+        // Every Free Slot Starts the Next File
+        
+        for (Counter = 0; Counter < RING_SLOTS && Next < Count; Counter ++)
+        {
+            if (Batch -> Slots[Counter].File < 0)
+            {
+                StartFile(Batch, Counter, Next ++);
+                
+                Busy ++;
+            }
+        }
+        
+        Submit();
+        
+        QWORD UserData;
+        
+        int Result;
+        
+        while (NextCompletion(&UserData, &Result))
+        {
+            int Index = UserData >> 2;
+            
+            Complete(Batch, Index, UserData & 3, Result);
+            
+            if (Batch -> Slots[Index].InFlight == 0 && Batch -> Slots[Index].Closing)
+            {
+                Batch -> Slots[Index].File = -1;
+                
+                Busy --;
+            }
+        }
+    }
+}
+
+int RingWriteFiles(RingFile * Files, int Count)
+{
+    if (!SetupRing())
+    {
+        return -1;
+    }
+    
+    RingBatch Batch = { .Mode = MODE_WRITE, .Files = Files };
+    
+    RunFiles(&Batch, Count);
+    
+    return 0;
+}
+
+int RingCopyFiles(RingFile * Files, int Count, int Output, RingInspect Inspect, void * Context)
+{
+    int Counter;
+    
+    for (Counter = 0; Counter < Count; Counter ++)
+    {
+        if (Files[Counter].Length >= RING_BUFFER_SIZE)
+        {
+            return -1;
+        }
+    }
+    
+    if (!SetupRing() || !RegisterBuffers())
+    {
+        return -1;
+    }
+    
+    // The Output takes the Fixed File past the Slots while the Batch Runs
+    
+    struct io_uring_files_update Update;
+    
+    memset(&Update, 0, sizeof(Update));
+    
+    Update.offset = OUTPUT_SLOT;
+    Update.fds = (QWORD) (uintptr_t) &Output;
+    
+    if (Register(IORING_REGISTER_FILES_UPDATE, &Update, 1) != 1)
+    {
+        return -1;
+    }
+    
+    RingBatch Batch = { .Mode = MODE_COPY, .Files = Files, .Inspect = Inspect, .Context = Context };
+    
+    RunFiles(&Batch, Count);
+    
+    int Empty = -1;
+    
+    Update.fds = (QWORD) (uintptr_t) &Empty;
+    
+    Register(IORING_REGISTER_FILES_UPDATE, &Update, 1);
+    
+    return 0;
+}
+
+/*
+ *  The Run Each Method will Submit one Operation for every Index, keeping
+ *  as many in Flight as the Queue holds.
+ * 
+ *  Parameters:
+ *          The Number of Operations and their Opcode
+ *          The Method Filling each Entry, and it's Context
+ *          The Array receiving each Operation's Result
+ * 
+ *  Returns:
+ *          VOID
+ */
+
+static void RunEach(int Count, BYTE Opcode, PrepareEntry Prepare, void * Context, int * Results)
+{
+    int Next = 0, Finished = 0;
+    
+    while (Finished < Count)
+    {
+        while (Next < Count && Next - Finished < RING_ENTRIES)
+        {
+            Prepare(QueueEntry(Opcode, Next), Next, Context);
+            
+            Next ++;
+        }
+        
+        Submit();
+        
+        QWORD UserData;
+        
+        int Result;
+        
+        while (NextCompletion(&UserData, &Result))
+        {
+            Results[UserData] = Result;
+            
+            Finished ++;
+        }
+    }
+}
+
+typedef struct
+{
+    char ** Paths;
+    
+    int Flags;
+    
+    int Mode;
+
+} OpenBatch;
+
+static void PrepareOpen(struct io_uring_sqe * Entry, int Index, void * Context)
+{
+    OpenBatch * Batch = Context;
+    
+    Entry -> fd = AT_FDCWD;
+    Entry -> addr = (QWORD) (uintptr_t) Batch -> Paths[Index];
+    Entry -> len = Batch -> Mode;
+    Entry -> open_flags = Batch -> Flags;
+}
+
+static void PrepareClose(struct io_uring_sqe * Entry, int Index, void * Context)
+{
+    int Descriptor = ((int *) Context)[Index];
+    
+    // A Descriptor which was never Opened is Skipped, as a No Operation
+    
+    if (Descriptor < 0)
+    {
+        Entry -> opcode = IORING_OP_NOP;
+    }
+    
+    Entry -> fd = Descriptor;
+}
+
+int RingOpenFiles(char ** Paths, int Count, int Flags, int Mode, int * Descriptors)
+{
+    if (!SetupRing())
+    {
+        return -1;
+    }
+    
+    OpenBatch Batch = { Paths, Flags, Mode };
+    
+    RunEach(Count, IORING_OP_OPENAT, PrepareOpen, &Batch, Descriptors);
+    
+    return 0;
+}
+
+int RingCloseFiles(int * Descriptors, int Count)
+{
+    if (!SetupRing())
+    {
+        return -1;
+    }
+    
+    int * Results = calloc(Count + 1, sizeof(int));
+    
+    RunEach(Count, IORING_OP_CLOSE, PrepareClose, Descriptors, Results);
+    
+    free(Results);
+    
+    return 0;
+}
@@ -0,0 +1,371 @@
+/* Flash Layouts */
+
+#include "../Headers/Common.h"
+#include "../Headers/Layout.h"
+
+// The Maximum Length of a Layout Line
+
+#define LINE_LENGTH 4096
+
+/*
+ *  The Parse Fill Method will convert a Fill Byte given inside a Layout.
+ */
+
+static BYTE ParseFill(char * Text, int LineNumber)
+{
+    QWORD Value = ParseSize(Text);
+    
+    if (Value > 0xFF)
+    {
+        printf("Line %d : Invalid Fill Byte %s \r\n", LineNumber, Text);
+        exit(-1);
+    }
+    
+    return Value;
+}
+
+/*
+ *  The Load Layout Method will read a Layout File. The Format is described
+ *  inside the Layout Header File. Any Syntax Error ends the Application.
+ * 
+ *  Parameters:
+ *          A Char Array with the Name of the Layout File
+ * 
+ *  Returns:
+ *          The Layout, in the Order of the File
+ */
+
+Layout LoadLayout(char * FileName)
+{
+    FILE * File = FileOpener(FileName, "r");
+    
+    Layout Map = { NULL, 0, 0, 0xFF };
+    
+    int LineNumber = 0;
+    
+    char Line[LINE_LENGTH];
+    
+    while (fgets(Line, LINE_LENGTH, File))
+    {
+        LineNumber ++;
+        
+        // Remove Comments
+        
+        Line[strcspn(Line, "#")] = '\0';
+        
+        char * Fields[5];
+        
+        int FieldCount = 0;
+        
+        char * Field = strtok(Line, " \t\r\n");
+        
+        while (Field && FieldCount < 5)
+        {
+            Fields[FieldCount ++] = Field;
+            
+            Field = strtok(NULL, " \t\r\n");
+        }
+        
+        if (FieldCount == 0)
+        {
+            continue;
+        }
+        
+        if (FieldCount == 5 || FieldCount < 2)
+        {
+            printf("Line %d : Expected <File> <Offset> [Maximum Size] [Fill Byte] \r\n", LineNumber);
+            exit(-1);
+        }
+        
+        // The Size Line
+        
+        if (strcmp(Fields[0], "Size") == 0 && FieldCount <= 3)
+        {
+            Map.ImageSize = ParseSize(Fields[1]);
+            
+            if (FieldCount == 3)
+            {
+                Map.Fill = ParseFill(Fields[2], LineNumber);
+            }
+            
+            continue;
+        }
+        
+        AddLayoutEntry(&Map, Fields[0], ParseSize(Fields[1]),
+                       (FieldCount > 2 && strcmp(Fields[2], "-") != 0) ? ParseSize(Fields[2]) : SIZE_TO_NEXT,
+                       FieldCount > 3 ? ParseFill(Fields[3], LineNumber) : 0xFF);
+    }
+    
+    fclose(File);
+    
+    return Map;
+}
+
+/*
+ *  The Add Layout Entry Method will append a Partition to a Layout.
+ *  The File Name is Copied.
+ * 
+ *  Parameters:
+ *          A Layout Pointer
+ *          The File Name, Offset, Maximum Size ( or SIZE_TO_NEXT ) and Fill Byte of the Partition
+ * 
+ *  Returns:
+ *          VOID
+ */
+
+void AddLayoutEntry(Layout * Map, char * FileName, QWORD Offset, QWORD MaximumSize, BYTE Fill)
+{
+    // The Entries grow by Doubling, Counts which are a Power of Two are Full
+    
+    if (Map -> Count == 0 || (Map -> Count >= 16 && (Map -> Count & (Map -> Count - 1)) == 0))
+    {
+        int Allocated = Map -> Count ? Map -> Count * 2 : 16;
+        
+        Map -> Entries = realloc(Map -> Entries, Allocated * sizeof(LayoutEntry));
+        
+        if (Map -> Entries == NULL)
+        {
+            puts("Error Allocating Memory");
+            exit(-1);
+        }
+    }
+    
+    LayoutEntry * Entry = &Map -> Entries[Map -> Count ++];
+    
+    Entry -> FileName = strdup(FileName);
+    
+    Entry -> Offset = Offset;
+    
+    Entry -> MaximumSize = MaximumSize;
+    
+    Entry -> Fill = Fill;
+}
+
+static int CompareOffsets(const void * First, const void * Second)
+{
+    const LayoutEntry * A = First;
+    const LayoutEntry * B = Second;
+    
+    if (A -> Offset != B -> Offset)
+    {
+        return A -> Offset > B -> Offset ? 1 : -1;
+    }
+    
+    // At the same Offset, Partitions of Known Size come First
+    
+    return (A -> MaximumSize == SIZE_TO_NEXT) - (B -> MaximumSize == SIZE_TO_NEXT);
+}
+
+/*
+ *  The Sort Layout Method will order the Partitions by Offset.
+ */
+
+void SortLayout(Layout * Map)
+{
+    qsort(Map -> Entries, Map -> Count, sizeof(LayoutEntry), CompareOffsets);
+}
+
+/*
+ *  The Cut Layout Method will treat each Partition ending at the Next one
+ *  ( Size - ) as a Split Point, when it starts inside a Partition of Known
+ *  Size. The enclosing Partition is Cut there, and the Split Point ends at
+ *  the Next Partition, or where the enclosing one Ended. This lets the
+ *  Signature Hits of the Binary Searcher cut the Hex Dump's Partitions.
+ *  A Split Point at the Offset of the Partition before it is Removed, as a
+ *  Partition already Starts there. The Layout has to be Sorted.
+ * 
+ *  Parameters:
+ *          A Layout Pointer
+ * 
+ *  Returns:
+ *          VOID
+ */
+
+void CutLayout(Layout * Map)
+{
+    LayoutEntry * Enclosing = NULL;
+    
+    QWORD EnclosingEnd = 0;
+    
+    int Kept = 0;
+    
+    int Counter;
+    
+    for (Counter = 0; Counter < Map -> Count; Counter ++)
+    {
+        LayoutEntry Entry = Map -> Entries[Counter];
+        
+        if (Entry.MaximumSize != SIZE_TO_NEXT)
+        {
+            Map -> Entries[Kept ++] = Entry;
+            
+            // The Sizes of the Hits inside it are Set once it is Kept
+            
+            Enclosing = &Map -> Entries[Kept - 1];
+            
+            EnclosingEnd = Entry.Offset + Entry.MaximumSize;
+            
+            continue;
+        }
+        
+        if (Kept > 0 && Entry.Offset == Map -> Entries[Kept - 1].Offset)
+        {
+            free(Entry.FileName);
+            
+            continue;
+        }
+        
+        if (Enclosing == NULL || Entry.Offset >= EnclosingEnd)
+        {
+            Map -> Entries[Kept ++] = Entry;
+            
+            continue;
+        }
+        
+        LayoutEntry * Previous = &Map -> Entries[Kept - 1];
+        
+        Previous -> MaximumSize = Entry.Offset - Previous -> Offset;
+        
+        // Until a Later Hit or Partition Cuts it
+        
+        Entry.MaximumSize = EnclosingEnd - Entry.Offset;
+        
+        Map -> Entries[Kept ++] = Entry;
+    }
+    
+    Map -> Count = Kept;
+}
+
+/*
+ *  The Resolve Layout Method will replace the Maximum Sizes set to - with
+ *  the Distance to the Next Partition, or to the End of the Image.
+ *  The Layout has to be Sorted.
+ * 
+ *  Parameters:
+ *          A Layout Pointer
+ *          The Size of the Image, used for the Last Partition
+ * 
+ *  Returns:
+ *          VOID
+ */
+
+void ResolveLayout(Layout * Map, QWORD ImageSize)
+{
+    int Counter;
+    
+    for (Counter = 0; Counter < Map -> Count; Counter ++)
+    {
+        LayoutEntry * Entry = &Map -> Entries[Counter];
+        
+        if (Entry -> MaximumSize != SIZE_TO_NEXT)
+        {
+            continue;
+        }
+        
+        QWORD End = Counter + 1 < Map -> Count ? Map -> Entries[Counter + 1].Offset : ImageSize;
+        
+        Entry -> MaximumSize = End > Entry -> Offset ? End - Entry -> Offset : 0;
+    }
+}
+
+/*
+ *  The Check Layout Method will make sure no Partition overlaps the Next one
+ *  and that every Partition fits inside the Image ( If it's Size is Set ).
+ *  The Layout has to be Sorted and Resolved. Every Problem is Printed.
+ * 
+ *  Parameters:
+ *          A Layout Pointer
+ * 
+ *  Returns:
+ *          The Number of Problems Found
+ */
+
+int CheckLayout(Layout * Map)
+{
+    int Problems = 0;
+    
+    int Counter;
+    
+    for (Counter = 0; Counter < Map -> Count; Counter ++)
+    {
+        LayoutEntry * Entry = &Map -> Entries[Counter];
+        
+        QWORD End = Entry -> Offset + Entry -> MaximumSize;
+        
+        if (End < Entry -> Offset)
+        {
+            printf("%s : Size Overflows \r\n", Entry -> FileName);
+            Problems ++;
+        }
+        
+        if (Counter + 1 < Map -> Count && End > Map -> Entries[Counter + 1].Offset)
+        {
+            printf("%s ( 0x%llX - 0x%llX ) Overlaps %s at 0x%llX \r\n", Entry -> FileName, (unsigned long long) Entry -> Offset,
+                   (unsigned long long) End, Map -> Entries[Counter + 1].FileName, (unsigned long long) Map -> Entries[Counter + 1].Offset);
+            Problems ++;
+        }
+        
+        if (Map -> ImageSize && End > Map -> ImageSize)
+        {
+            printf("%s ( 0x%llX - 0x%llX ) Ends after the Image Size 0x%llX \r\n", Entry -> FileName, (unsigned long long) Entry -> Offset,
+                   (unsigned long long) End, (unsigned long long) Map -> ImageSize);
+            Problems ++;
+        }
+    }
+    
+    return Problems;
+}
+
+/*
+ *  The Write Layout Method will write a Layout in the Layout File Format.
+ * 
+ *  Parameters:
+ *          A Layout Pointer
+ *          The File to Write To
+ * 
+ *  Returns:
+ *          VOID
+ */
+
+void WriteLayout(Layout * Map, FILE * File)
+{
+    int Counter;
+    
+    if (Map -> ImageSize)
+    {
+        fprintf(File, "%-32s 0x%-10llX 0x%02X\n", "Size", (unsigned long long) Map -> ImageSize, Map -> Fill);
+    }
+    
+    for (Counter = 0; Counter < Map -> Count; Counter ++)
+    {
+        LayoutEntry * Entry = &Map -> Entries[Counter];
+        
+        fprintf(File, "%-32s 0x%-10llX ", Entry -> FileName, (unsigned long long) Entry -> Offset);
+        
+        if (Entry -> MaximumSize == SIZE_TO_NEXT)
+        {
+            fprintf(File, "%-12s ", "-");
+        }
+        else
+        {
+            fprintf(File, "0x%-10llX ", (unsigned long long) Entry -> MaximumSize);
+        }
+        
+        fprintf(File, "0x%02X\n", Entry -> Fill);
+    }
+}
+
+void FreeLayout(Layout * Map)
+{
+    int Counter;
+    
+    for (Counter = 0; Counter < Map -> Count; Counter ++)
+    {
+        free(Map -> Entries[Counter].FileName);
+    }
+    
+    free(Map -> Entries);
+    
+    Map -> Entries = NULL;
+    Map -> Count = 0;
+}
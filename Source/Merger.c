@@ -12,12 +12,24 @@
  *  This Application will take multiple files as arguments          *
  *  and merge them as a single binary                               *
  *                                                                  *
+ *  The Files are Reflinked inside the Output when the File System  *
+ *  supports it, otherwise they are Copied by the Kernel.           *
+ *                                                                  *
+ *  With a Layout File, each File is placed at a Fixed Offset and   *
+ *  the Gaps are Filled. The Layout Format is described inside      *
+ *  the Layout Header File.                                         *
+ *                                                                  *
  * ******************************************************************/
  
 #include <string.h>
 #include <stdlib.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <time.h>
+#include <sys/stat.h>
 
 #include "../Headers/Common.h"
+#include "../Headers/Layout.h"
 
 ////////////////////////////////////////////////////////////////////////////////
 
@@ -25,101 +37,388 @@
 
 FILE * FileOpener(char * Filename, char * ReadMode);
 
-char * DumpHex(char * FileName);
-
 ////////////////////////////////////////////////////////////////////////////////
 
 // Internal Function Prototypes
 
-void MergeFiles(char * Files[], int FileCount, char * OutputFile);
+void MergeFiles(char * Files[], int FileCount, char * OutputFile, char Confirm);
+
+void AssembleLayout(char * LayoutFile, char * OutputFile, char Confirm);
+
+void AskConfirmation(char * OutputFile, char Confirm);
+
+void FillGap(int Output, QWORD Offset, QWORD Length, BYTE Fill);
+
+// The Names of the Copy Methods, as Returned by Copy Range
+
+static const char * Methods[] = { "Reflinked", "Kernel Copy", "Buffered Copy" };
 
 ////////////////////////////////////////////////////////////////////////////////
 
 int main(int argc, char * argv[])
 {
-    // If the Argument Count is greater then Two
+    InitStats(&argc, argv);
     
-    if (argc > 2)
-    {       
-        int Counter ;
+    // The -y Option skips the Confirmation, for Unattended Use
+    
+    char Confirm = 1;
+    
+    int First = 1;
+    
+    if (argc > 1 && strcmp(argv[1], "-y") == 0)
+    {
+        Confirm = 0;
+        
+        First = 2;
+    }
+    
+    // If a Layout File and an Output are Passed
+    
+    if (argc - First == 3 && strcmp(argv[First], "-Layout") == 0)
+    {
+        int Phase = STATS_BEGIN("Assemble");
         
-        // A Character Array to hold the Files being Merged
+        AssembleLayout(argv[First + 1], argv[First + 2], Confirm);
         
-        char * Files[argc - 2];
+        STATS_END(Phase);
+    }
+    
+    // If there is at least one File to Merge and an Output
+    
+    else if (argc - First > 1)
+    {       
+        // The Files being Merged are the Arguments preceding the Output
         
-        // Get the Passed Filenames and store then in the Files Array
+        int Phase = STATS_BEGIN("Merge");
         
-        for ( Counter = 1; Counter < argc - 1; Counter ++)
-        {
-            Files[Counter - 1] = argv[Counter];
-        }       
+        MergeFiles(argv + First, argc - First - 1, argv[argc - 1], Confirm);
         
-        MergeFiles(Files, argc - 2, argv[Counter]);
+        STATS_END(Phase);
     }
     else
     {
         printf("Syntax : \r\n");
-        printf("\t %s <Files to Pack ...> <Output> \r\n", argv[0]); 
+        printf("\t %s [-y] <Files to Pack ...> <Output> \r\n", argv[0]); 
+        printf("\t %s [-y] -Layout <Layout File> <Output> \r\n\r\n", argv[0]); 
+        
+        puts("Available Options:");
+        
+        printf("\t -y : Do not ask for Confirmation \r\n");
+        printf("\t -Layout FILE : Place each File at the Offset given by the Layout File \r\n\r\n");
+        
+        puts("Layout File Lines:");
+        
+        printf("\t <File> <Offset> [Maximum Size or -] [Fill Byte] \r\n");
+        printf("\t Size <Image Size> [Gap Fill Byte] \r\n");
     }
+    
+    return 0;
 }
 
 /*  The Merge Files method takes Two or More Binary Files and concatenates 
  *  them into one Binary File.
  * 
+ *  Each File is added with the Cheapest Copy the File System supports
+ *  ( Reflink, Kernel Copy or Buffered Copy ), so no File is Loaded in Memory.
+ * 
  *  Parameters:
  *          Files[]     : Char Array of the Files Being Merged
  *          File Count  : Integer with the Number of Files being Merged
  *          Output File : Char Array with the Name of the Output File
+ *          Confirm     : Char Indicating weather the User is asked to Confirm ( 1 ) or not ( 0 )
  * 
  *  Returns : 
  *          VOID
  */
  
-void MergeFiles(char * Files[], int FileCount, char * OutputFile)
+void MergeFiles(char * Files[], int FileCount, char * OutputFile, char Confirm)
 {
+    int Counter;
+    
+    AskConfirmation(OutputFile, Confirm);
+    
     // Create a writing handle using the Output File Variable
     
-    FILE * File = FileOpener(OutputFile, "w");
+    int Output = open(OutputFile, O_WRONLY | O_CREAT | O_TRUNC, 0644);
     
-    int Counter;
+    if (Output < 0)
+    {
+        puts("Cannot Create Output File");
+        
+        exit(EXIT_FAILURE);
+    }
+    
+    QWORD Offset = 0;
+    
+    struct timespec Start, End;
+    
+    clock_gettime(CLOCK_MONOTONIC, &Start);
+    
+    // Iterate the Files Array
     
+    for (Counter = 0; Counter < FileCount; Counter ++)
+    {
+        int Input = open(Files[Counter], O_RDONLY);
+        
+        struct stat Status;
+        
+        if (Input < 0 || fstat(Input, &Status) != 0)
+        {
+            printf("File Not Found : %s \r\n", Files[Counter]);
+            
+            exit(EXIT_FAILURE);
+        }
+        
+        // Append the File at the End of the Output
+        
+        int Method = CopyRange(Input, 0, Output, Offset, Status.st_size);
+        
+        if (Method < 0)
+        {
+            printf("Error Copying %s \r\n", Files[Counter]);
+            
+            exit(EXIT_FAILURE);
+        }
+        
+        printf("Added %s at Offset 0x%llX ( %llu Bytes, %s ) \r\n", Files[Counter], (unsigned long long) Offset,
+               (unsigned long long) Status.st_size, Methods[Method]);
+        
+        Offset += Status.st_size;
+        
+        close(Input);
+    }
+    
+    // Close the Output File
+    
+    close(Output);
+    
+    clock_gettime(CLOCK_MONOTONIC, &End);
+    
+    double Seconds = (End.tv_sec - Start.tv_sec) + (End.tv_nsec - Start.tv_nsec) / 1e9;
+    
+    printf("Merged %llu Bytes in %.3f Seconds ( %.0f MB/s ) \r\n", (unsigned long long) Offset, Seconds, Seconds > 0 ? Offset / Seconds / 1e6 : 0);
+
+    printf("Merged File saved as : %s \r\n", OutputFile);
+    
+}
+
+/*  The Ask Confirmation method asks the User to Confirm the Output File,
+ *  and Exits if the User does not.
+ * 
+ *  Parameters:
+ *          Output File : Char Array with the Name of the Output File
+ *          Confirm     : Char Indicating weather the User is asked to Confirm ( 1 ) or not ( 0 )
+ * 
+ *  Returns : 
+ *          VOID
+ */
+
+void AskConfirmation(char * OutputFile, char Confirm)
+{
     printf("Output is going to be saved to : %s ", OutputFile);
     
-    puts("Proceed ? [Y/N]");
+    if (Confirm)
+    {
+        puts("Proceed ? [Y/N]");
+        
+        // Get User Confirmation
+        
+        int UserInput = getchar();
+        
+        // If the User does Not Confirm
+        
+        if (UserInput != 'Y')
+        {
+            // Print Message and Exit
+            
+            puts("Exiting ... ");
+            
+            exit(EXIT_FAILURE);
+        }
+    }
+    else
+    {
+        printf("\r\n");
+    }
+}
+
+/*  The Assemble Layout method places each File of a Layout at it's Offset
+ *  inside the Output, in a single Pass.
+ * 
+ *  Every Input is checked against the Layout before any Byte is Written :
+ *  Partitions must not Overlap, and each File must fit inside it's Partition.
+ * 
+ *  The Space left inside a Partition is Filled with the Partition's Fill Byte,
+ *  and the Gaps between Partitions with the Layout's Fill Byte. A Fill Byte of
+ *  0x00 is not Written, the Space is left as a Hole inside the Output.
+ * 
+ *  Parameters:
+ *          Layout File : Char Array with the Name of the Layout File
+ *          Output File : Char Array with the Name of the Output File
+ *          Confirm     : Char Indicating weather the User is asked to Confirm ( 1 ) or not ( 0 )
+ * 
+ *  Returns : 
+ *          VOID
+ */
+
+void AssembleLayout(char * LayoutFile, char * OutputFile, char Confirm)
+{
+    Layout Map = LoadLayout(LayoutFile);
+    
+    if (Map.Count == 0)
+    {
+        puts("The Layout holds no Partitions");
+        
+        exit(EXIT_FAILURE);
+    }
     
-    // Get User Confirmation
+    SortLayout(&Map);
     
-    int UserInput = getchar();
+    QWORD * Sizes = malloc(Map.Count * sizeof(QWORD));
     
-    // If the User does Not Confirm
+    int Counter;
     
-    if (UserInput != 'Y')
+    int Problems = 0;
+    
+    // Get the Size of each Input, the Image Ends after the Last Partition unless it's Size is Set
+    
+    QWORD ImageSize = Map.ImageSize;
+    
+    for (Counter = 0; Counter < Map.Count; Counter ++)
     {
-        // Print Message and Exit
+        struct stat Status;
+        
+        if (stat(Map.Entries[Counter].FileName, &Status) != 0)
+        {
+            printf("File Not Found : %s \r\n", Map.Entries[Counter].FileName);
+            
+            exit(EXIT_FAILURE);
+        }
         
-        puts("Exiting ... ");
+        Sizes[Counter] = Status.st_size;
+        
+        QWORD End = Map.Entries[Counter].Offset + (Map.Entries[Counter].MaximumSize == SIZE_TO_NEXT ? Sizes[Counter] : Map.Entries[Counter].MaximumSize);
+        
+        if (Map.ImageSize == 0 && End > ImageSize)
+        {
+            ImageSize = End;
+        }
+    }
+    
+    ResolveLayout(&Map, ImageSize);
+    
+    Problems += CheckLayout(&Map);
+    
+    for (Counter = 0; Counter < Map.Count; Counter ++)
+    {
+        if (Sizes[Counter] > Map.Entries[Counter].MaximumSize)
+        {
+            printf("%s ( %llu Bytes ) does not fit inside it's Partition ( %llu Bytes ) \r\n", Map.Entries[Counter].FileName,
+                   (unsigned long long) Sizes[Counter], (unsigned long long) Map.Entries[Counter].MaximumSize);
+            
+            Problems ++;
+        }
+    }
+    
+    if (Problems > 0)
+    {
+        printf("%d Problems Found inside the Layout, Nothing was Written \r\n", Problems);
         
         exit(EXIT_FAILURE);
     }
     
-    // Iterate the Files Array
+    AskConfirmation(OutputFile, Confirm);
     
-    for (Counter = 0; Counter < FileCount; Counter ++)
+    int Output = open(OutputFile, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    
+    // Set the Final Size first, the Parts which are never Written stay as Holes
+    
+    if (Output < 0 || ftruncate(Output, ImageSize) != 0)
     {
-        // Get the File's Equivalent Hex Dump
+        puts("Cannot Create Output File");
+        
+        exit(EXIT_FAILURE);
+    }
+    
+    struct timespec Start, End;
+    
+    clock_gettime(CLOCK_MONOTONIC, &Start);
+    
+    QWORD Cursor = 0;
+    
+    for (Counter = 0; Counter < Map.Count; Counter ++)
+    {
+        LayoutEntry * Entry = &Map.Entries[Counter];
+        
+        // Fill the Gap preceding the Partition
+        
+        FillGap(Output, Cursor, Entry -> Offset - Cursor, Map.Fill);
         
-        char * Hex = DumpHex(Files[Counter]);
+        int Input = open(Entry -> FileName, O_RDONLY);
         
-        // Write the HexDump inside the New Output File
+        int Method = Input < 0 ? -1 : CopyRange(Input, 0, Output, Entry -> Offset, Sizes[Counter]);
         
-        fwrite(Hex, FileSize, 1, File);
+        if (Method < 0)
+        {
+            printf("Error Copying %s \r\n", Entry -> FileName);
+            
+            exit(EXIT_FAILURE);
+        }
+        
+        close(Input);
+        
+        // Fill the Rest of the Partition
+        
+        FillGap(Output, Entry -> Offset + Sizes[Counter], Entry -> MaximumSize - Sizes[Counter], Entry -> Fill);
+        
+        printf("Placed %s at Offset 0x%llX ( %llu of %llu Bytes, %s ) \r\n", Entry -> FileName, (unsigned long long) Entry -> Offset,
+               (unsigned long long) Sizes[Counter], (unsigned long long) Entry -> MaximumSize, Methods[Method]);
+        
+        Cursor = Entry -> Offset + Entry -> MaximumSize;
     }
     
+    // Fill the Space following the Last Partition
     
-    // Close the Output File
+    FillGap(Output, Cursor, ImageSize - Cursor, Map.Fill);
+    
+    close(Output);
+    
+    clock_gettime(CLOCK_MONOTONIC, &End);
+    
+    double Seconds = (End.tv_sec - Start.tv_sec) + (End.tv_nsec - Start.tv_nsec) / 1e9;
+    
+    printf("Assembled %llu Bytes in %.3f Seconds ( %.0f MB/s ) \r\n", (unsigned long long) ImageSize, Seconds, Seconds > 0 ? ImageSize / Seconds / 1e6 : 0);
     
-    fclose(File);
-
     printf("Merged File saved as : %s \r\n", OutputFile);
     
+    free(Sizes);
+    
+    FreeLayout(&Map);
+}
+
+/*  The Fill Gap method Fills a Range of the Output with a Byte Value.
+ *  Ranges Filled with 0x00 are left as Holes, they already Read as Zeros.
+ * 
+ *  Parameters:
+ *          The Output Descriptor
+ *          The Offset and Length of the Range
+ *          The Fill Byte
+ * 
+ *  Returns : 
+ *          VOID
+ */
+
+void FillGap(int Output, QWORD Offset, QWORD Length, BYTE Fill)
+{
+    if (Length == 0 || Fill == 0x00)
+    {
+        return;
+    }
+    
+    if (FillRange(Output, Offset, Length, Fill) != 0)
+    {
+        puts("Error Writing Output");
+        
+        exit(EXIT_FAILURE);
+    }
 }
@@ -0,0 +1,650 @@
+/* PFS File System Packing */
+
+#include <dirent.h>
+#include <sys/stat.h>
+
+#include "../Headers/Common.h"
+#include "../Headers/ThreadPool.h"
+#include "../Headers/PFS.h"
+
+// Variable Used to hold The ammount of files being Packed
+
+int TotalFiles;
+
+// Variable Used to Hold the Length of the Packed Folder's Path
+// The Name stored inside the Image is the Path relative to the Packed Folder
+
+int RootLength;
+
+// Static Variable Used to Hold The Filenames of the files being Packed
+
+static char * FileNames[MAX_FILES] = {0};
+
+/*
+ *  The Set Pack Root Method will remove any Trailing Slashes from the Folder
+ *  being Packed and store the Length of it's Path, so that the Names stored
+ *  inside the Image are relative to the Folder.
+ * 
+ *  Parameters:
+ *          A Char Array with the Folder Being Packed
+ * 
+ *  Returns:
+ *          VOID
+ */
+
+void SetPackRoot(char * Directory)
+{
+    int Length = strlen(Directory);
+    
+    while ( Length > 1 && Directory[Length - 1] == '/' )
+    {
+        Directory[--Length] = '\0';
+    }
+    
+    RootLength = Length + 1;
+}
+
+/*
+ *  The Gather Files Method will search a Given folder 
+ *  for regular files.
+ * 
+ *  Once executed, this method will populate the Globally declared 
+ *  Filenames Array with the relative path of the files found
+ * 
+ *  Parameters:
+ *          A Char Array with the Folder Being Searched
+ *          A Char Indicating weather a Recursive scan should be performed ( 1 ) or not ( 0 )
+ * 
+ *  Returns:
+ *          VOID
+ * 
+ */
+ 
+void GatherFiles(char * ParentFolder, char RecursiveScan)
+{
+    // DIR Pointer, Defined inside the Dirent Header File
+    
+    DIR * Directory;
+    
+    // Open the Directory and store it's content inside the Directory structure
+    
+    Directory = opendir(ParentFolder);
+    
+    // Dirent Pointer, Defined inside the Dirent Header File
+    
+    struct dirent * Entry;
+    
+    // A Char Array to store the Path of the file found
+    
+    char FullPath[PATH_MAX];
+    
+    // Structure used to check the Type of the Entry
+    
+    struct stat Status;
+    
+    // If Directory is NULL
+    
+    if (!Directory)
+    {
+        // Print Error message and Exit
+        
+        puts("Cannot Open Folder \n");
+        
+        exit(EXIT_FAILURE);
+    }
+    
+    while (1)
+    {
+        // Read Entry inside the Directory
+        
+        Entry = readdir(Directory);
+        
+        if (!Entry)
+        {
+            break;
+        }
+        
+        // Skit the Entry if the retrieved entry Name is either .. ( Top Folder ) or . ( Current Folder ) 
+        
+        if ( strcmp(Entry -> d_name, "..") == 0 || strcmp(Entry -> d_name, ".") == 0 )
+        {
+            continue;
+        }
+        
+        // Write the Relative Path of the Entry inside the FullPath char Array
+        
+        snprintf(FullPath, PATH_MAX, "%s/%s", ParentFolder, Entry -> d_name);
+        
+        if ( stat(FullPath, &Status) != 0 )
+        {
+            continue;
+        }
+        
+        // If the Entry is a Directory
+        
+        if ( S_ISDIR(Status.st_mode) )
+        {
+            // If a recursive scan is selected
+            
+            if (RecursiveScan == 1)
+            {
+                // If the Length is greater then the acceptable path length
+                
+                if (strlen(FullPath + RootLength) >= NAME_BLOCK)
+                {
+                    // Print Error Message and skip the directory
+                    
+                    printf("Ommiting Directory %s. Path too Long \r\n", Entry -> d_name);
+                    
+                    continue;
+                }
+                
+                
+                printf ("Recurring to Folder %s \r\n", Entry -> d_name);
+                
+                // Recure Folder
+                
+                GatherFiles(FullPath, 1);
+            }
+        }
+        
+        // If the Entry is a Regular File
+        else if ( S_ISREG(Status.st_mode) )
+        {
+            // The Stored Name has to fit inside the Name Block along with it's NULL Byte
+            
+            if (strlen(FullPath + RootLength) >= NAME_BLOCK)
+            {
+                printf("Ommiting File %s. Path too Long \r\n", Entry -> d_name);
+                
+                continue;
+            }
+            
+            if (TotalFiles == MAX_FILES)
+            {
+                printf("Ommiting File %s. More then %d Files \r\n", Entry -> d_name, MAX_FILES);
+                
+                continue;
+            }
+            
+            // Allocate Memory for the Entry ( Full Path Length + NULL Byte)
+            
+            FileNames[TotalFiles] = malloc( strlen( FullPath ) + 1 );
+            
+            // Copy the Path inside the array
+                        
+            strcpy( FileNames[TotalFiles], FullPath );
+            
+            // Increment Total Files Counter declared globally
+            
+            TotalFiles ++;
+        }
+    }
+    
+    // Close the Directory
+    
+    closedir(Directory);
+    
+}
+
+/*
+ *  The Populate Header Method will populate the Header for the 
+ *  PFS Image.
+ * 
+ * 
+ *  Parameters:
+ *          An 16 Bits (2 Bytes) Unsigned integer with the Number of Entries ( Files ) being Packed
+ * 
+ *  Returns:
+ *          PFSHeader Structure
+ * 
+ */
+
+PFSHeader PopulateArchiveHeader(WORD Entries)
+{
+    PFSHeader ArchiveHeader;
+    
+    ArchiveHeader.Signature[0] = 0x50; // P
+    ArchiveHeader.Signature[1] = 0x46; // F
+    ArchiveHeader.Signature[2] = 0x53; // S
+    ArchiveHeader.Signature[3] = 0x2F; // / 
+    ArchiveHeader.Signature[4] = 0x30; // 0
+    ArchiveHeader.Signature[5] = 0x2E; // .
+    ArchiveHeader.Signature[6] = 0x39; // 9
+    ArchiveHeader.Signature[7] = 0x00; // /0
+    
+    // Null Seperator
+    
+    ArchiveHeader.NullPadding[0] = 0x00;
+    ArchiveHeader.NullPadding[1] = 0x00;
+    ArchiveHeader.NullPadding[2] = 0x00;
+    ArchiveHeader.NullPadding[3] = 0x00;
+    
+    // Unknown Field
+    
+    ArchiveHeader.UnknownField = 0; // For the Sake of Diffing -
+    
+    // Entry Count
+    
+    ArchiveHeader.EntryCount = TotalFiles;
+    
+    return ArchiveHeader;
+    
+}
+
+/*
+ *  The Pack Files Method will Iterate the Filenames Array which is populated by the
+ *  Gather Files Method and generate information about each File.
+ *  
+ *  This method retrieves information about the File's Size and Timestamp 
+ *  from the File System. The File's Content is only read when the Image is Written.
+ * 
+ *  The Offset property is calculated inside this method. This property is needed
+ *  to tell the Unpacker where the File resides inside the final Binary.
+ * 
+ *  Parameters:
+ *          None
+ *  
+ *  Returns:
+ *          PFSEntry Structure Pointer
+ * 
+ */
+ 
+PFSEntry * PackFiles()
+{
+    // Variable used to Calculate the File's Offset
+    
+    QWORD OffsetCounter = 0;
+    
+    // Variable used to loob the Filenames Array
+    
+    int PackingCounter = 0;
+    
+    // PFSEntry Structure Pointer. 
+    // The Pointer is allocated Memory according to the number of Files being Packed
+    // The Memory is Zeroed so that the Name Blocks are padded with NULL Bytes
+    
+    PFSEntry * Packer = calloc (TotalFiles + 1, sizeof(PFSEntry));
+    
+    // Display Packing Information
+    
+    printf("Total Files to Pack : %d \r\n\r\n", TotalFiles);
+    
+    // If Memory Allocation Fails
+    
+    if (Packer == NULL)
+    {
+        // Print Error Message and Exit
+        
+        puts("Error Allocating Memory \r\n");
+        exit(EXIT_FAILURE);
+    }
+    
+    struct stat Status;
+    
+    for (PackingCounter = 0; PackingCounter < TotalFiles; PackingCounter ++)
+    {
+        PFSEntry * Packed = &Packer[PackingCounter];
+        
+        // Display Packing Information
+        
+        printf("Packing File %d of %d - %s \r\n", PackingCounter + 1, TotalFiles, FileNames[PackingCounter] );
+        
+        if (stat(FileNames[PackingCounter], &Status) != 0)
+        {
+            puts("File Not Found");
+            exit(EXIT_FAILURE);
+        }
+        
+        // Store the File's Location on Disk, it is read when the Image is Written
+        
+        Packed -> SourcePath = FileNames[PackingCounter];
+        
+        //Store the File's Name, relative to the Packed Folder, inside the Filename Property of the PFSEntry Structure
+        
+        strncpy(Packed -> FileName, FileNames[PackingCounter] + RootLength, NAME_BLOCK);
+        
+        //Store the File's Offset inside the Offset Property of the PFSEntry Structure
+        
+        Packed -> Offset = OffsetCounter;
+        
+        // Add the File's Size to the current offset, to point to the next file
+        
+        OffsetCounter += Status.st_size;
+        
+        // Offsets and Sizes are stored as 32 Bit Values
+        
+        if (OffsetCounter > 0xFFFFFFFF)
+        {
+            puts("The Files do not fit inside a PFS Image ( 4 GB Limit ) \r\n");
+            exit(EXIT_FAILURE);
+        }
+        
+        // Store the File's Size inside the Size Property of the PFSEntry Structure
+        
+        Packed -> Size = Status.st_size;
+        
+        // Store the Timestamp inside the Timestamp Property of the PFSEntry Structure
+        
+        Packed -> Timestamp = 1;
+        
+        // Store the Modification Time, used by the Manifest
+        
+        Packed -> Modified = Status.st_mtim.tv_sec * 1000000000ULL + Status.st_mtim.tv_nsec;
+        
+        Packed -> Alias = -1;
+    }
+    
+    // Return a Pointer to the PFSEntry Structure Array
+    
+    return Packer;
+}
+
+
+/*
+ *  The Deduplicate Files Method will Hash every Packed File in Parallel and
+ *  point Files with an Identical Content to the Data of the first such File.
+ * 
+ *  Files matching the Manifest ( Same Size and Modification Time ) reuse the
+ *  Hash stored inside it instead of being Read. Files with a matching Hash are
+ *  compared Byte by Byte before they share their Data.
+ * 
+ *  The Offsets of the Entries are recalculated, so that only the Unique
+ *  Files take space inside the Data Segment.
+ * 
+ *  Parameters:
+ *          PFSEntry Array Pointer to the Packed Files
+ *          The Manifest of the Previous Image and it's Line Count ( NULL and 0 if None )
+ *  
+ *  Returns:
+ *          VOID
+ */
+
+void DeduplicateFiles(PFSEntry * Packer, ManifestEntry * Manifest, int ManifestCount)
+{
+    int Counter;
+    
+    // Take the Hashes of the Untouched Files from the Manifest
+    
+    for (Counter = 0; Counter < TotalFiles; Counter ++)
+    {
+        ManifestEntry * Known = FindManifestEntry(Manifest, ManifestCount, Packer[Counter].FileName);
+        
+        if (Known && Known -> Size == Packer[Counter].Size && Known -> Modified == Packer[Counter].Modified)
+        {
+            Packer[Counter].Hash = Known -> Hash;
+            
+            Packer[Counter].Hashed = 1;
+        }
+    }
+    
+    // Hash the Remaining Files using every CPU
+    
+    RunParallel(TotalFiles, HashEntry, Packer);
+    
+    QWORD OffsetCounter = 0;
+    
+    QWORD SavedBytes = 0;
+    
+    int Duplicates = 0;
+    
+    for (Counter = 0; Counter < TotalFiles; Counter ++)
+    {
+        PFSEntry * Entry = &Packer[Counter];
+        
+        int Previous;
+        
+        // Look for an Earlier Unique File with the same Content
+        
+        for (Previous = 0; Previous < Counter; Previous ++)
+        {
+            if (Packer[Previous].Alias < 0 && Packer[Previous].Size == Entry -> Size
+                && Packer[Previous].Hash == Entry -> Hash && SameContent(&Packer[Previous], Entry))
+            {
+                break;
+            }
+        }
+        
+        // Empty Files have no Data to Share
+        
+        if (Previous < Counter && Entry -> Size > 0)
+        {
+            Entry -> Alias = Previous;
+            
+            Entry -> Offset = Packer[Previous].Offset;
+            
+            SavedBytes += Entry -> Size;
+            
+            Duplicates ++;
+        }
+        else
+        {
+            Entry -> Offset = OffsetCounter;
+            
+            OffsetCounter += Entry -> Size;
+        }
+    }
+    
+    printf("\r\n%d Duplicate Files Found, %llu Bytes Saved \r\n", Duplicates, (unsigned long long) SavedBytes);
+}
+
+/*
+ *  The Hash Entry Method will Hash the Content of a Single Packed File,
+ *  unless it's Hash is already Known. It is called by the Thread Pool.
+ * 
+ *  Parameters:
+ *          The Index of the Entry
+ *          PFSEntry Array Pointer to the Packed Files
+ *  
+ *  Returns:
+ *          VOID
+ */
+
+void HashEntry(int Index, void * Context)
+{
+    PFSEntry * Entry = (PFSEntry *) Context + Index;
+    
+    if (Entry -> Hashed)
+    {
+        return;
+    }
+    
+    QWORD Size;
+    
+    BYTE * Data = MapFile(Entry -> SourcePath, &Size);
+    
+    Entry -> Hash = HashContent(Data, Size);
+    
+    // A File which changed Size since it was Gathered can never match
+    
+    if (Size != Entry -> Size)
+    {
+        Entry -> Hash = ~Entry -> Hash;
+    }
+    
+    Entry -> Hashed = 1;
+    
+    UnmapFile(Data, Size);
+}
+
+/*
+ *  The Same Content Method will compare the Content of two Packed Files.
+ * 
+ *  Parameters:
+ *          Two PFSEntry Pointers
+ *  
+ *  Returns:
+ *          1 if Both Files hold the same Bytes, 0 Otherwise
+ */
+
+char SameContent(PFSEntry * First, PFSEntry * Second)
+{
+    QWORD FirstSize, SecondSize;
+    
+    BYTE * FirstData = MapFile(First -> SourcePath, &FirstSize);
+    BYTE * SecondData = MapFile(Second -> SourcePath, &SecondSize);
+    
+    char Same = FirstSize == SecondSize && memcmp(FirstData, SecondData, FirstSize) == 0;
+    
+    UnmapFile(FirstData, FirstSize);
+    UnmapFile(SecondData, SecondSize);
+    
+    return Same;
+}
+
+/*
+ *  The Find Manifest Entry Method will search the Manifest for a File Name.
+ * 
+ *  Parameters:
+ *          The Manifest and it's Line Count
+ *          A Char Array with the Name being Searched
+ *  
+ *  Returns:
+ *          A Pointer to the Manifest Line, or NULL if the Name is not Found
+ */
+
+ManifestEntry * FindManifestEntry(ManifestEntry * Manifest, int ManifestCount, char * FileName)
+{
+    int Counter;
+    
+    for (Counter = 0; Counter < ManifestCount; Counter ++)
+    {
+        if (strncmp(Manifest[Counter].FileName, FileName, NAME_BLOCK) == 0)
+        {
+            return &Manifest[Counter];
+        }
+    }
+    
+    return NULL;
+}
+
+/*
+ *  The Clear Files Method will release the Gathered File Names, so that
+ *  another Folder can be Gathered.
+ * 
+ *  Parameters:
+ *          None
+ * 
+ *  Returns:
+ *          VOID
+ */
+
+void ClearFiles()
+{
+    int Counter;
+    
+    for (Counter = 0; Counter < TotalFiles; Counter ++)
+    {
+        free(FileNames[Counter]);
+        
+        FileNames[Counter] = NULL;
+    }
+    
+    TotalFiles = 0;
+}
+
+/*
+ *  The Build Entry Table Method will generate the PFS Header followed by the
+ *  Entry Table of the Packed Files inside a single Buffer.
+ * 
+ *  PFSEntry Bytes
+ *      [ 64 Bytes - Filename ] [ 4 Bytes - Timestamp ] [ 4 Bytes - Offset ] [ 4 Bytes - Size ]
+ * 
+ *  Parameters:
+ *          PFSEntry Array Pointer to the Packed Files
+ *          A QWORD Pointer which will hold the Length of the Buffer ( The Data Segment's Offset )
+ * 
+ *  Returns:
+ *          The Buffer, to be Freed by the Caller
+ */
+
+BYTE * BuildEntryTable(PFSEntry * Packer, QWORD * Length)
+{
+    *Length = HEADER_SIZE + (QWORD) TotalFiles * ENTRY_SIZE;
+    
+    BYTE * Table = malloc(*Length);
+    
+    if (Table == NULL)
+    {
+        puts("Error Allocating Memory \r\n");
+        exit(EXIT_FAILURE);
+    }
+    
+    // Generate the PFSHeader
+    
+    PFSHeader ArchiveHeader = PopulateArchiveHeader(TotalFiles);
+    
+    memcpy(Table, ArchiveHeader.Signature, sizeof(ArchiveHeader.Signature));
+    memcpy(Table + 8, ArchiveHeader.NullPadding, sizeof(ArchiveHeader.NullPadding));
+    memcpy(Table + 12, &ArchiveHeader.UnknownField, sizeof(WORD));
+    memcpy(Table + 14, &ArchiveHeader.EntryCount, sizeof(WORD));
+    
+    int Counter;
+    
+    for (Counter = 0; Counter < TotalFiles; Counter ++)
+    {
+        BYTE * Record = Table + HEADER_SIZE + (QWORD) Counter * ENTRY_SIZE;
+        
+        memcpy(Record, Packer[Counter].FileName, NAME_BLOCK);
+        memcpy(Record + NAME_BLOCK, &Packer[Counter].Timestamp, sizeof(DWORD));
+        memcpy(Record + NAME_BLOCK + 4, &Packer[Counter].Offset, sizeof(DWORD));
+        memcpy(Record + NAME_BLOCK + 8, &Packer[Counter].Size, sizeof(DWORD));
+    }
+    
+    return Table;
+}
+
+/*
+ *  The Stream Archive Method will pass a whole PFS Image, in order, to a
+ *  Writer Function. The Header and Entry Table are passed first, followed
+ *  by the Data of every File which is not an Alias of another File.
+ * 
+ *  Each File is Mapped and passed as a single Block, so the Writer sees every
+ *  Byte exactly once and no intermediate Copy is made.
+ * 
+ *  Parameters:
+ *          PFSEntry Array Pointer to the Packed Files
+ *          The Writer Function and a Context Pointer passed to it
+ * 
+ *  Returns:
+ *          The Length of the Image
+ */
+
+QWORD StreamArchive(PFSEntry * Packer, ArchiveWriter Write, void * Context)
+{
+    QWORD Length;
+    
+    BYTE * Table = BuildEntryTable(Packer, &Length);
+    
+    Write(Table, Length, Context);
+    
+    free(Table);
+    
+    int Counter;
+    
+    for (Counter = 0; Counter < TotalFiles; Counter ++)
+    {
+        if (Packer[Counter].Alias >= 0)
+        {
+            continue;
+        }
+        
+        QWORD Size;
+        
+        BYTE * Data = MapFile(Packer[Counter].SourcePath, &Size);
+        
+        if (Size != Packer[Counter].Size)
+        {
+            printf("File %s Changed while Packing \r\n", Packer[Counter].SourcePath);
+            exit(EXIT_FAILURE);
+        }
+        
+        Write(Data, Size, Context);
+        
+        UnmapFile(Data, Size);
+        
+        Length += Size;
+    }
+    
+    return Length;
+}
@@ -21,482 +21,791 @@
  * ******************************************************************
  */
 
+#define _GNU_SOURCE
+
 #include <string.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <dirent.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
 
 #include "../Headers/Common.h"
+#include "../Headers/PFS.h"
+#include "../Headers/IORing.h"
+#include "../Headers/ThreadPool.h"
 
-#define NAME_BLOCK 64
-#define MAX_FILES 1000
-#define PATH_MAX 4096
-
-// A Structure used to store the Header of the PFS Image
-// A more Detailed Description can be found in the Unpacker 
-
-typedef struct 
-{
-    char Signature [8];
-
-    char NullPadding [4];
-
-    WORD UnknownField;
-
-    WORD EntryCount;
-
-} PFSHeader;
-
-// A Structure used to store each file's attributes including the equivalent Hex Dump
-// A more Detailed Description can be found in the Unpacker 
-
-typedef struct
-{
-    char FileName[NAME_BLOCK];
-    
-    DWORD Timestamp;
-    
-    DWORD Offset;
-    
-    DWORD Size;
-    
-    char * HexEquivalent;
-    
-} PFSEntry;
+// The Manifest is stored next to the Image, with this Extension appended
 
+#define MANIFEST_EXTENSION ".manifest"
 
 ////////////////////////////////////////////////////////////////////////////////
 
-// External Function Prototypes
+// Internal Function Prototypes
 
-char * DumpHex (char * FileName);
+static void PrintSyntax(char * ProgramName);
 
-////////////////////////////////////////////////////////////////////////////////
+void WriteBinary(PFSEntry * Packer, char * OutputFile);
 
-// Internal Function Prototypes
+void WriteEntryData(int Output, QWORD DataSegment, PFSEntry * Entry);
 
-void GatherFiles(char * ParentFolder, char RecursiveScan);
+void WriteEntries(int Output, QWORD DataSegment, PFSEntry * Packer, int * Entries, int Count);
 
-PFSHeader PopulateArchiveHeader(WORD Entries);
+void UpdateImage(char * ImageName);
 
-void WriteBinary(PFSEntry * Packer, char * OutputFile);
+ManifestEntry * LoadManifest(char * ImageName, int * Count);
 
-PFSEntry * PackFiles();
+void WriteManifest(PFSEntry * Packer, char * ImageName);
 
 ////////////////////////////////////////////////////////////////////////////////
 
-// Static Variable Used to hold The ammount of files being Packed
+// Static Variable Used to Hold the Descriptor of the Previous Image during an Update
 
-static int TotalFiles;
+static int PreviousImage = -1;
 
-// Static Variable Used to Hold The Filenames of the files being Packed
+// Static Variable Set when Identical Files should share their Data inside the Image
 
-static char * FileNames[MAX_FILES] = {0};
+static char Deduplicate = 0;
 
 
-void main ( int argc, char * argv[] )
+int main ( int argc, char * argv[] )
 {
-    // If the argument count is greater then Four, display the Application's Syntax
+    InitStats(&argc, argv);
     
-    if ( argc > 4 )
+    char RecursiveScan = 0;
+    
+    // A Batch runs every Command inside the same Process ( See FWTools.c ), a Failed Update may have left its Image Open
+    
+    Deduplicate = 0;
+    
+    if (PreviousImage >= 0)
     {
-        printf("%s Syntax Usage \r\n", argv[0]);
-        printf("\t %s <Directory to Pack> <Output FileName> \r\n", argv[0]);
+        close(PreviousImage);
+        
+        PreviousImage = -1;
+    }
+    
+    char * UpdatedImage = NULL;
+    
+    int Index = 1;
+    
+    // Parse the Options preceding the Directory
+    
+    while ( Index < argc && argv[Index][0] == '-' )
+    {
+        if ( strcmp( argv[Index], "-R" ) == 0 )
+        {
+            RecursiveScan = 1;
+        }
+        else if ( strcmp( argv[Index], "-Update" ) == 0 && Index + 1 < argc )
+        {
+            UpdatedImage = argv[++Index];
+        }
+        else if ( strcmp( argv[Index], "-Dedup" ) == 0 )
+        {
+            Deduplicate = 1;
+        }
+        else
+        {
+            PrintSyntax(argv[0]);
+            
+            return 0;
+        }
+        
+        Index ++;
     }
     
-    // If the argument count is equal to three, perform a Non-Recursive Packing
+    // An Update only needs the Directory, as the Previous Image is also the Output
     
-    else if ( argc == 3 )
+    if ( argc - Index != ( UpdatedImage ? 1 : 2 ) )
     {
-        // Display File Population Type
+        PrintSyntax(argv[0]);
         
-        printf ("Non - Recursive Packing - ");
+        return 0;
+    }
+    
+    char * Directory = argv[Index];
+    
+    // The Stored Names are relative to the Directory
+    
+    SetPackRoot(Directory);
+    
+    // Display File Population Type
+    
+    printf ( RecursiveScan ? "Recursive Packing - " : "Non - Recursive Packing - " );
+    
+    // Populate the FileNames Array with the Files found in the Selected Folder ( and it's subfolders if Recursive )
+    
+    ClearFiles();
+    
+    int Phase = STATS_BEGIN("Gather");
+    
+    GatherFiles(Directory, RecursiveScan);
+    
+    STATS_END(Phase);
+    
+    if ( UpdatedImage )
+    {
+        // Compare the Folder against the Previous Image and only write what Changed
         
-        // Populate the FileNames Array with the Files found in the Selected Folder
+        Phase = STATS_BEGIN("Update");
         
-        GatherFiles(argv[1], 0);
+        UpdateImage(UpdatedImage);
         
+        STATS_END(Phase);
+    }
+    else
+    {
         // Store the Packed Files inside an array of the PFSEntry Structure
         
+        Phase = STATS_BEGIN("Pack");
+        
         PFSEntry * PackedFiles = PackFiles();
         
+        // Point Identical Files to a single copy of their Data
+        
+        if ( Deduplicate )
+        {
+            DeduplicateFiles(PackedFiles, NULL, 0);
+        }
+        
+        STATS_END(Phase);
+        
         // Write the Binary File to the Client's Computer
         
-        WriteBinary(PackedFiles, argv[2]);
+        Phase = STATS_BEGIN("Write");
+        
+        WriteBinary(PackedFiles, argv[Index + 1]);
+        
+        STATS_ADD(STAT_FILES, TotalFiles);
+        
+        // Write the Manifest used by future Updates
+        
+        WriteManifest(PackedFiles, argv[Index + 1]);
+        
+        STATS_END(Phase);
     }
     
-    // If the argument count is equal to four, perform a Recursive Packing
-    
-    else if ( argc == 4)
-    {
-        if ( strcmp( argv[1], "-R" ) == 0)
-        {
-            printf ("Recursive Packing - ");
-        
-            // Populate the FileNames Array with Files found in the Selected Folder and it's subfolders
-            
-            GatherFiles(argv[2], 1);
-            
-            // Store the Packed Files inside an array of the PFSEntry Structure
-
-
-            PFSEntry * PackedFiles = PackFiles();
+    return 0;
+}
 
-            // Write the Binary File to the Client's Computer
+// Prints the Syntax Help
 
-            WriteBinary(PackedFiles, argv[3]);
-        }
-    }
+static void PrintSyntax(char * ProgramName)
+{
+    printf("%s Syntax Usage \r\n", ProgramName);
+    printf("\t %s [-R] [-Dedup] <Directory to Pack> <Output FileName> \r\n", ProgramName);
+    printf("\t %s [-R] [-Dedup] -Update <Previous Image> <Directory to Pack> \r\n", ProgramName);
     
-    // If none of the Conditions are met, Display the application's syntax
+    puts("Available Options:");
     
-    else
-    {
-        printf("%s Syntax Usage \r\n", argv[0]);
-        printf("\t %s <Directory to Pack> <Output FileName> \r\n", argv[0]);
-    }
+    printf("\t -R : Pack the Subfolders of the Directory \r\n");
+    printf("\t -Dedup : Store Identical Files only once \r\n");
+    printf("\t -Update IMAGE : Only Rewrite the Files which Changed since IMAGE was Packed \r\n");
 }
 
 
 /*
- *  The Gather Files Method will search a Given folder 
- *  for regular files.
+ *  The Write Binary Method will Iterate the PFSEntry Array and write 
+ *  the final PFSImage inside the Client's Computer
  * 
- *  Once executed, this method will populate the Globally declared 
- *  Filenames Array with the relative path of the files found
+ *  This Method First writes the PFSHeader and the Entry Table to the File
+ *  and then writes the Data of each packed file found inside the PFSEntry Array.
  * 
- *  Parameters:
- *          A Char Array with the Folder Being Searched
- *          A Char Indicating weather a Recursive scan should be performed ( 1 ) or not ( 0 )
+ *  Entries marked as Reused are copied from the Previous Image by the Kernel.
+ *  Consecutive Reused Entries which are also consecutive inside the Previous
+ *  Image are copied as a single Range.
  * 
+ *  The File Opener Method defined in the Hex Dump Header File is used in this method.
+ * 
+ *  Parameters:
+ *          PFSEntry Array Pointer to the Packed Files
+ *          char Array with the Output Binary Name
+ *  
  *  Returns:
  *          VOID
  * 
  */
  
-void GatherFiles(char * ParentFolder, char RecursiveScan)
+void WriteBinary(PFSEntry * Packer, char * OutputFile)
 {
-    // DIR Pointer, Defined inside the Dirent Header File
-    
-    DIR * Directory;
+    // Display basic Writing Information
     
-    // Open the Directory and store it's content inside the Directory structure
+    printf("\r\nWriting Output to : %s\r\n", OutputFile);
     
-    Directory = opendir(ParentFolder);
+    // Open a Writing File Handle using the Output File Variable as the File Name
     
-    // Dirent Pointer, Defined inside the Dirent Header File
+    FILE * File = FileOpener(OutputFile, "w");
     
-    struct dirent * Entry;
+    int Output = fileno(File);
     
-    // A Char Array of maximum size NAME_BLOCK to store the file found
+    // Write the PFSHeader and the Entry Table inside the File
     
-    char FullPath[NAME_BLOCK];
+    QWORD DataSegment;
     
-    // If Directory is NULL
+    BYTE * Table = BuildEntryTable(Packer, &DataSegment);
     
-    if (!Directory)
+    if (WriteAt(Output, Table, DataSegment, 0) != 0)
     {
-        // Print Error message and Exit
-        
-        puts("Cannot Open Folder \n");
-        
+        puts("Error Writing Output");
         exit(EXIT_FAILURE);
     }
     
-    while (1)
+    free(Table);
+    
+    // Re-Iterate the Array Copying the Reused Ranges, the Data of the other Files is Written at once
+    
+    int Counter = 0;
+    
+    int * Entries = malloc((TotalFiles + 1) * sizeof(int));
+    
+    int Count = 0;
+    
+    while (Counter < TotalFiles)
     {
-        // Read Entry inside the Directory
-        
-        Entry = readdir(Directory);
-        
-        if (!Entry)
-        {
-            break;
-        }
-        
-        // Skit the Entry if the retrieved entry Name is either .. ( Top Folder ) or . ( Current Folder ) 
+        // Aliased Entries point to Data Written for another Entry
         
-        if ( strcmp(Entry -> d_name, "..") == 0 || strcmp(Entry -> d_name, ".") == 0 )
+        if (Packer[Counter].Alias >= 0)
         {
-            continue;
+            Counter ++;
         }
-        
-        // Write the Relative Path of the Entry inside the FullPath char Array
-        
-        strcpy(FullPath, ParentFolder);
-        strcat(FullPath, "/");
-        strcpy(FullPath, Entry -> d_name);
-        
-        // If the Entry is a Directory
-        
-        if ( ( Entry -> d_type & DT_DIR ))
+        else if (Packer[Counter].Reused)
         {
-            // If a recursive scan is selected
+            // Extend the Range as long as the Next Entry continues it in both Images
+            
+            int Last = Counter;
+            
+            QWORD Length = Packer[Counter].Size;
             
-            if (RecursiveScan == 1)
+            while (Last + 1 < TotalFiles && Packer[Last + 1].Reused && Packer[Last + 1].Alias < 0
+                   && Packer[Last + 1].PreviousOffset == Packer[Counter].PreviousOffset + Length
+                   && Packer[Last + 1].Offset == Packer[Counter].Offset + Length)
             {
-                int PathLength = 0;
-                
-                char Path [NAME_BLOCK];
-                
-                // Concatenate the Relative path and store it's character length inside the Path Length Variable
+                Last ++;
                 
-                PathLength = snprintf(Path, PATH_MAX, "%s/%s", ParentFolder, Entry -> d_name);
-                
-                // If the Length is greater then the acceptable path length
-                
-                if (PathLength > NAME_BLOCK)
-                {
-                    // Print Error Message and skip the directory
-                    
-                    printf("Ommiting Directory %s. Path too Long \r\n", Entry -> d_name);
-                    
-                    continue;
-                }
-                
-                
-                printf ("Recurring to Folder %s \r\n", Entry -> d_name);
-                
-                // Recure Folder
-                
-                GatherFiles(Path, 1);
+                Length += Packer[Last].Size;
             }
+            
+            if (CopyRange(PreviousImage, Packer[Counter].PreviousOffset, Output, DataSegment + Packer[Counter].Offset, Length) < 0)
+            {
+                puts("Error Copying from the Previous Image");
+                exit(EXIT_FAILURE);
+            }
+            
+            Counter = Last + 1;
         }
-        
-        // If the Entry is not a Folder
         else
         {
-            // Allocate Memory for the Entry ( Full Path Length + NULL Byte)
-            
-            FileNames[TotalFiles] = malloc( strlen( FullPath ) + 1 );
-            
-            // Copy the Path inside the array
-                        
-            strcpy( FileNames[TotalFiles], FullPath );
-            
-            // Increment Total Files Counter declared globally
-            
-            TotalFiles ++;
+            Entries[Count ++] = Counter ++;
+        }
+    }
+    
+    WriteEntries(Output, DataSegment, Packer, Entries, Count);
+    
+    free(Entries);
+    
+    // The Hashes of the Aliased Entries are Known once the Data was Written
+    
+    for (Counter = 0; Counter < TotalFiles; Counter ++)
+    {
+        if (Packer[Counter].Alias >= 0)
+        {
+            Packer[Counter].Hash = Packer[Packer[Counter].Alias].Hash;
         }
     }
     
-    // Close the Directory
+    fclose(File);
+}
+
+// The Entries Written by WriteEntries, shared with the Workers and the IO Ring
+
+typedef struct
+{
+    PFSEntry * Packer;
+    
+    int * Entries;
+    
+    int Output;
+    
+    QWORD DataSegment;
+
+} EntryWrites;
+
+static void WriteEntryTask(int Index, void * Context)
+{
+    EntryWrites * Writes = Context;
+    
+    WriteEntryData(Writes -> Output, Writes -> DataSegment, &Writes -> Packer[Writes -> Entries[Index]]);
+}
+
+// The IO Ring shows each File's Content before Writing it, the Hash is taken from it's Buffer
+
+static void HashEntryData(int Index, const BYTE * Data, QWORD Length, void * Context)
+{
+    EntryWrites * Writes = Context;
     
-    closedir(Directory);
+    PFSEntry * Entry = &Writes -> Packer[Writes -> Entries[Index]];
     
+    if (!Entry -> Hashed)
+    {
+        Entry -> Hash = HashContent(Data, Length);
+    }
 }
 
 /*
- *  The Populate Header Method will populate the Header for the 
- *  PFS Image.
+ *  The Write Entries Method will write the Content of many Files at their
+ *  Offsets inside the Data Segment.
  * 
+ *  The Small Files are Read and Written through the IO Ring, many at once,
+ *  each with a single Read into a Registered Buffer. The Larger Files, and
+ *  every File when the Kernel lacks io_uring, are Mapped and Written by the
+ *  Workers of the Thread Pool.
  * 
  *  Parameters:
- *          An 16 Bits (2 Bytes) Unsigned integer with the Number of Entries ( Files ) being Packed
- * 
+ *          The Descriptor of the Image being Written
+ *          The Offset of the Data Segment inside the Image
+ *          The Packer Array, and the Indices of the Entries to Write
+ *  
  *  Returns:
- *          PFSHeader Structure
- * 
+ *          VOID
  */
 
-PFSHeader PopulateArchiveHeader(WORD Entries)
+void WriteEntries(int Output, QWORD DataSegment, PFSEntry * Packer, int * Entries, int Count)
 {
-    PFSHeader ArchiveHeader;
+    int * Small = malloc((Count + 1) * sizeof(int));
+    int * Large = malloc((Count + 1) * sizeof(int));
+    
+    RingFile * Files = calloc(Count + 1, sizeof(RingFile));
     
-    ArchiveHeader.Signature[0] = 0x50; // P
-    ArchiveHeader.Signature[1] = 0x46; // F
-    ArchiveHeader.Signature[2] = 0x53; // S
-    ArchiveHeader.Signature[3] = 0x2F; // / 
-    ArchiveHeader.Signature[4] = 0x30; // 0
-    ArchiveHeader.Signature[5] = 0x2E; // .
-    ArchiveHeader.Signature[6] = 0x39; // 9
-    ArchiveHeader.Signature[7] = 0x00; // /0
+    int SmallCount = 0, LargeCount = 0, Counter;
     
-    // Null Seperator
+    int Ring = RingAvailable();
     
-    ArchiveHeader.NullPadding[0] = 0x00;
-    ArchiveHeader.NullPadding[1] = 0x00;
-    ArchiveHeader.NullPadding[2] = 0x00;
-    ArchiveHeader.NullPadding[3] = 0x00;
+    for (Counter = 0; Counter < Count; Counter ++)
+    {
+        PFSEntry * Entry = &Packer[Entries[Counter]];
+        
+        if (Ring && Entry -> Size < RING_BUFFER_SIZE)
+        {
+            RingFile File = { Entry -> SourcePath, NULL, Entry -> Size, DataSegment + Entry -> Offset, 0 };
+            
+            Files[SmallCount] = File;
+            
+            Small[SmallCount ++] = Entries[Counter];
+        }
+        else
+        {
+            Large[LargeCount ++] = Entries[Counter];
+        }
+    }
     
-    // Unknown Field
+    EntryWrites Writes = { Packer, Small, Output, DataSegment };
     
-    ArchiveHeader.UnknownField = 0; // For the Sake of Diffing -
+    if (SmallCount > 0 && RingCopyFiles(Files, SmallCount, Output, HashEntryData, &Writes) < 0)
+    {
+        RunParallel(SmallCount, WriteEntryTask, &Writes);
+        
+        SmallCount = 0;
+    }
     
-    // Entry Count
+    for (Counter = 0; Counter < SmallCount; Counter ++)
+    {
+        if (Files[Counter].Result < 0)
+        {
+            printf("Error Packing %s ( %s ) \r\n", Files[Counter].Path, strerror(-Files[Counter].Result));
+            exit(EXIT_FAILURE);
+        }
+        
+        // The File might have changed since it was Gathered
+        
+        if (Files[Counter].Result != (long long) Files[Counter].Length)
+        {
+            printf("File %s Changed while Packing \r\n", Files[Counter].Path);
+            exit(EXIT_FAILURE);
+        }
+    }
     
-    ArchiveHeader.EntryCount = TotalFiles;
+    Writes.Entries = Large;
     
-    return ArchiveHeader;
+    RunParallel(LargeCount, WriteEntryTask, &Writes);
     
+    free(Files);
+    free(Large);
+    free(Small);
 }
 
 /*
- *  The Pack Files Method will Iterate the Filenames Array which is populated by the
- *  Gather Files Method and generate information about each File.
+ *  The Write Entry Data Method will write the Content of a File at it's
+ *  Offset inside the Data Segment and store the File's Content Hash.
+ * 
+ *  Parameters:
+ *          The Descriptor of the Image being Written
+ *          The Offset of the Data Segment inside the Image
+ *          A Pointer to the PFSEntry being Written
  *  
- *  This method retrieved information about the File's Size, Timestamp 
- *  and Hex Dump directly from the File.
+ *  Returns:
+ *          VOID
+ */
+
+void WriteEntryData(int Output, QWORD DataSegment, PFSEntry * Entry)
+{
+    QWORD Size;
+    
+    BYTE * Data = MapFile(Entry -> SourcePath, &Size);
+    
+    // The File might have changed since it was Gathered
+    
+    if (Size != Entry -> Size)
+    {
+        printf("File %s Changed while Packing \r\n", Entry -> SourcePath);
+        exit(EXIT_FAILURE);
+    }
+    
+    // The Hash is already Known when the Files were Deduplicated
+    
+    if (!Entry -> Hashed)
+    {
+        Entry -> Hash = HashContent(Data, Size);
+    }
+    
+    if (WriteAt(Output, Data, Size, DataSegment + Entry -> Offset) != 0)
+    {
+        puts("Error Writing Output");
+        exit(EXIT_FAILURE);
+    }
+    
+    UnmapFile(Data, Size);
+}
+
+/*
+ *  The Update Image Method will compare the Gathered Files against the Entry
+ *  Table of a Previous Image, and only read and write the Files which Changed.
  * 
- *  The Offset property is calculated inside this method. This property is needed
- *  to tell the Unpacker where the File resides inside the final Binary.
+ *  A File is considered Unchanged if it's Size and Modification Time match the
+ *  Manifest stored next to the Previous Image. If only the Size matches, the
+ *  File's Content Hash is compared instead.
  * 
- *  The DumpHex Method defined in the Hex Dump Header File is used in this method.
+ *  If every File keeps it's Name, Order and Size, the Previous Image is patched
+ *  in place. Otherwise a new Image is written, copying the Unchanged Data Ranges
+ *  from the Previous Image, and then replaces the Previous Image.
  * 
  *  Parameters:
- *          None
+ *          A Char Array with the Name of the Previous Image
  *  
  *  Returns:
- *          PFSEntry Structure Pointer
- * 
+ *          VOID
  */
- 
-PFSEntry * PackFiles()
+
+void UpdateImage(char * ImageName)
 {
-    // Variable used to Calculate the File's Offset
+    QWORD ImageSize;
+    
+    BYTE * Image = MapFile(ImageName, &ImageSize);
+    
+    // Check the Previous Image for a Valid PFS Header
     
-    int OffsetCounter = 0;
+    if (ImageSize < HEADER_SIZE || strncmp((char *) Image, "PFS", 3))
+    {
+        puts("Invalid PFS File");
+        exit(EXIT_FAILURE);
+    }
     
-    // Variable used to loob the Filenames Array
+    WORD PreviousCount;
     
-    int PackingCounter = 0;
+    memcpy(&PreviousCount, Image + 14, sizeof(WORD));
     
-    // PFSEntry Structure Pointer. 
-    // The Pointer is allocated Memory according to the number of Files being Packed
+    QWORD PreviousSegment = HEADER_SIZE + (QWORD) PreviousCount * ENTRY_SIZE;
     
-    PFSEntry * Packer = malloc (sizeof(PFSEntry) * TotalFiles );
+    if (PreviousSegment > ImageSize)
+    {
+        puts("Invalid PFS File");
+        exit(EXIT_FAILURE);
+    }
     
-    // Display Packing Information
+    int ManifestCount;
     
-    printf("Total Files to Pack : %d \r\n\r\n", TotalFiles);
+    ManifestEntry * Manifest = LoadManifest(ImageName, &ManifestCount);
     
-    // If Memory Allocation Fails
+    PFSEntry * Packer = PackFiles();
     
-    if (Packer == NULL)
+    if (Deduplicate)
     {
-        // Print Error Message and Exit
-        
-        puts("Error Allocating Memory \r\n");
-        exit(EXIT_FAILURE);
+        DeduplicateFiles(Packer, Manifest, ManifestCount);
     }
     
-    // Temorary PFSEntry to store temporary File Information
+    // The Layout is kept if every Entry has the same Name, Position, Offset and Size
+    
+    char SameLayout = (PreviousCount == TotalFiles);
+    
+    int ChangedFiles = 0;
+    
+    int Counter;
+    
+    for (Counter = 0; Counter < TotalFiles; Counter ++)
+    {
+        PFSEntry * Entry = &Packer[Counter];
+        
+        // Find the Entry with the Same Name inside the Previous Image
+        
+        int Previous;
+        
+        const BYTE * Record = NULL;
+        
+        for (Previous = 0; Previous < PreviousCount; Previous ++)
+        {
+            Record = Image + HEADER_SIZE + (QWORD) Previous * ENTRY_SIZE;
+            
+            if (strncmp((char *) Record, Entry -> FileName, NAME_BLOCK) == 0)
+            {
+                break;
+            }
+        }
+        
+        DWORD PreviousOffset = 0;
+        DWORD PreviousSize = 0;
+        
+        if (Previous < PreviousCount)
+        {
+            memcpy(&PreviousOffset, Record + NAME_BLOCK + 4, sizeof(DWORD));
+            memcpy(&PreviousSize, Record + NAME_BLOCK + 8, sizeof(DWORD));
+        }
+        
+        if (Previous != Counter || PreviousOffset != Entry -> Offset || PreviousSize != Entry -> Size)
+        {
+            SameLayout = 0;
+        }
+        
+        // Aliased Entries have no Data of their Own
+        
+        if (Entry -> Alias >= 0)
+        {
+            continue;
+        }
+        
+        // New Files, Resized Files and Entries pointing outside the Previous Image are Written
+        
+        if (Previous == PreviousCount || PreviousSize != Entry -> Size || PreviousSegment + PreviousOffset + PreviousSize > ImageSize)
+        {
+            ChangedFiles ++;
+            
+            continue;
+        }
+        
+        ManifestEntry * Known = FindManifestEntry(Manifest, ManifestCount, Entry -> FileName);
+        
+        const BYTE * PreviousData = Image + PreviousSegment + PreviousOffset;
+        
+        if (Known && Known -> Size == Entry -> Size && Known -> Modified == Entry -> Modified)
+        {
+            // Fast Path - The File was not Touched since the last Pack
+            
+            Entry -> Hash = Known -> Hash;
+            
+            Entry -> Hashed = 1;
+        }
+        else
+        {
+            // The File was Touched, Compare it's Content
+            
+            if (!Entry -> Hashed)
+            {
+                HashEntry(Counter, Packer);
+            }
+            
+            QWORD PreviousHash = Known ? Known -> Hash : HashContent(PreviousData, PreviousSize);
+            
+            if (Entry -> Hash != PreviousHash)
+            {
+                ChangedFiles ++;
+                
+                continue;
+            }
+        }
+        
+        Entry -> Reused = 1;
+        
+        Entry -> PreviousOffset = PreviousSegment + PreviousOffset;
+    }
     
-    PFSEntry Packed;
+    printf("\r\n%d of %d Files Changed \r\n", ChangedFiles, TotalFiles);
     
-    for (PackingCounter = 0; PackingCounter < TotalFiles; PackingCounter ++)
+    if (SameLayout)
     {
-        // Display Packing Information
+        // Patch the Changed Files inside the Previous Image
+        
+        int Output = open(ImageName, O_WRONLY);
+        
+        if (Output < 0)
+        {
+            puts("Error Opening Image");
+            exit(EXIT_FAILURE);
+        }
         
-        printf("Packing File %d of %d - %s \r\n", PackingCounter + 1, TotalFiles, FileNames[PackingCounter] );
+        if (ChangedFiles > 0)
+        {
+            printf("Layout Unchanged, Patching %s in Place \r\n", ImageName);
+        }
         
-        // Open The File, Retrieve it's Hex dump and store it inside the HexEquivalent Property of the PFSEntry Structure
+        int * Entries = malloc((TotalFiles + 1) * sizeof(int));
         
-        Packed.HexEquivalent = DumpHex( FileNames[PackingCounter] );
+        int Count = 0;
         
-        //Store the File's Name inside the Filename Property of the PFSEntry Structure
+        for (Counter = 0; Counter < TotalFiles; Counter ++)
+        {
+            if (!Packer[Counter].Reused && Packer[Counter].Alias < 0)
+            {
+                printf("Updating %s \r\n", Packer[Counter].FileName);
+                
+                Entries[Count ++] = Counter;
+            }
+        }
+        
+        WriteEntries(Output, PreviousSegment, Packer, Entries, Count);
         
-        strncpy(Packed.FileName, FileNames[PackingCounter], NAME_BLOCK);
+        free(Entries);
+        
+        close(Output);
+    }
+    else
+    {
+        // Write a New Image next to the Previous one, and replace it once Complete
         
-        //Store the File's Offset inside the Offset Property of the PFSEntry Structure
+        char TemporaryName[PATH_MAX];
         
-        Packed.Offset = OffsetCounter;
+        snprintf(TemporaryName, PATH_MAX, "%s.tmp", ImageName);
         
-        // Add the File's Size to the current offset, to point to the next file
+        PreviousImage = open(ImageName, O_RDONLY);
         
-        OffsetCounter += FileSize;
+        struct stat Status;
         
-        // Store the File's Size inside the Size Property of the PFSEntry Structure
+        if (PreviousImage < 0 || fstat(PreviousImage, &Status) != 0)
+        {
+            puts("Error Opening Image");
+            exit(EXIT_FAILURE);
+        }
         
-        Packed.Size = FileSize;
+        WriteBinary(Packer, TemporaryName);
         
-        // Store the Timestamp inside the Timestamp Property of the PFSEntry Structure
+        close(PreviousImage);
         
-        Packed.Timestamp = 1;
+        PreviousImage = -1;
         
-        // Copy the Temporary PFSEntry Variable to the PFSEntry Array
+        // The New Image is Created with the Default Mode, it keeps the Previous one's Permissions
         
-        Packer[PackingCounter] = Packed;
+        if (chmod(TemporaryName, Status.st_mode & 07777) != 0)
+        {
+            puts("Error Copying the Permissions of the Previous Image");
+            exit(EXIT_FAILURE);
+        }
         
+        if (rename(TemporaryName, ImageName) != 0)
+        {
+            puts("Error Replacing the Previous Image");
+            exit(EXIT_FAILURE);
+        }
     }
     
-    // Return a Pointer to the PFSEntry Structure Array
+    UnmapFile(Image, ImageSize);
+    
+    // Refresh the Manifest, Modification Times might have changed
     
-    return Packer;
+    WriteManifest(Packer, ImageName);
+    
+    free(Manifest);
 }
 
-
 /*
- *  The Write Binary Method will Iterate the PFSEntry Array and write 
- *  the final PFSImage inside the Client's Computer
- * 
- *  This Method First writes the PFSHeader to the File and then iterates
- *  each packed file found inside the PFSEntry Array, writing each file 
- *  in each iteration
+ *  The Load Manifest Method will read the Manifest stored next to an Image.
  * 
- *  The File Opener Method defined in the Hex Dump Header File is used in this method.
+ *  Each Line of the Manifest holds a File's Size, Modification Time,
+ *  Content Hash ( Hexadecimal ) and Name, seperated by Spaces.
  * 
  *  Parameters:
- *          PFSEntry Array Pointer to the Packed Files
- *          char Array with the Output Binary Name
+ *          A Char Array with the Name of the Image
+ *          An Integer Pointer which will hold the Number of Lines Read
  *  
  *  Returns:
- *          VOID
- * 
+ *          A ManifestEntry Array, or NULL if there is no Manifest
  */
- 
-void WriteBinary(PFSEntry * Packer, char * OutputFile)
+
+ManifestEntry * LoadManifest(char * ImageName, int * Count)
 {
-    // Display basic Writing Information
-    
-    printf("\r\nWriting Output to : %s\r\n", OutputFile);
+    char Path[PATH_MAX];
     
-    // Open a Writing File Handle using the Output File Variable as the File Name
-    
-    FILE * File = FileOpener(OutputFile, "w");
+    snprintf(Path, PATH_MAX, "%s%s", ImageName, MANIFEST_EXTENSION);
     
-    // Generate the PFSHeader
+    *Count = 0;
     
-    PFSHeader ArchiveHeader = PopulateArchiveHeader(TotalFiles);
+    FILE * File = fopen(Path, "r");
     
-    // Write the PFSHeader inside the File
-    
-    fwrite(ArchiveHeader.Signature, sizeof(ArchiveHeader.Signature), 1, File);
-    fwrite(ArchiveHeader.NullPadding, sizeof(ArchiveHeader.NullPadding), 1, File);
-    fwrite(&ArchiveHeader.UnknownField, sizeof(ArchiveHeader.UnknownField), 1, File);
-    fwrite(&ArchiveHeader.EntryCount, sizeof(ArchiveHeader.EntryCount), 1, File);
+    if (File == NULL)
+    {
+        puts("No Manifest Found, Files with an Unchanged Size will be Hashed");
+        
+        return NULL;
+    }
     
-    int Counter;
+    ManifestEntry * Manifest = calloc(MAX_FILES, sizeof(ManifestEntry));
     
-    // Iterate the Packed Files
+    char Line[PATH_MAX];
     
-    // PFSEntry Bytes
-        // [ 64 Bytes - Filename ] [ 4 Bytes - Timestamp ] [ 4 Bytes - Offset ] [ 4 Bytes - Size ]
-        
-    for (Counter = 0; Counter < TotalFiles; Counter ++)
+    while (*Count < MAX_FILES && fgets(Line, PATH_MAX, File))
     {
-        // Write the Name of the Packed File.
+        unsigned long long Size, Modified, Hash;
         
-        fwrite(Packer[Counter].FileName, NAME_BLOCK, 1, File);
+        int NameStart;
         
-        // Write the Timestamp of the Packed File.
+        if (sscanf(Line, "%llu %llu %llx %n", &Size, &Modified, &Hash, &NameStart) != 3)
+        {
+            continue;
+        }
         
-        fwrite(&Packer[Counter].Timestamp, sizeof(DWORD), 1, File);
+        // Remove the Line Ending from the Name
         
-        // Write the Data Offset of the Packed File.
+        Line[strcspn(Line, "\r\n")] = '\0';
         
-        fwrite(&Packer[Counter].Offset, sizeof(DWORD), 1, File);
+        strncpy(Manifest[*Count].FileName, Line + NameStart, NAME_BLOCK - 1);
         
-        // Write the Size of the Packed File.
+        Manifest[*Count].Size = Size;
+        Manifest[*Count].Modified = Modified;
+        Manifest[*Count].Hash = Hash;
         
-        fwrite(&Packer[Counter].Size, sizeof(DWORD), 1, File);
+        (*Count) ++;
     }
     
-    // Re-Iterate the Array Writing the Hex Equivalent of each file
+    fclose(File);
+    
+    return Manifest;
+}
+
+/*
+ *  The Write Manifest Method will write the Manifest of the Packed Files
+ *  next to the Image. The Format is described in the Load Manifest Method.
+ * 
+ *  Parameters:
+ *          PFSEntry Array Pointer to the Packed Files
+ *          A Char Array with the Name of the Image
+ *  
+ *  Returns:
+ *          VOID
+ */
+
+void WriteManifest(PFSEntry * Packer, char * ImageName)
+{
+    char Path[PATH_MAX];
+    
+    snprintf(Path, PATH_MAX, "%s%s", ImageName, MANIFEST_EXTENSION);
+    
+    FILE * File = FileOpener(Path, "w");
+    
+    int Counter;
     
     for (Counter = 0; Counter < TotalFiles; Counter ++)
     {
-        fwrite(Packer[Counter].HexEquivalent, Packer[Counter].Size, 1, File);
+        fprintf(File, "%u %llu %016llx %s\n", Packer[Counter].Size, (unsigned long long) Packer[Counter].Modified,
+                (unsigned long long) Packer[Counter].Hash, Packer[Counter].FileName);
     }
     
+    fclose(File);
 }
@@ -24,10 +24,16 @@
 #include <stdio.h> 
 #include <string.h>
 #include <stdint.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
 
 // Custom Header Files
 
 #include "../Headers/Common.h"
+#include "../Headers/IORing.h"
+#include "../Headers/ThreadPool.h"
 
 /*
  *  PFS Header Structure
@@ -81,12 +87,6 @@ typedef struct {
 
 short PFSEntrySize = 0;
 
-// External Function Prototypes - Hex Dump Header File
-
-char * DumpHex(char * FileName);
-
-void PartitionExtractor( char * Filename, long StartAddress, int Count, char * OutputFile);
-
 // Internal Function Prototypes
 
 void ShowEntries( char * FileName);
@@ -95,6 +95,14 @@ void ExtractEntries( char * FileName);
 
 PFSEntry * CheckFile(char * FileName);
 
+void PartitionExtractor(int Index, void * Context);
+
+int ComparePaths(const void * First, const void * Second);
+
+int FindAlias(PFSEntry * Entries, int Index);
+
+char * OutputPath(char * Filename);
+
 
 // Global Variables
 
@@ -105,15 +113,25 @@ PFSHeader ArchiveHeader;
 
 int DataSegment = 0;
 
+// The PFS Archive is Mapped in Memory by the Check File Method
+
+BYTE * Archive;
+
+QWORD ArchiveSize;
+
 // The Main Method will check the Passed Arguments and redirect the Applications' Flow Accordingly
 
 int main(int argc, char * argv[])
 {
+    InitStats(&argc, argv);
+    InitOutput(&argc, argv);
     
     // If the Argument Count is Equal to Three
     
     if (argc == 3)
     {
+        int Phase = STATS_BEGIN(argv[1] + 1);
+        
         // If the Second Parameter is -List Redirect to the Show Entries Method
         
         if (strcmp(argv[1], "-List") == 0)
@@ -128,7 +146,9 @@ int main(int argc, char * argv[])
             ExtractEntries(argv[2]);
         }
         
-        printf("\r\n\r\n");
+        STATS_END(Phase);
+        
+        OutputText("\r\n\r\n");
     }   
     
     // If No or an Invalid Option was Entered
@@ -167,50 +187,147 @@ void ShowEntries( char * FileName)
     int Counter = 0;
   
     // Print the Total Archive Entries Present inside the Archive
-    printf(" \t\t\t Total Files in Archive: %d\r\n\r\n", ArchiveHeader.Entries);
-    printf("--------------------------------------------------------------------- \r\n\r\n");
+    OutputText(" \t\t\t Total Files in Archive: %d\r\n\r\n", ArchiveHeader.Entries);
+    OutputText("--------------------------------------------------------------------- \r\n\r\n");
     
     // Iterate the PFS Archive and display information for each File inside the Archive
     
     for (Counter = 0; Counter < ArchiveHeader.Entries; Counter++)
     {
-        printf("Compressed File %d\r\n", Counter + 1);
-        printf(" \t Filename: %50s \r\n", (char *) Entries[Counter].Filename);
-        printf(" \t Timestamp: %49u \r\n", Entries[Counter].Timestamp);
-        printf(" \t Offset: %52X \r\n", DataSegment + Entries[Counter].Offset);
-        printf(" \t Size: %54u \r\n", Entries[Counter].Size);
+        // Deduplicated Images point Identical Files to the Same Data
+        
+        int Alias = FindAlias(Entries, Counter);
         
-        printf("\r\n");
+        EmitEntry(Counter, (char *) Entries[Counter].Filename, Entries[Counter].Timestamp, DataSegment + Entries[Counter].Offset,
+                  Entries[Counter].Size, Alias >= 0 ? (char *) Entries[Alias].Filename : NULL);
     }
     
     // Print the Data Segment Location
     
-    printf("Data Segment Starts at 0x%X", DataSegment);
+    OutputText("Data Segment Starts at 0x%X", DataSegment);
+    
+    free(Entries);
     
+    UnmapFile(Archive, ArchiveSize);
 }
 
-void PartitionExtractor( char * Filename, long StartAddress, int Count, char * OutputFile)
+/*
+ *  The Partition Extractor Method is run by the Workers when the IO Ring
+ *  cannot be Used, and writes a Range of the Mapped Archive to a new File.
+ * 
+ *  Parameters:
+ *              The Index of the File to Write
+ *              The Array of Files, each Result is Set as the Ring would
+ * 
+ *  Returns : 
+ *          VOID 
+ */
+
+void PartitionExtractor(int Index, void * Context)
 {
-    FILE * File = FileOpener(Filename, "rb");
+    RingFile * File = (RingFile *) Context + Index;
     
-    fseek(File, StartAddress, SEEK_SET);
+    int Output = open(File -> Path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
     
-    int Counter = 0;
+    if (Output < 0)
+    {
+        File -> Result = -errno;
+        
+        return;
+    }
+    
+    File -> Result = WriteAt(Output, File -> Data, File -> Length, 0) == 0 ? (long long) File -> Length : -errno;
+    
+    close(Output);
+}
+
+// Orders the Files by Path, and the Entries sharing a Path in Archive Order
+
+static RingFile * SortedFiles;
+
+int ComparePaths(const void * First, const void * Second)
+{
+    int Left = *(const int *) First, Right = *(const int *) Second;
     
-    FILE* NewFile = FileOpener(OutputFile, "w");
+    int Order = strcmp(SortedFiles[Left].Path, SortedFiles[Right].Path);
     
-    char Buffer [Count];
-     
-    while (Counter < Count)
+    return Order ? Order : Left - Right;
+}
+
+/*
+ *  The Find Alias Method will search the Entries preceding an Entry for one
+ *  holding the same Data Range. Such Entries are written by a Deduplicating Packer.
+ * 
+ *  Parameters:
+ *              A PFS Entry Array and the Index of the Entry being Checked
+ * 
+ *  Returns : 
+ *          The Index of the First Entry sharing the Data, or -1 if None
+ */
+
+int FindAlias(PFSEntry * Entries, int Index)
+{
+    int Counter;
+    
+    if (Entries[Index].Size == 0)
+    {
+        return -1;
+    }
+    
+    for (Counter = 0; Counter < Index; Counter ++)
+    {
+        if (Entries[Counter].Offset == Entries[Index].Offset && Entries[Counter].Size == Entries[Index].Size)
+        {
+            return Counter;
+        }
+    }
+    
+    return -1;
+}
+
+/*
+ *  The Output Path Method will turn an Entry's Name into a Path relative to the
+ *  Current Folder, creating the Folders found inside the Name.
+ * 
+ *  Names which would escape the Current Folder are refused.
+ * 
+ *  Parameters:
+ *              A Char Pointer with the Entry's Name
+ * 
+ *  Returns : 
+ *          The Path to Write, or NULL if the Name is refused
+ */
+
+char * OutputPath(char * Filename)
+{
+    // Absolute Names are Extracted inside the Current Folder
+    
+    while (*Filename == '/')
+    {
+        Filename ++;
+    }
+    
+    if (*Filename == '\0' || strcmp(Filename, "..") == 0 || strncmp(Filename, "../", 3) == 0 || strstr(Filename, "/../"))
+    {
+        return NULL;
+    }
+    
+    // Create each Parent Folder in turn
+    
+    char * Separator = Filename;
+    
+    while ((Separator = strchr(Separator, '/')) != NULL)
     {
+        *Separator = '\0';
+        
+        mkdir(Filename, 0755);
         
-        sprintf(Buffer + Counter, "%c", fgetc(File));
+        *Separator = '/';
         
-        Counter ++;
+        Separator ++;
     }
     
-    fwrite(Buffer, sizeof(char), sizeof(Buffer), NewFile);
-    
+    return Filename;
 }
 
 /* 
@@ -229,17 +346,156 @@ void ExtractEntries( char * FileName)
     
     int Counter = 0;
     
-    // Iterate the PFS Entries.
+    // The Files to Write, and for each Entry it's File, or -1 with the Reason it was Skipped
+    
+    RingFile * Files = calloc(ArchiveHeader.Entries + 1, sizeof(RingFile));
+    
+    int * Written = calloc(ArchiveHeader.Entries + 1, sizeof(int));
+    
+    const char ** Skipped = calloc(ArchiveHeader.Entries + 1, sizeof(char *));
+    
+    int Count = 0;
+    
+    // Iterate the PFS Entries. The Folders are Created here, before any File is Written
     
     for (Counter = 0; Counter < ArchiveHeader.Entries; Counter++)
     {
-        // Show Debug Information for Each File inside the Archive
+        QWORD Offset = (QWORD) DataSegment + Entries[Counter].Offset;
         
-        printf("Extracting %s Size %d \r\n", (char *)Entries[Counter].Filename, Entries[Counter].Size);
+        char * Path;
         
-        // Redirect Execution Flow to the Partition Detector Method found inside the Hex Dump Header File
+        Written[Counter] = -1;
         
-        PartitionExtractor(FileName, DataSegment + Entries[Counter].Offset, Entries[Counter].Size, (char *) Entries[Counter].Filename);
+        // Skip Entries pointing outside the Archive
+        
+        if (Offset + Entries[Counter].Size > ArchiveSize)
+        {
+            Skipped[Counter] = "Skipped, Outside the Archive";
+        }
+        else if ((Path = OutputPath((char *) Entries[Counter].Filename)) == NULL)
+        {
+            Skipped[Counter] = "Skipped, Invalid File Name";
+        }
+        else
+        {
+            RingFile File = { Path, Archive + Offset, Entries[Counter].Size, 0, 0 };
+            
+            Files[Count] = File;
+            
+            Written[Counter] = Count ++;
+        }
+    }
+    
+    // The Files are Written at once, so of the Entries sharing a Path only the Last is Written, as it would be Last to Overwrite it
+    
+    int * Order = malloc((Count + 1) * sizeof(int));
+    
+    for (Counter = 0; Counter < Count; Counter ++)
+    {
+        Order[Counter] = Counter;
+    }
+    
+    SortedFiles = Files;
+    
+    qsort(Order, Count, sizeof(int), ComparePaths);
+    
+    int Kept = 0;
+    
+    for (Counter = 0; Counter < Count; Counter ++)
+    {
+        if (Counter + 1 < Count && strcmp(Files[Order[Counter]].Path, Files[Order[Counter + 1]].Path) == 0)
+        {
+            continue;
+        }
+        
+        Order[Kept ++] = Order[Counter];
+    }
+    
+    // Each Kept File is Written once, the Entries are told where their File went
+    
+    RingFile * Writes = calloc(Kept + 1, sizeof(RingFile));
+    
+    int * Slot = malloc((Count + 1) * sizeof(int));
+    
+    for (Counter = 0; Counter < Count; Counter ++)
+    {
+        Slot[Counter] = -1;
+    }
+    
+    for (Counter = 0; Counter < Kept; Counter ++)
+    {
+        Writes[Counter] = Files[Order[Counter]];
+        
+        Slot[Order[Counter]] = Counter;
+    }
+    
+    // Every Output File is Written through the IO Ring, or by the Workers when the Kernel lacks it
+    
+    if (RingWriteFiles(Writes, Kept) < 0)
+    {
+        RunParallel(Kept, PartitionExtractor, Writes);
+    }
+    
+    STATS_ADD(STAT_FILES, Kept);
+    
+    int Failed = 0;
+    
+    for (Counter = 0; Counter < ArchiveHeader.Entries; Counter++)
+    {
+        char * Name = (char *) Entries[Counter].Filename;
+        
+        QWORD Offset = (QWORD) DataSegment + Entries[Counter].Offset;
+        
+        if (Written[Counter] < 0)
+        {
+            EmitExtraction(Name, Offset, Entries[Counter].Size, Skipped[Counter]);
+            
+            continue;
+        }
+        
+        int Index = Slot[Written[Counter]];
+        
+        char Status[128] = "Written";
+        
+        if (Index < 0)
+        {
+            snprintf(Status, sizeof(Status), "Replaced by a Later Entry");
+        }
+        else if (Writes[Index].Result != (long long) Writes[Index].Length)
+        {
+            snprintf(Status, sizeof(Status), "Error Writing ( %s )", strerror(Writes[Index].Result < 0 ? -Writes[Index].Result : EIO));
+            
+            Failed ++;
+        }
+        else
+        {
+            // Shared Data is read from the Archive for each Entry using it
+            
+            int Alias = FindAlias(Entries, Counter);
+            
+            if (Alias >= 0)
+            {
+                snprintf(Status, sizeof(Status), "Shared With %s", (char *) Entries[Alias].Filename);
+            }
+        }
+        
+        EmitExtraction(Files[Written[Counter]].Path, Offset, Entries[Counter].Size, Status);
+    }
+    
+    free(Writes);
+    free(Slot);
+    free(Order);
+    free(Skipped);
+    free(Written);
+    free(Files);
+    free(Entries);
+    
+    UnmapFile(Archive, ArchiveSize);
+    
+    if (Failed > 0)
+    {
+        puts("Error Writing File");
+        exit(-1);
     }
 }
 
@@ -254,9 +510,19 @@ void ExtractEntries( char * FileName)
  */
 PFSEntry * CheckFile(char * FileName)
 {
-    // Get a Hex Dump of the PFS Archive
+    // Map the PFS Archive in Memory
+    
+    Archive = MapFile(FileName, &ArchiveSize);
     
-    char * PFS = DumpHex(FileName);
+    char * PFS = (char *) Archive;
+    
+    // The Header has to fit inside the File
+    
+    if (ArchiveSize < 16)
+    {
+        puts("Invalid PFS File");
+        exit (-1);
+    }
     
     // Copy the First Eight Bytes (PFS Signature )of the Archive inside the Archive Header Structure
     
@@ -281,9 +547,13 @@ PFSEntry * CheckFile(char * FileName)
     
     ///////////////////////////////////////////////////////////////////////////////////////////////////
     
+    // Small Archives can end before the Name Block Checker does
+    
+    int CheckerLength = ArchiveSize - 16 < 128 ? (int) (ArchiveSize - 16) : 128;
+    
     char NameBlockChecker[128];
     
-    memcpy(&NameBlockChecker, PFS + 16, 128);
+    memcpy(&NameBlockChecker, PFS + 16, CheckerLength);
     
     int NameLength = 0;
     int NullPadding = 0;
@@ -291,7 +561,7 @@ PFSEntry * CheckFile(char * FileName)
     // Iterate The Name Field to get the Byte Size allocated to the Name Field
     // The Below Loop is required because the Name Byte Size is not standard between PFS Images
     
-    for (NameLength = 0; NameLength < 128; NameLength++)
+    for (NameLength = 0; NameLength < CheckerLength; NameLength++)
     {
         if (NameBlockChecker[NameLength] == '\0' && NullPadding == 0)
         {
@@ -310,17 +580,25 @@ PFSEntry * CheckFile(char * FileName)
     
     // Print all the Information Gathered
     
-    printf("--------------------------------------------------------------------- \r\n\r\n");
+    OutputText("--------------------------------------------------------------------- \r\n\r\n");
     
-    printf("\t\t\t Valid %s File Found \r\n", (char *)ArchiveHeader.Signature);
+    OutputText("\t\t\t Valid %s File Found \r\n", (char *)ArchiveHeader.Signature);
     
-    printf("\t\t\t   Entry Size %d Bytes \r\n\r\n", PFSEntrySize);
+    OutputText("\t\t\t   Entry Size %d Bytes \r\n\r\n", PFSEntrySize);
 
     
     // Start Gathering File Information Present inside the PFS Archive
     
     int Counter = 0;
     
+    // The Entry Table has to fit inside the File
+    
+    if (16 + (QWORD) ArchiveHeader.Entries * PFSEntrySize > ArchiveSize)
+    {
+        puts("Invalid PFS File");
+        exit (-1);
+    }
+    
     // Allocate Memory to Hold all the Files Information inside the Archive
     
     PFSEntry * ArchiveEntries = malloc(ArchiveHeader.Entries * sizeof(PFSEntry));
@@ -335,7 +613,9 @@ PFSEntry * CheckFile(char * FileName)
         
             // Copy the File Name inside the Name Field of the PFS Entry Structure
             
-            memcpy(Temp.Filename, PFS + ( 16 + (Counter * PFSEntrySize )), 40 * sizeof(char));
+            memset(Temp.Filename, 0, sizeof(Temp.Filename));
+            
+            memcpy(Temp.Filename, PFS + ( 16 + (Counter * PFSEntrySize )), NameLength - 1);
             
             // Copy the File's Timestamp inside the Timestamp Field of the PFS Entry Structure
             
@@ -10,91 +10,558 @@
  *  Description                                                     *
  *                                                                  *
  *  This application takes an input file and adds padding to        *
- *  enlarge the file to a specified size.                           *       
+ *  enlarge the file to a specified size.                           *
+ *                                                                  *
+ *  The Last 12 Bytes of the Partition hold the Belkin Trailer      *
+ *                                                                  *
+ *      [ 4 Bytes - Data Length ] [ 4 Bytes - 0x12345678 ]          *
+ *      [ 4 Bytes - CRC32 of the Data ]                             *
+ *                                                                  *
+ *  In Pipeline Mode, Folders are Packed as PFS File Systems and    *
+ *  every Input is streamed inside the Padded Image in one pass.    *
+ *                                                                  *
+ *  In In Place Mode, the Input File itself is Extended and Padded,  *
+ *  only the Fill and the Trailer are Written.                      *
+ *                                                                  *
+ *  Partition Sizes can use a K, M or G Suffix ( 8M, 0x800000 )     *
+ *                                                                  *
+ *  In Verify Mode, the Trailer of an existing Image is Checked     *
+ *  against the Image's Data.                                       *
  *                                                                  *
  * ******************************************************************/
- 
+
 #include <string.h>
 #include <stdlib.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <time.h>
+#include <sys/stat.h>
 
 #include "../Headers/Common.h"
+#include "../Headers/PFS.h"
+
+// The Size of the Belkin Trailer, written at the End of the Partition
+
+#define TRAILER_SIZE 12
+
+// The Signature stored inside the Trailer, after the Data Length
+
+#define BELKIN_SIGNATURE 0x12345678
+
+// The Byte used to Fill the Space between the Data and the Trailer
+
+#define FILL_BYTE 0xFF
+
+// The Image being Written, along with the Running Checksum of it's Data
 
-FILE * FileOpener(char * Filename, char * ReadMode);
-char * DumpHex(char * FileName);
-void PadFile(char * Filename, int PartitionSize, char * OutputFile);    
+typedef struct
+{
+    int Descriptor;
+    
+    QWORD Offset;
+    
+    DWORD Checksum;
+
+} ImageStream;
+
+void PadFile(char * Filename, QWORD PartitionSize, char * OutputFile);
+void PadInPlace(char * Filename, QWORD PartitionSize);
+void PipelineImage(char * Inputs[], int InputCount, QWORD PartitionSize, char * OutputFile, char RecursiveScan, char Deduplicate);
+void StreamBytes(const BYTE * Data, QWORD Length, void * Context);
+void WriteFill(ImageStream * Stream, QWORD Length);
+void WriteTrailer(ImageStream * Stream);
+int VerifyImage(char * Filename);
+static void PrintSyntax(char * ProgramName);
 
 int main(int argc, char * argv[])
 {
-    if (argc == 4)
+    InitStats(&argc, argv);
+    
+    int Phase = STATS_BEGIN("Pad");
+    
+    if (argc == 3 && strcmp(argv[1], "-Verify") == 0)
+    {
+        int Status = VerifyImage(argv[2]);
+        
+        STATS_END(Phase);
+        
+        return Status;
+    }
+    else if (argc == 4 && strcmp(argv[1], "-InPlace") == 0)
+    {
+        printf("Padding File %s In Place \r\n", argv[2]);
+        PadInPlace(argv[2], ParseSize(argv[3]));
+    }
+    else if (argc == 4)
     {
         printf("Padding File %s \r\n", argv[1]);
-        PadFile(argv[1], atoi(argv[2]), argv[3]);
+        PadFile(argv[1], ParseSize(argv[2]), argv[3]);
+    }
+    else if (argc > 4 && strcmp(argv[1], "-Pipeline") == 0)
+    {
+        char RecursiveScan = 0;
+        char Deduplicate = 0;
+        
+        int Index = 2;
+        
+        // Options applied to the Folders being Packed
+        
+        while (Index < argc && argv[Index][0] == '-')
+        {
+            if (strcmp(argv[Index], "-R") == 0)
+            {
+                RecursiveScan = 1;
+            }
+            else if (strcmp(argv[Index], "-Dedup") == 0)
+            {
+                Deduplicate = 1;
+            }
+            else
+            {
+                PrintSyntax(argv[0]);
+            }
+            
+            Index ++;
+        }
+        
+        // The Partition Size, the Output and at least one Input are needed
+        
+        if (argc - Index < 3)
+        {
+            PrintSyntax(argv[0]);
+        }
+        
+        PipelineImage(argv + Index + 2, argc - Index - 2, ParseSize(argv[Index]), argv[Index + 1], RecursiveScan, Deduplicate);
     }
     else
     {
-        puts("Syntax");
-        printf("%s <INPUT FILE> <Partition Size> <Output File> \r\n", argv[0]);
+        PrintSyntax(argv[0]);
     }
+    
+    STATS_END(Phase);
+    
+    return 0;
 }
 
-void PadFile(char * Filename, int PartitionSize, char * OutputFile)
+// Prints the Syntax Help
+
+static void PrintSyntax(char * ProgramName)
+{
+    puts("Syntax");
+    printf("%s <INPUT FILE> <Partition Size> <Output File> \r\n", ProgramName);
+    printf("%s -InPlace <INPUT FILE> <Partition Size> \r\n", ProgramName);
+    printf("%s -Pipeline [-R] [-Dedup] <Partition Size> <Output File> <INPUT FILE or FOLDER ...> \r\n", ProgramName);
+    printf("%s -Verify <Image File> \r\n\r\n", ProgramName);
+    
+    puts("Pipeline Options:");
+    
+    printf("\t -R : Pack the Subfolders of the Input Folders \r\n");
+    printf("\t -Dedup : Store Identical Files of the Input Folders only once \r\n");
+    
+    exit(0);
+}
+
+void PadFile(char * Filename, QWORD PartitionSize, char * OutputFile)
 {
+    QWORD Size;
+    
+    // Map the Input, it is only Read once
+    
+    BYTE * Data = MapFile(Filename, &Size);
+    
+    FileSize = Size;
+    
+    if (FileSize + TRAILER_SIZE > PartitionSize)
+    {
+        printf("The File size is already bigger then the specified Partition Size ( %lu Bytes ) \r\n", FileSize);
+        exit(-1);
+    }
+    
+    if (Size > 0xFFFFFFFF)
+    {
+        puts("The Data does not fit inside the Belkin Trailer ( 4 GB Limit )");
+        exit(-1);
+    }
+    
+    printf("Padding File To %llu \r\n", (unsigned long long) PartitionSize);
     
     FILE * File = FileOpener(OutputFile, "w");
     
-    int Counter;
+    ImageStream Stream = { fileno(File), 0, 0 };
     
-    char * Hex = DumpHex(Filename);
-        
-    if (FileSize > PartitionSize)
+    StreamBytes(Data, Size, &Stream);
+    
+    UnmapFile(Data, Size);
+    
+    WriteFill(&Stream, PartitionSize - FileSize - TRAILER_SIZE);
+    
+    WriteTrailer(&Stream);
+    
+    fclose(File);
+}
+
+/*
+ *  The Pad In Place Method will Pad a File without Copying it. The File is
+ *  Extended to the Partition Size, the Gap is Filled using Vectored Writes of
+ *  a single Fill Buffer and the Trailer is Written at the End.
+ * 
+ *  The Data is only Read to compute it's Checksum.
+ * 
+ *  Parameters:
+ *          A Char Array with the File Name
+ *          The Size of the Partition
+ * 
+ *  Returns:
+ *          VOID
+ */
+
+void PadInPlace(char * Filename, QWORD PartitionSize)
+{
+    int Descriptor = open(Filename, O_RDWR);
+    
+    if (Descriptor < 0)
+    {
+        puts("File Not Found");
+        exit(-1);
+    }
+    
+    QWORD Size;
+    
+    BYTE * Data = MapFile(Filename, &Size);
+    
+    FileSize = Size;
+    
+    if (Size + TRAILER_SIZE > PartitionSize)
     {
         printf("The File size is already bigger then the specified Partition Size ( %lu Bytes ) \r\n", FileSize);
         exit(-1);
     }
-    else if (PartitionSize > FileSize)
+    
+    if (Size > 0xFFFFFFFF)
     {
-        printf("Padding File To %d \r\n", PartitionSize);
-        
-        PartitionSize -= FileSize;
-        
-        char * Hex = DumpHex(Filename);
-        
-        fwrite(Hex, FileSize, 1, File);
-        
-        char NullChar = 0xFF;
+        puts("The Data does not fit inside the Belkin Trailer ( 4 GB Limit )");
+        exit(-1);
+    }
+    
+    printf("Padding File To %llu \r\n", (unsigned long long) PartitionSize);
+    
+    ImageStream Stream = { Descriptor, Size, Crc32(0, Data, Size) };
+    
+    UnmapFile(Data, Size);
+    
+    // Reserve the Final Size first, the Fill and Trailer are then Written in Place
+    
+    if (ftruncate(Descriptor, PartitionSize) != 0)
+    {
+        puts("Error Extending File");
+        exit(-1);
+    }
+    
+    WriteFill(&Stream, PartitionSize - Size - TRAILER_SIZE);
+    
+    WriteTrailer(&Stream);
+    
+    close(Descriptor);
+}
+
+/*
+ *  The Pipeline Image Method will build a Padded Firmware Image from a List
+ *  of Inputs in a single Pass, replacing a PFS Packer, Merger and Padder run.
+ * 
+ *  Regular Files are Mapped and Written as they are. Folders are Packed as
+ *  PFS File Systems and Streamed directly inside the Image, without an
+ *  intermediate Archive. The CRC32 of the Data is computed while Writing,
+ *  the Fill is Written in large Blocks and the Belkin Trailer closes the Image.
+ * 
+ *  Parameters:
+ *          A Char Array List with the Inputs and it's Length
+ *          The Size of the Final Image
+ *          A Char Array with the Output File Name
+ *          Chars Indicating weather Folders are Packed Recursively and Deduplicated
+ * 
+ *  Returns:
+ *          VOID
+ */
+
+void PipelineImage(char * Inputs[], int InputCount, QWORD PartitionSize, char * OutputFile, char RecursiveScan, char Deduplicate)
+{
+    int Descriptor = open(OutputFile, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    
+    if (Descriptor < 0)
+    {
+        puts("Cannot Create Output File");
+        exit(-1);
+    }
+    
+    ImageStream Stream = { Descriptor, 0, 0 };
+    
+    int Counter;
+    
+    for (Counter = 0; Counter < InputCount; Counter ++)
+    {
+        struct stat Status;
         
-        while (PartitionSize > 12)
+        if (stat(Inputs[Counter], &Status) != 0)
         {
-            fputc(NullChar, File);
-            PartitionSize --;
+            printf("Input %s Not Found \r\n", Inputs[Counter]);
+            unlink(OutputFile);
+            exit(-1);
         }
         
-        // Write the Length of the Partition
-        
-        fwrite(&FileSize, 4, 1, File);
-        
-        char BelkinSignature [4];
-        
-        BelkinSignature[0] = 0x78; 
-        BelkinSignature[1] = 0x56; 
-        BelkinSignature[2] = 0x34; 
-        BelkinSignature[3] = 0x12; 
-        
-        
-        
-        
-        fwrite(BelkinSignature, sizeof(BelkinSignature), 1, File);
-        
-        char BypassCRC[4];
-        
-        BypassCRC[0] = 0xFF; 
-        BypassCRC[1] = 0xFF; 
-        BypassCRC[2] = 0xFF; 
-        BypassCRC[3] = 0xFF; 
-
+        if (S_ISDIR(Status.st_mode))
+        {
+            // Pack the Folder and Stream the Archive inside the Image
             
-        fwrite(BypassCRC, sizeof(BypassCRC), 1, File);
-        
-        
+            printf("Packing Folder %s - ", Inputs[Counter]);
+            
+            SetPackRoot(Inputs[Counter]);
+            
+            // A Batch Command may have Failed with Files still Gathered
+            
+            ClearFiles();
+            
+            GatherFiles(Inputs[Counter], RecursiveScan);
+            
+            PFSEntry * Packer = PackFiles();
+            
+            if (Deduplicate)
+            {
+                DeduplicateFiles(Packer, NULL, 0);
+            }
+            
+            // The Size of the Archive is Known before any of it is Written
+            
+            QWORD ArchiveSize = HEADER_SIZE + (QWORD) TotalFiles * ENTRY_SIZE;
+            
+            int Entry;
+            
+            for (Entry = 0; Entry < TotalFiles; Entry ++)
+            {
+                if (Packer[Entry].Alias < 0)
+                {
+                    ArchiveSize += Packer[Entry].Size;
+                }
+            }
+            
+            if (Stream.Offset + ArchiveSize + TRAILER_SIZE > PartitionSize)
+            {
+                printf("The Inputs are bigger then the specified Partition Size ( %llu Bytes ) \r\n", (unsigned long long) PartitionSize);
+                free(Packer);
+                ClearFiles();
+                unlink(OutputFile);
+                exit(-1);
+            }
+            
+            printf("Streaming PFS Archive at Offset 0x%llX ( %llu Bytes ) \r\n", (unsigned long long) Stream.Offset, (unsigned long long) ArchiveSize);
+            
+            StreamArchive(Packer, StreamBytes, &Stream);
+            
+            free(Packer);
+            
+            ClearFiles();
+        }
+        else
+        {
+            if (Stream.Offset + Status.st_size + TRAILER_SIZE > PartitionSize)
+            {
+                printf("The Inputs are bigger then the specified Partition Size ( %llu Bytes ) \r\n", (unsigned long long) PartitionSize);
+                unlink(OutputFile);
+                exit(-1);
+            }
+            
+            printf("Streaming %s at Offset 0x%llX ( %llu Bytes ) \r\n", Inputs[Counter], (unsigned long long) Stream.Offset, (unsigned long long) Status.st_size);
+            
+            QWORD Size;
+            
+            BYTE * Data = MapFile(Inputs[Counter], &Size);
+            
+            StreamBytes(Data, Size, &Stream);
+            
+            UnmapFile(Data, Size);
+        }
+    }
+    
+    // The Trailer holds the Length of the Data, which is Limited to 32 Bits
+    
+    if (Stream.Offset > 0xFFFFFFFF)
+    {
+        puts("The Data does not fit inside the Belkin Trailer ( 4 GB Limit )");
+        unlink(OutputFile);
+        exit(-1);
+    }
+    
+    FileSize = Stream.Offset;
+    
+    printf("Padding File To %llu \r\n", (unsigned long long) PartitionSize);
+    
+    WriteFill(&Stream, PartitionSize - Stream.Offset - TRAILER_SIZE);
+    
+    WriteTrailer(&Stream);
+    
+    close(Descriptor);
+    
+    printf("Image saved as : %s ( Data Length %lu Bytes ) \r\n", OutputFile, FileSize);
+}
+
+/*
+ *  The Stream Bytes Method will Write a Block of Data at the End of the Image
+ *  and add it to the Image's Running Checksum.
+ * 
+ *  Parameters:
+ *          A Pointer to the Data and it's Length
+ *          An ImageStream Pointer
+ * 
+ *  Returns:
+ *          VOID
+ */
+
+void StreamBytes(const BYTE * Data, QWORD Length, void * Context)
+{
+    ImageStream * Stream = Context;
+    
+    Stream -> Checksum = Crc32(Stream -> Checksum, Data, Length);
+    
+    if (WriteAt(Stream -> Descriptor, Data, Length, Stream -> Offset) != 0)
+    {
+        puts("Error Writing Output");
+        exit(-1);
     }
+    
+    Stream -> Offset += Length;
+}
+
+/*
+ *  The Write Fill Method will Write Length Fill Bytes at the End of the Image.
+ *  The Fill is not part of the Checksum.
+ * 
+ *  Parameters:
+ *          An ImageStream Pointer
+ *          The Number of Fill Bytes
+ * 
+ *  Returns:
+ *          VOID
+ */
+
+void WriteFill(ImageStream * Stream, QWORD Length)
+{
+    if (FillRange(Stream -> Descriptor, Stream -> Offset, Length, FILL_BYTE) != 0)
+    {
+        puts("Error Writing Output");
+        exit(-1);
+    }
+    
+    Stream -> Offset += Length;
+}
+
+/*
+ *  The Write Trailer Method will Write the Belkin Trailer at the End of the
+ *  Image, using the Length and Checksum of the Data in FileSize and the Stream.
+ * 
+ *  Parameters:
+ *          An ImageStream Pointer
+ * 
+ *  Returns:
+ *          VOID
+ */
+
+void WriteTrailer(ImageStream * Stream)
+{
+    BYTE Trailer[TRAILER_SIZE];
+    
+    // Write the Length of the Partition
+    
+    DWORD Length = FileSize;
+    
+    memcpy(Trailer, &Length, 4);
+    
+    // The Belkin Signature
+    
+    Trailer[4] = 0x78;
+    Trailer[5] = 0x56;
+    Trailer[6] = 0x34;
+    Trailer[7] = 0x12;
+    
+    // The CRC32 of the Data
+    
+    memcpy(Trailer + 8, &Stream -> Checksum, 4);
+    
+    if (WriteAt(Stream -> Descriptor, Trailer, TRAILER_SIZE, Stream -> Offset) != 0)
+    {
+        puts("Error Writing Output");
+        exit(-1);
+    }
+    
+    Stream -> Offset += TRAILER_SIZE;
+}
+
+/*
+ *  The Verify Image Method will Check the Belkin Trailer at the End of an
+ *  Image. The Data Length must fit inside the Image, and the CRC32 of the
+ *  Data must match the one stored inside the Trailer.
+ * 
+ *  Parameters:
+ *          A Char Array with the Image File Name
+ * 
+ *  Returns:
+ *          0 if the Trailer is Valid, 1 Otherwise
+ */
+
+int VerifyImage(char * Filename)
+{
+    QWORD Size;
+    
+    BYTE * Image = MapFile(Filename, &Size);
+    
+    if (Size < TRAILER_SIZE)
+    {
+        puts("The File is too Small to hold a Belkin Trailer");
+        return 1;
+    }
+    
+    DWORD Length, Signature, Stored;
+    
+    memcpy(&Length, Image + Size - 12, 4);
+    memcpy(&Signature, Image + Size - 8, 4);
+    memcpy(&Stored, Image + Size - 4, 4);
+    
+    if (Signature != BELKIN_SIGNATURE)
+    {
+        puts("No Belkin Trailer Found");
+        return 1;
+    }
+    
+    printf("Belkin Trailer Found - Data Length %u Bytes, Partition Size %llu Bytes \r\n", Length, (unsigned long long) Size);
+    
+    if (Length > Size - TRAILER_SIZE)
+    {
+        puts("The Data Length points Outside the Image");
+        return 1;
+    }
+    
+    struct timespec Start, End;
+    
+    clock_gettime(CLOCK_MONOTONIC, &Start);
+    
+    DWORD Computed = Crc32(0, Image, Length);
+    
+    clock_gettime(CLOCK_MONOTONIC, &End);
+    
+    double Seconds = (End.tv_sec - Start.tv_sec) + (End.tv_nsec - Start.tv_nsec) / 1e9;
+    
+    printf("Stored CRC32   : 0x%08X \r\n", Stored);
+    printf("Computed CRC32 : 0x%08X \r\n", Computed);
+    
+    printf("Checked in %.3f Seconds ( %.0f MB/s, %s ) \r\n", Seconds, Seconds > 0 ? Length / Seconds / 1e6 : 0, ChecksumEngine());
+    
+    UnmapFile(Image, Size);
+    
+    if (Computed != Stored)
+    {
+        puts("Checksum Mismatch");
+        return 1;
+    }
+    
+    puts("Image Verified");
+    
+    return 0;
 }
@@ -0,0 +1,478 @@
+/* Structured Output Records */
+
+#define _GNU_SOURCE
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <unistd.h>
+
+#include "../Headers/Records.h"
+
+// The Standard Output's Buffer, when it is not a Terminal
+
+#define OUTPUT_BUFFER (256 * 1024)
+
+#define RECORD_SIGNATURE    1
+#define RECORD_STRING       2
+#define RECORD_PARTITION    3
+#define RECORD_ENTRY        4
+#define RECORD_EXTRACTION   5
+
+#define MAX_FIELDS 6
+
+int OutputFormat = FORMAT_TEXT;
+
+typedef struct
+{
+    const char * Name;
+    
+    int FieldCount;
+    
+    const char * Fields[MAX_FIELDS];
+    
+    // N for a Number, T for a Text
+    
+    const char * Types;
+
+} RecordType;
+
+static const RecordType Types[] =
+{
+    { "", 0, { NULL }, "" },
+    { "signature", 4, { "file", "name", "description", "offset" }, "TTTN" },
+    { "string", 2, { "offset", "text" }, "NT" },
+    { "partition", 4, { "index", "start", "end", "size" }, "NNNN" },
+    { "entry", 6, { "index", "name", "timestamp", "offset", "size", "shared" }, "NTNNNT" },
+    { "extraction", 4, { "path", "offset", "size", "status" }, "TNNT" }
+};
+
+#define TYPE_COUNT ((int) (sizeof(Types) / sizeof(Types[0])))
+
+typedef struct
+{
+    QWORD Number;
+    
+    const char * Text;
+    
+    QWORD Length;
+
+} RecordValue;
+
+// The CSV Header of each Type is Written once
+
+static int HeaderWritten[TYPE_COUNT];
+
+void FlushOutput()
+{
+    fflush(stdout);
+}
+
+// Records go through the Standard Output's own Buffer, so they stay in Order with what the Tools Print
+
+static void Append(const void * Data, QWORD Length)
+{
+    fwrite_unlocked(Data, 1, Length, stdout);
+}
+
+static void AppendString(const char * Text)
+{
+    Append(Text, strlen(Text));
+}
+
+static void AppendNumber(QWORD Number)
+{
+    char Digits[24];
+    
+    int Position = sizeof(Digits);
+    
+    do
+    {
+        Digits[-- Position] = '0' + Number % 10;
+        
+        Number /= 10;
+    }
+    while (Number);
+    
+    Append(Digits + Position, sizeof(Digits) - Position);
+}
+
+static void AppendFormat(const char * Format, ...)
+{
+    va_list Arguments;
+    
+    va_start(Arguments, Format);
+    
+    vprintf(Format, Arguments);
+    
+    va_end(Arguments);
+}
+
+static void AppendJSONText(const char * Text, QWORD Length)
+{
+    static const char Hex[] = "0123456789abcdef";
+    
+    Append("\"", 1);
+    
+    QWORD Start = 0, Counter;
+    
+    for (Counter = 0; Counter < Length; Counter ++)
+    {
+        unsigned char Character = Text[Counter];
+        
+        if (Character >= 0x20 && Character < 0x7F && Character != '"' && Character != '\\')
+        {
+            continue;
+        }
+        
+        Append(Text + Start, Counter - Start);
+        
+        // Bytes past ASCII are taken as Latin-1, so the Line stays Valid JSON
+        
+        char Escape[6] = { '\\', 'u', '0', '0', Hex[Character >> 4], Hex[Character & 15] };
+        
+        if (Character == '"' || Character == '\\')
+        {
+            Escape[1] = Character;
+            
+            Append(Escape, 2);
+        }
+        else
+        {
+            Append(Escape, 6);
+        }
+        
+        Start = Counter + 1;
+    }
+    
+    Append(Text + Start, Length - Start);
+    
+    Append("\"", 1);
+}
+
+static void AppendCSVText(const char * Text, QWORD Length)
+{
+    Append("\"", 1);
+    
+    const char * Quote;
+    
+    while ((Quote = memchr(Text, '"', Length)) != NULL)
+    {
+        Append(Text, Quote - Text + 1);
+        
+        Append("\"", 1);
+        
+        Length -= Quote - Text + 1;
+        
+        Text = Quote + 1;
+    }
+    
+    Append(Text, Length);
+    
+    Append("\"", 1);
+}
+
+// The Text Renderer, the Lines the Tools always Printed
+
+static void RenderText(int Type, const RecordValue * Values)
+{
+    switch (Type)
+    {
+        case RECORD_SIGNATURE:
+            
+            AppendFormat("%s was Found at Offset 0x%X \r\n", Values[2].Text, (unsigned int) Values[3].Number);
+            
+            break;
+        
+        case RECORD_STRING:
+            
+            Append(Values[1].Text, Values[1].Length);
+            
+            Append("\r\n", 2);
+            
+            break;
+        
+        case RECORD_PARTITION:
+            
+            AppendFormat("\t\t\t Partition %d \r\n\r\n", (int) Values[0].Number);
+            
+            AppendFormat("Data Found From Offset 0x%-6X Till 0x%-6X (%d Bytes) \r\n", (unsigned int) Values[1].Number,
+                         (unsigned int) Values[2].Number, (int) (Values[2].Number - Values[1].Number));
+            
+            AppendString("-----------------------------------------------------------------------------------------\n");
+            
+            break;
+        
+        case RECORD_ENTRY:
+            
+            AppendFormat("Compressed File %d\r\n", (int) Values[0].Number + 1);
+            AppendFormat(" \t Filename: %50s \r\n", Values[1].Text);
+            AppendFormat(" \t Timestamp: %49u \r\n", (unsigned int) Values[2].Number);
+            AppendFormat(" \t Offset: %52X \r\n", (unsigned int) Values[3].Number);
+            AppendFormat(" \t Size: %54u \r\n", (unsigned int) Values[4].Number);
+            
+            if (Values[5].Length)
+            {
+                AppendFormat(" \t Shared With: %47s \r\n", Values[5].Text);
+            }
+            
+            AppendString("\r\n");
+            
+            break;
+        
+        case RECORD_EXTRACTION:
+            
+            AppendFormat("0x%-10llX %-32s %llu Bytes ( %s ) \r\n", (unsigned long long) Values[1].Number, Values[0].Text,
+                         (unsigned long long) Values[2].Number, Values[3].Text);
+            
+            break;
+    }
+}
+
+/*
+ *  The Emit Record Method will Render a Record in the Chosen Format, inside
+ *  the Buffer.
+ * 
+ *  Parameters:
+ *          The Record's Type, and it's Values in the Order of it's Fields
+ * 
+ *  Returns:
+ *          VOID
+ */
+
+static void EmitRecord(int Type, const RecordValue * Values)
+{
+    const RecordType * Kind = &Types[Type];
+    
+    int Counter;
+    
+    if (OutputFormat == FORMAT_TEXT)
+    {
+        RenderText(Type, Values);
+    }
+    else if (OutputFormat == FORMAT_JSON)
+    {
+        AppendString("{\"type\": \"");
+        AppendString(Kind -> Name);
+        AppendString("\"");
+        
+        for (Counter = 0; Counter < Kind -> FieldCount; Counter ++)
+        {
+            AppendString(", \"");
+            AppendString(Kind -> Fields[Counter]);
+            AppendString("\": ");
+            
+            if (Kind -> Types[Counter] == 'N')
+            {
+                AppendNumber(Values[Counter].Number);
+            }
+            else
+            {
+                AppendJSONText(Values[Counter].Text, Values[Counter].Length);
+            }
+        }
+        
+        AppendString("}\n");
+    }
+    else if (OutputFormat == FORMAT_CSV)
+    {
+        if (!HeaderWritten[Type])
+        {
+            AppendString("type");
+            
+            for (Counter = 0; Counter < Kind -> FieldCount; Counter ++)
+            {
+                AppendString(",");
+                AppendString(Kind -> Fields[Counter]);
+            }
+            
+            AppendString("\n");
+            
+            HeaderWritten[Type] = 1;
+        }
+        
+        AppendString(Kind -> Name);
+        
+        for (Counter = 0; Counter < Kind -> FieldCount; Counter ++)
+        {
+            Append(",", 1);
+            
+            if (Kind -> Types[Counter] == 'N')
+            {
+                AppendNumber(Values[Counter].Number);
+            }
+            else
+            {
+                AppendCSVText(Values[Counter].Text, Values[Counter].Length);
+            }
+        }
+        
+        AppendString("\n");
+    }
+    else
+    {
+        // The Length is Known once the Fields are Sized
+        
+        DWORD Length = 1;
+        
+        for (Counter = 0; Counter < Kind -> FieldCount; Counter ++)
+        {
+            Length += Kind -> Types[Counter] == 'N' ? 8 : 2 + (Values[Counter].Length < 0xFFFF ? Values[Counter].Length : 0xFFFF);
+        }
+        
+        BYTE Code = Type;
+        
+        Append(&Length, 4);
+        Append(&Code, 1);
+        
+        for (Counter = 0; Counter < Kind -> FieldCount; Counter ++)
+        {
+            if (Kind -> Types[Counter] == 'N')
+            {
+                Append(&Values[Counter].Number, 8);
+            }
+            else
+            {
+                WORD TextLength = Values[Counter].Length < 0xFFFF ? Values[Counter].Length : 0xFFFF;
+                
+                Append(&TextLength, 2);
+                Append(Values[Counter].Text, TextLength);
+            }
+        }
+    }
+}
+
+#define TEXT_VALUE(Text) { 0, (Text) ? (Text) : "", (Text) ? strlen(Text) : 0 }
+
+#define NUMBER_VALUE(Number) { (Number), NULL, 0 }
+
+void EmitSignature(const char * File, const char * Name, const char * Description, QWORD Offset)
+{
+    RecordValue Values[] = { TEXT_VALUE(File), TEXT_VALUE(Name), TEXT_VALUE(Description), NUMBER_VALUE(Offset) };
+    
+    EmitRecord(RECORD_SIGNATURE, Values);
+}
+
+void EmitString(QWORD Offset, const char * Text, QWORD Length)
+{
+    RecordValue Values[] = { NUMBER_VALUE(Offset), { 0, Text, Length } };
+    
+    EmitRecord(RECORD_STRING, Values);
+}
+
+// The End is the Last Byte of the Partition
+
+void EmitPartition(int Index, QWORD Start, QWORD End)
+{
+    RecordValue Values[] = { NUMBER_VALUE(Index), NUMBER_VALUE(Start), NUMBER_VALUE(End), NUMBER_VALUE(End - Start + 1) };
+    
+    EmitRecord(RECORD_PARTITION, Values);
+}
+
+// The Offset is inside the Archive, and Shared is the Entry holding the same Data, or NULL
+
+void EmitEntry(int Index, const char * Name, DWORD Timestamp, QWORD Offset, QWORD Size, const char * Shared)
+{
+    RecordValue Values[] = { NUMBER_VALUE(Index), TEXT_VALUE(Name), NUMBER_VALUE(Timestamp), NUMBER_VALUE(Offset),
+                             NUMBER_VALUE(Size), TEXT_VALUE(Shared) };
+    
+    EmitRecord(RECORD_ENTRY, Values);
+}
+
+void EmitExtraction(const char * Path, QWORD Offset, QWORD Size, const char * Status)
+{
+    RecordValue Values[] = { TEXT_VALUE(Path), NUMBER_VALUE(Offset), NUMBER_VALUE(Size), TEXT_VALUE(Status) };
+    
+    EmitRecord(RECORD_EXTRACTION, Values);
+}
+
+void OutputText(const char * Format, ...)
+{
+    if (OutputFormat != FORMAT_TEXT)
+    {
+        return;
+    }
+    
+    va_list Arguments;
+    
+    va_start(Arguments, Format);
+    
+    vprintf(Format, Arguments);
+    
+    va_end(Arguments);
+}
+
+static int ParseFormat(const char * Name)
+{
+    static const char * Names[] = { "text", "json", "csv", "binary" };
+    
+    int Counter;
+    
+    for (Counter = 0; Counter < 4; Counter ++)
+    {
+        if (strcasecmp(Name, Names[Counter]) == 0)
+        {
+            return Counter;
+        }
+    }
+    
+    fprintf(stderr, "Unknown Format %s, Choose text, json, csv or binary \r\n", Name);
+    
+    exit(-1);
+}
+
+/*
+ *  The Init Output Method will Choose the Format. It is Called first by
+ *  each Tool's main, so --format can be Passed in front of any Tool's
+ *  Arguments. The Format Chosen by the First Call ( fwtools for a Batch )
+ *  stays the Default of the Later ones.
+ * 
+ *  Parameters:
+ *          The Tool's argc and argv, --format is Removed from them
+ * 
+ *  Returns:
+ *          VOID
+ */
+
+void InitOutput(int * argc, char * argv[])
+{
+    static int Default = -1;
+    
+    int Chosen = -1;
+    
+    int Counter;
+    
+    for (Counter = 1; Counter < *argc; Counter ++)
+    {
+        if (strncmp(argv[Counter], "--format=", 9) == 0)
+        {
+            Chosen = ParseFormat(argv[Counter] + 9);
+            
+            memmove(argv + Counter, argv + Counter + 1, (*argc - Counter) * sizeof(char *));
+            
+            (*argc) --;
+            
+            break;
+        }
+    }
+    
+    if (Default < 0)
+    {
+        Default = Chosen >= 0 ? Chosen : getenv("FWTOOLS_FORMAT") ? ParseFormat(getenv("FWTOOLS_FORMAT")) : FORMAT_TEXT;
+        
+        // A Terminal stays Line Buffered, so Progress is still seen as it is Printed
+        
+        if (!isatty(STDOUT_FILENO))
+        {
+            setvbuf(stdout, NULL, _IOFBF, OUTPUT_BUFFER);
+        }
+        
+        atexit(FlushOutput);
+    }
+    
+    OutputFormat = Chosen >= 0 ? Chosen : Default;
+    
+    memset(HeaderWritten, 0, sizeof(HeaderWritten));
+}
@@ -16,106 +16,371 @@
  * The Purpose of this application is to allow the user to connect  *
  * to the Serial interface of the Router using a UART Cable.        *       
  *                                                                  *
+ * The Connection sleeps until the Port or the Console have Data,   *
+ * and forwards it in large Chunks.                                 *
+ *                                                                  *
+ * The Logs are Written by their own Threads ( See SerialLog.h ),   *
+ * so that a busy Disk never slows down the Console.                *
+ *                                                                  *
+ * Files can be Uploaded to a Bootloader with XMODEM-1K, YMODEM     *
+ * or ZMODEM ( See Transfer.h ), and Memory can be Dumped through   *
+ * the Bootloader's Console ( See FlashDump.h ).                    *
+ *                                                                  *
+ * Many Ports can be Watched at once by a Hub, which Logs each      *
+ * Port and shares it on a Unix Socket ( See SerialHub.h ).         *
+ *                                                                  *
+ * Patterns can be Matched on the Live Stream, to Report, Answer    *
+ * or Run a Command when they Appear ( See Trigger.h ).             *
+ *                                                                  *
+ * An unknown Baud Rate can be Detected by Scoring what the Port    *
+ * reads at each Common Rate ( See AutoBaud.h ).                    *
+ *                                                                  *
  * Tested on a Belkin Router                                        *
  * ******************************************************************
  */
- 
+
+#define _GNU_SOURCE
+
 #include <string.h>
 #include <stdlib.h>
 #include <stdio.h>
 #include <unistd.h>
 #include <fcntl.h>
 #include <termios.h>
+#include <signal.h>
+#include <errno.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
 
 #include "../Headers/Common.h"
+#include "../Headers/SerialPort.h"
+#include "../Headers/SerialLog.h"
+#include "../Headers/Transfer.h"
+#include "../Headers/FlashDump.h"
+#include "../Headers/SerialHub.h"
+#include "../Headers/Trigger.h"
+#include "../Headers/AutoBaud.h"
 
 #define STDOUT 1
 
+// The Largest Chunk Forwarded at once, in either Direction
+
+#define FORWARD_CHUNK (64 * 1024)
+
+// The Console Byte which Closes the Connection ( CTRL-C )
+
+#define EXIT_CHARACTER 0x03
+
 /* Function Prototypes */
 
 FILE * FileOpener(char * Filename, char * ReadMode);
 
 // The Below Methods are used to Print the Syntax of the Application and the baudrates allowed
 
-void PrintHelp();
-void PrintBaud();
+static void PrintHelp(char * ProgramName);
+static void PrintBaud();
 
 // This Method does all the Serial Configuration and Connection
 
-int ConnectSerial(char * PortName, speed_t BaudRate, char * LogFile);
+int ConnectSerial(char * PortName, SerialSettings * Settings, char * LogFile, char * CaptureFile, LogSettings * Logging, TriggerSet * Triggers);
+
+// This Method Forwards Data between the Serial Port and the Console until the Connection is Closed
 
-// This Method Converts the User's Chosen Baudrate (String) to SPEED_T
+int ForwardSerial(int Port, int Input, int Output, SerialLog * Logs[], int LogCount, TriggerSet * Triggers);
 
-speed_t ReturnBaud(int BaudRate);
+// This Method Uploads a File through the Serial Port
+
+int SendSerial(char * PortName, SerialSettings * Settings, char * FileName, int Protocol, char * Command);
+
+// This Method Dumps Memory through the Bootloader's Console
+
+int DumpSerial(char * PortName, SerialSettings * Settings, DumpSettings * Dump, char * OutputFile);
+
+// This Method Attaches the Console to a Port shared by a Hub
+
+int AttachSerial(char * SocketPath);
+
+// This Method Detects the Baud Rate of a Port, Returns it or 0
+
+unsigned int DetectSerial(char * PortName, SerialSettings * Settings, int Verbose);
+
+// This Method Scores Captures as if they were Read at an unknown Rate
+
+void ScoreCaptures(char ** FileNames, int Count);
+
+// This Method Converts the User's Chosen Baudrate (String) to a Number
+
+unsigned int ReturnBaud(char * BaudRate);
 
 // The Main Method will check the Passed Arguments and redirect the Applications' Flow Accordingly
 
 int main (int argc, char ** argv)
 {
-    if (argc == 3)
-    {       
-        speed_t BaudRate = ReturnBaud(atoi(argv[2]));
+    SerialSettings Settings = SERIAL_DEFAULTS;
+    
+    char * LogFile = "";
+    
+    char * CaptureFile = "";
+    
+    LogSettings Logging = { STAMP_NONE, 0, 0, 0 };
+    
+    char * SendName = NULL;
+    
+    char * Command = NULL;
+    
+    int Protocol = PROTOCOL_YMODEM;
+    
+    char * DumpName = NULL;
+    
+    DumpSettings Dump = DUMP_DEFAULTS;
+    
+    char * TriggerFile = NULL;
+    
+    FILE * Events = stderr;
+    
+    TriggerSet Triggers;
+    
+    int First = 1;
+    
+    if (argc == 2 && strcmp(argv[1], "-List") == 0)
+    {
+        PrintBaud();
+        exit(0);
+    }
+    
+    if (argc == 3 && strcmp(argv[1], "-Hub") == 0)
+    {
+        Hub Ports = LoadHub(argv[2]);
+        
+        int Result = RunHub(&Ports);
         
-        ConnectSerial(argv[1], BaudRate, "");
+        FreeHub(&Ports);
+        
+        return Result == 0 ? 0 : 1;
     }
-    else if (argc == 2)
+    
+    if (argc == 3 && strcmp(argv[1], "-Attach") == 0)
     {
-        if (strcmp(argv[1], "-List") == 0)
+        return AttachSerial(argv[2]) == 0 ? 0 : 1;
+    }
+    
+    if (argc == 3 && strcmp(argv[1], "-AutoBaud") == 0)
+    {
+        return DetectSerial(argv[2], &Settings, 1) ? 0 : 1;
+    }
+    
+    if (argc >= 3 && strcmp(argv[1], "-Score") == 0)
+    {
+        ScoreCaptures(argv + 2, argc - 2);
+        exit(0);
+    }
+    
+    // Read the Options preceding the Port and the Baud Rate
+    
+    while (argc - First > 2)
+    {
+        if (strcmp(argv[First], "-Write") == 0)
+        {
+            LogFile = argv[First + 1];
+        }
+        else if (strcmp(argv[First], "-Capture") == 0)
+        {
+            CaptureFile = argv[First + 1];
+        }
+        else if (strcmp(argv[First], "-Stamp") == 0)
+        {
+            if (strcmp(argv[First + 1], "lines") == 0)
+            {
+                Logging.Timestamps = STAMP_LINES;
+            }
+            else if (strcmp(argv[First + 1], "chunks") == 0)
+            {
+                Logging.Timestamps = STAMP_CHUNKS;
+            }
+            else
+            {
+                puts("Invalid Timestamps, Expected lines or chunks");
+                exit(-1);
+            }
+        }
+        else if (strcmp(argv[First], "-Rotate") == 0)
+        {
+            Logging.MaximumSize = ParseSize(argv[First + 1]);
+        }
+        else if (strcmp(argv[First], "-RotateTime") == 0)
+        {
+            Logging.MaximumAge = ParseSize(argv[First + 1]);
+        }
+        else if (strcmp(argv[First], "-Send") == 0)
+        {
+            SendName = argv[First + 1];
+        }
+        else if (strcmp(argv[First], "-Protocol") == 0)
+        {
+            if ((Protocol = ParseProtocol(argv[First + 1])) < 0)
+            {
+                puts("Invalid Protocol, Expected xmodem, ymodem or zmodem");
+                exit(-1);
+            }
+        }
+        else if (strcmp(argv[First], "-Command") == 0)
+        {
+            Command = argv[First + 1];
+        }
+        else if (strcmp(argv[First], "-Triggers") == 0)
+        {
+            TriggerFile = argv[First + 1];
+        }
+        else if (strcmp(argv[First], "-Events") == 0)
+        {
+            if ((Events = fopen(argv[First + 1], "a")) == NULL)
+            {
+                puts("Cannot Open the Events File");
+                exit(-1);
+            }
+            
+            setvbuf(Events, NULL, _IOLBF, 0);
+        }
+        else if (strcmp(argv[First], "-Dump") == 0)
+        {
+            DumpName = argv[First + 1];
+        }
+        else if (strcmp(argv[First], "-Address") == 0)
+        {
+            Dump.Address = ParseSize(argv[First + 1]);
+        }
+        else if (strcmp(argv[First], "-Length") == 0)
+        {
+            Dump.Length = ParseSize(argv[First + 1]);
+        }
+        else if (strcmp(argv[First], "-Window") == 0)
+        {
+            if ((Dump.Window = ParseSize(argv[First + 1])) == 0)
+            {
+                puts("Invalid Window");
+                exit(-1);
+            }
+        }
+        else if (strcmp(argv[First], "-Prompt") == 0)
+        {
+            Dump.Prompt = argv[First + 1];
+        }
+        else if (strcmp(argv[First], "-Verify") == 0)
         {
-            PrintBaud();
-            exit(0);
+            Dump.Verify = strcmp(argv[First + 1], "none") != 0;
+        }
+        else if (strcmp(argv[First], "-Format") == 0)
+        {
+            if (ParseSerialFormat(argv[First + 1], &Settings) != 0)
+            {
+                puts("Invalid Format, Expected <Data Bits><N|E|O><Stop Bits> such as 8N1");
+                exit(-1);
+            }
+        }
+        else if (strcmp(argv[First], "-Flow") == 0)
+        {
+            if (ParseFlowControl(argv[First + 1], &Settings) != 0)
+            {
+                puts("Invalid Flow Control, Expected none, rtscts or xonxoff");
+                exit(-1);
+            }
         }
         else
         {
             PrintHelp(argv[0]);
         }
+        
+        First += 2;
     }
-    else if (argc == 5)
-    {
-        if (strcmp(argv[1], "-Write") == 0)
+    
+    if (argc - First == 2)
+    {       
+        if (strcmp(argv[First + 1], "auto") == 0)
         {
-                
-            speed_t BaudRate = ReturnBaud(atoi(argv[4]));
-            
-            
-            ConnectSerial(argv[3], BaudRate, argv[2]);
+            if (DetectSerial(argv[First], &Settings, 0) == 0)
+            {
+                puts("No Baud Rate Found");
+                exit(-1);
+            }
+        }
+        else
+        {
+            Settings.BaudRate = ReturnBaud(argv[First + 1]);
+        }
+        
+        if (TriggerFile)
+        {
+            LoadTriggers(&Triggers, TriggerFile, Events);
         }
+        
+        if (DumpName)
+        {
+            return DumpSerial(argv[First], &Settings, &Dump, DumpName) == 0 ? 0 : 1;
+        }
+        
+        if (SendName)
+        {
+            return SendSerial(argv[First], &Settings, SendName, Protocol, Command) == 0 ? 0 : 1;
+        }
+        
+        ConnectSerial(argv[First], &Settings, LogFile, CaptureFile, &Logging, TriggerFile ? &Triggers : NULL);
     }
     else
     {
         PrintHelp(argv[0]);
     }
     
+    return 0;
 }
 
 
 // Prints the Syntax Help
 
-void PrintHelp(char * ProgramName)
+static void PrintHelp(char * ProgramName)
 {
     puts("Serial Port Terminal \r\n");
         
         puts("Sytax : ");
-        
+            
             printf("\t %s <Serial Port> <Baud Rate> \r\n\r\n", ProgramName);
-            printf("\t %s -Write LOGFILE <Serial Port> <Baud Rate> \r\n\r\n", ProgramName);
-        
+            printf("\t %s [Options] <Serial Port> <Baud Rate> \r\n\r\n", ProgramName);
+            printf("\t %s -Hub <Hub File> : Watch every Port of the Hub File ( See SerialHub.h ) \r\n\r\n", ProgramName);
+            printf("\t %s -Attach <Socket> : Attach to a Port shared by a Hub, CTRL-C Detaches \r\n\r\n", ProgramName);
+            printf("\t %s -AutoBaud <Serial Port> : Detect the Baud Rate, \"auto\" also does it before Connecting \r\n\r\n", ProgramName);
+            printf("\t %s -Score <Capture> ... : Score how much each Capture looks like Console Text \r\n\r\n", ProgramName);
+    
     puts("Available Options:");
         
-        printf("\t -List : List Available Buad Rates \r\n\r\n");
+        printf("\t -List : List Common Buad Rates \r\n\r\n");
         printf("\t -Write LOGFILE : Write Serial Output to Logfile \r\n\r\n");
-            
-    exit(0);
+        printf("\t -Stamp lines|chunks : Timestamp every Line or every Chunk of the Logfile \r\n\r\n");
+        printf("\t -Capture FILE : Write the Raw Serial Output to a Binary Capture \r\n\r\n");
+        printf("\t -Send FILE : Upload FILE instead of Connecting, then Exit \r\n\r\n");
+        printf("\t -Protocol NAME : The Upload Protocol, xmodem ( 1K ), ymodem ( Default ) or zmodem \r\n\r\n");
+        printf("\t -Command TEXT : Type TEXT before the Upload, such as \"loady 0x80000000\" \r\n\r\n");
+        printf("\t -Triggers FILE : Match the Patterns of FILE on the Port ( See Trigger.h ) \r\n\r\n");
+        printf("\t -Events FILE : Append the Trigger Events to FILE instead of the Standard Error \r\n\r\n");
+        printf("\t -Dump FILE : Read Memory through the U-Boot Console ( md.b ) to FILE, then Exit \r\n\r\n");
+        printf("\t -Address ADDRESS -Length SIZE : The Memory to Dump \r\n\r\n");
+        printf("\t -Window SIZE : The Bytes Read by each Command ( Default 64K ) \r\n\r\n");
+        printf("\t -Prompt TEXT : The Console Prompt ( Default \"=> \" ) \r\n\r\n");
+        printf("\t -Verify crc32|none : Check each Window with the Target's crc32 Command ( Default crc32 ) \r\n\r\n");
+        printf("\t -Rotate SIZE : Rotate the Logs once they reach SIZE Bytes ( K, M and G Suffixes ) \r\n\r\n");
+        printf("\t -RotateTime SECONDS : Rotate the Logs once they are SECONDS old \r\n\r\n");
+        printf("\t -Format 8N1 : Data Bits ( 5 - 8 ), Parity ( N, E, O ) and Stop Bits ( 1, 2 ) \r\n\r\n");
+        printf("\t -Flow MODE : Flow Control, none ( Default ), rtscts or xonxoff \r\n\r\n");
     
+    exit(0);
+
 }
 
 // Prints the Allowed Baud Rates
 
-void PrintBaud()
+static void PrintBaud()
 {
-    printf("%s", "\r\nAvailable Baud Rates \r\n");
+    printf("%s", "\r\nCommon Baud Rates, any other Rate the UART supports is also Accepted \r\n");
     
-    printf("%10s \r\n", "0");
     printf("%10s \r\n", "50");
     printf("%10s \r\n", "75");
     printf("%10s \r\n", "110");
@@ -134,13 +399,20 @@ void PrintBaud()
     printf("%10s \r\n", "57600");
     printf("%10s \r\n", "115200");
     printf("%10s \r\n", "230400");
+    printf("%10s \r\n", "460800");
+    printf("%10s \r\n", "921600");
+    printf("%10s \r\n", "1000000");
+    printf("%10s \r\n", "1500000");
+    printf("%10s \r\n", "2000000");
+    printf("%10s \r\n", "3000000");
+    printf("%10s \r\n", "4000000");
 }
 
-int ConnectSerial(char * PortName, speed_t BaudRate, char * LogFile)
+int ConnectSerial(char * PortName, SerialSettings * Settings, char * LogFile, char * CaptureFile, LogSettings * Logging, TriggerSet * Triggers)
 {
     
-            
-            
+    
+    
     if (strcmp(LogFile, "") != 0)
     {
         printf("Output is Going to Be Written to %s\r\n", LogFile);
@@ -150,43 +422,46 @@ int ConnectSerial(char * PortName, speed_t BaudRate, char * LogFile)
         puts("Output is not Going to be Logged");
     } 
     
+    if (strcmp(CaptureFile, "") != 0)
+    {
+        printf("Raw Output is Going to Be Captured to %s\r\n", CaptureFile);
+    }
+    
     puts("Press CTRL-C To Close the Connection");
-
+    
     /* Structures to Hold the Settings for 
-     
+            
             - Standard Output and the Serial Port Configurations
             - Backup Standard Output
-            
+    
     */
-        
+    
     struct termios OldSettings, Terminal;
     
     int FileDescriptor;
     
-    unsigned char Character = 'X';
-    
     // Get The Standard Output's Old Settings and Store then in Old Settings
-
+    
     tcgetattr(STDOUT, &OldSettings);
-
+    
     // Allocate Memory for the New Settings Structure
     
     memset(&Terminal, 0, sizeof(Terminal));
-
+    
     /*
       Configure the Standard Output
-      
+        
         - The Below Configurations are Found inside the Termios Header File
             + Input Modes           - C_IFLAG
             + Output Modes          - C_OFLAG
             + Control Modes         - C_CFLAG
             + Local Modes           - C_LFLAG
             + Special Characters    - C_CC
-        
+    
     */
     
     // Raw Input Mode
-
+    
     Terminal.c_iflag    = 0;
     
     // Raw Output Mode
@@ -210,88 +485,79 @@ int ConnectSerial(char * PortName, speed_t BaudRate, char * LogFile)
     Terminal.c_cc[VTIME] = 0;
     
     // Apply the settings for the Standard Output Immediately
-
+    
     tcsetattr(STDOUT, TCSANOW, &Terminal);
-
     
-    /*  Configure the Standard Input
-            - Set The File Status Flags (F_SETFL)
-            - Set No Blocking   */
-        
-    fcntl(STDIN_FILENO, F_SETFL, O_NONBLOCK);
-
-    // Allocate Memory for the Serial Port 
     
-    memset(&Terminal, 0, sizeof(Terminal));
+    /* Open the Serial Port and Store it's File Descriptor inside the Variable FileDescriptor
+            + Raw Mode, Non Blocking
+            + The Baud Rate, Frame Format and Flow Control Chosen by the User    */
     
-    // Set the Serial Port Configurations - Check Above for Details
+    FileDescriptor = OpenSerialPort(PortName, Settings);
     
-    Terminal.c_iflag        =   0;
-    Terminal.c_oflag        =   0;
+    if (FileDescriptor < 0)
+    {
+        tcsetattr(STDOUT, TCSANOW, &OldSettings);
+        
+        printf("Cannot Open %s at %u Baud \r\n", PortName, Settings -> BaudRate);
+        
+        exit(-1);
+    }
     
-    /* Set the Control Flags TO:
-            + Eight Character Size
-            + Enable Read
-            + Ignore Modem Control Lines    */
-            
-    Terminal.c_cflag        =   CS8|CREAD|CLOCAL;
+    // The Driver picks the Closest Rate the UART can Generate
     
-    Terminal.c_lflag        =   0;
+    unsigned int BaudRate = ActualBaudRate(FileDescriptor);
     
-    Terminal.c_cc[VMIN]     =   1;
+    if (BaudRate != Settings -> BaudRate)
+    {
+        printf("Baud Rate set to %u instead of %u \r\n", BaudRate, Settings -> BaudRate);
+    }
     
-    Terminal.c_cc[VTIME]    =   5;
+    // Start the Loggers, the Capture keeps the Exact Bytes
     
-    //Open the Serial Port and Store it's File Descriptor inside the Variable FileDescriptor
-
-    FileDescriptor = open(PortName, O_RDWR | O_NONBLOCK);
-
-    // Set the Baudrate of the Serial Port to the One Specified by the User ( Both for the Input (cfsetispeed) and Output (cfsetospeed)
+    SerialLog * Logs[2];
     
-    cfsetospeed(&Terminal, BaudRate);
-    cfsetispeed(&Terminal, BaudRate);
+    int LogCount = 0;
     
-    // Apply the Settings - TCSANOW Apply the Settings Immediately
-
-    tcsetattr(FileDescriptor, TCSANOW, &Terminal);
+    LogSettings Capture = *Logging;
+    
+    Capture.Timestamps = STAMP_NONE;
     
-    FILE * OutputFile;
-
     if (strcmp(LogFile, "") != 0)
     {
-        OutputFile = FileOpener(LogFile, "w");
+        Logs[LogCount ++] = OpenSerialLog(LogFile, Logging);
     }
-    // Keep Connected with the Serial Port until the CTRL + C Sequence Button is Pressed
-        
-    while (1)
+    
+    if (strcmp(CaptureFile, "") != 0)
     {
-        // Read the Serial Port and if New Data is Available, Display It
-        
-        if (read(FileDescriptor, &Character, 1) > 0)
+        Logs[LogCount ++] = OpenSerialLog(CaptureFile, &Capture);
+    }
+    
+    int Counter;
+    
+    for (Counter = 0; Counter < LogCount; Counter ++)
+    {
+        if (Logs[Counter] == NULL)
         {
-            write(STDOUT_FILENO, &Character, 1);
+            close(FileDescriptor);
             
-            if (strcmp(LogFile, "") != 0)
-            {               
-                fputc(Character, OutputFile);
-            }
+            tcsetattr(STDOUT, TCSANOW, &OldSettings);
             
-        }
-        
-        // Read the Console and if New Input is Available, Send it to the Serial Port
-        
-        if (read(STDIN_FILENO, &Character, 1) > 0)
-        {
-            if (Character != 0x03)
-            {
-                write(FileDescriptor, &Character, 1);
-            }
-            else
-            {
-                break;
-            }
-        }
+            puts("Cannot Create Log File");
             
+            exit(-1);
+        }
+    }
+    
+    // Keep Connected with the Serial Port until the CTRL + C Sequence Button is Pressed, or a Signal is Received
+    
+    ForwardSerial(FileDescriptor, STDIN_FILENO, STDOUT_FILENO, Logs, LogCount, Triggers);
+    
+    // Write whatever is still Queued before Exiting
+    
+    for (Counter = 0; Counter < LogCount; Counter ++)
+    {
+        CloseSerialLog(Logs[Counter]);
     }
     
     // Close the Serial Port
@@ -305,72 +571,440 @@ int ConnectSerial(char * PortName, speed_t BaudRate, char * LogFile)
     puts("Exiting");
     
     return 1;
+
+}
+
+unsigned int ReturnBaud(char * BaudRate)
+{
+    char * End;
+    
+    unsigned long Rate = strtoul(BaudRate, &End, 10);
     
+    // If an Incorrect Baudrate is Enterred Exit the Application
+    
+    if (*End != '\0' || Rate == 0 || Rate > 0xFFFFFFFF)
+    {
+        printf("Invalid Baud Rate %s \r\n", BaudRate);
+        exit(-1);
+    }
+    
+    return Rate;
+}
+
+// Set by the Signal Handler, the Forwarding Loop Stops when it is Set
+
+static volatile sig_atomic_t StopForwarding = 0;
+
+static void StopHandler(int Signal)
+{
+    StopForwarding = 1;
+}
+
+// Trigger Replies are Typed straight on the Port, the only one Forwarded
+
+static int TypeReply(const BYTE * Data, QWORD Length, void * Context)
+{
+    return WriteAll(*(int *) Context, Data, Length);
 }
 
-speed_t ReturnBaud(int BaudRate)
+/*
+ *  The Forward Serial Method will copy Data from the Port to the Output ( and
+ *  the Logs ), and from the Input to the Port, until the Exit Character is
+ *  Typed, the Port Hangs Up, or SIGINT, SIGTERM or SIGHUP is Received.
+ * 
+ *  The Method Sleeps inside ppoll until one of the Descriptors has Data. The
+ *  Signals are only Unblocked while Sleeping, so a Signal can never be missed
+ *  between the Check of the Stop Flag and the Sleep.
+ * 
+ *  Parameters:
+ *          The Serial Port, Input and Output Descriptors
+ *          The Logs, and their Count
+ *          The Triggers Matched on the Port's Data, or NULL
+ * 
+ *  Returns:
+ *          0 when Closed by the User or a Signal, -1 when the Port Fails
+ */
+
+int ForwardSerial(int Port, int Input, int Output, SerialLog * Logs[], int LogCount, TriggerSet * Triggers)
 {
-    switch(BaudRate)
+    static unsigned char Buffer[FORWARD_CHUNK];
+    
+    struct sigaction Action, OldActions[3];
+    
+    int Signals[3] = { SIGINT, SIGTERM, SIGHUP };
+    
+    sigset_t Blocked, Waiting;
+    
+    int Counter;
+    
+    int Result = 0;
+    
+    // Install the Handlers without SA_RESTART, so that ppoll is Interrupted
+    
+    memset(&Action, 0, sizeof(Action));
+    
+    Action.sa_handler = StopHandler;
+    
+    sigemptyset(&Blocked);
+    
+    for (Counter = 0; Counter < 3; Counter ++)
     {
-            case 0:
-                return B0;
-            
-            case 50:
-                return B50;
-            
-            case 75:
-                return B75;
-         
-            case 110:
-                return B110;
-            
-            case 134:
-                return B134;
-            
-            case 150:
-                return B150;
-            
-            case 200:
-                return B200;
+        sigaction(Signals[Counter], &Action, &OldActions[Counter]);
+        
+        sigaddset(&Blocked, Signals[Counter]);
+    }
+    
+    sigprocmask(SIG_BLOCK, &Blocked, &Waiting);
+    
+    StopForwarding = 0;
+    
+    TriggerState Matching;
+    
+    if (Triggers)
+    {
+        ResetTriggers(&Matching, "Port");
+    }
+    
+    struct pollfd Descriptors[2];
+    
+    Descriptors[0].fd = Port;
+    Descriptors[0].events = POLLIN;
+    
+    Descriptors[1].fd = Input;
+    Descriptors[1].events = POLLIN;
+    
+    while (!StopForwarding)
+    {
+        if (ppoll(Descriptors, 2, NULL, &Waiting) < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
             
-            case 300:
-                return B300;
+            Result = -1;
+            break;
+        }
+        
+        // Forward everything the Port has, in a single Read
+        
+        if (Descriptors[0].revents & POLLIN)
+        {
+            ssize_t Length = read(Port, Buffer, FORWARD_CHUNK);
             
-            case 600:
-                return B600;
+            if (Length > 0)
+            {
+                WriteAll(Output, Buffer, Length);
+                
+                for (Counter = 0; Counter < LogCount; Counter ++)
+                {
+                    LogData(Logs[Counter], Buffer, Length);
+                }
+                
+                if (Triggers)
+                {
+                    MatchTriggers(Triggers, &Matching, TypeReply, &Port, Buffer, Length);
+                }
+            }
+            else if (Length == 0 || (errno != EAGAIN && errno != EINTR))
+            {
+                Result = -1;
+                break;
+            }
+        }
+        else if (Descriptors[0].revents & (POLLHUP | POLLERR | POLLNVAL))
+        {
+            Result = -1;
+            break;
+        }
+        
+        // Forward the Console Input up to the Exit Character
+        
+        if (Descriptors[1].revents & (POLLIN | POLLHUP))
+        {
+            ssize_t Length = read(Input, Buffer, FORWARD_CHUNK);
             
-            case 1200:
-                return B1200;
+            // The Input is Closed, keep Displaying the Port
             
-            case 1800:
-                return B1800;
+            if (Length <= 0)
+            {
+                if (Length == 0 || (errno != EAGAIN && errno != EINTR))
+                {
+                    Descriptors[1].fd = -1;
+                }
+                
+                continue;
+            }
             
-            case 2400:
-                return B2400;
+            unsigned char * Exit = memchr(Buffer, EXIT_CHARACTER, Length);
             
-            case 4800:
-                return B4800;
+            if (WriteAll(Port, Buffer, Exit ? Exit - Buffer : Length) != 0)
+            {
+                Result = -1;
+                break;
+            }
             
-            case 9600:
-                return B9600;
+            if (Exit)
+            {
+                break;
+            }
+        }
+    }
+    
+    if (Triggers)
+    {
+        PrintTriggerStats(Triggers, &Matching);
+    }
+    
+    // Put Back the Signal Handlers and Mask found on Entry
+    
+    for (Counter = 0; Counter < 3; Counter ++)
+    {
+        sigaction(Signals[Counter], &OldActions[Counter], NULL);
+    }
+    
+    sigprocmask(SIG_SETMASK, &Waiting, NULL);
+    
+    return Result;
+}
+
+/*
+ *  The Send Serial Method will Upload a File to the Device. The Command, if
+ *  any, is Typed first ( to Start the Bootloader's Receiver ) and the Device's
+ *  Answer is Displayed until it goes Quiet.
+ * 
+ *  Parameters:
+ *          The Name of the Port and it's Settings
+ *          The Name of the File and the Protocol
+ *          The Command to Type, or NULL
+ * 
+ *  Returns:
+ *          0 on Success, -1 on Failure
+ */
+
+int SendSerial(char * PortName, SerialSettings * Settings, char * FileName, int Protocol, char * Command)
+{
+    int Port = OpenSerialPort(PortName, Settings);
+    
+    if (Port < 0)
+    {
+        printf("Cannot Open %s at %u Baud \r\n", PortName, Settings -> BaudRate);
+        
+        return -1;
+    }
+    
+    if (Command)
+    {
+        unsigned char Buffer[1024];
+        
+        WriteAll(Port, (unsigned char *) Command, strlen(Command));
+        WriteAll(Port, (unsigned char *) "\r", 1);
+        
+        // Show the Answer until nothing is Received for Half a Second, stopping at the Receiver's First Request
+        
+        struct pollfd Answer = { Port, POLLIN, 0 };
+        
+        while (poll(&Answer, 1, 500) > 0)
+        {
+            ssize_t Length = read(Port, Buffer, sizeof(Buffer));
             
-            case 19200:
-                return B19200;
+            if (Length <= 0)
+            {
+                break;
+            }
             
-            case 38400:
-                return B38400;
+            unsigned char * Request = memchr(Buffer, Protocol == PROTOCOL_ZMODEM ? '*' : 'C', Length);
             
-            case 57600:
-                return B57600;
+            WriteAll(STDOUT_FILENO, Buffer, Request ? Request - Buffer : Length);
             
-            case 115200:
-                return B115200;
+            if (Request)
+            {
+                break;
+            }
+        }
+        
+        puts("");
+    }
+    
+    int Result = SendFile(Port, FileName, Protocol);
+    
+    close(Port);
+    
+    return Result;
+}
+
+/*
+ *  The Dump Serial Method will Open the Port and Dump the Memory asked for.
+ * 
+ *  Parameters:
+ *          The Name of the Port and it's Settings
+ *          The Dump Settings
+ *          The Name of the Output File
+ * 
+ *  Returns:
+ *          0 on Success, -1 on Failure
+ */
+
+int DumpSerial(char * PortName, SerialSettings * Settings, DumpSettings * Dump, char * OutputFile)
+{
+    if (Dump -> Length == 0)
+    {
+        puts("The Length to Dump is Missing ( -Length )");
+        
+        return -1;
+    }
+    
+    int Port = OpenSerialPort(PortName, Settings);
+    
+    if (Port < 0)
+    {
+        printf("Cannot Open %s at %u Baud \r\n", PortName, Settings -> BaudRate);
+        
+        return -1;
+    }
+    
+    int Result = DumpFlash(Port, Dump, OutputFile);
+    
+    close(Port);
+    
+    return Result;
+}
+
+/*
+ *  The Detect Serial Method will Open a Port and Probe it's Baud Rate ( See
+ *  AutoBaud.h ), the Settings keep the Rate Found.
+ * 
+ *  Parameters:
+ *          A Char Array with the Port's Name, and it's Settings
+ *          1 to Print the Score of every Rate Probed
+ * 
+ *  Returns:
+ *          The Rate Found, or 0
+ */
+
+unsigned int DetectSerial(char * PortName, SerialSettings * Settings, int Verbose)
+{
+    int Port = OpenSerialPort(PortName, Settings);
+    
+    if (Port < 0)
+    {
+        printf("Cannot Open %s \r\n", PortName);
+        
+        return 0;
+    }
+    
+    unsigned int Rate = DetectBaudRate(Port, Settings, Verbose);
+    
+    close(Port);
+    
+    if (Rate)
+    {
+        printf("%s is at %u Baud \r\n", PortName, Rate);
+    }
+    else if (Verbose)
+    {
+        printf("No Baud Rate Found on %s \r\n", PortName);
+    }
+    
+    return Rate;
+}
+
+/*
+ *  The Score Captures Method will Score Raw Captures ( -Capture ) offline,
+ *  such as the same Console Recorded at several Rates, and Name the Best.
+ * 
+ *  Parameters:
+ *          The Capture Files and their Count
+ * 
+ *  Returns:
+ *          VOID
+ */
+
+void ScoreCaptures(char ** FileNames, int Count)
+{
+    int Best = -1;
+    
+    double BestScore = 0;
+    
+    int Counter;
+    
+    for (Counter = 0; Counter < Count; Counter ++)
+    {
+        QWORD Size;
+        
+        BYTE * Capture = MapFile(FileNames[Counter], &Size);
+        
+        BaudScore Score;
+        
+        ScoreSample(Capture, Size, 0, &Score);
+        
+        UnmapFile(Capture, Size);
+        
+        printf("%-32s : %8llu Characters, %3.0f%% Printable, %d Tokens, Score %5.2f \r\n", FileNames[Counter],
+               (unsigned long long) Score.Length, Score.Length ? Score.Printable * 100.0 / Score.Length : 0, Score.Tokens, Score.Score);
+        
+        if (Best < 0 || Score.Score > BestScore)
+        {
+            Best = Counter;
             
-            case 230400:
-                return B230400;
-                
-            // If an Incorrect Baudrate is Enterred Exit the Application
-            default:
-                exit(-1);
+            BestScore = Score.Score;
+        }
     }
+    
+    printf("Best : %s \r\n", FileNames[Best]);
+}
+
+/*
+ *  The Attach Serial Method will Connect the Console to a Port shared by a
+ *  Hub. The Exit Character Detaches, the Hub keeps Logging the Port.
+ * 
+ *  Parameters:
+ *          A Char Array with the Path of the Hub's Socket
+ * 
+ *  Returns:
+ *          0 when Detached by the User, -1 on Failure or when the Hub Stops
+ */
+
+int AttachSerial(char * SocketPath)
+{
+    struct sockaddr_un Address;
+    
+    memset(&Address, 0, sizeof(Address));
+    
+    Address.sun_family = AF_UNIX;
+    
+    strncpy(Address.sun_path, SocketPath, sizeof(Address.sun_path) - 1);
+    
+    int Socket = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    
+    if (Socket < 0 || connect(Socket, (struct sockaddr *) &Address, sizeof(Address)) != 0)
+    {
+        printf("Cannot Attach to %s \r\n", SocketPath);
+        
+        return -1;
+    }
+    
+    puts("Press CTRL-C To Detach");
+    
+    // The Console is Raw while Attached, as for a Port
+    
+    struct termios OldSettings, Terminal;
+    
+    tcgetattr(STDOUT, &OldSettings);
+    
+    Terminal = OldSettings;
+    
+    cfmakeraw(&Terminal);
+    
+    tcsetattr(STDOUT, TCSANOW, &Terminal);
+    
+    int Result = ForwardSerial(Socket, STDIN_FILENO, STDOUT_FILENO, NULL, 0, NULL);
+    
+    close(Socket);
+    
+    tcsetattr(STDOUT, TCSANOW, &OldSettings);
+    
+    puts(Result == 0 ? "Detached" : "The Hub Closed the Connection");
+    
+    return Result;
 }
@@ -0,0 +1,1826 @@
+/********************************************************************
+ *                  Serial Benchmark                                *
+ *                                                                  *
+ *  [   Author  ]       -       Andrew Borg                         *
+ *  [   Type    ]       -       Serial Port Connector               *
+ *  [   Date    ]       -       19.01.2013                          *
+ *                                                                  *
+ * ******************************************************************
+ *                                                                  *
+ *  Description                                                     *
+ *                                                                  *
+ * Measures how fast the Serial Connector forwards a Port to the    *
+ * Console, and whether it Loses anything, without any Hardware.    *
+ *                                                                  *
+ * A Pseudo Terminal plays the Device : the Serial Connector is     *
+ * Started on it's Slave, with it's Console on a Pipe, and the      *
+ * Benchmark Writes Traffic on the Master while Reading the         *
+ * Console back. Every Byte which comes out is Checked against      *
+ * what went in, and every Write is Timed until it's Last Byte      *
+ * reaches the Console.                                             *
+ *                                                                  *
+ * The Traffic is either Synthetic Console Lines, Written at a      *
+ * Rate and in Bursts, or a Session Recorded on a real Port with    *
+ * it's original Timing ( -Record ), Replayed at any Speed.         *
+ *                                                                  *
+ * When a Rate is Set, the Master behaves like a UART without Flow  *
+ * Control : what cannot be Written at once is Lost ( an Overrun ). *
+ * Without a Rate, the Benchmark Waits for Room and measures the    *
+ * Highest Throughput.                                              *
+ *                                                                  *
+ * Reported : Throughput, Overrun, Missing and Corrupted Bytes,     *
+ * Latency Percentiles and the Connector's CPU Time per MB.         *
+ *                                                                  *
+ * With -Send, the Benchmark plays a Bootloader's Receiver : the    *
+ * Connector Uploads a File ( XMODEM-1K, YMODEM or ZMODEM ) and     *
+ * what Arrives is Compared with the File. One Block in -Damage is  *
+ * Damaged on it's way in, so that the Retries and Rewinds are Run. *
+ *                                                                  *
+ * ******************************************************************/
+
+#define _GNU_SOURCE
+
+#include <errno.h>
+#include <fcntl.h>
+#include <libgen.h>
+#include <poll.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+
+#include "../Headers/Common.h"
+#include "../Headers/SerialPort.h"
+#include "../Headers/Transfer.h"
+
+// The Recording's Magic, followed by Records of a Time ( Nanoseconds ), a Length and the Data
+
+#define RECORDING_MAGIC "SREC"
+
+// Written first and Waited for, so that the Connector is known to be Forwarding
+
+#define SYNC_LINE "Sync\r\n"
+
+// Nanoseconds without Progress after which the Missing Bytes are given up on
+
+#define DRAIN_TIMEOUT (2 * 1000000000ULL)
+
+#define READ_CHUNK (64 * 1024)
+
+////////////////////////////////////////////////////////////////////////////////
+
+typedef struct
+{
+    // When the Write is Due, relative to the Start, and when it was Done
+    
+    QWORD Due;
+    
+    QWORD Sent;
+    
+    // The Write's Data, inside the Traffic
+    
+    QWORD Offset;
+    
+    DWORD Length;
+    
+    // The End of the Write inside the Stream of Bytes which were Written, 0 if Lost
+    
+    QWORD End;
+
+} Write;
+
+typedef struct
+{
+    BYTE * Data;
+    
+    QWORD Size;
+    
+    Write * Writes;
+    
+    QWORD Count;
+
+} Traffic;
+
+// Internal Function Prototypes
+
+void PrintHelp(char * ProgramName);
+
+int RecordSession(char * FileName, char * PortName, unsigned int BaudRate);
+
+Traffic SyntheticTraffic(QWORD Size, QWORD Rate, DWORD Chunk, DWORD Burst, DWORD Seed);
+
+Traffic ReplayTraffic(char * FileName, double Speed);
+
+int RunBenchmark(char * SerialPath, char ** SerialOptions, int OptionCount, Traffic * Load, int Paced);
+
+int RunTransfer(char * SerialPath, char * FileName, int Protocol, DWORD Damage);
+
+////////////////////////////////////////////////////////////////////////////////
+
+static QWORD Monotonic()
+{
+    struct timespec Now;
+    
+    clock_gettime(CLOCK_MONOTONIC, &Now);
+    
+    return (QWORD) Now.tv_sec * 1000000000ULL + Now.tv_nsec;
+}
+
+int main(int argc, char ** argv)
+{
+    char SerialPath[4096];
+    
+    QWORD Size = 16 * 1024 * 1024, Rate = 0;
+    
+    DWORD Chunk = 256, Burst = 1, Seed = 1;
+    
+    char * ReplayFile = NULL;
+    
+    double Speed = 1.0;
+    
+    char * SendName = NULL;
+    
+    int Protocol = PROTOCOL_YMODEM;
+    
+    DWORD Damage = 0;
+    
+    // The Connector is looked for next to the Benchmark
+    
+    snprintf(SerialPath, sizeof(SerialPath), "%s", argv[0]);
+    
+    char * Slash = strrchr(SerialPath, '/');
+    
+    snprintf(Slash ? Slash + 1 : SerialPath, sizeof(SerialPath) - (Slash ? Slash + 1 - SerialPath : 0), "Serial");
+    
+    if (argc == 5 && strcmp(argv[1], "-Record") == 0)
+    {
+        char * End;
+        
+        unsigned long BaudRate = strtoul(argv[4], &End, 10);
+        
+        if (*End != '\0' || BaudRate == 0)
+        {
+            printf("Invalid Baud Rate %s \r\n", argv[4]);
+            exit(-1);
+        }
+        
+        return RecordSession(argv[2], argv[3], BaudRate) == 0 ? 0 : 1;
+    }
+    
+    int First = 1;
+    
+    while (First < argc && strcmp(argv[First], "--") != 0)
+    {
+        if (First + 1 >= argc)
+        {
+            PrintHelp(argv[0]);
+        }
+        
+        if (strcmp(argv[First], "-Serial") == 0)
+        {
+            snprintf(SerialPath, sizeof(SerialPath), "%s", argv[First + 1]);
+        }
+        else if (strcmp(argv[First], "-Size") == 0)
+        {
+            Size = ParseSize(argv[First + 1]);
+        }
+        else if (strcmp(argv[First], "-Rate") == 0)
+        {
+            Rate = ParseSize(argv[First + 1]);
+        }
+        else if (strcmp(argv[First], "-Chunk") == 0)
+        {
+            Chunk = ParseSize(argv[First + 1]);
+        }
+        else if (strcmp(argv[First], "-Burst") == 0)
+        {
+            Burst = ParseSize(argv[First + 1]);
+        }
+        else if (strcmp(argv[First], "-Seed") == 0)
+        {
+            Seed = ParseSize(argv[First + 1]);
+        }
+        else if (strcmp(argv[First], "-Replay") == 0)
+        {
+            ReplayFile = argv[First + 1];
+        }
+        else if (strcmp(argv[First], "-Speed") == 0)
+        {
+            Speed = atof(argv[First + 1]);
+        }
+        else if (strcmp(argv[First], "-Send") == 0)
+        {
+            SendName = argv[First + 1];
+        }
+        else if (strcmp(argv[First], "-Protocol") == 0)
+        {
+            if ((Protocol = ParseProtocol(argv[First + 1])) < 0)
+            {
+                PrintHelp(argv[0]);
+            }
+        }
+        else if (strcmp(argv[First], "-Damage") == 0)
+        {
+            Damage = ParseSize(argv[First + 1]);
+        }
+        else
+        {
+            PrintHelp(argv[0]);
+        }
+        
+        First += 2;
+    }
+    
+    if (Size == 0 || Chunk == 0 || Burst == 0 || Speed <= 0 || Damage == 1)
+    {
+        PrintHelp(argv[0]);
+    }
+    
+    // The Upload Loopback, instead of the Console Traffic
+    
+    if (SendName)
+    {
+        return RunTransfer(SerialPath, SendName, Protocol, Damage) == 0 ? 0 : 1;
+    }
+    
+    // Everything after -- is given to the Connector, such as -Write or -Triggers
+    
+    char ** SerialOptions = First < argc ? argv + First + 1 : argv + argc;
+    
+    int OptionCount = First < argc ? argc - First - 1 : 0;
+    
+    Traffic Load = ReplayFile ? ReplayTraffic(ReplayFile, Speed) : SyntheticTraffic(Size, Rate, Chunk, Burst, Seed);
+    
+    if (ReplayFile)
+    {
+        printf("Traffic   : %s, %llu Bytes in %llu Writes, at %.2fx the Recorded Speed \r\n", ReplayFile,
+               (unsigned long long) Load.Size, (unsigned long long) Load.Count, Speed);
+    }
+    else
+    {
+        printf("Traffic   : Synthetic, %llu Bytes in Bursts of %u x %u Bytes, ", (unsigned long long) Load.Size, Burst, Chunk);
+        
+        if (Rate)
+        {
+            printf("%llu Bytes per Second \r\n", (unsigned long long) Rate);
+        }
+        else
+        {
+            printf("Unlimited \r\n");
+        }
+    }
+    
+    // Replays keep their Timing, and lose Bytes as a Port would
+    
+    return RunBenchmark(SerialPath, SerialOptions, OptionCount, &Load, ReplayFile != NULL || Rate != 0) == 0 ? 0 : 1;
+}
+
+void PrintHelp(char * ProgramName)
+{
+    puts("Serial Benchmark \r\n");
+        
+        puts("Syntax : ");
+            
+            printf("\t %s [Options] [-- Serial Options] \r\n\r\n", ProgramName);
+            printf("\t %s -Record <File> <Serial Port> <Baud Rate> : Record a Session with it's Timing, until CTRL-C \r\n", ProgramName);
+            printf("\t %s -Send <File> [-Protocol NAME] [-Damage COUNT] : Upload a File with the Connector and Receive it on the Device \r\n\r\n", ProgramName);
+    
+    puts("Available Options:");
+        
+        printf("\t -Size SIZE : Synthetic Bytes to Send ( Default 16M ) \r\n\r\n");
+        printf("\t -Rate SIZE : Bytes per Second, Bytes which do not fit are Lost ( Default Unlimited, Waiting for Room ) \r\n\r\n");
+        printf("\t -Chunk SIZE : Bytes per Write ( Default 256 ) \r\n\r\n");
+        printf("\t -Burst COUNT : Writes sent back to back, then Paced by the Rate ( Default 1 ) \r\n\r\n");
+        printf("\t -Seed NUMBER : Seed of the Synthetic Console Lines ( Default 1 ) \r\n\r\n");
+        printf("\t -Replay FILE : Play a Recorded Session instead, with it's Timing \r\n\r\n");
+        printf("\t -Speed FACTOR : Replay Faster ( 2 ) or Slower ( 0.5 ) than Recorded \r\n\r\n");
+        printf("\t -Serial PATH : The Serial Connector to Measure ( Default : next to the Benchmark ) \r\n\r\n");
+        printf("\t -Send FILE : Upload FILE with -Send, the Benchmark plays the Receiver and Compares what Arrived \r\n\r\n");
+        printf("\t -Protocol NAME : The Upload Protocol, xmodem ( 1K ), ymodem ( Default ) or zmodem \r\n\r\n");
+        printf("\t -Damage COUNT : Flip a Bit in one Received Block out of COUNT, to Exercise the Retries ( Default None ) \r\n\r\n");
+    
+    exit(-1);
+}
+
+/*
+ *  The Add Write Method will append a Write to the Traffic.
+ */
+
+static void AddWrite(Traffic * Load, QWORD Due, QWORD Offset, DWORD Length)
+{
+    // The Writes grow by Doubling, Counts which are a Power of Two are Full
+    
+    if (Load -> Count == 0 || (Load -> Count >= 1024 && (Load -> Count & (Load -> Count - 1)) == 0))
+    {
+        Load -> Writes = realloc(Load -> Writes, (Load -> Count ? Load -> Count * 2 : 1024) * sizeof(Write));
+        
+        if (Load -> Writes == NULL)
+        {
+            puts("Error Allocating Memory");
+            exit(-1);
+        }
+    }
+    
+    Write * Entry = &Load -> Writes[Load -> Count ++];
+    
+    memset(Entry, 0, sizeof(Write));
+    
+    Entry -> Due = Due;
+    Entry -> Offset = Offset;
+    Entry -> Length = Length;
+}
+
+/*
+ *  The Synthetic Traffic Method will generate Console Lines, Kernel Messages
+ *  with Timestamps and the odd Hex Dump, and cut them into Writes.
+ * 
+ *  Parameters:
+ *          The Total Size, and the Rate in Bytes per Second ( 0 : Unlimited )
+ *          The Size of each Write and the Writes per Burst
+ *          The Seed of the Lines
+ * 
+ *  Returns:
+ *          The Traffic
+ */
+
+Traffic SyntheticTraffic(QWORD Size, QWORD Rate, DWORD Chunk, DWORD Burst, DWORD Seed)
+{
+    static const char * Words[] =
+    {
+        "eth0:", "link", "up", "down", "usb", "1-1:", "new", "high-speed", "device", "mtd:", "partition", "rootfs",
+        "jffs2:", "squashfs:", "mounted", "read-only", "kernel", "clocksource", "switched", "to", "timer", "irq",
+        "DMA", "zone", "free", "pages", "init", "started", "wlan0", "associated", "with", "bssid", "firmware", "loaded",
+    };
+    
+    Traffic Load = { malloc(Size + 256), Size, NULL, 0 };
+    
+    if (Load.Data == NULL)
+    {
+        puts("Error Allocating Memory");
+        exit(-1);
+    }
+    
+    QWORD State = Seed * 0x9E3779B97F4A7C15ULL + 1;
+    
+    QWORD Length = 0;
+    
+    QWORD Line = 0;
+    
+    while (Length < Size)
+    {
+        char * Text = (char *) Load.Data + Length;
+        
+        // Xorshift, the same Seed gives the same Traffic
+        
+        State ^= State << 13;
+        State ^= State >> 7;
+        State ^= State << 17;
+        
+        int Written = sprintf(Text, "[%5llu.%06llu]", (unsigned long long) Line / 100, (unsigned long long) (Line % 100) * 10000);
+        
+        if (State % 16 == 0)
+        {
+            int Counter;
+            
+            for (Counter = 0; Counter < 16; Counter ++)
+            {
+                Written += sprintf(Text + Written, " %02x", (unsigned) (State >> (Counter * 4)) & 0xFF);
+            }
+        }
+        else
+        {
+            int Count = 3 + State % 9;
+            
+            int Counter;
+            
+            for (Counter = 0; Counter < Count; Counter ++)
+            {
+                Written += sprintf(Text + Written, " %s", Words[(State >> (Counter * 5)) % (sizeof(Words) / sizeof(Words[0]))]);
+            }
+        }
+        
+        Written += sprintf(Text + Written, "\r\n");
+        
+        Length += Written;
+        
+        Line ++;
+    }
+    
+    // Each Burst is Due once the Bytes before it have had their Time at the Rate
+    
+    QWORD Offset;
+    
+    DWORD Index = 0;
+    
+    for (Offset = 0; Offset < Size; Offset += Chunk, Index ++)
+    {
+        QWORD BurstStart = (QWORD) (Index - Index % Burst) * Chunk;
+        
+        QWORD Due = Rate ? (QWORD) (BurstStart * 1e9 / Rate) : 0;
+        
+        AddWrite(&Load, Due, Offset, Size - Offset < Chunk ? Size - Offset : Chunk);
+    }
+    
+    return Load;
+}
+
+/*
+ *  The Replay Traffic Method will Load a Recording, each Chunk becomes a
+ *  Write Due at it's Recorded Time, divided by the Speed.
+ * 
+ *  Parameters:
+ *          A Char Array with the Name of the Recording
+ *          The Speed
+ * 
+ *  Returns:
+ *          The Traffic
+ */
+
+Traffic ReplayTraffic(char * FileName, double Speed)
+{
+    QWORD Size;
+    
+    BYTE * Recording = MapFile(FileName, &Size);
+    
+    if (Recording == NULL || Size < 4 || memcmp(Recording, RECORDING_MAGIC, 4) != 0)
+    {
+        puts("Not a Recording");
+        exit(-1);
+    }
+    
+    Traffic Load = { malloc(Size), 0, NULL, 0 };
+    
+    QWORD Position = 4;
+    
+    while (Position + sizeof(QWORD) + sizeof(DWORD) <= Size)
+    {
+        QWORD Time;
+        
+        DWORD Length;
+        
+        memcpy(&Time, Recording + Position, sizeof(Time));
+        memcpy(&Length, Recording + Position + sizeof(Time), sizeof(Length));
+        
+        Position += sizeof(Time) + sizeof(Length);
+        
+        if (Position + Length > Size)
+        {
+            break;
+        }
+        
+        memcpy(Load.Data + Load.Size, Recording + Position, Length);
+        
+        AddWrite(&Load, Time / Speed, Load.Size, Length);
+        
+        Load.Size += Length;
+        
+        Position += Length;
+    }
+    
+    UnmapFile(Recording, Size);
+    
+    if (Load.Count == 0)
+    {
+        puts("The Recording is Empty");
+        exit(-1);
+    }
+    
+    return Load;
+}
+
+// Set by the Signal Handler, the Recording Stops when it is Set
+
+static volatile sig_atomic_t StopRecording = 0;
+
+static void StopHandler(int Signal)
+{
+    StopRecording = 1;
+}
+
+/*
+ *  The Record Session Method will Save everything a Port sends, each Chunk
+ *  with the Time it was Read at, until SIGINT or SIGTERM.
+ * 
+ *  Parameters:
+ *          A Char Array with the Name of the Recording
+ *          The Port and it's Baud Rate
+ * 
+ *  Returns:
+ *          0 on Success, -1 on Failure
+ */
+
+int RecordSession(char * FileName, char * PortName, unsigned int BaudRate)
+{
+    SerialSettings Settings = SERIAL_DEFAULTS;
+    
+    Settings.BaudRate = BaudRate;
+    
+    int Port = OpenSerialPort(PortName, &Settings);
+    
+    if (Port < 0)
+    {
+        printf("Cannot Open %s at %u Baud \r\n", PortName, BaudRate);
+        
+        return -1;
+    }
+    
+    FILE * Recording = fopen(FileName, "wb");
+    
+    if (Recording == NULL)
+    {
+        puts("Cannot Create the Recording");
+        
+        close(Port);
+        
+        return -1;
+    }
+    
+    struct sigaction Action;
+    
+    memset(&Action, 0, sizeof(Action));
+    
+    Action.sa_handler = StopHandler;
+    
+    sigaction(SIGINT, &Action, NULL);
+    sigaction(SIGTERM, &Action, NULL);
+    
+    fwrite(RECORDING_MAGIC, 1, 4, Recording);
+    
+    puts("Recording, Press CTRL-C To Stop");
+    
+    static BYTE Buffer[READ_CHUNK];
+    
+    QWORD Start = Monotonic(), Total = 0;
+    
+    struct pollfd Descriptor = { Port, POLLIN, 0 };
+    
+    while (!StopRecording)
+    {
+        if (poll(&Descriptor, 1, -1) < 0)
+        {
+            continue;
+        }
+        
+        ssize_t Length = read(Port, Buffer, READ_CHUNK);
+        
+        if (Length <= 0)
+        {
+            if (Length == 0 || (errno != EAGAIN && errno != EINTR))
+            {
+                break;
+            }
+            
+            continue;
+        }
+        
+        QWORD Time = Monotonic() - Start;
+        
+        DWORD Size = Length;
+        
+        fwrite(&Time, sizeof(Time), 1, Recording);
+        fwrite(&Size, sizeof(Size), 1, Recording);
+        fwrite(Buffer, 1, Length, Recording);
+        
+        Total += Length;
+    }
+    
+    printf("Recorded %llu Bytes in %.2f Seconds \r\n", (unsigned long long) Total, (Monotonic() - Start) / 1e9);
+    
+    fclose(Recording);
+    
+    close(Port);
+    
+    return 0;
+}
+
+static int CompareTimes(const void * First, const void * Second)
+{
+    QWORD A = *(const QWORD *) First;
+    QWORD B = *(const QWORD *) Second;
+    
+    return (A > B) - (A < B);
+}
+
+/*
+ *  The Open Device Method will create the Pseudo Terminal playing the Device.
+ *  The Slave is made Raw and kept Open, so nothing Written before the
+ *  Connector Opens it is Lost or Echoed.
+ */
+
+static int OpenDevice(char * SlaveName, int NameSize, int * Slave)
+{
+    int Master = posix_openpt(O_RDWR | O_NOCTTY | O_NONBLOCK);
+    
+    if (Master < 0 || grantpt(Master) != 0 || unlockpt(Master) != 0 || ptsname_r(Master, SlaveName, NameSize) != 0)
+    {
+        return -1;
+    }
+    
+    *Slave = open(SlaveName, O_RDWR | O_NOCTTY);
+    
+    struct termios Raw;
+    
+    if (*Slave < 0 || tcgetattr(*Slave, &Raw) != 0)
+    {
+        return -1;
+    }
+    
+    cfmakeraw(&Raw);
+    
+    tcsetattr(*Slave, TCSANOW, &Raw);
+    
+    return Master;
+}
+
+/*
+ *  The Run Benchmark Method will Start the Connector on a Pseudo Terminal,
+ *  play the Traffic on it and Read it's Console until every Byte is back,
+ *  or nothing came for DRAIN_TIMEOUT.
+ * 
+ *  Parameters:
+ *          The Path of the Serial Connector, and the Options given to it
+ *          The Traffic
+ *          1 to keep the Traffic's Timing and Lose what does not fit, 0 to Wait for Room
+ * 
+ *  Returns:
+ *          0 if every Byte Written came back intact, -1 otherwise
+ */
+
+int RunBenchmark(char * SerialPath, char ** SerialOptions, int OptionCount, Traffic * Load, int Paced)
+{
+    char SlaveName[256];
+    
+    int Slave;
+    
+    int Master = OpenDevice(SlaveName, sizeof(SlaveName), &Slave);
+    
+    int Input[2], Output[2];
+    
+    if (Master < 0 || pipe2(Input, O_CLOEXEC) != 0 || pipe2(Output, O_CLOEXEC) != 0)
+    {
+        puts("Cannot Create the Pseudo Terminal");
+        
+        return -1;
+    }
+    
+    // The Connector's Arguments : it's Options, the Port and a Baud Rate ( a Pseudo Terminal has no Speed )
+    
+    char ** Arguments = calloc(OptionCount + 4, sizeof(char *));
+    
+    Arguments[0] = SerialPath;
+    
+    memcpy(Arguments + 1, SerialOptions, OptionCount * sizeof(char *));
+    
+    Arguments[OptionCount + 1] = SlaveName;
+    Arguments[OptionCount + 2] = "115200";
+    
+    pid_t Child = fork();
+    
+    if (Child == 0)
+    {
+        dup2(Input[0], STDIN_FILENO);
+        dup2(Output[1], STDOUT_FILENO);
+        
+        execv(SerialPath, Arguments);
+        
+        _exit(127);
+    }
+    
+    close(Input[0]);
+    close(Output[1]);
+    
+    free(Arguments);
+    
+    fcntl(Output[0], F_SETFL, O_NONBLOCK);
+    
+    // Everything which comes out after the Sync Line is Checked against what was Written
+    
+    BYTE * Expected = malloc(Load -> Size);
+    
+    QWORD * Latencies = malloc(Load -> Count * sizeof(QWORD));
+    
+    static BYTE Buffer[READ_CHUNK];
+    
+    char Banner[4096];
+    
+    int BannerLength = 0;
+    
+    QWORD Pushed = 0, Received = 0, Corrupted = 0, Overrun = 0, Acked = 0, LatencyCount = 0;
+    
+    QWORD Next = 0, Start = 0, Progress = Monotonic(), Finish = 0;
+    
+    int Synced = 0;
+    
+    if (write(Master, SYNC_LINE, strlen(SYNC_LINE)) != (ssize_t) strlen(SYNC_LINE))
+    {
+        puts("Cannot Write to the Pseudo Terminal");
+        
+        return -1;
+    }
+    
+    while (1)
+    {
+        QWORD Now = Monotonic();
+        
+        // Write every Due Write
+        
+        while (Synced && Next < Load -> Count && Load -> Writes[Next].Due <= Now - Start)
+        {
+            Write * Entry = &Load -> Writes[Next];
+            
+            ssize_t Written = write(Master, Load -> Data + Entry -> Offset, Entry -> Length);
+            
+            if (Written < 0)
+            {
+                if (errno != EAGAIN)
+                {
+                    break;
+                }
+                
+                Written = 0;
+            }
+            
+            if (!Paced && Written < Entry -> Length)
+            {
+                // Wait for Room and Write the Rest ( Unpaced Writes are never Lost )
+                
+                Entry -> Offset += Written;
+                Entry -> Length -= Written;
+                
+                memcpy(Expected + Pushed, Load -> Data + Entry -> Offset - Written, Written);
+                
+                Pushed += Written;
+                
+                break;
+            }
+            
+            memcpy(Expected + Pushed, Load -> Data + Entry -> Offset, Written);
+            
+            Pushed += Written;
+            
+            Overrun += Entry -> Length - Written;
+            
+            Entry -> Sent = Now;
+            
+            Entry -> End = Written ? Pushed : 0;
+            
+            Next ++;
+        }
+        
+        if (Synced && Next == Load -> Count && (Received >= Pushed || Now - Progress > DRAIN_TIMEOUT))
+        {
+            break;
+        }
+        
+        if (!Synced && Now - Progress > 10 * DRAIN_TIMEOUT)
+        {
+            puts("The Connector did not Forward the Sync Line");
+            
+            kill(Child, SIGKILL);
+            
+            waitpid(Child, NULL, 0);
+            
+            return -1;
+        }
+        
+        // Sleep until the next Write is Due, or the Console has Data
+        
+        struct pollfd Descriptors[2] = { { Output[0], POLLIN, 0 }, { Master, 0, 0 } };
+        
+        struct timespec Timeout = { 0, 100 * 1000000 };
+        
+        if (Synced && Next < Load -> Count)
+        {
+            QWORD Due = Start + Load -> Writes[Next].Due;
+            
+            QWORD Wait = Due > Now ? Due - Now : 0;
+            
+            if (Wait < 100 * 1000000ULL)
+            {
+                Timeout.tv_nsec = Wait;
+            }
+            
+            // An Unpaced Write which did not fit Waits for Room
+            
+            if (!Paced && Wait == 0)
+            {
+                Descriptors[1].events = POLLOUT;
+                
+                Timeout.tv_nsec = 100 * 1000000;
+            }
+        }
+        
+        ppoll(Descriptors, 2, &Timeout, NULL);
+        
+        ssize_t Length;
+        
+        while ((Length = read(Output[0], Buffer, READ_CHUNK)) > 0)
+        {
+            Now = Monotonic();
+            
+            Progress = Now;
+            
+            BYTE * Data = Buffer;
+            
+            // The Banner is Skipped up to the Sync Line, which Starts the Clock
+            
+            if (!Synced)
+            {
+                int Copy = Length < (ssize_t) sizeof(Banner) - 1 - BannerLength ? Length : (ssize_t) sizeof(Banner) - 1 - BannerLength;
+                
+                memcpy(Banner + BannerLength, Buffer, Copy);
+                
+                BannerLength += Copy;
+                
+                Banner[BannerLength] = '\0';
+                
+                char * Sync = strstr(Banner, SYNC_LINE);
+                
+                if (Sync == NULL)
+                {
+                    continue;
+                }
+                
+                Synced = 1;
+                
+                Start = Now;
+                
+                // What followed the Sync Line inside this Read is already Traffic
+                
+                int Consumed = (Sync + strlen(SYNC_LINE)) - Banner - (BannerLength - Copy);
+                
+                Data = Buffer + Consumed;
+                
+                Length -= Consumed;
+            }
+            
+            QWORD Useful = Received + Length <= Pushed ? Length : (Received < Pushed ? Pushed - Received : 0);
+            
+            QWORD Counter;
+            
+            for (Counter = 0; Counter < Useful; Counter ++)
+            {
+                Corrupted += Data[Counter] != Expected[Received + Counter];
+            }
+            
+            Received += Length;
+            
+            // Every Write whose Last Byte has arrived is Done
+            
+            while (Acked < Next && (Load -> Writes[Acked].End == 0 || Load -> Writes[Acked].End <= Received))
+            {
+                if (Load -> Writes[Acked].End)
+                {
+                    Latencies[LatencyCount ++] = Now - Load -> Writes[Acked].Sent;
+                }
+                
+                Acked ++;
+            }
+            
+            Finish = Now;
+        }
+    }
+    
+    // Close the Connector with the Exit Character, and collect it's CPU Time
+    
+    if (write(Input[1], "\x03", 1) != 1)
+    {
+        kill(Child, SIGTERM);
+    }
+    
+    struct rusage Usage;
+    
+    int Status;
+    
+    wait4(Child, &Status, 0, &Usage);
+    
+    close(Input[1]);
+    close(Output[0]);
+    close(Master);
+    close(Slave);
+    
+    double Seconds = Finish > Start ? (Finish - Start) / 1e9 : 0;
+    
+    double Megabytes = Received / (1024.0 * 1024.0);
+    
+    double Cpu = Usage.ru_utime.tv_sec + Usage.ru_utime.tv_usec / 1e6 + Usage.ru_stime.tv_sec + Usage.ru_stime.tv_usec / 1e6;
+    
+    QWORD Missing = Pushed > Received ? Pushed - Received : 0;
+    
+    printf("Forwarded : %llu Bytes in %.3f Seconds, %.2f MB/s \r\n", (unsigned long long) Received, Seconds, Seconds > 0 ? Megabytes / Seconds : 0);
+    
+    printf("Lost      : %llu Overrun, %llu Missing, %llu Corrupted \r\n", (unsigned long long) Overrun, (unsigned long long) Missing,
+           (unsigned long long) Corrupted);
+    
+    if (LatencyCount)
+    {
+        qsort(Latencies, LatencyCount, sizeof(QWORD), CompareTimes);
+        
+        printf("Latency   : p50 %.1f us, p90 %.1f us, p99 %.1f us, p99.9 %.1f us, Max %.1f us \r\n",
+               Latencies[LatencyCount * 50 / 100] / 1e3, Latencies[LatencyCount * 90 / 100] / 1e3, Latencies[LatencyCount * 99 / 100] / 1e3,
+               Latencies[LatencyCount * 999 / 1000] / 1e3, Latencies[LatencyCount - 1] / 1e3);
+    }
+    
+    printf("CPU       : %.3f Seconds User, %.3f Seconds System, %.2f ms per MB \r\n", Usage.ru_utime.tv_sec + Usage.ru_utime.tv_usec / 1e6,
+           Usage.ru_stime.tv_sec + Usage.ru_stime.tv_usec / 1e6, Megabytes > 0 ? Cpu * 1000 / Megabytes : 0);
+    
+    free(Expected);
+    free(Latencies);
+    
+    return Overrun || Missing || Corrupted ? -1 : 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+/*
+ *  The Transfer Loopback plays a Bootloader's Receiver on the Pseudo Terminal,
+ *  while the Serial Connector Uploads a File with -Send on it's Slave. The
+ *  Receivers below only share the Checksums with Transfer.c, which are first
+ *  Checked against the Check Values of the Standards.
+ */
+
+#define SOH     0x01
+#define STX     0x02
+#define EOT     0x04
+#define ACK     0x06
+#define NAK     0x15
+#define CAN     0x18
+#define CPMEOF  0x1A
+
+#define ZPAD    '*'
+#define ZDLE    0x18
+#define ZBIN    'A'
+#define ZHEX    'B'
+#define ZBIN32  'C'
+
+#define ZRQINIT 0
+#define ZRINIT  1
+#define ZACK    3
+#define ZFILE   4
+#define ZFIN    8
+#define ZRPOS   9
+#define ZDATA   10
+#define ZEOF    11
+
+#define ZCRCE   'h'
+#define ZCRCG   'i'
+#define ZCRCQ   'j'
+#define ZCRCW   'k'
+
+// ZRINIT's ZF0 : Full Duplex, Receives while Storing and CRC32
+
+#define RECEIVER_FLAGS (0x01 | 0x02 | 0x20)
+
+// Milliseconds without anything from the Sender after which the Transfer Failed
+
+#define TRANSFER_TIMEOUT 10000
+
+// The Receivers give up after this many Damaged Blocks in a row
+
+#define TRANSFER_RETRIES 10
+
+// Returned by the Readers instead of a Byte
+
+#define DEVICE_TIMEOUT -1
+#define DEVICE_CANCELLED -2
+
+typedef struct
+{
+    int Master;
+    
+    BYTE Buffer[READ_CHUNK];
+    
+    int Length, Position;
+    
+    // The File as it was Received, and the Size the Sender Announced ( YMODEM and ZMODEM )
+    
+    BYTE * Data;
+    
+    QWORD Size, Capacity, Announced;
+    
+    // Every Damage-th Block or Sub Packet has a Bit Flipped on it's way in, 0 for none
+    
+    DWORD Damage;
+    
+    QWORD Blocks, Damaged, Rejected;
+    
+    // ZMODEM Sub Packets carry the Checksum of the Header before them
+    
+    int Crc32;
+
+} Receiver;
+
+static const char * TransferNames[] = { "XMODEM-1K", "YMODEM", "ZMODEM" };
+static char * SenderNames[] = { "xmodem", "ymodem", "zmodem" };
+
+static int DeviceByte(Receiver * Device, int Timeout)
+{
+    while (Device -> Position == Device -> Length)
+    {
+        struct pollfd Readable = { Device -> Master, POLLIN, 0 };
+        
+        if (poll(&Readable, 1, Timeout) <= 0)
+        {
+            return DEVICE_TIMEOUT;
+        }
+        
+        ssize_t Length = read(Device -> Master, Device -> Buffer, READ_CHUNK);
+        
+        if (Length <= 0)
+        {
+            if (Length < 0 && (errno == EAGAIN || errno == EINTR))
+            {
+                continue;
+            }
+            
+            return DEVICE_TIMEOUT;
+        }
+        
+        Device -> Length = Length;
+        Device -> Position = 0;
+    }
+    
+    return Device -> Buffer[Device -> Position ++];
+}
+
+static void DeviceSend(Receiver * Device, const void * Data, int Length)
+{
+    WriteAll(Device -> Master, Data, Length);
+}
+
+static void DeviceAnswer(Receiver * Device, BYTE Answer)
+{
+    DeviceSend(Device, &Answer, 1);
+}
+
+// Discards what the Sender has Sent so far, after a Damaged Block
+
+static void DevicePurge(Receiver * Device)
+{
+    Device -> Position = Device -> Length = 0;
+    
+    while (DeviceByte(Device, 10) >= 0)
+    {
+        Device -> Position = Device -> Length;
+    }
+}
+
+// Returns 1 when the Next Block has to be Damaged
+
+static int DamageNext(Receiver * Device)
+{
+    Device -> Blocks ++;
+    
+    if (Device -> Damage && Device -> Blocks % Device -> Damage == 0)
+    {
+        Device -> Damaged ++;
+        
+        return 1;
+    }
+    
+    return 0;
+}
+
+static int Store(Receiver * Device, const BYTE * Data, QWORD Count)
+{
+    if (Device -> Size + Count > Device -> Capacity)
+    {
+        return -1;
+    }
+    
+    memcpy(Device -> Data + Device -> Size, Data, Count);
+    
+    Device -> Size += Count;
+    
+    return 0;
+}
+
+/*
+ *  The Receive Block Method will Read an XMODEM Block, once it's First Byte
+ *  ( SOH or STX ) was Read, and Check it's Number and CRC16.
+ * 
+ *  Returns:
+ *          The Length of the Block's Data, or -1 if it was Damaged or Cut
+ */
+
+static int ReceiveBlock(Receiver * Device, int Start, BYTE * Number, BYTE * Block)
+{
+    BYTE Frame[2 + 1024 + 2];
+    
+    int Length = Start == STX ? 1024 : 128;
+    
+    int Counter;
+    
+    for (Counter = 0; Counter < Length + 4; Counter ++)
+    {
+        int Byte = DeviceByte(Device, 1000);
+        
+        if (Byte < 0)
+        {
+            return -1;
+        }
+        
+        Frame[Counter] = Byte;
+    }
+    
+    if (DamageNext(Device))
+    {
+        Frame[2 + Length / 2] ^= 0x01;
+    }
+    
+    WORD Checksum = Crc16(0, Frame + 2, Length);
+    
+    if ((BYTE) (Frame[0] ^ Frame[1]) != 0xFF || Frame[2 + Length] != (Checksum >> 8) || Frame[3 + Length] != (Checksum & 0xFF))
+    {
+        return -1;
+    }
+    
+    *Number = Frame[0];
+    
+    memcpy(Block, Frame + 2, Length);
+    
+    return Length;
+}
+
+/*
+ *  The Receive Blocks Method will play an XMODEM Receiver : it asks for CRC16
+ *  Blocks with C, Stores each Block once, NAKs the Damaged ones and Acks the
+ *  Second EOT ( the First is NAKed, as careful Receivers do ).
+ * 
+ *  Parameters:
+ *          The Receiver
+ *          The Number of the Block Expected, 0 for a YMODEM Header
+ *          The Block Read, for a Header
+ * 
+ *  Returns:
+ *          0 once the File ( or the Header ) was Received, -1 on Failure
+ */
+
+static int ReceiveBlocks(Receiver * Device, int First, BYTE * Header)
+{
+    static BYTE Block[1024];
+    
+    BYTE Expected = First, Number;
+    
+    int Started = 0, Requests = 0, Errors = 0, Cancels = 0, Ends = 0;
+    
+    DeviceAnswer(Device, 'C');
+    
+    while (Errors < TRANSFER_RETRIES)
+    {
+        int Byte = DeviceByte(Device, Started ? TRANSFER_TIMEOUT : 1000);
+        
+        Cancels = Byte == CAN ? Cancels + 1 : 0;
+        
+        if (Cancels == 2)
+        {
+            return -1;
+        }
+        
+        if (Byte == SOH || Byte == STX)
+        {
+            int Length = ReceiveBlock(Device, Byte, &Number, Block);
+            
+            if (Length < 0)
+            {
+                Device -> Rejected ++;
+                
+                Errors ++;
+                
+                DevicePurge(Device);
+                
+                DeviceAnswer(Device, NAK);
+                
+                continue;
+            }
+            
+            Started = 1;
+            
+            Errors = 0;
+            
+            if (First == 0 && Number != 0)
+            {
+                return -1;
+            }
+            
+            if (First == 0)
+            {
+                memcpy(Header, Block, Length);
+                
+                DeviceAnswer(Device, ACK);
+                
+                return 0;
+            }
+            
+            // A Block whose Ack was Lost is Sent again, and only Acked
+            
+            if (Number == Expected)
+            {
+                if (Store(Device, Block, Length) != 0)
+                {
+                    return -1;
+                }
+                
+                Expected ++;
+            }
+            else if (Number != (BYTE) (Expected - 1))
+            {
+                return -1;
+            }
+            
+            DeviceAnswer(Device, ACK);
+        }
+        else if (Byte == EOT && First != 0)
+        {
+            DeviceAnswer(Device, Ends ++ ? ACK : NAK);
+            
+            if (Ends == 2)
+            {
+                return 0;
+            }
+        }
+        else if (Byte == DEVICE_TIMEOUT)
+        {
+            if (Started || ++ Requests == 60)
+            {
+                return -1;
+            }
+            
+            DeviceAnswer(Device, 'C');
+        }
+    }
+    
+    return -1;
+}
+
+/*
+ *  The Receive YModem Method will Read the Header Block ( Name and Size ),
+ *  the File as XMODEM Blocks, then the Empty Header ending the Batch.
+ */
+
+static int ReceiveYModem(Receiver * Device, char * FileName)
+{
+    BYTE Header[1024 + 1];
+    
+    Header[1024] = '\0';
+    
+    if (ReceiveBlocks(Device, 0, Header) != 0)
+    {
+        return -1;
+    }
+    
+    char * Copy = strdup(FileName);
+    
+    int SameName = strcmp((char *) Header, basename(Copy)) == 0;
+    
+    free(Copy);
+    
+    Device -> Announced = strtoull((char *) Header + strlen((char *) Header) + 1, NULL, 10);
+    
+    if (!SameName || ReceiveBlocks(Device, 1, NULL) != 0 || ReceiveBlocks(Device, 0, Header) != 0)
+    {
+        return -1;
+    }
+    
+    // A Header starting with a NULL Byte Ends the Batch
+    
+    return Header[0] == '\0' ? 0 : -1;
+}
+
+/*
+ *  The ZMODEM Byte Method will Read a Byte which may be Escaped with ZDLE,
+ *  skipping the Flow Control Bytes.
+ * 
+ *  Returns:
+ *          The Byte, 0x100 with the End of a Sub Packet, DEVICE_TIMEOUT or DEVICE_CANCELLED
+ */
+
+static int ZModemByte(Receiver * Device)
+{
+    int Byte;
+    
+    while ((Byte = DeviceByte(Device, TRANSFER_TIMEOUT)) >= 0)
+    {
+        if ((Byte & 0x7F) == 0x11 || (Byte & 0x7F) == 0x13)
+        {
+            continue;
+        }
+        
+        if (Byte != ZDLE)
+        {
+            return Byte;
+        }
+        
+        int Cancels = 1;
+        
+        while ((Byte = DeviceByte(Device, TRANSFER_TIMEOUT)) == CAN)
+        {
+            if (++ Cancels == 5)
+            {
+                return DEVICE_CANCELLED;
+            }
+        }
+        
+        if (Byte < 0)
+        {
+            return DEVICE_TIMEOUT;
+        }
+        
+        if (Byte >= ZCRCE && Byte <= ZCRCW)
+        {
+            return 0x100 | Byte;
+        }
+        
+        // ZRUB0 and ZRUB1
+        
+        if (Byte == 'l' || Byte == 'm')
+        {
+            return Byte == 'l' ? 0x7F : 0xFF;
+        }
+        
+        return Byte ^ 0x40;
+    }
+    
+    return DEVICE_TIMEOUT;
+}
+
+static int ZModemHex(Receiver * Device)
+{
+    int Value = 0, Counter;
+    
+    for (Counter = 0; Counter < 2; Counter ++)
+    {
+        int Byte = DeviceByte(Device, TRANSFER_TIMEOUT);
+        
+        if (Byte >= '0' && Byte <= '9')
+        {
+            Value = (Value << 4) | (Byte - '0');
+        }
+        else if (Byte >= 'a' && Byte <= 'f')
+        {
+            Value = (Value << 4) | (Byte - 'a' + 10);
+        }
+        else
+        {
+            return -1;
+        }
+    }
+    
+    return Value;
+}
+
+/*
+ *  The ZMODEM Header Method will wait for the Next Valid Header from the Sender,
+ *  skipping anything else, such as the rz Command or a Stream being Rewound.
+ * 
+ *  Returns:
+ *          The Frame Type, DEVICE_TIMEOUT or DEVICE_CANCELLED
+ */
+
+static int ZModemHeader(Receiver * Device, BYTE Position[4])
+{
+    QWORD Start = Monotonic();
+    
+    int Cancels = 0;
+    
+    while (Monotonic() - Start < TRANSFER_TIMEOUT * 1000000ULL)
+    {
+        int Byte = DeviceByte(Device, TRANSFER_TIMEOUT);
+        
+        Cancels = Byte == CAN ? Cancels + 1 : 0;
+        
+        if (Byte == DEVICE_TIMEOUT || Cancels == 5)
+        {
+            return Byte == DEVICE_TIMEOUT ? DEVICE_TIMEOUT : DEVICE_CANCELLED;
+        }
+        
+        if (Byte != ZPAD)
+        {
+            continue;
+        }
+        
+        while ((Byte = DeviceByte(Device, TRANSFER_TIMEOUT)) == ZPAD)
+        {
+        }
+        
+        if (Byte != ZDLE)
+        {
+            continue;
+        }
+        
+        int Format = DeviceByte(Device, TRANSFER_TIMEOUT);
+        
+        if (Format != ZHEX && Format != ZBIN && Format != ZBIN32)
+        {
+            continue;
+        }
+        
+        BYTE Header[9];
+        
+        int Counter, Length = Format == ZBIN32 ? 9 : 7, Value = 0;
+        
+        for (Counter = 0; Counter < Length && Value >= 0 && Value <= 0xFF; Counter ++)
+        {
+            Value = Format == ZHEX ? ZModemHex(Device) : ZModemByte(Device);
+            
+            if (Value == DEVICE_CANCELLED)
+            {
+                return DEVICE_CANCELLED;
+            }
+            
+            Header[Counter] = Value;
+        }
+        
+        if (Value < 0 || Value > 0xFF)
+        {
+            continue;
+        }
+        
+        int Valid;
+        
+        if (Format == ZBIN32)
+        {
+            DWORD Checksum = Crc32(0, Header, 5);
+            
+            Valid = Header[5] == (BYTE) Checksum && Header[6] == (BYTE) (Checksum >> 8) &&
+                    Header[7] == (BYTE) (Checksum >> 16) && Header[8] == (BYTE) (Checksum >> 24);
+        }
+        else
+        {
+            WORD Checksum = Crc16(0, Header, 5);
+            
+            Valid = Header[5] == (Checksum >> 8) && Header[6] == (Checksum & 0xFF);
+        }
+        
+        if (Valid)
+        {
+            Device -> Crc32 = Format == ZBIN32;
+            
+            memcpy(Position, Header + 1, 4);
+            
+            return Header[0];
+        }
+    }
+    
+    return DEVICE_TIMEOUT;
+}
+
+// Sends a Hex Header, with a Position ( or the Flags ) Least Significant Byte first
+
+static void ZModemAnswer(Receiver * Device, BYTE Type, QWORD Position, BYTE Flags)
+{
+    BYTE Header[5] = { Type, Position, Position >> 8, Position >> 16, (Position >> 24) | Flags };
+    
+    WORD Checksum = Crc16(0, Header, 5);
+    
+    char Buffer[32];
+    
+    int Length = snprintf(Buffer, sizeof(Buffer), "%c%c%c%c%02x%02x%02x%02x%02x%02x%02x\r\x8a", ZPAD, ZPAD, ZDLE, ZHEX,
+                          Header[0], Header[1], Header[2], Header[3], Header[4], Checksum >> 8, Checksum & 0xFF);
+    
+    DeviceSend(Device, Buffer, Length);
+}
+
+/*
+ *  The ZMODEM Sub Packet Method will Read a Sub Packet and Check it with the
+ *  Checksum of the Header before it.
+ * 
+ *  Returns:
+ *          The End of the Sub Packet ( ZCRCE, ZCRCG, ZCRCQ or ZCRCW ), -1 if Damaged or Cut, or DEVICE_CANCELLED
+ */
+
+static int ZModemSubPacket(Receiver * Device, BYTE * Packet, int * Count)
+{
+    int Byte;
+    
+    *Count = 0;
+    
+    while ((Byte = ZModemByte(Device)) >= 0 && Byte < 0x100)
+    {
+        if (*Count == 1024)
+        {
+            return -1;
+        }
+        
+        Packet[(*Count) ++] = Byte;
+    }
+    
+    if (Byte < 0)
+    {
+        return Byte == DEVICE_CANCELLED ? DEVICE_CANCELLED : -1;
+    }
+    
+    BYTE End = Byte & 0xFF, Trailer[4];
+    
+    int Counter;
+    
+    for (Counter = 0; Counter < (Device -> Crc32 ? 4 : 2); Counter ++)
+    {
+        if ((Byte = ZModemByte(Device)) < 0 || Byte > 0xFF)
+        {
+            return Byte == DEVICE_CANCELLED ? DEVICE_CANCELLED : -1;
+        }
+        
+        Trailer[Counter] = Byte;
+    }
+    
+    if (DamageNext(Device) && *Count > 0)
+    {
+        Packet[*Count / 2] ^= 0x01;
+    }
+    
+    if (Device -> Crc32)
+    {
+        DWORD Checksum = Crc32(Crc32(0, Packet, *Count), &End, 1);
+        
+        return Trailer[0] == (BYTE) Checksum && Trailer[1] == (BYTE) (Checksum >> 8) && Trailer[2] == (BYTE) (Checksum >> 16) &&
+               Trailer[3] == (BYTE) (Checksum >> 24) ? End : -1;
+    }
+    
+    WORD Checksum = Crc16(Crc16(0, Packet, *Count), &End, 1);
+    
+    return Trailer[0] == (Checksum >> 8) && Trailer[1] == (Checksum & 0xFF) ? End : -1;
+}
+
+/*
+ *  The Receive ZModem Method will play a ZMODEM Receiver : it Answers ZRQINIT
+ *  with ZRINIT ( CRC32, no Buffer Limit ), Accepts the Offered File, Stores
+ *  the Stream and asks to Resume with ZRPOS from the first Damaged Sub
+ *  Packet, Acks every ZCRCQ and ZCRCW, and Closes the Session on ZFIN.
+ */
+
+static int ReceiveZModem(Receiver * Device)
+{
+    static BYTE Packet[1024 + 1];
+    
+    BYTE Position[4];
+    
+    int Count, Errors = 0, Offered = 0;
+    
+    while (Errors < TRANSFER_RETRIES)
+    {
+        int Type = ZModemHeader(Device, Position);
+        
+        QWORD Offset = Position[0] | (Position[1] << 8) | (Position[2] << 16) | ((DWORD) Position[3] << 24);
+        
+        if (Type < 0)
+        {
+            return -1;
+        }
+        
+        if (Type == ZRQINIT)
+        {
+            ZModemAnswer(Device, ZRINIT, 0, RECEIVER_FLAGS);
+        }
+        else if (Type == ZFILE)
+        {
+            // The File's Information : the Name, then the Size, Time and Mode
+            
+            int End = ZModemSubPacket(Device, Packet, &Count);
+            
+            if (End == DEVICE_CANCELLED)
+            {
+                return -1;
+            }
+            
+            if (End < 0)
+            {
+                Device -> Rejected ++;
+                
+                Errors ++;
+                
+                ZModemAnswer(Device, ZRINIT, 0, RECEIVER_FLAGS);
+                
+                continue;
+            }
+            
+            Packet[Count] = '\0';
+            
+            Device -> Announced = strtoull((char *) Packet + strlen((char *) Packet) + 1, NULL, 10);
+            
+            Offered = 1;
+            
+            ZModemAnswer(Device, ZRPOS, Device -> Size, 0);
+        }
+        else if (Type == ZDATA && Offered && Offset != Device -> Size)
+        {
+            ZModemAnswer(Device, ZRPOS, Device -> Size, 0);
+        }
+        else if (Type == ZDATA && Offered)
+        {
+            int End;
+            
+            do
+            {
+                End = ZModemSubPacket(Device, Packet, &Count);
+                
+                if (End == DEVICE_CANCELLED)
+                {
+                    return -1;
+                }
+                
+                if (End < 0)
+                {
+                    Device -> Rejected ++;
+                    
+                    Errors ++;
+                    
+                    ZModemAnswer(Device, ZRPOS, Device -> Size, 0);
+                    
+                    break;
+                }
+                
+                Errors = 0;
+                
+                if (Store(Device, Packet, Count) != 0)
+                {
+                    return -1;
+                }
+                
+                if (End == ZCRCQ || End == ZCRCW)
+                {
+                    ZModemAnswer(Device, ZACK, Device -> Size, 0);
+                }
+            }
+            while (End == ZCRCG || End == ZCRCQ);
+        }
+        else if (Type == ZEOF && Offered && Offset == Device -> Size)
+        {
+            // An End Sent before the Sender Read the Last ZRPOS is Ignored, as the Standard asks
+            
+            ZModemAnswer(Device, ZRINIT, 0, RECEIVER_FLAGS);
+        }
+        else if (Type == ZFIN)
+        {
+            ZModemAnswer(Device, ZFIN, 0, 0);
+            
+            // Over and Out
+            
+            DeviceByte(Device, 1000);
+            DeviceByte(Device, 1000);
+            
+            return Offered ? 0 : -1;
+        }
+    }
+    
+    return -1;
+}
+
+/*
+ *  The Run Transfer Method will Upload a File with the Serial Connector on a
+ *  Pseudo Terminal, Receive it on the Master and Compare it with the File.
+ * 
+ *  Parameters:
+ *          The Path of the Serial Connector
+ *          A Char Array with the Name of the File
+ *          The Protocol ( See Transfer.h )
+ *          Every how many Blocks one is Damaged, 0 for none
+ * 
+ *  Returns:
+ *          0 if the File arrived Intact and the Connector Succeeded, -1 otherwise
+ */
+
+int RunTransfer(char * SerialPath, char * FileName, int Protocol, DWORD Damage)
+{
+    // The Standard Check Values of CRC-16/XMODEM and CRC-32, over "123456789"
+    
+    if (Crc16(0, (BYTE *) "123456789", 9) != 0x31C3 || Crc32(0, (BYTE *) "123456789", 9) != 0xCBF43926)
+    {
+        puts("The Checksums do not match the Standard Check Values");
+        
+        return -1;
+    }
+    
+    QWORD Size;
+    
+    BYTE * Original = MapFile(FileName, &Size);
+    
+    char SlaveName[256];
+    
+    int Slave;
+    
+    int Master = OpenDevice(SlaveName, sizeof(SlaveName), &Slave);
+    
+    if (Master < 0)
+    {
+        puts("Cannot Create the Pseudo Terminal");
+        
+        return -1;
+    }
+    
+    static Receiver Device;
+    
+    memset(&Device, 0, sizeof(Device));
+    
+    Device.Master = Master;
+    Device.Damage = Damage;
+    
+    // XMODEM Pads the Last Block
+    
+    Device.Capacity = Size + 1024;
+    Device.Data = malloc(Device.Capacity);
+    
+    if (Device.Data == NULL)
+    {
+        puts("Error Allocating Memory");
+        exit(-1);
+    }
+    
+    printf("Transfer  : %s, %llu Bytes, ", TransferNames[Protocol], (unsigned long long) Size);
+    
+    if (Damage)
+    {
+        printf("One Block in %u Damaged \r\n", Damage);
+    }
+    else
+    {
+        printf("Undamaged \r\n");
+    }
+    
+    fflush(stdout);
+    
+    char * Arguments[] = { SerialPath, "-Send", FileName, "-Protocol", SenderNames[Protocol], SlaveName, "115200", NULL };
+    
+    pid_t Child = fork();
+    
+    if (Child == 0)
+    {
+        execv(SerialPath, Arguments);
+        
+        _exit(127);
+    }
+    
+    QWORD Start = Monotonic();
+    
+    int Result;
+    
+    if (Protocol == PROTOCOL_XMODEM)
+    {
+        Result = ReceiveBlocks(&Device, 1, NULL);
+    }
+    else if (Protocol == PROTOCOL_YMODEM)
+    {
+        Result = ReceiveYModem(&Device, FileName);
+    }
+    else
+    {
+        Result = ReceiveZModem(&Device);
+    }
+    
+    double Seconds = (Monotonic() - Start) / 1e9;
+    
+    // A Failed Receiver Cancels, so that the Connector does not wait for it
+    
+    if (Result != 0)
+    {
+        static const BYTE Abort[] = { CAN, CAN, CAN, CAN, CAN, CAN, CAN, CAN };
+        
+        DeviceSend(&Device, Abort, sizeof(Abort));
+    }
+    
+    int Status;
+    
+    waitpid(Child, &Status, 0);
+    
+    close(Master);
+    close(Slave);
+    
+    // XMODEM and YMODEM Pad the Last Block with CPMEOF, ZMODEM Sends the Exact Size
+    
+    QWORD Padding = Device.Size > Size ? Device.Size - Size : 0;
+    
+    int Intact = Device.Size >= Size && memcmp(Device.Data, Original, Size) == 0;
+    
+    QWORD Counter;
+    
+    for (Counter = Size; Counter < Device.Size && Intact; Counter ++)
+    {
+        Intact = Device.Data[Counter] == CPMEOF && Protocol != PROTOCOL_ZMODEM && Padding < 1024;
+    }
+    
+    if (Protocol != PROTOCOL_XMODEM && Device.Announced != Size)
+    {
+        Intact = 0;
+    }
+    
+    UnmapFile(Original, Size);
+    
+    free(Device.Data);
+    
+    printf("\r\nReceived  : %llu Bytes ( %llu Padding ) in %.3f Seconds, %.2f MB/s \r\n", (unsigned long long) Device.Size,
+           (unsigned long long) Padding, Seconds, Seconds > 0 ? Device.Size / (1024.0 * 1024.0) / Seconds : 0);
+    
+    printf("Blocks    : %llu, %llu Damaged, %llu Rejected \r\n", (unsigned long long) Device.Blocks, (unsigned long long) Device.Damaged,
+           (unsigned long long) Device.Rejected);
+    
+    printf("File      : %s \r\n", Result == 0 && Intact ? "Identical" : "Different");
+    
+    printf("Connector : Exit Status %d \r\n", WIFEXITED(Status) ? WEXITSTATUS(Status) : -1);
+    
+    return Result == 0 && Intact && WIFEXITED(Status) && WEXITSTATUS(Status) == 0 ? 0 : -1;
+}
@@ -0,0 +1,860 @@
+/* Serial Hub */
+
+#define _GNU_SOURCE
+
+#include <errno.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/resource.h>
+#include <sys/signalfd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#include "../Headers/Common.h"
+#include "../Headers/SerialHub.h"
+
+// The Maximum Length of a Hub Line
+
+#define LINE_LENGTH 4096
+
+// The Largest Chunk Read from a Port or a Client at once
+
+#define HUB_CHUNK (64 * 1024)
+
+// Seconds between two Attempts to Open a Port which went away
+
+#define HUB_RETRY 2
+
+// The Socket Buffer of each Client, a Client which lets it Fill up is Detached
+
+#define CLIENT_BUFFER (1024 * 1024)
+
+// The Bytes Queued for a Port which does not Drain, more Input is Dropped
+
+#define PORT_QUEUE (64 * 1024)
+
+// What each epoll Event belongs to, Stored with the Port's Index and the Descriptor
+
+#define EVENT_PORT      0
+#define EVENT_LISTENER  1
+#define EVENT_CLIENT    2
+#define EVENT_SIGNAL    3
+
+#define EVENT_DATA(Kind, Index, Descriptor) (((QWORD) (Descriptor) << 32) | ((QWORD) (Index) << 2) | (Kind))
+
+// Where the Trigger Replies of a Port are Queued
+
+typedef struct
+{
+    int Loop;
+    
+    HubPort * Port;
+    
+    int Index;
+
+} HubOutput;
+
+static QWORD Seconds()
+{
+    struct timespec Now;
+    
+    clock_gettime(CLOCK_MONOTONIC, &Now);
+    
+    return Now.tv_sec;
+}
+
+/*
+ *  The Load Hub Method will read a Hub File. The Format is described inside
+ *  the Serial Hub Header File. Any Syntax Error ends the Application.
+ * 
+ *  Parameters:
+ *          A Char Array with the Name of the Hub File
+ * 
+ *  Returns:
+ *          The Hub, with every Port Closed
+ */
+
+Hub LoadHub(char * FileName)
+{
+    FILE * File = FileOpener(FileName, "r");
+    
+    Hub Ports = { NULL, 0, { STAMP_NONE, 0, 0, HUB_RING_SIZE }, NULL };
+    
+    char * TriggerFile = NULL;
+    
+    FILE * Events = stderr;
+    
+    int LineNumber = 0;
+    
+    char Line[LINE_LENGTH];
+    
+    while (fgets(Line, LINE_LENGTH, File))
+    {
+        LineNumber ++;
+        
+        // Remove Comments
+        
+        Line[strcspn(Line, "#")] = '\0';
+        
+        char * Fields[7];
+        
+        int FieldCount = 0;
+        
+        char * Field = strtok(Line, " \t\r\n");
+        
+        while (Field && FieldCount < 7)
+        {
+            Fields[FieldCount ++] = Field;
+            
+            Field = strtok(NULL, " \t\r\n");
+        }
+        
+        if (FieldCount == 0)
+        {
+            continue;
+        }
+        
+        // The Logging Lines
+        
+        if (strcmp(Fields[0], "Rotate") == 0 && FieldCount <= 3)
+        {
+            if (FieldCount < 2)
+            {
+                printf("Line %d : Expected Rotate <Size> [Seconds] \r\n", LineNumber);
+                exit(-1);
+            }
+            
+            Ports.Logging.MaximumSize = ParseSize(Fields[1]);
+            Ports.Logging.MaximumAge = FieldCount == 3 ? ParseSize(Fields[2]) : 0;
+            
+            continue;
+        }
+        
+        if (strcmp(Fields[0], "Stamp") == 0 && FieldCount == 2)
+        {
+            if (strcmp(Fields[1], "lines") == 0)
+            {
+                Ports.Logging.Timestamps = STAMP_LINES;
+            }
+            else if (strcmp(Fields[1], "chunks") == 0)
+            {
+                Ports.Logging.Timestamps = STAMP_CHUNKS;
+            }
+            else if (strcmp(Fields[1], "none") == 0)
+            {
+                Ports.Logging.Timestamps = STAMP_NONE;
+            }
+            else
+            {
+                printf("Line %d : Expected Stamp none|lines|chunks \r\n", LineNumber);
+                exit(-1);
+            }
+            
+            continue;
+        }
+        
+        if (strcmp(Fields[0], "Ring") == 0 && FieldCount == 2)
+        {
+            QWORD Size = ParseSize(Fields[1]);
+            
+            if (Size < 4096 || (Size & (Size - 1)) != 0)
+            {
+                printf("Line %d : The Ring Size has to be a Power of Two, 4K or more \r\n", LineNumber);
+                exit(-1);
+            }
+            
+            Ports.Logging.RingSize = Size;
+            
+            continue;
+        }
+        
+        if (strcmp(Fields[0], "Triggers") == 0 && FieldCount == 2)
+        {
+            free(TriggerFile);
+            
+            TriggerFile = strdup(Fields[1]);
+            
+            continue;
+        }
+        
+        if (strcmp(Fields[0], "Events") == 0 && FieldCount == 2)
+        {
+            if ((Events = fopen(Fields[1], "a")) == NULL)
+            {
+                printf("Line %d : Cannot Open %s \r\n", LineNumber, Fields[1]);
+                exit(-1);
+            }
+            
+            setvbuf(Events, NULL, _IOLBF, 0);
+            
+            continue;
+        }
+        
+        if (FieldCount < 4 || FieldCount > 6)
+        {
+            printf("Line %d : Expected <Port> <Baud Rate> <Log File> <Socket> [Format] [Flow] \r\n", LineNumber);
+            exit(-1);
+        }
+        
+        Ports.Ports = realloc(Ports.Ports, (Ports.Count + 1) * sizeof(HubPort));
+        
+        if (Ports.Ports == NULL)
+        {
+            puts("Error Allocating Memory");
+            exit(-1);
+        }
+        
+        HubPort * Port = &Ports.Ports[Ports.Count ++];
+        
+        SerialSettings Defaults = SERIAL_DEFAULTS;
+        
+        memset(Port, 0, sizeof(HubPort));
+        
+        Port -> Settings = Defaults;
+        
+        char * End;
+        
+        unsigned long Rate = strtoul(Fields[1], &End, 10);
+        
+        if (*End != '\0' || Rate == 0 || Rate > 0xFFFFFFFF)
+        {
+            printf("Line %d : Invalid Baud Rate %s \r\n", LineNumber, Fields[1]);
+            exit(-1);
+        }
+        
+        Port -> Settings.BaudRate = Rate;
+        
+        if (FieldCount > 4 && ParseSerialFormat(Fields[4], &Port -> Settings) != 0)
+        {
+            printf("Line %d : Invalid Format %s \r\n", LineNumber, Fields[4]);
+            exit(-1);
+        }
+        
+        if (FieldCount > 5 && ParseFlowControl(Fields[5], &Port -> Settings) != 0)
+        {
+            printf("Line %d : Invalid Flow Control %s \r\n", LineNumber, Fields[5]);
+            exit(-1);
+        }
+        
+        if (strlen(Fields[3]) >= sizeof(((struct sockaddr_un *) 0) -> sun_path))
+        {
+            printf("Line %d : The Socket Path is too Long \r\n", LineNumber);
+            exit(-1);
+        }
+        
+        Port -> PortName = strdup(Fields[0]);
+        Port -> LogFile = strdup(Fields[2]);
+        Port -> SocketPath = strdup(Fields[3]);
+        
+        Port -> Descriptor = -1;
+        Port -> Listener = -1;
+    }
+    
+    fclose(File);
+    
+    // The Triggers are Loaded last, once the Events Output is known
+    
+    if (TriggerFile)
+    {
+        Ports.Triggers = malloc(sizeof(TriggerSet));
+        
+        LoadTriggers(Ports.Triggers, TriggerFile, Events);
+        
+        free(TriggerFile);
+    }
+    
+    return Ports;
+}
+
+/*
+ *  The Open Port Method will Open a Port and add it to the Loop. When it
+ *  fails, the Port is Retried after HUB_RETRY Seconds.
+ */
+
+static void OpenPort(int Loop, HubPort * Port, int Index)
+{
+    Port -> Descriptor = OpenSerialPort(Port -> PortName, &Port -> Settings);
+    
+    if (Port -> Descriptor < 0)
+    {
+        Port -> RetryAt = Seconds() + HUB_RETRY;
+        
+        return;
+    }
+    
+    struct epoll_event Event = { EPOLLIN, { .u64 = EVENT_DATA(EVENT_PORT, Index, Port -> Descriptor) } };
+    
+    epoll_ctl(Loop, EPOLL_CTL_ADD, Port -> Descriptor, &Event);
+    
+    printf("%s Opened at %u Baud \r\n", Port -> PortName, ActualBaudRate(Port -> Descriptor));
+}
+
+static void ClosePort(int Loop, HubPort * Port)
+{
+    epoll_ctl(Loop, EPOLL_CTL_DEL, Port -> Descriptor, NULL);
+    
+    close(Port -> Descriptor);
+    
+    Port -> Descriptor = -1;
+    
+    // What was Queued was meant for the Target which went away
+    
+    Port -> Queued = 0;
+    
+    Port -> RetryAt = Seconds() + HUB_RETRY;
+    
+    printf("%s Lost, Retrying every %d Seconds \r\n", Port -> PortName, HUB_RETRY);
+}
+
+/*
+ *  The Watch Port Method will have the Loop Report when the Port can take
+ *  more Bytes, only while some are Queued.
+ */
+
+static void WatchPort(int Loop, HubPort * Port, int Index, int Writing)
+{
+    struct epoll_event Event = { EPOLLIN | (Writing ? EPOLLOUT : 0), { .u64 = EVENT_DATA(EVENT_PORT, Index, Port -> Descriptor) } };
+    
+    epoll_ctl(Loop, EPOLL_CTL_MOD, Port -> Descriptor, &Event);
+}
+
+/*
+ *  The Queue Output Method will Type Bytes on a Port without ever Waiting
+ *  on it : what the Port does not Take at once is Queued, and Written as
+ *  it Drains. Input sent while the Port is Closed is Dropped.
+ * 
+ *  Parameters:
+ *          The Loop, the Port and it's Index
+ *          The Bytes and their Length
+ * 
+ *  Returns:
+ *          0 on Success, -1 when the Queue is Full and Nothing was Typed
+ */
+
+static int QueueOutput(int Loop, HubPort * Port, int Index, const BYTE * Data, QWORD Length)
+{
+    if (Port -> Descriptor < 0)
+    {
+        return 0;
+    }
+    
+    if (Port -> Queued + Length > PORT_QUEUE)
+    {
+        return -1;
+    }
+    
+    ssize_t Written = 0;
+    
+    // Bytes are only Written straight away when Nothing is Queued before them
+    
+    if (Port -> Queued == 0)
+    {
+        Written = write(Port -> Descriptor, Data, Length);
+        
+        if (Written < 0 && errno != EAGAIN && errno != EINTR)
+        {
+            ClosePort(Loop, Port);
+            
+            return 0;
+        }
+        
+        Written = Written > 0 ? Written : 0;
+    }
+    
+    if ((QWORD) Written < Length)
+    {
+        if (Port -> Queue == NULL && (Port -> Queue = malloc(PORT_QUEUE)) == NULL)
+        {
+            return -1;
+        }
+        
+        if (Port -> Queued == 0)
+        {
+            WatchPort(Loop, Port, Index, 1);
+        }
+        
+        memcpy(Port -> Queue + Port -> Queued, Data + Written, Length - Written);
+        
+        Port -> Queued += Length - Written;
+    }
+    
+    return 0;
+}
+
+static int QueueReply(const BYTE * Data, QWORD Length, void * Context)
+{
+    HubOutput * Output = Context;
+    
+    return QueueOutput(Output -> Loop, Output -> Port, Output -> Index, Data, Length);
+}
+
+static void FlushPort(int Loop, HubPort * Port, int Index)
+{
+    ssize_t Written = write(Port -> Descriptor, Port -> Queue, Port -> Queued);
+    
+    if (Written < 0)
+    {
+        if (errno != EAGAIN && errno != EINTR)
+        {
+            ClosePort(Loop, Port);
+        }
+        
+        return;
+    }
+    
+    Port -> Queued -= Written;
+    
+    memmove(Port -> Queue, Port -> Queue + Written, Port -> Queued);
+    
+    if (Port -> Queued == 0)
+    {
+        WatchPort(Loop, Port, Index, 0);
+    }
+}
+
+/*
+ *  The Open Listener Method will create the Port's Unix Socket, replacing
+ *  one left behind by an earlier Run.
+ */
+
+static int OpenListener(int Loop, HubPort * Port, int Index)
+{
+    struct sockaddr_un Address;
+    
+    memset(&Address, 0, sizeof(Address));
+    
+    Address.sun_family = AF_UNIX;
+    
+    strcpy(Address.sun_path, Port -> SocketPath);
+    
+    unlink(Port -> SocketPath);
+    
+    Port -> Listener = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    
+    if (Port -> Listener < 0 || bind(Port -> Listener, (struct sockaddr *) &Address, sizeof(Address)) != 0 || listen(Port -> Listener, 16) != 0)
+    {
+        return -1;
+    }
+    
+    struct epoll_event Event = { EPOLLIN, { .u64 = EVENT_DATA(EVENT_LISTENER, Index, Port -> Listener) } };
+    
+    return epoll_ctl(Loop, EPOLL_CTL_ADD, Port -> Listener, &Event);
+}
+
+static void AcceptClient(int Loop, HubPort * Port, int Index)
+{
+    int Client = accept4(Port -> Listener, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC);
+    
+    if (Client < 0)
+    {
+        return;
+    }
+    
+    if (Port -> ClientCount == Port -> ClientSpace)
+    {
+        Port -> ClientSpace = Port -> ClientSpace ? Port -> ClientSpace * 2 : 4;
+        
+        Port -> Clients = realloc(Port -> Clients, Port -> ClientSpace * sizeof(int));
+    }
+    
+    int Size = CLIENT_BUFFER;
+    
+    setsockopt(Client, SOL_SOCKET, SO_SNDBUF, &Size, sizeof(Size));
+    
+    struct epoll_event Event = { EPOLLIN, { .u64 = EVENT_DATA(EVENT_CLIENT, Index, Client) } };
+    
+    epoll_ctl(Loop, EPOLL_CTL_ADD, Client, &Event);
+    
+    Port -> Clients[Port -> ClientCount ++] = Client;
+    
+    char Greeting[256];
+    
+    int Length = snprintf(Greeting, sizeof(Greeting), "Attached to %s ( %s ) \r\n", Port -> PortName,
+                          Port -> Descriptor < 0 ? "Closed, Retrying" : "Open");
+    
+    send(Client, Greeting, Length, MSG_DONTWAIT | MSG_NOSIGNAL);
+}
+
+static int IsAttached(HubPort * Port, int Client)
+{
+    int Counter;
+    
+    for (Counter = 0; Counter < Port -> ClientCount; Counter ++)
+    {
+        if (Port -> Clients[Counter] == Client)
+        {
+            return 1;
+        }
+    }
+    
+    return 0;
+}
+
+static void DetachClient(int Loop, HubPort * Port, int Client)
+{
+    int Counter;
+    
+    for (Counter = 0; Counter < Port -> ClientCount; Counter ++)
+    {
+        if (Port -> Clients[Counter] == Client)
+        {
+            Port -> Clients[Counter] = Port -> Clients[-- Port -> ClientCount];
+            
+            break;
+        }
+    }
+    
+    epoll_ctl(Loop, EPOLL_CTL_DEL, Client, NULL);
+    
+    close(Client);
+}
+
+/*
+ *  The Read Port Method will Log what the Port has, and hand it to every
+ *  Client. A Client whose Socket is Full is Detached rather than Waited on.
+ */
+
+static void ReadPort(int Loop, HubPort * Port, int Index, TriggerSet * Triggers)
+{
+    static BYTE Buffer[HUB_CHUNK];
+    
+    ssize_t Length = read(Port -> Descriptor, Buffer, HUB_CHUNK);
+    
+    if (Length <= 0)
+    {
+        if (Length == 0 || (errno != EAGAIN && errno != EINTR))
+        {
+            ClosePort(Loop, Port);
+        }
+        
+        return;
+    }
+    
+    Port -> Bytes += Length;
+    
+    LogData(Port -> Log, Buffer, Length);
+    
+    if (Triggers)
+    {
+        HubOutput Output = { Loop, Port, Index };
+        
+        MatchTriggers(Triggers, &Port -> Matching, QueueReply, &Output, Buffer, Length);
+    }
+    
+    int Counter = 0;
+    
+    while (Counter < Port -> ClientCount)
+    {
+        int Client = Port -> Clients[Counter];
+        
+        if (send(Client, Buffer, Length, MSG_DONTWAIT | MSG_NOSIGNAL) != Length)
+        {
+            // The Last Client takes this Slot, so the Counter stays
+            
+            DetachClient(Loop, Port, Client);
+            
+            continue;
+        }
+        
+        Counter ++;
+    }
+}
+
+/*
+ *  The Read Client Method will Type what a Client sent on the Port. Input
+ *  sent while the Port is Closed, or while it's Queue is Full, is Dropped
+ *  and the Client is Told so.
+ */
+
+static void ReadClient(int Loop, HubPort * Port, int Index, int Client)
+{
+    static BYTE Buffer[HUB_CHUNK];
+    
+    ssize_t Length = read(Client, Buffer, HUB_CHUNK);
+    
+    if (Length <= 0)
+    {
+        if (Length == 0 || (errno != EAGAIN && errno != EINTR))
+        {
+            DetachClient(Loop, Port, Client);
+        }
+        
+        return;
+    }
+    
+    if (QueueOutput(Loop, Port, Index, Buffer, Length) != 0)
+    {
+        char Notice[256];
+        
+        int Size = snprintf(Notice, sizeof(Notice), "\r\n%s is not Taking Data, %d Bytes Dropped \r\n", Port -> PortName, (int) Length);
+        
+        send(Client, Notice, Size, MSG_DONTWAIT | MSG_NOSIGNAL);
+    }
+}
+
+/*
+ *  The Raise Limit Method will allow as many Descriptors as the System lets
+ *  the Process have, each Port needs a few of them.
+ */
+
+static void RaiseLimit()
+{
+    struct rlimit Limit;
+    
+    if (getrlimit(RLIMIT_NOFILE, &Limit) == 0 && Limit.rlim_cur < Limit.rlim_max)
+    {
+        Limit.rlim_cur = Limit.rlim_max;
+        
+        setrlimit(RLIMIT_NOFILE, &Limit);
+    }
+}
+
+/*
+ *  The Run Hub Method will Open every Port, Log and Socket, then Serve them
+ *  from a single epoll Loop until SIGINT, SIGTERM or SIGHUP is Received.
+ *  The Signals arrive through a signalfd, as any other Event.
+ * 
+ *  Parameters:
+ *          The Hub
+ * 
+ *  Returns:
+ *          0 when Stopped by a Signal, -1 if the Hub could not Start
+ */
+
+int RunHub(Hub * Ports)
+{
+    RaiseLimit();
+    
+    int Loop = epoll_create1(EPOLL_CLOEXEC);
+    
+    sigset_t Signals, Saved;
+    
+    sigemptyset(&Signals);
+    sigaddset(&Signals, SIGINT);
+    sigaddset(&Signals, SIGTERM);
+    sigaddset(&Signals, SIGHUP);
+    
+    sigprocmask(SIG_BLOCK, &Signals, &Saved);
+    
+    int Stop = signalfd(-1, &Signals, SFD_CLOEXEC);
+    
+    struct epoll_event Event = { EPOLLIN, { .u64 = EVENT_DATA(EVENT_SIGNAL, 0, Stop) } };
+    
+    if (Loop < 0 || Stop < 0 || epoll_ctl(Loop, EPOLL_CTL_ADD, Stop, &Event) != 0)
+    {
+        puts("Cannot Start the Event Loop");
+        
+        return -1;
+    }
+    
+    int Counter;
+    
+    for (Counter = 0; Counter < Ports -> Count; Counter ++)
+    {
+        HubPort * Port = &Ports -> Ports[Counter];
+        
+        Port -> Log = OpenSerialLog(Port -> LogFile, &Ports -> Logging);
+        
+        ResetTriggers(&Port -> Matching, Port -> PortName);
+        
+        if (Port -> Log == NULL || OpenListener(Loop, Port, Counter) != 0)
+        {
+            printf("Cannot Create %s or %s \r\n", Port -> LogFile, Port -> SocketPath);
+            
+            return -1;
+        }
+        
+        OpenPort(Loop, Port, Counter);
+        
+        if (Port -> Descriptor < 0)
+        {
+            printf("Cannot Open %s, Retrying every %d Seconds \r\n", Port -> PortName, HUB_RETRY);
+        }
+    }
+    
+    printf("Watching %d Ports, Send SIGTERM to Stop \r\n", Ports -> Count);
+    
+    fflush(stdout);
+    
+    struct epoll_event Events[64];
+    
+    int Running = 1;
+    
+    while (Running)
+    {
+        // Wake up every Second only while a Port is waiting to be Opened again
+        
+        int Waiting = 0;
+        
+        QWORD Now = Seconds();
+        
+        for (Counter = 0; Counter < Ports -> Count; Counter ++)
+        {
+            HubPort * Port = &Ports -> Ports[Counter];
+            
+            if (Port -> Descriptor < 0 && Now >= Port -> RetryAt)
+            {
+                OpenPort(Loop, Port, Counter);
+            }
+            
+            Waiting |= Port -> Descriptor < 0;
+        }
+        
+        fflush(stdout);
+        
+        int Count = epoll_wait(Loop, Events, 64, Waiting ? 1000 : -1);
+        
+        if (Count < 0 && errno != EINTR)
+        {
+            break;
+        }
+        
+        int Current;
+        
+        for (Current = 0; Current < Count; Current ++)
+        {
+            QWORD Data = Events[Current].data.u64;
+            
+            int Kind = Data & 3;
+            
+            int Descriptor = Data >> 32;
+            
+            HubPort * Port = &Ports -> Ports[(Data & 0xFFFFFFFF) >> 2];
+            
+            switch (Kind)
+            {
+                case EVENT_PORT:
+                    
+                    // The Port may have been Closed, or Opened again, by an earlier Event
+                    
+                    if (Port -> Descriptor == Descriptor && (Events[Current].events & EPOLLOUT))
+                    {
+                        FlushPort(Loop, Port, Port - Ports -> Ports);
+                    }
+                    
+                    if (Port -> Descriptor == Descriptor && (Events[Current].events & ~EPOLLOUT))
+                    {
+                        ReadPort(Loop, Port, Port - Ports -> Ports, Ports -> Triggers);
+                    }
+                    
+                    break;
+                
+                case EVENT_LISTENER:
+                    
+                    AcceptClient(Loop, Port, Port - Ports -> Ports);
+                    
+                    break;
+                
+                case EVENT_CLIENT:
+                    
+                    // The Client may have been Detached by an earlier Event
+                    
+                    if (IsAttached(Port, Descriptor))
+                    {
+                        ReadClient(Loop, Port, Port - Ports -> Ports, Descriptor);
+                    }
+                    
+                    break;
+                
+                default:
+                    
+                    // Consume the Signal, it would be Delivered once Unblocked otherwise
+                    
+                    {
+                        struct signalfd_siginfo Received;
+                        
+                        if (read(Stop, &Received, sizeof(Received)) == sizeof(Received))
+                        {
+                            printf("Signal %u Received \r\n", Received.ssi_signo);
+                        }
+                    }
+                    
+                    Running = 0;
+                    
+                    break;
+            }
+        }
+    }
+    
+    // Detach every Client, then Write whatever is still Queued
+    
+    QWORD Total = 0;
+    
+    for (Counter = 0; Counter < Ports -> Count; Counter ++)
+    {
+        HubPort * Port = &Ports -> Ports[Counter];
+        
+        while (Port -> ClientCount > 0)
+        {
+            DetachClient(Loop, Port, Port -> Clients[0]);
+        }
+        
+        close(Port -> Listener);
+        
+        unlink(Port -> SocketPath);
+        
+        if (Port -> Descriptor >= 0)
+        {
+            close(Port -> Descriptor);
+        }
+        
+        CloseSerialLog(Port -> Log);
+        
+        Total += Port -> Bytes;
+    }
+    
+    printf("Stopped, %llu Bytes Logged from %d Ports \r\n", (unsigned long long) Total, Ports -> Count);
+    
+    // The Cost per Chunk is Reported over every Port
+    
+    if (Ports -> Triggers)
+    {
+        TriggerState Overall;
+        
+        ResetTriggers(&Overall, "Hub");
+        
+        for (Counter = 0; Counter < Ports -> Count; Counter ++)
+        {
+            Overall.Chunks += Ports -> Ports[Counter].Matching.Chunks;
+            Overall.Nanoseconds += Ports -> Ports[Counter].Matching.Nanoseconds;
+            Overall.Dropped += Ports -> Ports[Counter].Matching.Dropped;
+        }
+        
+        PrintTriggerStats(Ports -> Triggers, &Overall);
+    }
+    
+    close(Stop);
+    close(Loop);
+    
+    sigprocmask(SIG_SETMASK, &Saved, NULL);
+    
+    return 0;
+}
+
+void FreeHub(Hub * Ports)
+{
+    int Counter;
+    
+    for (Counter = 0; Counter < Ports -> Count; Counter ++)
+    {
+        free(Ports -> Ports[Counter].PortName);
+        free(Ports -> Ports[Counter].LogFile);
+        free(Ports -> Ports[Counter].SocketPath);
+        free(Ports -> Ports[Counter].Clients);
+        free(Ports -> Ports[Counter].Queue);
+    }
+    
+    free(Ports -> Ports);
+    
+    if (Ports -> Triggers)
+    {
+        FreeTriggers(Ports -> Triggers);
+        
+        free(Ports -> Triggers);
+    }
+}
@@ -0,0 +1,447 @@
+/* Serial Logger */
+
+#define _GNU_SOURCE
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/eventfd.h>
+
+#include "../Headers/SerialLog.h"
+
+// Every Chunk inside the Ring starts with it's Time and Length
+
+#define RECORD_HEADER (sizeof(QWORD) + sizeof(DWORD))
+
+// The Logger waits this long after waking up, so that Chunks are Written in Batches
+
+#define BATCH_WINDOW_NS (20 * 1000 * 1000)
+
+// The Largest Buffer the Log Lines are Formatted in, Smaller Rings get a Quarter of their Size
+
+#define LOG_BUFFER_SIZE (256 * 1024)
+
+// The Logger's Stack, it only holds a few Names and Counters
+
+#define LOGGER_STACK (64 * 1024)
+
+static void * LoggerThread(void * Context);
+
+static QWORD Monotonic()
+{
+    struct timespec Now;
+    
+    clock_gettime(CLOCK_MONOTONIC, &Now);
+    
+    return (QWORD) Now.tv_sec * 1000000000ULL + Now.tv_nsec;
+}
+
+/*
+ *  The Open Serial Log Method will create the Log File and Start it's Logger.
+ * 
+ *  Parameters:
+ *          A Char Array with the Name of the Log File
+ *          The Log Settings
+ * 
+ *  Returns:
+ *          The Log, or NULL on Error
+ */
+
+SerialLog * OpenSerialLog(char * FileName, LogSettings * Settings)
+{
+    SerialLog * Log = calloc(1, sizeof(SerialLog));
+    
+    if (Log == NULL)
+    {
+        return NULL;
+    }
+    
+    Log -> FileName = FileName;
+    Log -> Settings = *Settings;
+    Log -> RingSize = Settings -> RingSize ? Settings -> RingSize : LOG_RING_SIZE;
+    Log -> BufferSize = Log -> RingSize / 4 < LOG_BUFFER_SIZE ? Log -> RingSize / 4 : LOG_BUFFER_SIZE;
+    Log -> Ring = malloc(Log -> RingSize);
+    Log -> AtLineStart = 1;
+    Log -> Start = Log -> Opened = Monotonic();
+    
+    Log -> Descriptor = open(FileName, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    
+    Log -> Event = eventfd(0, EFD_CLOEXEC);
+    
+    pthread_attr_t Attributes;
+    
+    pthread_attr_init(&Attributes);
+    pthread_attr_setstacksize(&Attributes, LOGGER_STACK);
+    
+    int Started = Log -> Ring && Log -> Descriptor >= 0 && Log -> Event >= 0 && pthread_create(&Log -> Thread, &Attributes, LoggerThread, Log) == 0;
+    
+    pthread_attr_destroy(&Attributes);
+    
+    if (!Started)
+    {
+        if (Log -> Descriptor >= 0)
+        {
+            close(Log -> Descriptor);
+        }
+        
+        if (Log -> Event >= 0)
+        {
+            close(Log -> Event);
+        }
+        
+        free(Log -> Ring);
+        free(Log);
+        
+        return NULL;
+    }
+    
+    return Log;
+}
+
+/*
+ *  The Ring Copy Method will copy Bytes inside the Ring, at a Position which
+ *  may Wrap around it's End. ( Direction 1 : To the Ring, 0 : From the Ring )
+ */
+
+static void RingCopy(SerialLog * Log, QWORD Position, BYTE * Data, QWORD Length, int ToRing)
+{
+    QWORD Offset = Position & (Log -> RingSize - 1);
+    
+    QWORD First = Log -> RingSize - Offset < Length ? Log -> RingSize - Offset : Length;
+    
+    if (ToRing)
+    {
+        memcpy(Log -> Ring + Offset, Data, First);
+        memcpy(Log -> Ring, Data + First, Length - First);
+    }
+    else
+    {
+        memcpy(Data, Log -> Ring + Offset, First);
+        memcpy(Data + First, Log -> Ring, Length - First);
+    }
+}
+
+static void WakeLogger(SerialLog * Log)
+{
+    QWORD One = 1;
+    
+    if (write(Log -> Event, &One, sizeof(One)) < 0)
+    {
+        // The Counter is already Non Zero, the Logger will Wake Up anyway
+    }
+}
+
+/*
+ *  The Log Data Method will Queue a Chunk for the Logger. It never Blocks on
+ *  the Disk. If the Ring is Full, the Reader Waits for the Logger instead of
+ *  Dropping Data, and the Stall is Counted.
+ * 
+ *  Parameters:
+ *          The Log
+ *          The Chunk and it's Length
+ * 
+ *  Returns:
+ *          VOID
+ */
+
+void LogData(SerialLog * Log, const BYTE * Data, QWORD Length)
+{
+    QWORD Time = Monotonic();
+    
+    // Chunks larger than the Ring are Queued in Pieces
+    
+    QWORD Largest = Log -> RingSize / 4;
+    
+    while (Length > 0)
+    {
+        DWORD Piece = Length < Largest ? Length : Largest;
+        
+        QWORD Head = atomic_load_explicit(&Log -> Head, memory_order_relaxed);
+        
+        // Wait for Space, the Logger is Woken so that it Drains the Ring at once
+        
+        if (RECORD_HEADER + Piece > Log -> RingSize - (Head - atomic_load_explicit(&Log -> Tail, memory_order_acquire)))
+        {
+            atomic_fetch_add(&Log -> Stalls, 1);
+            
+            WakeLogger(Log);
+            
+            while (RECORD_HEADER + Piece > Log -> RingSize - (Head - atomic_load_explicit(&Log -> Tail, memory_order_acquire)))
+            {
+                usleep(1000);
+            }
+        }
+        
+        RingCopy(Log, Head, (BYTE *) &Time, sizeof(Time), 1);
+        RingCopy(Log, Head + sizeof(Time), (BYTE *) &Piece, sizeof(Piece), 1);
+        RingCopy(Log, Head + RECORD_HEADER, (BYTE *) Data, Piece, 1);
+        
+        // Publish the Chunk, then Wake the Logger if it went to Sleep
+        
+        atomic_store_explicit(&Log -> Head, Head + RECORD_HEADER + Piece, memory_order_seq_cst);
+        
+        if (atomic_load_explicit(&Log -> Sleeping, memory_order_seq_cst))
+        {
+            atomic_store_explicit(&Log -> Sleeping, 0, memory_order_relaxed);
+            
+            WakeLogger(Log);
+        }
+        
+        Data += Piece;
+        Length -= Piece;
+    }
+}
+
+/*
+ *  The Flush Method will Write the Formatted Buffer to the Log.
+ */
+
+static void Flush(SerialLog * Log, BYTE * Buffer, QWORD * Pending)
+{
+    QWORD Done = 0;
+    
+    while (Done < *Pending)
+    {
+        ssize_t Written = write(Log -> Descriptor, Buffer + Done, *Pending - Done);
+        
+        if (Written < 0 && errno != EINTR)
+        {
+            break;
+        }
+        
+        Done += Written > 0 ? Written : 0;
+    }
+    
+    Log -> Written += *Pending;
+    
+    *Pending = 0;
+}
+
+/*
+ *  The Rotate Method will Rename the Log to the next Free <Log>.N Name and
+ *  Start a new Log.
+ */
+
+static void Rotate(SerialLog * Log)
+{
+    char Name[4096];
+    
+    do
+    {
+        snprintf(Name, sizeof(Name), "%s.%d", Log -> FileName, ++ Log -> Rotations);
+    }
+    while (access(Name, F_OK) == 0);
+    
+    close(Log -> Descriptor);
+    
+    rename(Log -> FileName, Name);
+    
+    Log -> Descriptor = open(Log -> FileName, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    
+    Log -> Written = 0;
+    
+    Log -> Opened = Monotonic();
+}
+
+/*
+ *  The Format Chunk Method will append a Chunk to the Buffer, with the
+ *  Timestamps asked for. The Buffer is Flushed when it gets Full.
+ */
+
+static void FormatChunk(SerialLog * Log, QWORD Time, BYTE * Data, DWORD Length, BYTE * Buffer, QWORD * Pending)
+{
+    char Stamp[32];
+    
+    int StampLength = snprintf(Stamp, sizeof(Stamp), "[%12.6f] ", (Time - Log -> Start) / 1e9);
+    
+    if (*Pending + sizeof(Stamp) + 2 > Log -> BufferSize)
+    {
+        Flush(Log, Buffer, Pending);
+    }
+    
+    if (Log -> Settings.Timestamps == STAMP_CHUNKS)
+    {
+        // Each Chunk starts on it's own Line
+        
+        if (!Log -> AtLineStart)
+        {
+            Buffer[(*Pending) ++] = '\n';
+        }
+        
+        memcpy(Buffer + *Pending, Stamp, StampLength);
+        
+        *Pending += StampLength;
+    }
+    
+    DWORD Counter;
+    
+    for (Counter = 0; Counter < Length; Counter ++)
+    {
+        // Keep Room for a Stamp and a Byte
+        
+        if (*Pending + sizeof(Stamp) + 2 > Log -> BufferSize)
+        {
+            Flush(Log, Buffer, Pending);
+        }
+        
+        if (Log -> Settings.Timestamps == STAMP_LINES && Log -> AtLineStart)
+        {
+            memcpy(Buffer + *Pending, Stamp, StampLength);
+            
+            *Pending += StampLength;
+        }
+        
+        Buffer[(*Pending) ++] = Data[Counter];
+        
+        Log -> AtLineStart = Data[Counter] == '\n';
+    }
+}
+
+/*
+ *  The Logger Thread will Sleep until Chunks are Queued, wait for the Batch
+ *  Window, then Format and Write every Queued Chunk in Large Writes.
+ */
+
+static void * LoggerThread(void * Context)
+{
+    SerialLog * Log = Context;
+    
+    BYTE * Buffer = malloc(Log -> BufferSize);
+    
+    BYTE * Chunk = malloc(Log -> RingSize / 4);
+    
+    QWORD Pending = 0;
+    
+    while (1)
+    {
+        QWORD Tail = atomic_load_explicit(&Log -> Tail, memory_order_relaxed);
+        
+        // Sleep only if the Ring is still Empty once the Reader can see the Flag
+        
+        if (atomic_load_explicit(&Log -> Head, memory_order_acquire) == Tail)
+        {
+            if (atomic_load(&Log -> Closing))
+            {
+                break;
+            }
+            
+            atomic_store_explicit(&Log -> Sleeping, 1, memory_order_seq_cst);
+            
+            if (atomic_load_explicit(&Log -> Head, memory_order_seq_cst) == Tail && !atomic_load(&Log -> Closing))
+            {
+                QWORD Count;
+                
+                if (read(Log -> Event, &Count, sizeof(Count)) < 0)
+                {
+                    // Interrupted, the Ring is Checked again
+                }
+                
+                if (!atomic_load(&Log -> Closing))
+                {
+                    struct timespec Window = { 0, BATCH_WINDOW_NS };
+                    
+                    nanosleep(&Window, NULL);
+                }
+            }
+            
+            atomic_store_explicit(&Log -> Sleeping, 0, memory_order_relaxed);
+            
+            continue;
+        }
+        
+        QWORD Head = atomic_load_explicit(&Log -> Head, memory_order_acquire);
+        
+        while (Tail != Head)
+        {
+            QWORD Time;
+            
+            DWORD Length;
+            
+            RingCopy(Log, Tail, (BYTE *) &Time, sizeof(Time), 0);
+            RingCopy(Log, Tail + sizeof(Time), (BYTE *) &Length, sizeof(Length), 0);
+            RingCopy(Log, Tail + RECORD_HEADER, Chunk, Length, 0);
+            
+            // Free the Space as soon as the Chunk is Copied out
+            
+            Tail += RECORD_HEADER + Length;
+            
+            atomic_store_explicit(&Log -> Tail, Tail, memory_order_release);
+            
+            // Rotation happens between Chunks, so a Chunk is never Split between two Logs
+            
+            if ((Log -> Settings.MaximumSize && Log -> Written + Pending + Length > Log -> Settings.MaximumSize && Log -> Written + Pending > 0) ||
+                (Log -> Settings.MaximumAge && Time - Log -> Opened >= Log -> Settings.MaximumAge * 1000000000ULL))
+            {
+                Flush(Log, Buffer, &Pending);
+                
+                Rotate(Log);
+            }
+            
+            if (Log -> Settings.Timestamps == STAMP_NONE)
+            {
+                if (Pending + Length > Log -> BufferSize)
+                {
+                    Flush(Log, Buffer, &Pending);
+                }
+                
+                // A Chunk larger than the Buffer is Written as it is
+                
+                if (Length > Log -> BufferSize)
+                {
+                    QWORD Whole = Length;
+                    
+                    Flush(Log, Chunk, &Whole);
+                }
+                else
+                {
+                    memcpy(Buffer + Pending, Chunk, Length);
+                    
+                    Pending += Length;
+                }
+            }
+            else
+            {
+                FormatChunk(Log, Time, Chunk, Length, Buffer, &Pending);
+            }
+            
+            Log -> Bytes += Length;
+        }
+        
+        Flush(Log, Buffer, &Pending);
+    }
+    
+    free(Buffer);
+    free(Chunk);
+    
+    return NULL;
+}
+
+/*
+ *  The Close Serial Log Method will wait until every Queued Chunk is Written,
+ *  then Stop the Logger and Close the Log.
+ * 
+ *  Parameters:
+ *          The Log
+ * 
+ *  Returns:
+ *          VOID
+ */
+
+void CloseSerialLog(SerialLog * Log)
+{
+    atomic_store(&Log -> Closing, 1);
+    
+    WakeLogger(Log);
+    
+    pthread_join(Log -> Thread, NULL);
+    
+    close(Log -> Descriptor);
+    close(Log -> Event);
+    
+    free(Log -> Ring);
+    free(Log);
+}
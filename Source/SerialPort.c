@@ -0,0 +1,258 @@
+/* Serial Port Configuration */
+
+// The Kernel's termios2 Definitions clash with the C Library's termios.h,
+// so this File uses the Kernel Headers only
+
+#include <asm/termbits.h>
+#include <asm/ioctls.h>
+#include <ctype.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <strings.h>
+#include <unistd.h>
+#include <poll.h>
+
+#include "../Headers/SerialPort.h"
+
+int ioctl(int Descriptor, unsigned long Request, ...);
+
+/*
+ *  The Open Serial Port Method will open a Serial Port and Configure it.
+ * 
+ *  Parameters:
+ *          A Char Array with the Name of the Port
+ *          The Settings to Apply
+ * 
+ *  Returns:
+ *          The Descriptor of the Port, or -1 on Error
+ */
+
+int OpenSerialPort(char * PortName, SerialSettings * Settings)
+{
+    int Port = open(PortName, O_RDWR | O_NONBLOCK | O_NOCTTY);
+    
+    if (Port < 0)
+    {
+        return -1;
+    }
+    
+    if (ConfigureSerialPort(Port, Settings) != 0)
+    {
+        close(Port);
+        
+        return -1;
+    }
+    
+    return Port;
+}
+
+/*
+ *  The Configure Serial Port Method will put a Port in Raw Mode with the
+ *  given Baud Rate, Frame Format and Flow Control.
+ * 
+ *  The Baud Rate is always passed as a Number ( BOTHER ), the Driver picks
+ *  the closest Rate it can generate.
+ * 
+ *  Parameters:
+ *          The Descriptor of the Port
+ *          The Settings to Apply
+ * 
+ *  Returns:
+ *          0 on Success, -1 on Error
+ */
+
+int ConfigureSerialPort(int Port, SerialSettings * Settings)
+{
+    static const unsigned int DataBits[] = { CS5, CS6, CS7, CS8 };
+    
+    struct termios2 Terminal;
+    
+    if (Settings -> DataBits < 5 || Settings -> DataBits > 8 || Settings -> BaudRate == 0)
+    {
+        return -1;
+    }
+    
+    if (ioctl(Port, TCGETS2, &Terminal) != 0)
+    {
+        return -1;
+    }
+    
+    // Raw Input, Output and Local Modes
+    
+    Terminal.c_iflag = 0;
+    Terminal.c_oflag = 0;
+    Terminal.c_lflag = 0;
+    
+    /* Set the Control Flags TO:
+            + The Character Size
+            + Enable Read
+            + Ignore Modem Control Lines
+            + Take the Baud Rate from the Speed Fields    */
+    
+    Terminal.c_cflag = DataBits[Settings -> DataBits - 5] | CREAD | CLOCAL | BOTHER;
+    
+    if (Settings -> StopBits == 2)
+    {
+        Terminal.c_cflag |= CSTOPB;
+    }
+    
+    // Parity is Generated, and Checked on Input
+    
+    if (Settings -> Parity == 'E' || Settings -> Parity == 'O')
+    {
+        Terminal.c_cflag |= PARENB | (Settings -> Parity == 'O' ? PARODD : 0);
+        
+        Terminal.c_iflag |= INPCK;
+    }
+    
+    if (Settings -> FlowControl == FLOW_HARDWARE)
+    {
+        Terminal.c_cflag |= CRTSCTS;
+    }
+    else if (Settings -> FlowControl == FLOW_SOFTWARE)
+    {
+        Terminal.c_iflag |= IXON | IXOFF;
+    }
+    
+    Terminal.c_ispeed = Settings -> BaudRate;
+    Terminal.c_ospeed = Settings -> BaudRate;
+    
+    memset(Terminal.c_cc, 0, sizeof(Terminal.c_cc));
+    
+    // Return as soon as a Single Byte is Available
+    
+    Terminal.c_cc[VMIN] = 1;
+    Terminal.c_cc[VTIME] = 0;
+    
+    return ioctl(Port, TCSETS2, &Terminal) == 0 ? 0 : -1;
+}
+
+unsigned int ActualBaudRate(int Port)
+{
+    struct termios2 Terminal;
+    
+    if (ioctl(Port, TCGETS2, &Terminal) != 0)
+    {
+        return 0;
+    }
+    
+    return Terminal.c_ospeed;
+}
+
+/*
+ *  The Mark Line Errors Method will have the Driver Report Framing and Parity
+ *  Errors inside the Data : a Bad Character arrives as 0xFF 0x00 <Character>,
+ *  a Break as 0xFF 0x00 0x00, and a Real 0xFF is Doubled.
+ * 
+ *  The Driver only Checks the Input with INPCK, which Configure Serial Port
+ *  Sets for Parity alone, so it is Set here for Framing Errors too. The next
+ *  Configure Serial Port puts the Input Modes back.
+ * 
+ *  Parameters:
+ *          The Descriptor of the Port
+ * 
+ *  Returns:
+ *          0 on Success, -1 on Error
+ */
+
+int MarkLineErrors(int Port)
+{
+    struct termios2 Terminal;
+    
+    if (ioctl(Port, TCGETS2, &Terminal) != 0)
+    {
+        return -1;
+    }
+    
+    Terminal.c_iflag |= PARMRK | INPCK;
+    Terminal.c_iflag &= ~(IGNPAR | IGNBRK | ISTRIP);
+    
+    return ioctl(Port, TCSETS2, &Terminal) == 0 ? 0 : -1;
+}
+
+int FlushInput(int Port)
+{
+    return ioctl(Port, TCFLSH, TCIFLUSH) == 0 ? 0 : -1;
+}
+
+int ParseSerialFormat(char * Text, SerialSettings * Settings)
+{
+    if (strlen(Text) != 3 || Text[0] < '5' || Text[0] > '8' || (Text[2] != '1' && Text[2] != '2'))
+    {
+        return -1;
+    }
+    
+    char Parity = toupper((unsigned char) Text[1]);
+    
+    if (Parity != 'N' && Parity != 'E' && Parity != 'O')
+    {
+        return -1;
+    }
+    
+    Settings -> DataBits = Text[0] - '0';
+    Settings -> Parity = Parity;
+    Settings -> StopBits = Text[2] - '0';
+    
+    return 0;
+}
+
+int ParseFlowControl(char * Text, SerialSettings * Settings)
+{
+    if (strcasecmp(Text, "none") == 0)
+    {
+        Settings -> FlowControl = FLOW_NONE;
+    }
+    else if (strcasecmp(Text, "rtscts") == 0)
+    {
+        Settings -> FlowControl = FLOW_HARDWARE;
+    }
+    else if (strcasecmp(Text, "xonxoff") == 0)
+    {
+        Settings -> FlowControl = FLOW_SOFTWARE;
+    }
+    else
+    {
+        return -1;
+    }
+    
+    return 0;
+}
+
+/*
+ *  The Write All Method will write a whole Buffer to a Descriptor. A Non
+ *  Blocking Descriptor which is Full is waited on, so no Byte is Dropped.
+ * 
+ *  Parameters:
+ *          The Descriptor
+ *          The Buffer and it's Length
+ * 
+ *  Returns:
+ *          0 on Success, -1 on Error
+ */
+
+int WriteAll(int Descriptor, const unsigned char * Buffer, size_t Length)
+{
+    while (Length > 0)
+    {
+        ssize_t Written = write(Descriptor, Buffer, Length);
+        
+        if (Written > 0)
+        {
+            Buffer += Written;
+            Length -= Written;
+        }
+        else if (Written < 0 && errno == EAGAIN)
+        {
+            struct pollfd Full = { Descriptor, POLLOUT, 0 };
+            
+            poll(&Full, 1, -1);
+        }
+        else if (Written < 0 && errno != EINTR)
+        {
+            return -1;
+        }
+    }
+    
+    return 0;
+}
@@ -0,0 +1,365 @@
+/********************************************************************
+ *                  Image Splitter                                  *
+ *                                                                  *
+ *  [   Author  ]       -       Andrew Borg                         *
+ *  [   Type    ]       -       Firmware Analysis                   *
+ *  [   Date    ]       -       02.01.2014                          *
+ *                                                                  *
+ * ******************************************************************
+ *                                                                  *
+ *  Description                                                     *
+ *                                                                  *
+ *  This Application is the inverse of the Merger. It cuts an       *
+ *  Image into it's Partitions, as described by a Layout File.      *
+ *                                                                  *
+ *  The Layout can be written by hand, or produced by the Hex       *
+ *  Dump's Partition Detector ( -Map ) and the Binary Searcher's    *
+ *  Signature Hits ( -Map ). Both Maps can be Concatenated : each   *
+ *  Hit ( Size - ) Cuts the Partition it was Found in, and ends     *
+ *  where the Next Hit Starts or where that Partition Ended.        *
+ *                                                                  *
+ *  The Image is Opened once and every Partition is Copied by the   *
+ *  Kernel, in Parallel, straight from the Image's Page Cache. The  *
+ *  Output Files are Opened and Closed in Batches by the IO Ring,   *
+ *  when the Kernel offers it.                                      *
+ *                                                                  *
+ * ******************************************************************/
+
+#include <string.h>
+#include <stdlib.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <time.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "../Headers/Common.h"
+#include "../Headers/Layout.h"
+#include "../Headers/ThreadPool.h"
+#include "../Headers/IORing.h"
+
+////////////////////////////////////////////////////////////////////////////////
+
+// Internal Function Prototypes
+
+void SplitImage(char * LayoutFile, char * ImageFile, char * Folder, char Trim);
+
+void SplitPartition(int Index, void * Context);
+
+QWORD TrimmedLength(BYTE * Data, QWORD Length, BYTE Fill);
+
+// The Names of the Copy Methods, as Returned by Copy Range
+
+static const char * Methods[] = { "Reflinked", "Kernel Copy", "Buffered Copy" };
+
+// The State shared by the Workers, each Worker only Writes it's own Partition's Slots
+
+typedef struct
+{
+    Layout * Map;
+    
+    int Image;
+    
+    QWORD ImageSize;
+    
+    // The Image Mapping, only used to Trim the Fill Bytes
+    
+    BYTE * Data;
+    
+    char * Folder;
+    
+    QWORD * Lengths;
+    
+    int * Results;
+    
+    // The Output Files, Opened by the IO Ring, or NULL when each Worker Opens it's own
+    
+    char ** Paths;
+    
+    int * Outputs;
+
+} SplitContext;
+
+////////////////////////////////////////////////////////////////////////////////
+
+int main(int argc, char * argv[])
+{
+    InitStats(&argc, argv);
+    InitOutput(&argc, argv);
+    
+    // The -Trim Option removes the Fill Bytes at the End of each Partition
+    
+    char Trim = argc > 1 && strcmp(argv[1], "-Trim") == 0;
+    
+    int First = Trim ? 2 : 1;
+    
+    if (argc - First == 2 || argc - First == 3)
+    {
+        SplitImage(argv[First], argv[First + 1], argc - First == 3 ? argv[First + 2] : ".", Trim);
+    }
+    else
+    {
+        puts("Syntax : \r\n");
+        
+        printf("\t %s [-Trim] <Layout File> <Image> [Output Folder] \r\n\r\n", argv[0]);
+        
+        puts("Available Options:");
+        
+        printf("\t -Trim : Remove the Fill Bytes at the End of each Partition \r\n\r\n");
+        
+        puts("Layout File Lines:");
+        
+        printf("\t <Output File> <Offset> [Size or -] [Fill Byte] \r\n");
+    }
+    
+    return 0;
+}
+
+/*  The Split Image method Writes every Partition of a Layout to it's own File.
+ * 
+ *  Partitions reaching past the End of the Image are Cut at the End of the Image.
+ * 
+ *  Parameters:
+ *          Layout File : Char Array with the Name of the Layout File
+ *          Image File  : Char Array with the Name of the Image to Split
+ *          Folder      : Char Array with the Folder the Partitions are Written to
+ *          Trim        : Char Indicating weather the Fill Bytes are Removed ( 1 ) or not ( 0 )
+ * 
+ *  Returns :
+ *          VOID
+ */
+
+void SplitImage(char * LayoutFile, char * ImageFile, char * Folder, char Trim)
+{
+    Layout Map = LoadLayout(LayoutFile);
+    
+    int Image = open(ImageFile, O_RDONLY);
+    
+    struct stat Status;
+    
+    if (Image < 0 || fstat(Image, &Status) != 0)
+    {
+        puts("File Not Found");
+        
+        exit(EXIT_FAILURE);
+    }
+    
+    QWORD ImageSize = Status.st_size;
+    
+    SortLayout(&Map);
+    
+    // Signature Hits cut the Partitions they were Found in
+    
+    CutLayout(&Map);
+    
+    ResolveLayout(&Map, Map.ImageSize ? Map.ImageSize : ImageSize);
+    
+    int Counter;
+    
+    int Problems = CheckLayout(&Map);
+    
+    // Output Names are kept inside the Output Folder
+    
+    for (Counter = 0; Counter < Map.Count; Counter ++)
+    {
+        char * Name = Map.Entries[Counter].FileName;
+        
+        if (Name[0] == '/' || strcmp(Name, "..") == 0 || strncmp(Name, "../", 3) == 0 || strstr(Name, "/../"))
+        {
+            printf("Invalid Output Name : %s \r\n", Name);
+            
+            Problems ++;
+        }
+    }
+    
+    if (Problems > 0)
+    {
+        printf("%d Problems Found inside the Layout, Nothing was Written \r\n", Problems);
+        
+        exit(EXIT_FAILURE);
+    }
+    
+    mkdir(Folder, 0755);
+    
+    SplitContext Context = { &Map, Image, ImageSize, NULL, Folder, calloc(Map.Count, sizeof(QWORD)), calloc(Map.Count, sizeof(int)),
+                             calloc(Map.Count + 1, sizeof(char *)), calloc(Map.Count + 1, sizeof(int)) };
+    
+    for (Counter = 0; Counter < Map.Count; Counter ++)
+    {
+        Context.Paths[Counter] = malloc(strlen(Folder) + strlen(Map.Entries[Counter].FileName) + 2);
+        
+        sprintf(Context.Paths[Counter], "%s/%s", Folder, Map.Entries[Counter].FileName);
+    }
+    
+    // The Mapping shares the Image's Descriptor, the Image is still Opened once
+    
+    if (Trim && ImageSize > 0)
+    {
+        Context.Data = mmap(NULL, ImageSize, PROT_READ, MAP_PRIVATE, Image, 0);
+        
+        if (Context.Data == MAP_FAILED)
+        {
+            puts("Error Reading File");
+            
+            exit(EXIT_FAILURE);
+        }
+    }
+    
+    struct timespec Start, End;
+    
+    clock_gettime(CLOCK_MONOTONIC, &Start);
+    
+    int Phase = STATS_BEGIN("Split");
+    
+    int Ring = RingOpenFiles(Context.Paths, Map.Count, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644, Context.Outputs) == 0;
+    
+    if (!Ring)
+    {
+        free(Context.Outputs);
+        
+        Context.Outputs = NULL;
+    }
+    
+    RunParallel(Map.Count, SplitPartition, &Context);
+    
+    if (Ring)
+    {
+        RingCloseFiles(Context.Outputs, Map.Count);
+    }
+    
+    STATS_ADD(STAT_FILES, Map.Count);
+    
+    STATS_END(Phase);
+    
+    clock_gettime(CLOCK_MONOTONIC, &End);
+    
+    // The Report is Printed once every Worker is Done, in Layout Order
+    
+    QWORD Total = 0;
+    
+    int Failed = 0;
+    
+    for (Counter = 0; Counter < Map.Count; Counter ++)
+    {
+        LayoutEntry * Entry = &Map.Entries[Counter];
+        
+        if (Context.Results[Counter] < 0)
+        {
+            EmitExtraction(Entry -> FileName, Entry -> Offset, 0, "Error Writing");
+            
+            Failed ++;
+            
+            continue;
+        }
+        
+        EmitExtraction(Entry -> FileName, Entry -> Offset, Context.Lengths[Counter], Methods[Context.Results[Counter]]);
+        
+        Total += Context.Lengths[Counter];
+    }
+    
+    double Seconds = (End.tv_sec - Start.tv_sec) + (End.tv_nsec - Start.tv_nsec) / 1e9;
+    
+    OutputText("Split %d Partitions ( %llu Bytes ) in %.3f Seconds ( %.0f MB/s ) using %d Threads \r\n", Map.Count - Failed, (unsigned long long) Total,
+               Seconds, Seconds > 0 ? Total / Seconds / 1e6 : 0, PoolSize());
+    
+    if (Context.Data)
+    {
+        munmap(Context.Data, ImageSize);
+    }
+    
+    close(Image);
+    
+    for (Counter = 0; Counter < Map.Count; Counter ++)
+    {
+        free(Context.Paths[Counter]);
+    }
+    
+    free(Context.Paths);
+    free(Context.Outputs);
+    free(Context.Lengths);
+    free(Context.Results);
+    
+    FreeLayout(&Map);
+    
+    if (Failed > 0)
+    {
+        exit(EXIT_FAILURE);
+    }
+}
+
+/*  The Split Partition method is run by the Workers, and Writes a single Partition.
+ * 
+ *  Parameters:
+ *          Index   : The Index of the Partition inside the Layout
+ *          Context : The Split Context
+ * 
+ *  Returns :
+ *          VOID
+ */
+
+void SplitPartition(int Index, void * Context)
+{
+    SplitContext * Split = Context;
+    
+    LayoutEntry * Entry = &Split -> Map -> Entries[Index];
+    
+    QWORD Length = 0;
+    
+    // Cut the Partition at the End of the Image
+    
+    if (Entry -> Offset < Split -> ImageSize)
+    {
+        Length = Split -> ImageSize - Entry -> Offset;
+        
+        if (Entry -> MaximumSize < Length)
+        {
+            Length = Entry -> MaximumSize;
+        }
+    }
+    
+    if (Split -> Data)
+    {
+        Length = TrimmedLength(Split -> Data + Entry -> Offset, Length, Entry -> Fill);
+    }
+    
+    int Output = Split -> Outputs ? Split -> Outputs[Index] : open(Split -> Paths[Index], O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    
+    if (Output < 0)
+    {
+        Split -> Results[Index] = -1;
+        
+        return;
+    }
+    
+    Split -> Results[Index] = CopyRange(Split -> Image, Entry -> Offset, Output, 0, Length);
+    
+    Split -> Lengths[Index] = Length;
+    
+    // The Descriptors Opened by the IO Ring are Closed by it, in a single Batch
+    
+    if (!Split -> Outputs)
+    {
+        close(Output);
+    }
+}
+
+/*  The Trimmed Length method returns the Length of a Partition without the
+ *  Fill Bytes found at it's End.
+ * 
+ *  Parameters:
+ *          The Partition's Data and Length
+ *          The Fill Byte
+ * 
+ *  Returns :
+ *          The Length up to the Last Byte which is not a Fill Byte
+ */
+
+QWORD TrimmedLength(BYTE * Data, QWORD Length, BYTE Fill)
+{
+    while (Length > 0 && Data[Length - 1] == Fill)
+    {
+        Length --;
+    }
+    
+    return Length;
+}
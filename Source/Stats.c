@@ -0,0 +1,512 @@
+/* Phase Timing and Resource Statistics */
+
+#define _GNU_SOURCE
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <sys/resource.h>
+
+#include "../Headers/Stats.h"
+
+// The Most Phases, Threads, and Phases Open at once on a Thread
+
+#define MAX_PHASES 32
+#define MAX_THREADS 128
+#define MAX_DEPTH 16
+
+int StatsEnabled = 0;
+
+typedef struct
+{
+    const char * Name;
+    
+    QWORD Calls;
+    
+    // Nanoseconds of Wall Time, and of the Process' CPU Time ( every Thread ) while the Phase was Open
+    
+    QWORD Wall;
+    
+    QWORD CPU;
+    
+    long MinorFaults;
+    
+    long MajorFaults;
+    
+    QWORD Counters[STAT_COUNTERS];
+
+} Phase;
+
+typedef struct
+{
+    const char * Name;
+    
+    clockid_t Clock;
+    
+    // Written only by it's own Thread
+    
+    QWORD Counters[STAT_COUNTERS];
+    
+    // The CPU Time when the Recording Started
+    
+    QWORD StartCPU;
+
+} ThreadStats;
+
+// What an Open Phase Started from
+
+typedef struct
+{
+    int Index;
+    
+    QWORD Wall;
+    
+    QWORD CPU;
+    
+    long MinorFaults;
+    
+    long MajorFaults;
+    
+    QWORD Counters[STAT_COUNTERS];
+
+} Frame;
+
+static pthread_mutex_t StatsLock = PTHREAD_MUTEX_INITIALIZER;
+
+static Phase Phases[MAX_PHASES];
+
+static int PhaseCount = 0;
+
+static ThreadStats Threads[MAX_THREADS];
+
+static int ThreadCount = 0;
+
+static __thread ThreadStats * Local = NULL;
+
+static __thread Frame Frames[MAX_DEPTH];
+
+static __thread int Depth = 0;
+
+static char ToolName[64] = "";
+
+// NULL to Print the Summary
+
+static char * JSONFile = NULL;
+
+static QWORD StartWall;
+
+// The CPU Time of each Thread, Read with the Wall Time of the Report
+
+static QWORD ThreadCPU[MAX_THREADS];
+
+static struct rusage StartUsage;
+
+static QWORD ReadClock(clockid_t Clock)
+{
+    struct timespec Now;
+    
+    if (clock_gettime(Clock, &Now) != 0)
+    {
+        return 0;
+    }
+    
+    return (QWORD) Now.tv_sec * 1000000000ULL + Now.tv_nsec;
+}
+
+static QWORD TimevalNanoseconds(struct timeval Time)
+{
+    return (QWORD) Time.tv_sec * 1000000000ULL + Time.tv_usec * 1000ULL;
+}
+
+// Sums a Counter over every Thread, the Other Threads' Values may be a little behind
+
+static QWORD TotalCounter(int Counter)
+{
+    QWORD Total = 0;
+    
+    int Index;
+    
+    for (Index = 0; Index < ThreadCount; Index ++)
+    {
+        Total += Threads[Index].Counters[Counter];
+    }
+    
+    return Total;
+}
+
+void RegisterThread(const char * Name)
+{
+    if (!StatsEnabled || Local)
+    {
+        return;
+    }
+    
+    pthread_mutex_lock(&StatsLock);
+    
+    if (ThreadCount < MAX_THREADS)
+    {
+        Local = &Threads[ThreadCount ++];
+        
+        memset(Local, 0, sizeof(ThreadStats));
+        
+        Local -> Name = Name;
+        
+        if (pthread_getcpuclockid(pthread_self(), &Local -> Clock) != 0)
+        {
+            Local -> Clock = CLOCK_THREAD_CPUTIME_ID;
+        }
+        
+        Local -> StartCPU = ReadClock(Local -> Clock);
+    }
+    
+    pthread_mutex_unlock(&StatsLock);
+}
+
+void AddCounter(int Counter, QWORD Amount)
+{
+    if (Local == NULL)
+    {
+        RegisterThread("Thread");
+        
+        // Past MAX_THREADS, the Counts are Lost
+        
+        if (Local == NULL)
+        {
+            return;
+        }
+    }
+    
+    Local -> Counters[Counter] += Amount;
+}
+
+/*
+ *  The Begin Phase Method will Start Timing a Phase. Phases with the same
+ *  Name are Added together, and Phases can be Nested.
+ * 
+ *  Parameters:
+ *          The Name of the Phase, a String which stays Valid
+ * 
+ *  Returns:
+ *          The Handle to Pass to EndPhase, or -1 when Nested too Deep
+ */
+
+int BeginPhase(const char * Name)
+{
+    if (Depth == MAX_DEPTH)
+    {
+        return -1;
+    }
+    
+    pthread_mutex_lock(&StatsLock);
+    
+    int Index;
+    
+    for (Index = 0; Index < PhaseCount && strcmp(Phases[Index].Name, Name) != 0; Index ++);
+    
+    if (Index == PhaseCount && PhaseCount < MAX_PHASES)
+    {
+        memset(&Phases[PhaseCount ++], 0, sizeof(Phase));
+        
+        Phases[Index].Name = Name;
+    }
+    
+    Frame * Open = &Frames[Depth];
+    
+    int Counter;
+    
+    for (Counter = 0; Counter < STAT_COUNTERS; Counter ++)
+    {
+        Open -> Counters[Counter] = TotalCounter(Counter);
+    }
+    
+    pthread_mutex_unlock(&StatsLock);
+    
+    if (Index == MAX_PHASES)
+    {
+        return -1;
+    }
+    
+    struct rusage Usage;
+    
+    getrusage(RUSAGE_SELF, &Usage);
+    
+    Open -> Index = Index;
+    Open -> MinorFaults = Usage.ru_minflt;
+    Open -> MajorFaults = Usage.ru_majflt;
+    Open -> CPU = ReadClock(CLOCK_PROCESS_CPUTIME_ID);
+    Open -> Wall = ReadClock(CLOCK_MONOTONIC);
+    
+    return Depth ++;
+}
+
+void EndPhase(int Handle)
+{
+    QWORD Wall = ReadClock(CLOCK_MONOTONIC);
+    
+    QWORD CPU = ReadClock(CLOCK_PROCESS_CPUTIME_ID);
+    
+    struct rusage Usage;
+    
+    getrusage(RUSAGE_SELF, &Usage);
+    
+    // Phases Ended out of Order close the ones Opened inside them
+    
+    if (Handle < 0 || Handle >= Depth)
+    {
+        return;
+    }
+    
+    Depth = Handle;
+    
+    Frame * Open = &Frames[Handle];
+    
+    pthread_mutex_lock(&StatsLock);
+    
+    Phase * Ended = &Phases[Open -> Index];
+    
+    Ended -> Calls ++;
+    Ended -> Wall += Wall - Open -> Wall;
+    Ended -> CPU += CPU - Open -> CPU;
+    Ended -> MinorFaults += Usage.ru_minflt - Open -> MinorFaults;
+    Ended -> MajorFaults += Usage.ru_majflt - Open -> MajorFaults;
+    
+    int Counter;
+    
+    for (Counter = 0; Counter < STAT_COUNTERS; Counter ++)
+    {
+        Ended -> Counters[Counter] += TotalCounter(Counter) - Open -> Counters[Counter];
+    }
+    
+    pthread_mutex_unlock(&StatsLock);
+}
+
+// Starts Recording from now, the Threads stay Registered
+
+static void ResetStats()
+{
+    PhaseCount = 0;
+    
+    // A Batch Command Ended by ExitTool leaves it's Phases Open
+    
+    Depth = 0;
+    
+    int Index;
+    
+    for (Index = 0; Index < ThreadCount; Index ++)
+    {
+        memset(Threads[Index].Counters, 0, sizeof(Threads[Index].Counters));
+        
+        Threads[Index].StartCPU = ReadClock(Threads[Index].Clock);
+    }
+    
+    getrusage(RUSAGE_SELF, &StartUsage);
+    
+    StartWall = ReadClock(CLOCK_MONOTONIC);
+}
+
+/*
+ *  The Init Stats Method will Enable the Statistics, when Asked for, and
+ *  Report them when the Process Exits. It is Called first by each Tool's
+ *  main, so --stats can be Passed in front of any Tool's Arguments.
+ * 
+ *  Parameters:
+ *          The Tool's argc and argv, --stats is Removed from them
+ * 
+ *  Returns:
+ *          VOID
+ */
+
+void InitStats(int * argc, char * argv[])
+{
+    char * Setting = getenv("FWTOOLS_STATS");
+    
+    int Counter;
+    
+    for (Counter = 1; Counter < *argc; Counter ++)
+    {
+        if (strcmp(argv[Counter], "--stats") == 0 || strncmp(argv[Counter], "--stats=", 8) == 0)
+        {
+            Setting = argv[Counter][7] == '=' ? argv[Counter] + 8 : "1";
+            
+            memmove(argv + Counter, argv + Counter + 1, (*argc - Counter) * sizeof(char *));
+            
+            (*argc) --;
+            
+            break;
+        }
+    }
+    
+    // A Batch Calls every Tool's main, each Command is Reported under it's own Tool
+    
+    if (!StatsEnabled && (Setting == NULL || strcmp(Setting, "0") == 0))
+    {
+        return;
+    }
+    
+    char * Name = strrchr(argv[0], '/') ? strrchr(argv[0], '/') + 1 : argv[0];
+    
+    snprintf(ToolName, sizeof(ToolName), "%s", Name);
+    
+    if (!StatsEnabled)
+    {
+        JSONFile = *Setting && strcmp(Setting, "1") != 0 ? Setting : NULL;
+        
+        StatsEnabled = 1;
+        
+        RegisterThread("Main");
+        
+        atexit(ReportStats);
+    }
+    
+    ResetStats();
+}
+
+static void PrintSummary(QWORD Wall, struct rusage * Usage)
+{
+    fprintf(stderr, "\r\n--- Statistics : %s ----------------------------------------- \r\n", ToolName);
+    
+    fprintf(stderr, "Wall %.3f s, User %.3f s, System %.3f s, Peak RSS %ld KB, Faults %ld Minor %ld Major \r\n", Wall / 1e9,
+            (TimevalNanoseconds(Usage -> ru_utime) - TimevalNanoseconds(StartUsage.ru_utime)) / 1e9,
+            (TimevalNanoseconds(Usage -> ru_stime) - TimevalNanoseconds(StartUsage.ru_stime)) / 1e9, Usage -> ru_maxrss,
+            Usage -> ru_minflt - StartUsage.ru_minflt, Usage -> ru_majflt - StartUsage.ru_majflt);
+    
+    fprintf(stderr, "Read %llu Bytes, Written %llu Bytes, %llu Hits, %llu Files \r\n\r\n", (unsigned long long) TotalCounter(STAT_READ),
+            (unsigned long long) TotalCounter(STAT_WRITTEN), (unsigned long long) TotalCounter(STAT_HITS),
+            (unsigned long long) TotalCounter(STAT_FILES));
+    
+    if (PhaseCount)
+    {
+        fprintf(stderr, "%-16s %6s %10s %10s %8s %8s %12s %12s %8s \r\n", "Phase", "Calls", "Wall s", "CPU s", "Minor", "Major",
+                "Read", "Written", "Hits");
+    }
+    
+    int Index;
+    
+    for (Index = 0; Index < PhaseCount; Index ++)
+    {
+        Phase * Shown = &Phases[Index];
+        
+        fprintf(stderr, "%-16s %6llu %10.4f %10.4f %8ld %8ld %12llu %12llu %8llu \r\n", Shown -> Name, (unsigned long long) Shown -> Calls,
+                Shown -> Wall / 1e9, Shown -> CPU / 1e9, Shown -> MinorFaults, Shown -> MajorFaults,
+                (unsigned long long) Shown -> Counters[STAT_READ], (unsigned long long) Shown -> Counters[STAT_WRITTEN],
+                (unsigned long long) Shown -> Counters[STAT_HITS]);
+    }
+    
+    fprintf(stderr, "\r\nThreads : ");
+    
+    for (Index = 0; Index < ThreadCount; Index ++)
+    {
+        QWORD CPU = ThreadCPU[Index];
+        
+        fprintf(stderr, "%s%s %.0f%%", Index ? ", " : "", Threads[Index].Name, Wall ? CPU * 100.0 / Wall : 0);
+    }
+    
+    fprintf(stderr, " \r\n");
+}
+
+static void WriteJSON(QWORD Wall, struct rusage * Usage)
+{
+    FILE * Output = fopen(JSONFile, "w");
+    
+    if (Output == NULL)
+    {
+        fprintf(stderr, "Cannot Write the Statistics to %s \r\n", JSONFile);
+        
+        return;
+    }
+    
+    fprintf(Output, "{\n  \"tool\": \"%s\",\n  \"wall\": %.6f,\n  \"user\": %.6f,\n  \"system\": %.6f,\n  \"peak_rss_kb\": %ld,\n"
+            "  \"minor_faults\": %ld,\n  \"major_faults\": %ld,\n  \"read\": %llu,\n  \"written\": %llu,\n  \"hits\": %llu,\n"
+            "  \"files\": %llu,\n  \"phases\": [", ToolName, Wall / 1e9,
+            (TimevalNanoseconds(Usage -> ru_utime) - TimevalNanoseconds(StartUsage.ru_utime)) / 1e9,
+            (TimevalNanoseconds(Usage -> ru_stime) - TimevalNanoseconds(StartUsage.ru_stime)) / 1e9, Usage -> ru_maxrss,
+            Usage -> ru_minflt - StartUsage.ru_minflt, Usage -> ru_majflt - StartUsage.ru_majflt,
+            (unsigned long long) TotalCounter(STAT_READ), (unsigned long long) TotalCounter(STAT_WRITTEN),
+            (unsigned long long) TotalCounter(STAT_HITS), (unsigned long long) TotalCounter(STAT_FILES));
+    
+    int Index;
+    
+    for (Index = 0; Index < PhaseCount; Index ++)
+    {
+        Phase * Shown = &Phases[Index];
+        
+        fprintf(Output, "%s\n    {\"name\": \"%s\", \"calls\": %llu, \"wall\": %.6f, \"cpu\": %.6f, \"minor_faults\": %ld, "
+                "\"major_faults\": %ld, \"read\": %llu, \"written\": %llu, \"hits\": %llu, \"files\": %llu}", Index ? "," : "",
+                Shown -> Name, (unsigned long long) Shown -> Calls, Shown -> Wall / 1e9, Shown -> CPU / 1e9, Shown -> MinorFaults,
+                Shown -> MajorFaults, (unsigned long long) Shown -> Counters[STAT_READ],
+                (unsigned long long) Shown -> Counters[STAT_WRITTEN], (unsigned long long) Shown -> Counters[STAT_HITS],
+                (unsigned long long) Shown -> Counters[STAT_FILES]);
+    }
+    
+    fprintf(Output, "\n  ],\n  \"threads\": [");
+    
+    for (Index = 0; Index < ThreadCount; Index ++)
+    {
+        QWORD CPU = ThreadCPU[Index];
+        
+        fprintf(Output, "%s\n    {\"name\": \"%s\", \"cpu\": %.6f, \"utilization\": %.4f}", Index ? "," : "", Threads[Index].Name,
+                CPU / 1e9, Wall ? (double) CPU / Wall : 0);
+    }
+    
+    fprintf(Output, "\n  ]\n}\n");
+    
+    fclose(Output);
+}
+
+/*
+ *  The Report Stats Method will Print the Summary on the Standard Error, or
+ *  Write the JSON File, then Start Recording again. It is Called when the
+ *  Process Exits, and after each Command of a Batch.
+ * 
+ *  Parameters:
+ *          VOID
+ * 
+ *  Returns:
+ *          VOID
+ */
+
+void ReportStats()
+{
+    // Nothing Ran since the Last Report, such as at the End of a Batch
+    
+    if (!StatsEnabled || ToolName[0] == '\0')
+    {
+        return;
+    }
+    
+    QWORD Wall = ReadClock(CLOCK_MONOTONIC) - StartWall;
+    
+    struct rusage Usage;
+    
+    getrusage(RUSAGE_SELF, &Usage);
+    
+    pthread_mutex_lock(&StatsLock);
+    
+    int Index;
+    
+    for (Index = 0; Index < ThreadCount; Index ++)
+    {
+        ThreadCPU[Index] = ReadClock(Threads[Index].Clock) - Threads[Index].StartCPU;
+    }
+    
+    // The Tool's Output comes first
+    
+    fflush(stdout);
+    
+    if (JSONFile)
+    {
+        WriteJSON(Wall, &Usage);
+    }
+    else
+    {
+        PrintSummary(Wall, &Usage);
+    }
+    
+    ResetStats();
+    
+    ToolName[0] = '\0';
+    
+    pthread_mutex_unlock(&StatsLock);
+}
@@ -0,0 +1,224 @@
+/* Task Graph */
+
+#include <pthread.h>
+#include <stdlib.h>
+
+#include "../Headers/TaskGraph.h"
+#include "../Headers/ThreadPool.h"
+
+struct Task
+{
+    TaskWork Work;
+    
+    void * Context;
+    
+    // The Dependencies not yet Done, plus one until the Task is Submitted
+    
+    int Waiting;
+    
+    int Done;
+    
+    // The Tasks waiting for this one
+    
+    Task ** Dependents;
+    
+    int DependentCount;
+    
+    int DependentCapacity;
+    
+    // The Next Task of the Ready Stack, and of the Graph's List of every Task
+    
+    Task * NextReady;
+    
+    Task * NextCreated;
+    
+    TaskGraph * Graph;
+
+};
+
+struct TaskGraph
+{
+    pthread_mutex_t Lock;
+    
+    pthread_cond_t Changed;
+    
+    Task * Ready;
+    
+    Task * Created;
+    
+    // The Tasks Created and not yet Done, and those being Run
+    
+    int Unfinished;
+    
+    int Running;
+
+};
+
+TaskGraph * CreateGraph()
+{
+    TaskGraph * Graph = calloc(1, sizeof(TaskGraph));
+    
+    pthread_mutex_init(&Graph -> Lock, NULL);
+    pthread_cond_init(&Graph -> Changed, NULL);
+    
+    return Graph;
+}
+
+Task * CreateTask(TaskGraph * Graph, TaskWork Work, void * Context)
+{
+    Task * Item = calloc(1, sizeof(Task));
+    
+    Item -> Work = Work;
+    Item -> Context = Context;
+    Item -> Waiting = 1;
+    Item -> Graph = Graph;
+    
+    pthread_mutex_lock(&Graph -> Lock);
+    
+    Item -> NextCreated = Graph -> Created;
+    
+    Graph -> Created = Item;
+    
+    Graph -> Unfinished ++;
+    
+    pthread_mutex_unlock(&Graph -> Lock);
+    
+    return Item;
+}
+
+void AddDependency(Task * Later, Task * Earlier)
+{
+    TaskGraph * Graph = Earlier -> Graph;
+    
+    pthread_mutex_lock(&Graph -> Lock);
+    
+    if (!Earlier -> Done)
+    {
+        if (Earlier -> DependentCount == Earlier -> DependentCapacity)
+        {
+            Earlier -> DependentCapacity = Earlier -> DependentCapacity ? Earlier -> DependentCapacity * 2 : 4;
+            
+            Earlier -> Dependents = realloc(Earlier -> Dependents, Earlier -> DependentCapacity * sizeof(Task *));
+        }
+        
+        Earlier -> Dependents[Earlier -> DependentCount ++] = Later;
+        
+        Later -> Waiting ++;
+    }
+    
+    pthread_mutex_unlock(&Graph -> Lock);
+}
+
+// The Lock has to be held
+
+static void Release(TaskGraph * Graph, Task * Item)
+{
+    if (-- Item -> Waiting == 0)
+    {
+        Item -> NextReady = Graph -> Ready;
+        
+        Graph -> Ready = Item;
+        
+        pthread_cond_broadcast(&Graph -> Changed);
+    }
+}
+
+void SubmitTask(Task * Item)
+{
+    TaskGraph * Graph = Item -> Graph;
+    
+    pthread_mutex_lock(&Graph -> Lock);
+    
+    Release(Graph, Item);
+    
+    pthread_mutex_unlock(&Graph -> Lock);
+}
+
+/*
+ *  The Graph Worker Method is Run by each Worker of the Pool. It Runs the
+ *  Ready Tasks, and Waits while none is Ready but others are Running, as
+ *  they may Create or Release more. Once Nothing is Ready or Running, the
+ *  Graph is Done.
+ *
+ *  Parameters:
+ *          The Worker's Index, and the Graph
+ *
+ *  Returns:
+ *          VOID
+ */
+
+static void GraphWorker(int Index, void * Context)
+{
+    TaskGraph * Graph = Context;
+    
+    (void) Index;
+    
+    pthread_mutex_lock(&Graph -> Lock);
+    
+    while (1)
+    {
+        while (!Graph -> Ready && Graph -> Running > 0)
+        {
+            pthread_cond_wait(&Graph -> Changed, &Graph -> Lock);
+        }
+        
+        // Tasks still Waiting now were never Submitted, or Wait on each other
+        
+        if (!Graph -> Ready)
+        {
+            break;
+        }
+        
+        Task * Item = Graph -> Ready;
+        
+        Graph -> Ready = Item -> NextReady;
+        
+        Graph -> Running ++;
+        
+        pthread_mutex_unlock(&Graph -> Lock);
+        
+        Item -> Work(Item -> Context);
+        
+        pthread_mutex_lock(&Graph -> Lock);
+        
+        Graph -> Running --;
+        
+        Graph -> Unfinished --;
+        
+        Item -> Done = 1;
+        
+        int Counter;
+        
+        for (Counter = 0; Counter < Item -> DependentCount; Counter ++)
+        {
+            Release(Graph, Item -> Dependents[Counter]);
+        }
+        
+        pthread_cond_broadcast(&Graph -> Changed);
+    }
+    
+    pthread_mutex_unlock(&Graph -> Lock);
+}
+
+void RunGraph(TaskGraph * Graph)
+{
+    RunParallel(PoolSize(), GraphWorker, Graph);
+}
+
+void FreeGraph(TaskGraph * Graph)
+{
+    while (Graph -> Created)
+    {
+        Task * Item = Graph -> Created;
+        
+        Graph -> Created = Item -> NextCreated;
+        
+        free(Item -> Dependents);
+        free(Item);
+    }
+    
+    pthread_mutex_destroy(&Graph -> Lock);
+    pthread_cond_destroy(&Graph -> Changed);
+    
+    free(Graph);
+}
@@ -0,0 +1,193 @@
+/* Thread Pool */
+
+#include <pthread.h>
+#include <unistd.h>
+
+#include "../Headers/ThreadPool.h"
+#include "../Headers/Stats.h"
+
+// The Maximum Number of Workers, regardless of the CPU Count
+
+#define MAX_WORKERS 64
+
+// The State shared between the Caller and the Workers
+
+static pthread_mutex_t Lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t WorkReady = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t WorkDone = PTHREAD_COND_INITIALIZER;
+
+// Only one Parallel Loop runs at a time
+
+static pthread_mutex_t CallerLock = PTHREAD_MUTEX_INITIALIZER;
+
+static int Workers = 0;
+
+static ParallelWork CurrentWork;
+static void * CurrentContext;
+
+static int TotalItems;
+static int NextItem;
+static int FinishedItems;
+
+// Incremented for every Loop, so Workers can tell a New Loop from a Spurious Wake Up
+
+static unsigned long Generation;
+
+// Set while the Thread runs a Work Function
+
+static __thread int Working = 0;
+
+/*
+ *  The Take Items Method lets the calling Thread process Items of the Current
+ *  Loop until none are left. It is used both by the Workers and by the Caller.
+ *  The Lock has to be held when called, and is held again when it Returns.
+ */
+
+static void TakeItems()
+{
+    while (NextItem < TotalItems)
+    {
+        int Index = NextItem ++;
+        
+        ParallelWork Work = CurrentWork;
+        void * Context = CurrentContext;
+        
+        pthread_mutex_unlock(&Lock);
+        
+        Working = 1;
+        
+        Work(Index, Context);
+        
+        Working = 0;
+        
+        pthread_mutex_lock(&Lock);
+        
+        if (++ FinishedItems == TotalItems)
+        {
+            pthread_cond_broadcast(&WorkDone);
+        }
+    }
+}
+
+static void * Worker(void * Argument)
+{
+    unsigned long Seen = 0;
+    
+    RegisterThread("Worker");
+    
+    pthread_mutex_lock(&Lock);
+    
+    while (1)
+    {
+        // Sleep until a New Loop is Started
+        
+        while (Generation == Seen)
+        {
+            pthread_cond_wait(&WorkReady, &Lock);
+        }
+        
+        Seen = Generation;
+        
+        TakeItems();
+    }
+    
+    return NULL;
+}
+
+int InParallelWork()
+{
+    return Working;
+}
+
+int PoolSize()
+{
+    pthread_mutex_lock(&Lock);
+    
+    if (Workers == 0)
+    {
+        long Processors = sysconf(_SC_NPROCESSORS_ONLN);
+        
+        if (Processors < 1)
+        {
+            Processors = 1;
+        }
+        
+        if (Processors > MAX_WORKERS)
+        {
+            Processors = MAX_WORKERS;
+        }
+        
+        // The Caller also works, so one Worker less is Started
+        
+        int Counter;
+        
+        for (Counter = 0; Counter < Processors - 1; Counter ++)
+        {
+            pthread_t Thread;
+            
+            if (pthread_create(&Thread, NULL, Worker, NULL) != 0)
+            {
+                break;
+            }
+            
+            pthread_detach(Thread);
+        }
+        
+        Workers = Counter + 1;
+    }
+    
+    pthread_mutex_unlock(&Lock);
+    
+    return Workers;
+}
+
+/*
+ *  The Run Parallel Method will call the Work Function for every Index between
+ *  0 and Count - 1, spreading the Indexes over the Pool's Workers.
+ * 
+ *  The Calling Thread takes part in the Work, and the Method only Returns once
+ *  every Index was Processed.
+ * 
+ *  Parameters:
+ *          The Number of Items to Process
+ *          The Work Function and a Context Pointer passed to it
+ * 
+ *  Returns:
+ *          VOID
+ */
+
+void RunParallel(int Count, ParallelWork Work, void * Context)
+{
+    if (Count <= 0)
+    {
+        return;
+    }
+    
+    PoolSize();
+    
+    pthread_mutex_lock(&CallerLock);
+    
+    pthread_mutex_lock(&Lock);
+    
+    CurrentWork = Work;
+    CurrentContext = Context;
+    
+    TotalItems = Count;
+    NextItem = 0;
+    FinishedItems = 0;
+    
+    Generation ++;
+    
+    pthread_cond_broadcast(&WorkReady);
+    
+    TakeItems();
+    
+    while (FinishedItems < TotalItems)
+    {
+        pthread_cond_wait(&WorkDone, &Lock);
+    }
+    
+    pthread_mutex_unlock(&Lock);
+    
+    pthread_mutex_unlock(&CallerLock);
+}
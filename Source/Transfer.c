@@ -0,0 +1,1221 @@
+/* Serial File Transfers */
+
+#include <libgen.h>
+#include <poll.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include "../Headers/Common.h"
+#include "../Headers/SerialPort.h"
+#include "../Headers/Transfer.h"
+
+// XMODEM and YMODEM Control Characters
+
+#define SOH     0x01
+#define STX     0x02
+#define EOT     0x04
+#define ACK     0x06
+#define NAK     0x15
+#define CAN     0x18
+#define CPMEOF  0x1A
+
+// The Number of times a Block or a Header is Sent before giving Up
+
+#define MAX_RETRIES 10
+
+// Seconds to wait for the Receiver to Start, and for each Answer
+
+#define START_TIMEOUT 60
+#define ANSWER_TIMEOUT 10
+
+// ZMODEM Framing
+
+#define ZPAD    '*'
+#define ZDLE    0x18
+#define ZBIN    'A'
+#define ZHEX    'B'
+#define ZBIN32  'C'
+
+// ZMODEM Frame Types
+
+#define ZRQINIT     0
+#define ZRINIT      1
+#define ZACK        3
+#define ZFILE       4
+#define ZSKIP       5
+#define ZNAK        6
+#define ZABORT      7
+#define ZFIN        8
+#define ZRPOS       9
+#define ZDATA       10
+#define ZEOF        11
+#define ZFERR       12
+#define ZCRC        13
+#define ZCHALLENGE  14
+#define ZCAN        16
+
+// ZMODEM Data Sub Packet Ends
+
+#define ZCRCE   'h'
+#define ZCRCG   'i'
+#define ZCRCQ   'j'
+#define ZCRCW   'k'
+
+// ZRINIT Capabilities
+
+#define CANFC32 0x20
+#define ESCCTL  0x40
+
+// The Size of a ZMODEM Sub Packet, and the Data Sent before an Ack is Waited on
+
+#define ZMODEM_BLOCK 1024
+#define ZMODEM_WINDOW (64 * 1024)
+
+// Returned by the Header Reader when the Receiver Cancelled
+
+#define TRANSFER_CANCELLED -2
+
+////////////////////////////////////////////////////////////////////////////////
+
+// The Bytes Received from the Port, consumed one at a time
+
+static BYTE Received[4096];
+static int ReceivedLength, ReceivedPosition;
+
+// The ZMODEM Options agreed with the Receiver
+
+static int UseCrc32;
+static int EscapeControl;
+
+// The Bytes ZMODEM has to Escape
+
+static BYTE EscapeTable[256];
+
+// The Progress of the Current Transfer
+
+static struct timespec TransferStart, LastProgress;
+
+static const char * ProtocolNames[] = { "XMODEM-1K", "YMODEM", "ZMODEM" };
+
+////////////////////////////////////////////////////////////////////////////////
+
+int ParseProtocol(char * Text)
+{
+    int Protocol;
+    
+    for (Protocol = 0; Protocol < 3; Protocol ++)
+    {
+        // Accept both xmodem and XMODEM-1K
+        
+        if (strncasecmp(Text, ProtocolNames[Protocol], 6) == 0)
+        {
+            return Protocol;
+        }
+    }
+    
+    return -1;
+}
+
+static double Elapsed(struct timespec * Since)
+{
+    struct timespec Now;
+    
+    clock_gettime(CLOCK_MONOTONIC, &Now);
+    
+    return (Now.tv_sec - Since -> tv_sec) + (Now.tv_nsec - Since -> tv_nsec) / 1e9;
+}
+
+/*
+ *  The Show Progress Method will print the Bytes Sent and the Throughput,
+ *  at most Ten times a Second unless it is the Final Report.
+ */
+
+static void ShowProgress(QWORD Sent, QWORD Total, int Final)
+{
+    if (!Final && Elapsed(&LastProgress) < 0.1)
+    {
+        return;
+    }
+    
+    clock_gettime(CLOCK_MONOTONIC, &LastProgress);
+    
+    double Seconds = Elapsed(&TransferStart);
+    
+    printf("\rSent %llu of %llu Bytes ( %3.0f%% ) %8.1f KB/s ", (unsigned long long) Sent, (unsigned long long) Total,
+           Total ? Sent * 100.0 / Total : 100.0, Seconds > 0 ? Sent / Seconds / 1024 : 0);
+    
+    if (Final)
+    {
+        printf("in %.2f Seconds \r\n", Seconds);
+    }
+    
+    fflush(stdout);
+}
+
+/*
+ *  The Read Byte Method will return the Next Byte from the Port, waiting at
+ *  most Timeout Milliseconds for it.
+ * 
+ *  Returns:
+ *          The Byte, or -1 on Timeout or Error
+ */
+
+static int ReadByte(int Port, int Timeout)
+{
+    if (ReceivedPosition == ReceivedLength)
+    {
+        struct pollfd Readable = { Port, POLLIN, 0 };
+        
+        if (poll(&Readable, 1, Timeout) <= 0)
+        {
+            return -1;
+        }
+        
+        ssize_t Length = read(Port, Received, sizeof(Received));
+        
+        if (Length <= 0)
+        {
+            return -1;
+        }
+        
+        ReceivedLength = Length;
+        ReceivedPosition = 0;
+    }
+    
+    return Received[ReceivedPosition ++];
+}
+
+// Returns 1 if the Receiver has Sent something which was not Read yet
+
+static int HasInput(int Port)
+{
+    struct pollfd Readable = { Port, POLLIN, 0 };
+    
+    return ReceivedPosition < ReceivedLength || poll(&Readable, 1, 0) > 0;
+}
+
+// Skips the Bytes Received which cannot start a Header, Returns 1 if a Header ( or a Cancel ) is Waiting
+
+static int HeaderPending(int Port)
+{
+    while (HasInput(Port))
+    {
+        int Byte = ReadByte(Port, 0);
+        
+        if (Byte == ZPAD || Byte == CAN)
+        {
+            ReceivedPosition --;
+            
+            return 1;
+        }
+    }
+    
+    return 0;
+}
+
+// Discards the Bytes Received so far
+
+static void Purge(int Port)
+{
+    ReceivedLength = ReceivedPosition = 0;
+    
+    while (ReadByte(Port, 0) >= 0)
+    {
+        ReceivedLength = ReceivedPosition = 0;
+    }
+}
+
+// Sends Eight CAN Bytes, which stop any of the Receivers
+
+static void Cancel(int Port)
+{
+    static const BYTE Abort[] = { CAN, CAN, CAN, CAN, CAN, CAN, CAN, CAN, 8, 8, 8, 8, 8, 8, 8, 8 };
+    
+    WriteAll(Port, Abort, sizeof(Abort));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+/*
+ *  The Wait Start Method will wait for the Receiver to ask for the First Block,
+ *  with C ( CRC16 ) or NAK ( Additive Checksum ).
+ * 
+ *  Returns:
+ *          1 for CRC16, 0 for the Additive Checksum, -1 on Timeout or Cancel
+ */
+
+static int WaitStart(int Port)
+{
+    int Cancels = 0;
+    
+    struct timespec Start;
+    
+    clock_gettime(CLOCK_MONOTONIC, &Start);
+    
+    while (Elapsed(&Start) < START_TIMEOUT)
+    {
+        int Byte = ReadByte(Port, 1000);
+        
+        if (Byte == 'C')
+        {
+            return 1;
+        }
+        
+        if (Byte == NAK)
+        {
+            return 0;
+        }
+        
+        Cancels = Byte == CAN ? Cancels + 1 : 0;
+        
+        if (Cancels == 2)
+        {
+            break;
+        }
+    }
+    
+    return -1;
+}
+
+/*
+ *  The Send Block Method will Send an XMODEM Block until it is Acked.
+ * 
+ *  Parameters:
+ *          The Port
+ *          The Block Number
+ *          The Data, which is Padded up to the Block Size with the Pad Byte
+ *          The Block Size ( 128 or 1024 ) and weather CRC16 is used
+ * 
+ *  Returns:
+ *          0 once Acked, -1 on Failure
+ */
+
+static int SendBlock(int Port, BYTE Number, const BYTE * Data, QWORD Length, int BlockSize, BYTE Pad, int Crc)
+{
+    BYTE Block[1024 + 5];
+    
+    Block[0] = BlockSize == 1024 ? STX : SOH;
+    Block[1] = Number;
+    Block[2] = ~Number;
+    
+    memcpy(Block + 3, Data, Length);
+    memset(Block + 3 + Length, Pad, BlockSize - Length);
+    
+    int Trailer = 3 + BlockSize;
+    
+    if (Crc)
+    {
+        WORD Checksum = Crc16(0, Block + 3, BlockSize);
+        
+        Block[Trailer ++] = Checksum >> 8;
+        Block[Trailer ++] = Checksum & 0xFF;
+    }
+    else
+    {
+        BYTE Sum = 0;
+        
+        int Counter;
+        
+        for (Counter = 0; Counter < BlockSize; Counter ++)
+        {
+            Sum += Block[3 + Counter];
+        }
+        
+        Block[Trailer ++] = Sum;
+    }
+    
+    int Retry;
+    
+    for (Retry = 0; Retry < MAX_RETRIES; Retry ++)
+    {
+        Purge(Port);
+        
+        if (WriteAll(Port, Block, Trailer) != 0)
+        {
+            return -1;
+        }
+        
+        // Wait for the Answer, ignoring Noise and Repeated Start Requests
+        
+        int Cancels = 0;
+        
+        int Byte;
+        
+        while ((Byte = ReadByte(Port, ANSWER_TIMEOUT * 1000)) >= 0)
+        {
+            if (Byte == ACK)
+            {
+                return 0;
+            }
+            
+            if (Byte == NAK)
+            {
+                break;
+            }
+            
+            Cancels = Byte == CAN ? Cancels + 1 : 0;
+            
+            if (Cancels == 2)
+            {
+                return -1;
+            }
+        }
+    }
+    
+    return -1;
+}
+
+/*
+ *  The Send Blocks Method will Send the whole File as XMODEM Blocks, then End
+ *  the File with EOT. CRC16 Receivers get 1024 Byte Blocks, except for a
+ *  short Last Block.
+ */
+
+static int SendBlocks(int Port, const BYTE * Data, QWORD Size, int Crc)
+{
+    QWORD Sent = 0;
+    
+    BYTE Number = 1;
+    
+    while (Sent < Size)
+    {
+        int BlockSize = Crc && Size - Sent > 128 ? 1024 : 128;
+        
+        QWORD Length = Size - Sent < (QWORD) BlockSize ? Size - Sent : (QWORD) BlockSize;
+        
+        if (SendBlock(Port, Number ++, Data + Sent, Length, BlockSize, CPMEOF, Crc) != 0)
+        {
+            return -1;
+        }
+        
+        Sent += Length;
+        
+        ShowProgress(Sent, Size, 0);
+    }
+    
+    // Receivers may NAK the First EOT, to make sure it is not Noise
+    
+    int Retry;
+    
+    for (Retry = 0; Retry < MAX_RETRIES; Retry ++)
+    {
+        BYTE End = EOT;
+        
+        WriteAll(Port, &End, 1);
+        
+        int Byte;
+        
+        while ((Byte = ReadByte(Port, ANSWER_TIMEOUT * 1000)) >= 0 && Byte != ACK && Byte != NAK)
+        {
+        }
+        
+        if (Byte == ACK)
+        {
+            return 0;
+        }
+    }
+    
+    return -1;
+}
+
+static int SendXModem(int Port, const BYTE * Data, QWORD Size)
+{
+    int Crc = WaitStart(Port);
+    
+    if (Crc < 0)
+    {
+        return -1;
+    }
+    
+    return SendBlocks(Port, Data, Size, Crc);
+}
+
+/*
+ *  The Send YModem Method will Send the Header Block ( Name, Size, Time and
+ *  Mode ), the File, then the Empty Header Block which Ends the Batch.
+ */
+
+static int SendYModem(int Port, char * FileName, const BYTE * Data, QWORD Size)
+{
+    BYTE Header[1024];
+    
+    struct stat Status;
+    
+    stat(FileName, &Status);
+    
+    char * Copy = strdup(FileName);
+    
+    memset(Header, 0, sizeof(Header));
+    
+    int Length = snprintf((char *) Header, sizeof(Header) - 64, "%s", basename(Copy)) + 1;
+    
+    Length += snprintf((char *) Header + Length, 64, "%llu %llo %o", (unsigned long long) Size, (unsigned long long) Status.st_mtime, Status.st_mode) + 1;
+    
+    free(Copy);
+    
+    if (WaitStart(Port) != 1 || SendBlock(Port, 0, Header, Length, Length > 128 ? 1024 : 128, 0, 1) != 0)
+    {
+        return -1;
+    }
+    
+    if (WaitStart(Port) != 1 || SendBlocks(Port, Data, Size, 1) != 0)
+    {
+        return -1;
+    }
+    
+    // The Empty Header Block tells the Receiver no other File follows
+    
+    if (WaitStart(Port) != 1)
+    {
+        return -1;
+    }
+    
+    return SendBlock(Port, 0, Header, 0, 128, 0, 1);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+/*
+ *  The Build Escape Table Method marks the Bytes ZMODEM has to Escape : ZDLE,
+ *  DLE and the Flow Control Bytes, with or without their High Bit, and every
+ *  Control Character if the Receiver asked for it.
+ */
+
+static void BuildEscapeTable()
+{
+    static const BYTE Always[] = { ZDLE, 0x10, 0x11, 0x13 };
+    
+    int Counter;
+    
+    memset(EscapeTable, 0, sizeof(EscapeTable));
+    
+    for (Counter = 0; Counter < 4; Counter ++)
+    {
+        EscapeTable[Always[Counter]] = 1;
+        EscapeTable[Always[Counter] | 0x80] = 1;
+    }
+    
+    if (EscapeControl)
+    {
+        for (Counter = 0; Counter < 0x20; Counter ++)
+        {
+            EscapeTable[Counter] = 1;
+            EscapeTable[Counter | 0x80] = 1;
+        }
+    }
+}
+
+/*
+ *  The Escape Method will append Bytes to a Buffer, Escaped with ZDLE.
+ *  A CR following an @ is Escaped too, so that Telnet never sees @ CR.
+ * 
+ *  Returns:
+ *          The new Length of the Buffer
+ */
+
+static int Escape(BYTE * Buffer, int Length, const BYTE * Data, int Count)
+{
+    int Counter;
+    
+    for (Counter = 0; Counter < Count; Counter ++)
+    {
+        BYTE Byte = Data[Counter];
+        
+        BYTE Last = Length > 0 ? Buffer[Length - 1] : 0;
+        
+        if (EscapeTable[Byte] || ((Byte & 0x7F) == '\r' && (Last & 0x7F) == '@'))
+        {
+            Buffer[Length ++] = ZDLE;
+            Buffer[Length ++] = Byte ^ 0x40;
+        }
+        else
+        {
+            Buffer[Length ++] = Byte;
+        }
+    }
+    
+    return Length;
+}
+
+/*
+ *  The Send Hex Header Method will Send a Header as Hex Digits, which is how
+ *  the Session is Opened and Closed.
+ */
+
+static int SendHexHeader(int Port, BYTE Type, const BYTE Position[4])
+{
+    BYTE Header[5] = { Type, Position[0], Position[1], Position[2], Position[3] };
+    
+    WORD Checksum = Crc16(0, Header, 5);
+    
+    char Buffer[32];
+    
+    int Length = snprintf(Buffer, sizeof(Buffer), "%c%c%c%c%02x%02x%02x%02x%02x%02x%02x\r\x8a", ZPAD, ZPAD, ZDLE, ZHEX,
+                          Header[0], Header[1], Header[2], Header[3], Header[4], Checksum >> 8, Checksum & 0xFF);
+    
+    // The Receiver may have been Stopped by an XOFF
+    
+    if (Type != ZFIN && Type != ZACK)
+    {
+        Buffer[Length ++] = 0x11;
+    }
+    
+    return WriteAll(Port, (BYTE *) Buffer, Length);
+}
+
+/*
+ *  The Send Binary Header Method will Send a Header in Binary, with CRC16 or
+ *  CRC32 depending on the Receiver.
+ */
+
+static int SendBinaryHeader(int Port, BYTE Type, const BYTE Position[4])
+{
+    BYTE Header[5] = { Type, Position[0], Position[1], Position[2], Position[3] };
+    
+    BYTE Buffer[64] = { ZPAD, ZDLE, UseCrc32 ? ZBIN32 : ZBIN };
+    
+    int Length = Escape(Buffer, 3, Header, 5);
+    
+    if (UseCrc32)
+    {
+        DWORD Checksum = Crc32(0, Header, 5);
+        
+        BYTE Trailer[4] = { Checksum, Checksum >> 8, Checksum >> 16, Checksum >> 24 };
+        
+        Length = Escape(Buffer, Length, Trailer, 4);
+    }
+    else
+    {
+        WORD Checksum = Crc16(0, Header, 5);
+        
+        BYTE Trailer[2] = { Checksum >> 8, Checksum };
+        
+        Length = Escape(Buffer, Length, Trailer, 2);
+    }
+    
+    return WriteAll(Port, Buffer, Length);
+}
+
+// Stores a File Position inside a Header, Least Significant Byte first
+
+static void PositionHeader(BYTE Header[4], QWORD Position)
+{
+    Header[0] = Position;
+    Header[1] = Position >> 8;
+    Header[2] = Position >> 16;
+    Header[3] = Position >> 24;
+}
+
+static QWORD HeaderPosition(const BYTE Header[4])
+{
+    return Header[0] | (Header[1] << 8) | (Header[2] << 16) | ((DWORD) Header[3] << 24);
+}
+
+/*
+ *  The Send Sub Packet Method will Send a Block of Data, followed by it's End
+ *  ( which tells the Receiver weather to Answer ) and it's Checksum.
+ */
+
+static int SendSubPacket(int Port, const BYTE * Data, int Count, BYTE End)
+{
+    static BYTE Buffer[ZMODEM_BLOCK * 2 + 16];
+    
+    int Length = Escape(Buffer, 0, Data, Count);
+    
+    Buffer[Length ++] = ZDLE;
+    Buffer[Length ++] = End;
+    
+    // The Checksum covers the Data and the End Byte
+    
+    if (UseCrc32)
+    {
+        DWORD Checksum = Crc32(Crc32(0, Data, Count), &End, 1);
+        
+        BYTE Trailer[4] = { Checksum, Checksum >> 8, Checksum >> 16, Checksum >> 24 };
+        
+        Length = Escape(Buffer, Length, Trailer, 4);
+    }
+    else
+    {
+        WORD Checksum = Crc16(Crc16(0, Data, Count), &End, 1);
+        
+        BYTE Trailer[2] = { Checksum >> 8, Checksum };
+        
+        Length = Escape(Buffer, Length, Trailer, 2);
+    }
+    
+    // Some Receivers only Answer ZCRCW once they see an XON
+    
+    if (End == ZCRCW)
+    {
+        Buffer[Length ++] = 0x11;
+    }
+    
+    return WriteAll(Port, Buffer, Length);
+}
+
+/*
+ *  The Read Escaped Method will Read a Byte which may be Escaped with ZDLE,
+ *  skipping the Flow Control Bytes. Five CAN in a row Cancel the Transfer.
+ * 
+ *  Returns:
+ *          The Byte, -1 on Timeout, or TRANSFER_CANCELLED
+ */
+
+static int ReadEscaped(int Port, int Timeout)
+{
+    int Byte;
+    
+    while ((Byte = ReadByte(Port, Timeout)) >= 0)
+    {
+        if ((Byte & 0x7F) == 0x11 || (Byte & 0x7F) == 0x13)
+        {
+            continue;
+        }
+        
+        if (Byte != ZDLE)
+        {
+            return Byte;
+        }
+        
+        int Cancels = 1;
+        
+        while ((Byte = ReadByte(Port, Timeout)) == CAN)
+        {
+            if (++ Cancels == 5)
+            {
+                return TRANSFER_CANCELLED;
+            }
+        }
+        
+        if (Byte < 0)
+        {
+            return -1;
+        }
+        
+        // ZRUB0 and ZRUB1
+        
+        if (Byte == 'l')
+        {
+            return 0x7F;
+        }
+        
+        if (Byte == 'm')
+        {
+            return 0xFF;
+        }
+        
+        return Byte ^ 0x40;
+    }
+    
+    return -1;
+}
+
+static int HexDigit(int Port, int Timeout)
+{
+    int Byte = ReadByte(Port, Timeout);
+    
+    if (Byte >= '0' && Byte <= '9')
+    {
+        return Byte - '0';
+    }
+    
+    if (Byte >= 'a' && Byte <= 'f')
+    {
+        return Byte - 'a' + 10;
+    }
+    
+    return -1;
+}
+
+/*
+ *  The Read Header Method will wait for the Next Valid Header from the Receiver,
+ *  in any of the Three Formats. Damaged Headers are skipped.
+ * 
+ *  Parameters:
+ *          The Port
+ *          The Four Position / Flag Bytes of the Header
+ *          The Time to wait, in Seconds
+ * 
+ *  Returns:
+ *          The Frame Type, -1 on Timeout, or TRANSFER_CANCELLED
+ */
+
+static int ReadHeader(int Port, BYTE Position[4], int Timeout)
+{
+    struct timespec Start;
+    
+    clock_gettime(CLOCK_MONOTONIC, &Start);
+    
+    int Cancels = 0;
+    
+    while (Elapsed(&Start) < Timeout)
+    {
+        int Byte = ReadByte(Port, 1000);
+        
+        Cancels = Byte == CAN ? Cancels + 1 : 0;
+        
+        if (Cancels == 5)
+        {
+            return TRANSFER_CANCELLED;
+        }
+        
+        if (Byte != ZPAD)
+        {
+            continue;
+        }
+        
+        while ((Byte = ReadByte(Port, 1000)) == ZPAD)
+        {
+        }
+        
+        if (Byte != ZDLE)
+        {
+            continue;
+        }
+        
+        int Format = ReadByte(Port, 1000);
+        
+        BYTE Header[9];
+        
+        int Counter, Length = Format == ZBIN32 ? 9 : 7;
+        
+        int Valid = 1;
+        
+        for (Counter = 0; Counter < Length && Valid; Counter ++)
+        {
+            int Value;
+            
+            if (Format == ZHEX)
+            {
+                int High = HexDigit(Port, 1000);
+                int Low = HexDigit(Port, 1000);
+                
+                Value = High < 0 || Low < 0 ? -1 : (High << 4) | Low;
+            }
+            else if (Format == ZBIN || Format == ZBIN32)
+            {
+                Value = ReadEscaped(Port, 1000);
+            }
+            else
+            {
+                Value = -1;
+            }
+            
+            if (Value == TRANSFER_CANCELLED)
+            {
+                return TRANSFER_CANCELLED;
+            }
+            
+            Valid = Value >= 0;
+            
+            Header[Counter] = Value;
+        }
+        
+        if (!Valid)
+        {
+            continue;
+        }
+        
+        if (Format == ZBIN32)
+        {
+            DWORD Checksum = Crc32(0, Header, 5);
+            
+            Valid = Header[5] == (BYTE) Checksum && Header[6] == (BYTE) (Checksum >> 8) &&
+                    Header[7] == (BYTE) (Checksum >> 16) && Header[8] == (BYTE) (Checksum >> 24);
+        }
+        else
+        {
+            WORD Checksum = Crc16(0, Header, 5);
+            
+            Valid = Header[5] == (Checksum >> 8) && Header[6] == (Checksum & 0xFF);
+        }
+        
+        if (Valid)
+        {
+            memcpy(Position, Header + 1, 4);
+            
+            return Header[0];
+        }
+    }
+    
+    return -1;
+}
+
+/*
+ *  The Send Data Method will Stream the File from an Offset. Every Window a
+ *  ZCRCQ Packet asks the Receiver for an Ack, without waiting for it. The
+ *  Sender only Stops when a Full Window is still not Acked, or when the
+ *  Receiver's Buffer is Full. A ZRPOS from the Receiver Rewinds the Stream.
+ * 
+ *  Returns:
+ *          0 once the whole File was Sent, -1 on Failure
+ */
+
+static int SendData(int Port, const BYTE * Data, QWORD Size, QWORD Offset, QWORD ReceiverBuffer)
+{
+    BYTE Position[4];
+    
+    int Errors = 0;
+    
+    QWORD Acked = Offset, Rewound = Offset;
+    
+    while (Errors < MAX_RETRIES)
+    {
+        PositionHeader(Position, Offset);
+        
+        SendBinaryHeader(Port, ZDATA, Position);
+        
+        QWORD SinceWait = 0;
+        
+        int Rewind = 0;
+        
+        do
+        {
+            int Count = Size - Offset < ZMODEM_BLOCK ? Size - Offset : ZMODEM_BLOCK;
+            
+            BYTE End = ZCRCG;
+            
+            SinceWait += Count;
+            
+            if (Offset + Count == Size)
+            {
+                End = ZCRCE;
+            }
+            else if (ReceiverBuffer && SinceWait + ZMODEM_BLOCK > ReceiverBuffer)
+            {
+                End = ZCRCW;
+            }
+            else if ((Offset + Count) % ZMODEM_WINDOW < (QWORD) Count)
+            {
+                End = ZCRCQ;
+            }
+            
+            if (SendSubPacket(Port, Data + Offset, Count, End) != 0)
+            {
+                return -1;
+            }
+            
+            Offset += Count;
+            
+            ShowProgress(Offset, Size, 0);
+            
+            // Read the Acks which arrived, and Wait if the Window is Full or the Receiver asked to
+            
+            while (HeaderPending(Port) || End == ZCRCW || Offset - Acked > 2 * ZMODEM_WINDOW)
+            {
+                int Type = ReadHeader(Port, Position, ANSWER_TIMEOUT);
+                
+                if (Type == ZACK)
+                {
+                    Acked = HeaderPosition(Position);
+                    
+                    if (End == ZCRCW)
+                    {
+                        SinceWait = 0;
+                        
+                        break;
+                    }
+                }
+                else if (Type == ZRPOS)
+                {
+                    Offset = Acked = HeaderPosition(Position);
+                    
+                    Rewind = 1;
+                    
+                    // Only the Rewinds which made no Progress since the Last one are Errors
+                    
+                    Errors = Offset > Rewound ? 1 : Errors + 1;
+                    
+                    Rewound = Offset;
+                    
+                    Purge(Port);
+                    
+                    break;
+                }
+                else if (Type == TRANSFER_CANCELLED || Type == ZABORT || Type == ZFERR || Type == ZCAN)
+                {
+                    return -1;
+                }
+                else if (Type < 0)
+                {
+                    // No Answer, Resume where the Receiver last Acked
+                    
+                    Offset = Acked;
+                    
+                    Rewind = 1;
+                    
+                    Errors ++;
+                    
+                    break;
+                }
+            }
+            
+            // A ZCRCW Packet was Acked, the Frame carries on with a New Header
+            
+            if (End == ZCRCW && !Rewind)
+            {
+                PositionHeader(Position, Offset);
+                
+                SendBinaryHeader(Port, ZDATA, Position);
+            }
+        }
+        while (!Rewind && Offset < Size);
+        
+        if (Rewind)
+        {
+            continue;
+        }
+        
+        // Tell the Receiver where the File Ends, it Answers with ZRINIT or asks to Resume
+        
+        PositionHeader(Position, Size);
+        
+        SendBinaryHeader(Port, ZEOF, Position);
+        
+        int Type;
+        
+        while ((Type = ReadHeader(Port, Position, ANSWER_TIMEOUT)) == ZACK)
+        {
+        }
+        
+        if (Type == ZRINIT)
+        {
+            return 0;
+        }
+        
+        if (Type == ZRPOS)
+        {
+            Offset = Acked = HeaderPosition(Position);
+            
+            if (Offset > Rewound)
+            {
+                Errors = 0;
+            }
+            
+            Rewound = Offset;
+        }
+        else if (Type == TRANSFER_CANCELLED || Type == ZABORT || Type == ZFERR || Type == ZCAN)
+        {
+            return -1;
+        }
+        
+        Errors ++;
+    }
+    
+    return -1;
+}
+
+/*
+ *  The Send ZModem Method will Open the Session ( ZRQINIT, answered by ZRINIT ),
+ *  Offer the File ( ZFILE, answered by ZRPOS ), Stream it, then Close the
+ *  Session ( ZFIN, answered by ZFIN, then Over and Out ).
+ */
+
+static int SendZModem(int Port, char * FileName, const BYTE * Data, QWORD Size)
+{
+    BYTE Position[4] = { 0, 0, 0, 0 };
+    
+    int Type = -1;
+    
+    int Retry;
+    
+    // Start the Receiver, if the Other Side is a Shell
+    
+    WriteAll(Port, (BYTE *) "rz\r", 3);
+    
+    for (Retry = 0; Retry < MAX_RETRIES && Type != ZRINIT; Retry ++)
+    {
+        BYTE Zero[4] = { 0, 0, 0, 0 };
+        
+        SendHexHeader(Port, ZRQINIT, Zero);
+        
+        Type = ReadHeader(Port, Position, ANSWER_TIMEOUT);
+        
+        // Answer the Receiver's Challenge with it's own Value
+        
+        if (Type == ZCHALLENGE)
+        {
+            SendHexHeader(Port, ZACK, Position);
+        }
+        
+        if (Type == TRANSFER_CANCELLED)
+        {
+            return -1;
+        }
+    }
+    
+    if (Type != ZRINIT)
+    {
+        return -1;
+    }
+    
+    // ZRINIT holds the Capabilities in ZF0 and the Receiver's Buffer Size in ZP0 and ZP1
+    
+    UseCrc32 = (Position[3] & CANFC32) != 0;
+    EscapeControl = (Position[3] & ESCCTL) != 0;
+    
+    QWORD ReceiverBuffer = Position[0] | (Position[1] << 8);
+    
+    BuildEscapeTable();
+    
+    // The File Information : Name, Size, Time, Mode, Serial Number, Files and Bytes Left
+    
+    struct stat Status;
+    
+    stat(FileName, &Status);
+    
+    char * Copy = strdup(FileName);
+    
+    BYTE Information[1024];
+    
+    memset(Information, 0, sizeof(Information));
+    
+    int Length = snprintf((char *) Information, sizeof(Information) - 128, "%s", basename(Copy)) + 1;
+    
+    Length += snprintf((char *) Information + Length, 128, "%llu %llo %o 0 1 %llu", (unsigned long long) Size,
+                       (unsigned long long) Status.st_mtime, Status.st_mode, (unsigned long long) Size) + 1;
+    
+    free(Copy);
+    
+    QWORD Offset = 0;
+    
+    for (Retry = 0; Retry < MAX_RETRIES; Retry ++)
+    {
+        // ZF0 : Binary Transfer
+        
+        BYTE Flags[4] = { 0, 0, 0, 1 };
+        
+        SendBinaryHeader(Port, ZFILE, Flags);
+        
+        SendSubPacket(Port, Information, Length, ZCRCW);
+        
+        // A Repeated ZRINIT means the Offer was Lost, and is Sent again
+        
+        Type = ReadHeader(Port, Position, ANSWER_TIMEOUT);
+        
+        // The Receiver wants the Checksum of the File, to Resume a Previous Transfer
+        
+        if (Type == ZCRC)
+        {
+            PositionHeader(Position, Crc32(0, Data, Size));
+            
+            SendHexHeader(Port, ZCRC, Position);
+            
+            Type = ReadHeader(Port, Position, ANSWER_TIMEOUT);
+        }
+        
+        if (Type == ZRPOS || Type == ZSKIP || Type == TRANSFER_CANCELLED || Type == ZABORT || Type == ZFERR)
+        {
+            break;
+        }
+    }
+    
+    if (Type == ZRPOS)
+    {
+        Offset = HeaderPosition(Position);
+        
+        if (SendData(Port, Data, Size, Offset, ReceiverBuffer) != 0)
+        {
+            return -1;
+        }
+    }
+    else if (Type == ZSKIP)
+    {
+        printf("The Receiver Skipped %s \r\n", FileName);
+    }
+    else
+    {
+        return -1;
+    }
+    
+    // Close the Session
+    
+    for (Retry = 0; Retry < MAX_RETRIES; Retry ++)
+    {
+        BYTE Zero[4] = { 0, 0, 0, 0 };
+        
+        SendHexHeader(Port, ZFIN, Zero);
+        
+        Type = ReadHeader(Port, Position, ANSWER_TIMEOUT);
+        
+        if (Type == ZFIN || Type < 0)
+        {
+            break;
+        }
+    }
+    
+    WriteAll(Port, (BYTE *) "OO", 2);
+    
+    return 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+/*
+ *  The Send File Method will Send a File over an Open Port, printing the
+ *  Progress and the Throughput. A Transfer which Fails is Cancelled, so that
+ *  the Receiver does not wait for it.
+ * 
+ *  Parameters:
+ *          The Port
+ *          A Char Array with the Name of the File
+ *          The Protocol
+ * 
+ *  Returns:
+ *          0 on Success, -1 on Failure
+ */
+
+int SendFile(int Port, char * FileName, int Protocol)
+{
+    QWORD Size;
+    
+    BYTE * Data = MapFile(FileName, &Size);
+    
+    printf("Sending %s ( %llu Bytes ) with %s, Start the Receiver \r\n", FileName, (unsigned long long) Size, ProtocolNames[Protocol]);
+    
+    // The Receiver may already be Asking for the File, nothing Received is Discarded
+    
+    ReceivedLength = ReceivedPosition = 0;
+    
+    clock_gettime(CLOCK_MONOTONIC, &TransferStart);
+    
+    LastProgress = TransferStart;
+    
+    int Result;
+    
+    if (Protocol == PROTOCOL_XMODEM)
+    {
+        Result = SendXModem(Port, Data, Size);
+    }
+    else if (Protocol == PROTOCOL_YMODEM)
+    {
+        Result = SendYModem(Port, FileName, Data, Size);
+    }
+    else
+    {
+        Result = SendZModem(Port, FileName, Data, Size);
+    }
+    
+    if (Result == 0)
+    {
+        ShowProgress(Size, Size, 1);
+        
+        puts("Transfer Complete");
+    }
+    else
+    {
+        Cancel(Port);
+        
+        puts("\r\nTransfer Failed");
+    }
+    
+    UnmapFile(Data, Size);
+    
+    return Result;
+}
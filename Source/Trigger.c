@@ -0,0 +1,671 @@
+/* Serial Triggers */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#include <sqlite3.h>
+
+#include "../Headers/Common.h"
+#include "../Headers/Trigger.h"
+
+// The Maximum Length of a Trigger Line
+
+#define LINE_LENGTH 4096
+
+// The Matches Fired after a single Chunk, the Rest are Dropped and Counted ( See TriggerState )
+
+#define CHUNK_MATCHES 64
+
+// Commands still Running, Reaped as new Matches are Fired
+
+static int Children = 0;
+
+static QWORD Monotonic()
+{
+    struct timespec Now;
+    
+    clock_gettime(CLOCK_MONOTONIC, &Now);
+    
+    return (QWORD) Now.tv_sec * 1000000000ULL + Now.tv_nsec;
+}
+
+/*
+ *  The Read Token Method will Read the next Word or Quoted String of a Line,
+ *  and Decode it's Escapes in Place.
+ * 
+ *  Returns:
+ *          The Token's Length, 0 at the End of the Line ( or at a Comment ), -1 on a Syntax Error
+ */
+
+static int ReadToken(char ** Line, char ** Token)
+{
+    char * Read = *Line;
+    
+    while (*Read == ' ' || *Read == '\t' || *Read == '\r' || *Read == '\n')
+    {
+        Read ++;
+    }
+    
+    if (*Read == '\0' || *Read == '#')
+    {
+        return 0;
+    }
+    
+    char * Write = Read;
+    
+    *Token = Write;
+    
+    // A Word ends at the next Space
+    
+    if (*Read != '"')
+    {
+        while (*Read && *Read != ' ' && *Read != '\t' && *Read != '\r' && *Read != '\n')
+        {
+            Read ++;
+        }
+        
+        *Line = *Read ? Read + 1 : Read;
+        
+        *Read = '\0';
+        
+        return Read - Write;
+    }
+    
+    Read ++;
+    
+    while (*Read != '"')
+    {
+        if (*Read == '\0' || *Read == '\r' || *Read == '\n')
+        {
+            return -1;
+        }
+        
+        if (*Read != '\\')
+        {
+            *Write ++ = *Read ++;
+            
+            continue;
+        }
+        
+        Read ++;
+        
+        switch (*Read)
+        {
+            case 'r':  *Write ++ = '\r'; break;
+            case 'n':  *Write ++ = '\n'; break;
+            case 't':  *Write ++ = '\t'; break;
+            case '\\': *Write ++ = '\\'; break;
+            case '"':  *Write ++ = '"';  break;
+            
+            case 'x':
+            {
+                char Digits[3] = { Read[1], Read[1] ? Read[2] : '\0', '\0' };
+                
+                char * End;
+                
+                long Value = strtol(Digits, &End, 16);
+                
+                if (End != Digits + 2)
+                {
+                    return -1;
+                }
+                
+                *Write ++ = Value;
+                
+                Read += 2;
+                
+                break;
+            }
+            
+            default:
+                
+                return -1;
+        }
+        
+        Read ++;
+    }
+    
+    *Line = Read + 1;
+    
+    return Write - *Token;
+}
+
+/*
+ *  The Load Triggers Method will read a Trigger File. The Format is described
+ *  inside the Trigger Header File. Any Syntax Error ends the Application.
+ * 
+ *  Parameters:
+ *          An Empty Trigger Set
+ *          A Char Array with the Name of the Trigger File
+ *          Where the Events are Written
+ * 
+ *  Returns:
+ *          VOID
+ */
+
+void LoadTriggers(TriggerSet * Set, char * FileName, FILE * Events)
+{
+    FILE * File = FileOpener(FileName, "r");
+    
+    int LineNumber = 0;
+    
+    char Line[LINE_LENGTH];
+    
+    memset(Set, 0, sizeof(TriggerSet));
+    
+    Set -> Events = Events;
+    
+    while (fgets(Line, LINE_LENGTH, File))
+    {
+        LineNumber ++;
+        
+        char * Read = Line;
+        
+        char * Tokens[3];
+        
+        int Lengths[3];
+        
+        int TokenCount = 0;
+        
+        int Length;
+        
+        while (TokenCount < 3 && (Length = ReadToken(&Read, &Tokens[TokenCount])) > 0)
+        {
+            Lengths[TokenCount ++] = Length;
+        }
+        
+        if (Length < 0)
+        {
+            printf("Line %d : Invalid Quoted String \r\n", LineNumber);
+            exit(-1);
+        }
+        
+        if (TokenCount == 0)
+        {
+            continue;
+        }
+        
+        if (strcmp(Tokens[0], "Signatures") == 0 && TokenCount == 2)
+        {
+            if (AddSignatureTriggers(Set, Tokens[1]) < 0)
+            {
+                printf("Line %d : Cannot Read the Signatures of %s \r\n", LineNumber, Tokens[1]);
+                exit(-1);
+            }
+            
+            continue;
+        }
+        
+        int Action = -1;
+        
+        if (strcmp(Tokens[0], "Event") == 0 && TokenCount == 2)
+        {
+            Action = TRIGGER_EVENT;
+        }
+        else if (strcmp(Tokens[0], "Reply") == 0 && TokenCount == 3)
+        {
+            Action = TRIGGER_REPLY;
+        }
+        else if (strcmp(Tokens[0], "Command") == 0 && TokenCount == 3)
+        {
+            Action = TRIGGER_COMMAND;
+        }
+        
+        if (Action < 0)
+        {
+            printf("Line %d : Expected Event <Pattern>, Reply <Pattern> <Reply>, Command <Pattern> <Command> or Signatures <Database> \r\n", LineNumber);
+            exit(-1);
+        }
+        
+        // The Name shows the Pattern with Dots in place of it's Unprintable Bytes
+        
+        char * Name = strndup(Tokens[1], Lengths[1]);
+        
+        int Counter;
+        
+        for (Counter = 0; Counter < Lengths[1]; Counter ++)
+        {
+            if (Name[Counter] < 0x20 || Name[Counter] > 0x7E)
+            {
+                Name[Counter] = '.';
+            }
+        }
+        
+        AddTrigger(Set, Name, (BYTE *) Tokens[1], Lengths[1], Action,
+                   TokenCount == 3 ? (BYTE *) Tokens[2] : NULL, TokenCount == 3 ? Lengths[2] : 0);
+        
+        free(Name);
+    }
+    
+    fclose(File);
+    
+    BuildTriggers(Set);
+}
+
+/*
+ *  The Add Trigger Method will append a Trigger to a Set. Every Field is
+ *  Copied, and a Command is kept Null Terminated.
+ * 
+ *  Parameters:
+ *          The Trigger Set
+ *          The Trigger's Name, Pattern, Action and Argument
+ * 
+ *  Returns:
+ *          VOID
+ */
+
+void AddTrigger(TriggerSet * Set, char * Name, BYTE * Pattern, int Length, int Action, BYTE * Argument, int ArgumentLength)
+{
+    Set -> Triggers = realloc(Set -> Triggers, (Set -> Count + 1) * sizeof(Trigger));
+    
+    if (Set -> Triggers == NULL)
+    {
+        puts("Error Allocating Memory");
+        exit(-1);
+    }
+    
+    Trigger * Entry = &Set -> Triggers[Set -> Count ++];
+    
+    Entry -> Name = strdup(Name);
+    
+    Entry -> Pattern = malloc(Length);
+    
+    memcpy(Entry -> Pattern, Pattern, Length);
+    
+    Entry -> Length = Length;
+    
+    Entry -> Action = Action;
+    
+    Entry -> Argument = calloc(1, ArgumentLength + 1);
+    
+    memcpy(Entry -> Argument, Argument ? Argument : (BYTE *) "", ArgumentLength);
+    
+    Entry -> ArgumentLength = ArgumentLength;
+    
+    Entry -> Same = -1;
+    
+    Entry -> Matches = 0;
+}
+
+/*
+ *  The Add Signature Triggers Method will add an Event for every Signature
+ *  of a Signature Database, named after the Signature.
+ * 
+ *  Parameters:
+ *          The Trigger Set
+ *          A Char Array with the Name of the Database
+ * 
+ *  Returns:
+ *          The Number of Signatures Added, -1 on Error
+ */
+
+int AddSignatureTriggers(TriggerSet * Set, char * DatabaseName)
+{
+    sqlite3 * Connection;
+    
+    sqlite3_stmt * Result;
+    
+    if (sqlite3_open_v2(DatabaseName, &Connection, SQLITE_OPEN_READONLY, NULL) != SQLITE_OK)
+    {
+        sqlite3_close(Connection);
+        
+        return -1;
+    }
+    
+    if (sqlite3_prepare_v2(Connection, "SELECT Name, Signature FROM Signatures", -1, &Result, NULL) != SQLITE_OK)
+    {
+        sqlite3_close(Connection);
+        
+        return -1;
+    }
+    
+    int Count = 0;
+    
+    while (sqlite3_step(Result) == SQLITE_ROW)
+    {
+        const char * Name = (const char *) sqlite3_column_text(Result, 0);
+        
+        const BYTE * Signature = sqlite3_column_blob(Result, 1);
+        
+        int Length = sqlite3_column_bytes(Result, 1);
+        
+        if (Signature && Length > 0)
+        {
+            AddTrigger(Set, (char *) (Name ? Name : "Signature"), (BYTE *) Signature, Length, TRIGGER_EVENT, NULL, 0);
+            
+            Count ++;
+        }
+    }
+    
+    sqlite3_finalize(Result);
+    sqlite3_close(Connection);
+    
+    return Count;
+}
+
+static int NewNode(TriggerSet * Set)
+{
+    memset(Set -> Next[Set -> NodeCount], -1, sizeof(*Set -> Next));
+    
+    Set -> Output[Set -> NodeCount] = -1;
+    
+    return Set -> NodeCount ++;
+}
+
+/*
+ *  The Build Triggers Method will compile every Pattern into the Automaton.
+ *  The Patterns are put inside a Trie, then the Nodes are visited Breadth
+ *  First to find each one's Failure Node ( the Longest Suffix which is also
+ *  inside the Trie ). Missing Transitions are filled from the Failure Node,
+ *  so that Matching never has to follow a Failure Chain.
+ * 
+ *  Parameters:
+ *          The Trigger Set
+ * 
+ *  Returns:
+ *          VOID
+ */
+
+void BuildTriggers(TriggerSet * Set)
+{
+    free(Set -> Next);
+    free(Set -> Output);
+    free(Set -> OutputLink);
+    free(Set -> Final);
+    
+    // The Trie has at most one Node per Pattern Byte, and the Root
+    
+    QWORD Nodes = 1;
+    
+    int Counter;
+    
+    for (Counter = 0; Counter < Set -> Count; Counter ++)
+    {
+        Nodes += Set -> Triggers[Counter].Length;
+    }
+    
+    Set -> Next = malloc(Nodes * sizeof(*Set -> Next));
+    Set -> Output = malloc(Nodes * sizeof(int));
+    
+    if (Set -> Next == NULL || Set -> Output == NULL)
+    {
+        puts("Error Allocating Memory");
+        exit(-1);
+    }
+    
+    Set -> NodeCount = 0;
+    
+    NewNode(Set);
+    
+    for (Counter = 0; Counter < Set -> Count; Counter ++)
+    {
+        Trigger * Entry = &Set -> Triggers[Counter];
+        
+        int Node = 0;
+        
+        int Position;
+        
+        for (Position = 0; Position < Entry -> Length; Position ++)
+        {
+            BYTE Character = Entry -> Pattern[Position];
+            
+            if (Set -> Next[Node][Character] < 0)
+            {
+                int Child = NewNode(Set);
+                
+                Set -> Next[Node][Character] = Child;
+            }
+            
+            Node = Set -> Next[Node][Character];
+        }
+        
+        // Triggers sharing a Pattern are Chained
+        
+        Entry -> Same = Set -> Output[Node];
+        
+        Set -> Output[Node] = Counter;
+    }
+    
+    int * Failure = malloc(Set -> NodeCount * sizeof(int));
+    int * Queue = malloc(Set -> NodeCount * sizeof(int));
+    
+    Set -> OutputLink = malloc(Set -> NodeCount * sizeof(int));
+    Set -> Final = calloc(Set -> NodeCount, 1);
+    
+    if (Failure == NULL || Queue == NULL || Set -> OutputLink == NULL || Set -> Final == NULL)
+    {
+        puts("Error Allocating Memory");
+        exit(-1);
+    }
+    
+    int Head = 0, Tail = 0;
+    
+    Failure[0] = 0;
+    
+    Set -> OutputLink[0] = -1;
+    
+    Queue[Tail ++] = 0;
+    
+    while (Head < Tail)
+    {
+        int Node = Queue[Head ++];
+        
+        int Character;
+        
+        for (Character = 0; Character < 256; Character ++)
+        {
+            int Child = Set -> Next[Node][Character];
+            
+            if (Child < 0)
+            {
+                // The Root loops on itself, other Nodes borrow their Failure Node's Transition
+                
+                Set -> Next[Node][Character] = Node == 0 ? 0 : Set -> Next[Failure[Node]][Character];
+                
+                continue;
+            }
+            
+            Failure[Child] = Node == 0 ? 0 : Set -> Next[Failure[Node]][Character];
+            
+            Set -> OutputLink[Child] = Set -> Output[Failure[Child]] >= 0 ? Failure[Child] : Set -> OutputLink[Failure[Child]];
+            
+            Set -> Final[Child] = Set -> Output[Child] >= 0 || Set -> OutputLink[Child] >= 0;
+            
+            Queue[Tail ++] = Child;
+        }
+    }
+    
+    free(Failure);
+    free(Queue);
+}
+
+void ResetTriggers(TriggerState * State, char * Name)
+{
+    memset(State, 0, sizeof(TriggerState));
+    
+    State -> Name = Name;
+    
+    State -> Start = Monotonic();
+}
+
+/*
+ *  The Fire Method will Write the Event of a Match, and Run it's Action.
+ */
+
+static void Fire(TriggerSet * Set, TriggerState * State, Trigger * Entry, TriggerReply Reply, void * Context, QWORD Offset, QWORD Time)
+{
+    Entry -> Matches ++;
+    
+    static const char * Actions[] = { "Event", "Reply", "Command" };
+    
+    if (Set -> Events)
+    {
+        struct timespec Wall;
+        
+        clock_gettime(CLOCK_REALTIME, &Wall);
+        
+        char Clock[32];
+        
+        strftime(Clock, sizeof(Clock), "%Y-%m-%dT%H:%M:%S", localtime(&Wall.tv_sec));
+        
+        fprintf(Set -> Events, "[%12.6f] %s.%06ld %s %s \"%s\" at %llu \r\n", (Time - State -> Start) / 1e9, Clock, Wall.tv_nsec / 1000,
+                State -> Name, Actions[Entry -> Action], Entry -> Name, (unsigned long long) Offset);
+    }
+    
+    if (Entry -> Action == TRIGGER_REPLY && Reply)
+    {
+        Reply(Entry -> Argument, Entry -> ArgumentLength, Context);
+    }
+    
+    if (Entry -> Action == TRIGGER_COMMAND)
+    {
+        pid_t Child = fork();
+        
+        if (Child == 0)
+        {
+            char Text[32];
+            
+            snprintf(Text, sizeof(Text), "%llu", (unsigned long long) Offset);
+            
+            setenv("SERIAL_PORT", State -> Name, 1);
+            setenv("SERIAL_TRIGGER", Entry -> Name, 1);
+            setenv("SERIAL_OFFSET", Text, 1);
+            
+            execl("/bin/sh", "sh", "-c", (char *) Entry -> Argument, (char *) NULL);
+            
+            _exit(127);
+        }
+        
+        Children += Child > 0;
+    }
+}
+
+/*
+ *  The Match Triggers Method will run a Chunk through the Automaton. The
+ *  Matches are only Collected while Scanning, and Fired once the Chunk is
+ *  done, so the Scan itself is a Table Lookup and a Flag Test per Byte.
+ * 
+ *  Parameters:
+ *          The Trigger Set and the Stream's State
+ *          What Types the Replies on the Port, or NULL, and it's Context
+ *          The Chunk and it's Length
+ * 
+ *  Returns:
+ *          VOID
+ */
+
+void MatchTriggers(TriggerSet * Set, TriggerState * State, TriggerReply Reply, void * Context, const BYTE * Data, QWORD Length)
+{
+    QWORD Start = Monotonic();
+    
+    QWORD Ends[CHUNK_MATCHES];
+    
+    int Nodes[CHUNK_MATCHES];
+    
+    int Found = 0;
+    
+    int Node = State -> Node;
+    
+    const int (* Next)[256] = (const int (*)[256]) Set -> Next;
+    
+    const BYTE * Final = Set -> Final;
+    
+    QWORD Position;
+    
+    for (Position = 0; Position < Length; Position ++)
+    {
+        Node = Next[Node][Data[Position]];
+        
+        if (Final[Node] && Found < CHUNK_MATCHES)
+        {
+            Ends[Found] = Position;
+            Nodes[Found ++] = Node;
+        }
+        else if (Final[Node])
+        {
+            State -> Dropped ++;
+        }
+    }
+    
+    State -> Node = Node;
+    
+    State -> Chunks ++;
+    
+    State -> Nanoseconds += Monotonic() - Start;
+    
+    // Every Pattern Ending at a Node is on it's Output Chain
+    
+    int Counter;
+    
+    for (Counter = 0; Counter < Found; Counter ++)
+    {
+        int Current = Set -> Output[Nodes[Counter]] >= 0 ? Nodes[Counter] : Set -> OutputLink[Nodes[Counter]];
+        
+        while (Current >= 0)
+        {
+            int Index;
+            
+            for (Index = Set -> Output[Current]; Index >= 0; Index = Set -> Triggers[Index].Same)
+            {
+                Trigger * Entry = &Set -> Triggers[Index];
+                
+                Fire(Set, State, Entry, Reply, Context, State -> Offset + Ends[Counter] + 1 - Entry -> Length, Start);
+            }
+            
+            Current = Set -> OutputLink[Current];
+        }
+    }
+    
+    State -> Offset += Length;
+    
+    // Reap the Commands which are done
+    
+    while (Children > 0 && waitpid(-1, NULL, WNOHANG) > 0)
+    {
+        Children --;
+    }
+}
+
+void PrintTriggerStats(TriggerSet * Set, TriggerState * State)
+{
+    int Counter;
+    
+    for (Counter = 0; Counter < Set -> Count; Counter ++)
+    {
+        if (Set -> Triggers[Counter].Matches)
+        {
+            printf("%8llu x \"%s\" \r\n", (unsigned long long) Set -> Triggers[Counter].Matches, Set -> Triggers[Counter].Name);
+        }
+    }
+    
+    if (State -> Dropped)
+    {
+        printf("%8llu Matches Dropped, past %d in a single Chunk \r\n", (unsigned long long) State -> Dropped, CHUNK_MATCHES);
+    }
+    
+    printf("%d Triggers, %d States, %llu Chunks Matched in %.2f us each \r\n", Set -> Count, Set -> NodeCount, (unsigned long long) State -> Chunks,
+           State -> Chunks ? State -> Nanoseconds / 1e3 / State -> Chunks : 0);
+}
+
+void FreeTriggers(TriggerSet * Set)
+{
+    int Counter;
+    
+    for (Counter = 0; Counter < Set -> Count; Counter ++)
+    {
+        free(Set -> Triggers[Counter].Name);
+        free(Set -> Triggers[Counter].Pattern);
+        free(Set -> Triggers[Counter].Argument);
+    }
+    
+    free(Set -> Triggers);
+    free(Set -> Next);
+    free(Set -> Output);
+    free(Set -> OutputLink);
+    free(Set -> Final);
+    
+    memset(Set, 0, sizeof(TriggerSet));
+}